@@ -7,8 +7,12 @@
 
 #include "Benchmark.h"
 #include "SkAAClip.h"
+#include "SkBitmap.h"
 #include "SkCanvas.h"
+#include "SkGraphics.h"
 #include "SkPath.h"
+#include "SkPicture.h"
+#include "SkPictureRecorder.h"
 #include "SkRandom.h"
 #include "SkRegion.h"
 #include "SkString.h"
@@ -244,6 +248,101 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+////////////////////////////////////////////////////////////////////////////////
+// This bench replays the same complex clips over and over, like an animation redrawing each
+// frame or a tiled renderer revisiting a tile. With SkRasterClipCache enabled, SkCanvas should
+// find the clips it built on earlier playbacks. The _unique variants nudge the clips on every
+// playback, so they measure building the clips plus the cost of missing the cache.
+class RepeatedClipBench : public Benchmark {
+    SkString                fName;
+    bool                    fDoAA;
+    bool                    fUnique;
+    bool                    fWasCaching;
+    SkScalar                fNudge;
+    SkBitmap                fBitmap;
+    SkAutoTUnref<SkPicture> fPicture;
+
+    static const int kStarPoints = 48;
+
+public:
+    RepeatedClipBench(bool doAA, bool unique)
+        : fDoAA(doAA)
+        , fUnique(unique)
+        , fWasCaching(false)
+        , fNudge(0) {
+        fName.printf("clip_replay_%s%s", doAA ? "AA" : "BW", unique ? "_unique" : "");
+    }
+
+    virtual ~RepeatedClipBench() {
+        if (fPicture.get()) {
+            SkGraphics::SetRasterClipCacheEnabled(fWasCaching);
+        }
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return kNonRendering_Backend == backend;
+    }
+
+protected:
+    virtual const char* onGetName() { return fName.c_str(); }
+
+    virtual void onPreDraw() {
+        // Canvases only start tracking their clips for the cache once it is enabled, so this
+        // draws into its own canvas, made after enabling it.
+        fWasCaching = SkGraphics::SetRasterClipCacheEnabled(true);
+        fBitmap.allocN32Pixels(640, 480);
+
+        SkPath star;
+        for (int i = 0; i < kStarPoints; ++i) {
+            SkScalar angle = SK_ScalarPI * 2 * i / kStarPoints;
+            SkScalar radius = SkIntToScalar((i & 1) ? 90 : 220);
+            SkPoint pt = SkPoint::Make(320 + radius * SkScalarCos(angle),
+                                       240 + radius * SkScalarSin(angle));
+            if (0 == i) {
+                star.moveTo(pt);
+            } else {
+                star.lineTo(pt);
+            }
+        }
+        star.close();
+        SkPath hole;
+        hole.addCircle(320, 240, 60);
+
+        SkPaint paint;
+        this->setupPaint(&paint);
+        SkPictureRecorder recorder;
+        SkCanvas* canvas = recorder.beginRecording(640, 480);
+        canvas->save();
+        canvas->clipPath(star, SkRegion::kIntersect_Op, fDoAA);
+        canvas->clipPath(hole, SkRegion::kDifference_Op, fDoAA);
+        canvas->drawRect(SkRect::MakeXYWH(300, 0, 40, 40), paint);
+        canvas->restore();
+        fPicture.reset(recorder.endRecording());
+    }
+
+    virtual void onDraw(const int loops, SkCanvas*) {
+        SkCanvas canvas(fBitmap);
+        for (int i = 0; i < loops; ++i) {
+            canvas.save();
+            if (fUnique) {
+                // Steps of 1/256 pixel, wrapping after far more clips than the cache holds.
+                fNudge += SK_Scalar1 / 256;
+                if (fNudge >= 64) {
+                    fNudge = 0;
+                }
+                canvas.translate(fNudge, 0);
+            }
+            canvas.drawPicture(fPicture);
+            canvas.restore();
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 DEF_BENCH( return SkNEW_ARGS(AAClipBuilderBench, (false, false)); )
 DEF_BENCH( return SkNEW_ARGS(AAClipBuilderBench, (false, true)); )
 DEF_BENCH( return SkNEW_ARGS(AAClipBuilderBench, (true, false)); )
@@ -255,3 +354,7 @@ DEF_BENCH( return SkNEW_ARGS(AAClipBench, (true, false)); )
 DEF_BENCH( return SkNEW_ARGS(AAClipBench, (true, true)); )
 DEF_BENCH( return SkNEW_ARGS(NestedAAClipBench, (false)); )
 DEF_BENCH( return SkNEW_ARGS(NestedAAClipBench, (true)); )
+DEF_BENCH( return SkNEW_ARGS(RepeatedClipBench, (false, false)); )
+DEF_BENCH( return SkNEW_ARGS(RepeatedClipBench, (true, false)); )
+DEF_BENCH( return SkNEW_ARGS(RepeatedClipBench, (false, true)); )
+DEF_BENCH( return SkNEW_ARGS(RepeatedClipBench, (true, true)); )
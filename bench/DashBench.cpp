@@ -439,6 +439,50 @@ private:
     typedef Benchmark INHERITED;
 };
 
+// Long paths dashed with tiny intervals make hundreds of thousands of dash segments.
+class LongDashBench : public Benchmark {
+    SkString fName;
+    SkPath   fPath;
+    SkPaint  fPaint;
+
+public:
+    LongDashBench(bool polyline, SkScalar interval, SkScalar width, bool doAA) {
+        fName.printf("longdash_%s_%g_%g%s", polyline ? "poly" : "line", interval, width,
+                     doAA ? "_aa" : "_bw");
+
+        if (polyline) {
+            SkRandom rand;
+            fPath.moveTo(rand.nextUScalar1() * 640, rand.nextUScalar1() * 480);
+            for (int i = 0; i < 1000; ++i) {
+                fPath.lineTo(rand.nextUScalar1() * 640, rand.nextUScalar1() * 480);
+            }
+        } else {
+            fPath.moveTo(-20000, 20);
+            fPath.lineTo(20000, 460);
+        }
+
+        const SkScalar intervals[] = { interval, interval };
+        fPaint.setPathEffect(SkDashPathEffect::Create(intervals, 2, 0))->unref();
+        fPaint.setStyle(SkPaint::kStroke_Style);
+        fPaint.setStrokeWidth(width);
+        fPaint.setAntiAlias(doAA);
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onDraw(const int loops, SkCanvas* canvas) override {
+        for (int i = 0; i < loops; ++i) {
+            canvas->drawPath(fPath, fPaint);
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static const SkScalar gDots[] = { SK_Scalar1, SK_Scalar1 };
@@ -485,4 +529,10 @@ DEF_BENCH( return new DashGridBench(1, 1, true); )
 DEF_BENCH( return new DashGridBench(1, 1, false); )
 DEF_BENCH( return new DashGridBench(3, 1, true); )
 DEF_BENCH( return new DashGridBench(3, 1, false); )
+
+DEF_BENCH( return new LongDashBench(true, SK_Scalar1, 0, false); )
+DEF_BENCH( return new LongDashBench(true, SK_Scalar1, 0, true); )
+DEF_BENCH( return new LongDashBench(true, SK_Scalar1 / 4, 0, true); )
+DEF_BENCH( return new LongDashBench(false, 2 * SK_Scalar1, 3, false); )
+DEF_BENCH( return new LongDashBench(false, 2 * SK_Scalar1, 3, true); )
 #endif
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Benchmark.h"
+#include "SkDiscardableMemoryPool.h"
+#include "SkRandom.h"
+#include "SkString.h"
+#include "SkTaskGroup.h"
+#include "SkTemplates.h"
+
+SK_DECLARE_STATIC_MUTEX(gBenchPoolMutex);
+
+// Exercises a pool the way the image caches do: from several threads at once, either locking and
+// unlocking long-lived allocations, or creating and deleting short-lived ones.
+class DiscardableMemoryPoolBench : public Benchmark {
+public:
+    enum Mode {
+        kLockUnlock_Mode,
+        kChurn_Mode,
+    };
+
+    DiscardableMemoryPoolBench(Mode mode, int threads) : fMode(mode), fThreads(threads) {
+        fName.printf("discardablememorypool_%s_%d",
+                     kLockUnlock_Mode == mode ? "lockunlock" : "churn", threads);
+    }
+
+    ~DiscardableMemoryPoolBench() override {
+        if (fPool) {
+            for (int i = 0; i < kThreads * kPerThread; ++i) {
+                SkDELETE(fMemory[i]);
+            }
+        }
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return kNonRendering_Backend == backend;
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onPreDraw() override {
+        if (fPool) {
+            return;
+        }
+        fPool.reset(SkDiscardableMemoryPool::Create(kBudget, &gBenchPoolMutex));
+        fMemory.reset(kThreads * kPerThread);
+        SkRandom rand;
+        for (int i = 0; i < kThreads * kPerThread; ++i) {
+            fMemory[i] = fPool->create(64 + rand.nextULessThan(4096));
+            fMemory[i]->unlock();
+        }
+    }
+
+
+    void onDraw(const int loops, SkCanvas*) override {
+        Task tasks[kThreads];
+        for (int i = 0; i < fThreads; ++i) {
+            tasks[i].fBench = this;
+            tasks[i].fIndex = i;
+            tasks[i].fLoops = loops;
+        }
+        if (1 == fThreads) {
+            Run(&tasks[0]);
+        } else {
+            SkTaskGroup().batch(Run, tasks, fThreads);  // ~SkTaskGroup() waits.
+        }
+    }
+
+private:
+    static const int    kThreads = 8;
+    static const int    kPerThread = 64;
+    static const size_t kBudget = 8 * 1024 * 1024;
+
+    struct Task {
+        DiscardableMemoryPoolBench* fBench;
+        int                         fIndex;
+        int                         fLoops;
+    };
+
+    static void Run(Task* task) {
+        DiscardableMemoryPoolBench* bench = task->fBench;
+        SkDiscardableMemory** memory = bench->fMemory.get() + task->fIndex * kPerThread;
+        for (int loop = 0; loop < task->fLoops; ++loop) {
+            for (int i = 0; i < kPerThread; ++i) {
+                if (kLockUnlock_Mode == bench->fMode) {
+                    if (memory[i]->lock()) {
+                        memory[i]->unlock();
+                    }
+                } else {
+                    SkDELETE(memory[i]);
+                    memory[i] = bench->fPool->create(64 + ((loop + i) & 63) * 64);
+                    memory[i]->unlock();
+                }
+            }
+        }
+    }
+
+    Mode                                    fMode;
+    int                                     fThreads;
+    SkString                                fName;
+    SkAutoTUnref<SkDiscardableMemoryPool>   fPool;
+    SkAutoTMalloc<SkDiscardableMemory*>     fMemory;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new DiscardableMemoryPoolBench(DiscardableMemoryPoolBench::kLockUnlock_Mode, 1); )
+DEF_BENCH( return new DiscardableMemoryPoolBench(DiscardableMemoryPoolBench::kLockUnlock_Mode, 8); )
+DEF_BENCH( return new DiscardableMemoryPoolBench(DiscardableMemoryPoolBench::kChurn_Mode, 1); )
+DEF_BENCH( return new DiscardableMemoryPoolBench(DiscardableMemoryPoolBench::kChurn_Mode, 8); )
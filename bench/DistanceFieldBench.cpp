@@ -0,0 +1,107 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Benchmark.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkDistanceFieldGen.h"
+#include "SkPaint.h"
+#include "SkString.h"
+#include "SkTemplates.h"
+
+// Generates distance fields for a run of glyph-sized A8 masks, the way the GPU text and path
+// renderers do.
+class DistanceFieldBench : public Benchmark {
+public:
+    enum Mode {
+        kSweeps_Mode,       // SkGenerateDistanceFieldFromA8Image()
+        kGenerator_Mode,    // One SkDistanceFieldGenerator for all the masks
+        kBatch_Mode,        // SkGenerateDistanceFields()
+    };
+
+    DistanceFieldBench(Mode mode, int glyphSize) : fMode(mode), fGlyphSize(glyphSize) {
+        static const char* kModeNames[] = { "sweeps", "generator", "batch" };
+        fName.printf("distancefield_%s_%d", kModeNames[mode], glyphSize);
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return kNonRendering_Backend == backend;
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onPreDraw() override {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setTextSize(SkIntToScalar(fGlyphSize) * 3 / 4);
+        for (int i = 0; i < kGlyphCount; ++i) {
+            fMasks[i].allocPixels(SkImageInfo::MakeA8(fGlyphSize, fGlyphSize));
+            fMasks[i].eraseColor(SK_ColorTRANSPARENT);
+            SkCanvas canvas(fMasks[i]);
+            const char c = 'A' + i;
+            canvas.drawText(&c, 1, SkIntToScalar(fGlyphSize) / 8,
+                            SkIntToScalar(fGlyphSize) * 3 / 4, paint);
+        }
+        fFields.reset(kGlyphCount * SkComputeDistanceFieldSize(fGlyphSize, fGlyphSize));
+    }
+
+    void onDraw(const int loops, SkCanvas*) override {
+        const size_t fieldSize = SkComputeDistanceFieldSize(fGlyphSize, fGlyphSize);
+        SkDistanceFieldJob jobs[kGlyphCount];
+        for (int i = 0; i < kGlyphCount; ++i) {
+            jobs[i].fDistanceField = fFields.get() + i * fieldSize;
+            jobs[i].fImage = (const unsigned char*)fMasks[i].getPixels();
+            jobs[i].fWidth = fGlyphSize;
+            jobs[i].fHeight = fGlyphSize;
+            jobs[i].fRowBytes = fMasks[i].rowBytes();
+            jobs[i].fIsBW = false;
+        }
+
+        SkDistanceFieldGenerator generator;
+        for (int loop = 0; loop < loops; ++loop) {
+            switch (fMode) {
+                case kSweeps_Mode:
+                    for (int i = 0; i < kGlyphCount; ++i) {
+                        SkGenerateDistanceFieldFromA8Image(jobs[i].fDistanceField, jobs[i].fImage,
+                                                           fGlyphSize, fGlyphSize,
+                                                           jobs[i].fRowBytes);
+                    }
+                    break;
+                case kGenerator_Mode:
+                    for (int i = 0; i < kGlyphCount; ++i) {
+                        generator.generateFromA8Image(jobs[i].fDistanceField, jobs[i].fImage,
+                                                      fGlyphSize, fGlyphSize, jobs[i].fRowBytes);
+                    }
+                    break;
+                case kBatch_Mode:
+                    SkGenerateDistanceFields(jobs, kGlyphCount);
+                    break;
+            }
+        }
+    }
+
+private:
+    static const int kGlyphCount = 26;
+
+    Mode                    fMode;
+    int                     fGlyphSize;
+    SkString                fName;
+    SkBitmap                fMasks[kGlyphCount];
+    SkAutoTMalloc<uint8_t>  fFields;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new DistanceFieldBench(DistanceFieldBench::kSweeps_Mode, 32); )
+DEF_BENCH( return new DistanceFieldBench(DistanceFieldBench::kGenerator_Mode, 32); )
+DEF_BENCH( return new DistanceFieldBench(DistanceFieldBench::kBatch_Mode, 32); )
+DEF_BENCH( return new DistanceFieldBench(DistanceFieldBench::kSweeps_Mode, 128); )
+DEF_BENCH( return new DistanceFieldBench(DistanceFieldBench::kGenerator_Mode, 128); )
+DEF_BENCH( return new DistanceFieldBench(DistanceFieldBench::kBatch_Mode, 128); )
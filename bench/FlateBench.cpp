@@ -0,0 +1,121 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Benchmark.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkData.h"
+#include "SkFlate.h"
+#include "SkGradientShader.h"
+#include "SkImageEncoder.h"
+#include "SkStream.h"
+#include "SkString.h"
+
+// Something that looks like a PDF content stream: mostly text, very compressible.
+static SkData* make_content_stream(size_t size) {
+    SkDynamicMemoryWStream stream;
+    int i = 0;
+    while (stream.bytesWritten() < size) {
+        SkString op;
+        op.printf("%d %d m %d %d l S\nq 1 0 0 1 %d.5 %d cm /X%d Do Q\n",
+                  i % 613, i % 797, (i * 7) % 613, (i * 13) % 797, i % 31, i % 17, i % 5);
+        stream.writeText(op.c_str());
+        i++;
+    }
+    return stream.copyToData();
+}
+
+class DeflateBench : public Benchmark {
+public:
+    DeflateBench(size_t size, bool useWStream)
+        : fSize(size)
+        , fUseWStream(useWStream)
+        , fName(SkStringPrintf("deflate_%s_%dK", useWStream ? "wstream" : "data",
+                               SkToInt(size >> 10))) {}
+
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onPreDraw() override {
+        fData.reset(make_content_stream(fSize));
+    }
+
+    void onDraw(const int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            SkDynamicMemoryWStream compressed;
+            if (fUseWStream) {
+                SkDeflateWStream deflateWStream(&compressed);
+                deflateWStream.write(fData->data(), fData->size());
+            } else {
+                SkFlate::Deflate(fData.get(), &compressed);
+            }
+        }
+    }
+
+private:
+    size_t fSize;
+    bool fUseWStream;
+    SkString fName;
+    SkAutoTUnref<SkData> fData;
+};
+
+class EncodePNGBench : public Benchmark {
+public:
+    EncodePNGBench(int width, int height, bool opaque)
+        : fWidth(width)
+        , fHeight(height)
+        , fOpaque(opaque)
+        , fName(SkStringPrintf("encode_png_%dx%d_%s", width, height,
+                               opaque ? "opaque" : "alpha")) {}
+
+    const char* onGetName() override { return fName.c_str(); }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+    void onPreDraw() override {
+        fBitmap.allocN32Pixels(fWidth, fHeight, fOpaque);
+        fBitmap.eraseColor(fOpaque ? SK_ColorWHITE : SK_ColorTRANSPARENT);
+
+        SkCanvas canvas(fBitmap);
+        const SkPoint pts[] = { { 0, 0 }, { SkIntToScalar(fWidth), SkIntToScalar(fHeight) } };
+        const SkColor colors[] = { SK_ColorRED, 0x8000FF00, SK_ColorBLUE };
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        paint.setShader(SkGradientShader::CreateLinear(pts, colors, NULL, SK_ARRAY_COUNT(colors),
+                                                       SkShader::kMirror_TileMode))->unref();
+        for (int i = 0; i < 64; i++) {
+            canvas.drawCircle(SkIntToScalar((i * 97) % fWidth), SkIntToScalar((i * 61) % fHeight),
+                              SkIntToScalar(fWidth / 16 + i), paint);
+        }
+    }
+
+    void onDraw(const int loops, SkCanvas*) override {
+        for (int i = 0; i < loops; i++) {
+            SkDynamicMemoryWStream stream;
+            SkImageEncoder::EncodeStream(&stream, fBitmap, SkImageEncoder::kPNG_Type, 100);
+        }
+    }
+
+private:
+    int fWidth, fHeight;
+    bool fOpaque;
+    SkString fName;
+    SkBitmap fBitmap;
+};
+
+DEF_BENCH( return SkNEW_ARGS(DeflateBench, (64 * 1024, false)); )
+DEF_BENCH( return SkNEW_ARGS(DeflateBench, (4 * 1024 * 1024, false)); )
+DEF_BENCH( return SkNEW_ARGS(DeflateBench, (4 * 1024 * 1024, true)); )
+
+DEF_BENCH( return SkNEW_ARGS(EncodePNGBench, (256, 256, true)); )
+DEF_BENCH( return SkNEW_ARGS(EncodePNGBench, (2048, 2048, true)); )
+DEF_BENCH( return SkNEW_ARGS(EncodePNGBench, (2048, 2048, false)); )
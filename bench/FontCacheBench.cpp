@@ -8,6 +8,7 @@
 #include "Benchmark.h"
 #include "SkCanvas.h"
 #include "SkChecksum.h"
+#include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkString.h"
 #include "SkTemplates.h"
@@ -51,6 +52,59 @@ private:
     typedef Benchmark INHERITED;
 };
 
+/*  Draws (rasterizes) every glyph in gUniqueGlyphIDs under the smallest font cache budget, so
+    the time is dominated by how often glyph images are evicted and re-rasterized. Comparing the
+    packed and unpacked variants shows the hit-rate gain from packing glyph images, net of the
+    cost of unpacking them as they are drawn.
+ */
+class FontCacheImageBench : public Benchmark {
+public:
+    FontCacheImageBench(bool packed) : fPacked(packed) {
+        fName.printf("fontcache_images%s", packed ? "_packed" : "");
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onPerCanvasPreDraw(SkCanvas*) override {
+        fPrevPacked = SkGraphics::SetFontCachePackedImages(fPacked);
+        fPrevLimit = SkGraphics::SetFontCacheLimit(0);  // clamped to the minimum
+        SkGraphics::PurgeFontCache();
+    }
+
+    void onPerCanvasPostDraw(SkCanvas*) override {
+        SkGraphics::SetFontCachePackedImages(fPrevPacked);
+        SkGraphics::SetFontCacheLimit(fPrevLimit);
+        SkGraphics::PurgeFontCache();
+    }
+
+    void onDraw(const int loops, SkCanvas* canvas) override {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setTextEncoding(SkPaint::kGlyphID_TextEncoding);
+        paint.setTextSize(SkIntToScalar(24));
+
+        for (int i = 0; i < loops; ++i) {
+            const uint16_t* array = gUniqueGlyphIDs;
+            while (*array != gUniqueGlyphIDs_Sentinel) {
+                int count = count_glyphs(array);
+                canvas->drawText(array, count * sizeof(uint16_t), 0, SkIntToScalar(24), paint);
+                array += count + 1;    // skip the sentinel
+            }
+        }
+    }
+
+private:
+    SkString    fName;
+    bool        fPacked;
+    bool        fPrevPacked;
+    size_t      fPrevLimit;
+
+    typedef Benchmark INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 static uint32_t rotr(uint32_t value, unsigned bits) {
@@ -142,6 +196,8 @@ private:
 ///////////////////////////////////////////////////////////////////////////////
 
 DEF_BENCH( return new FontCacheBench(); )
+DEF_BENCH( return new FontCacheImageBench(false); )
+DEF_BENCH( return new FontCacheImageBench(true); )
 
 // undefine this to run the efficiency test
 //DEF_BENCH( return new FontCacheEfficiency(); )
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Benchmark.h"
+#include "SamplePipeControllers.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkGPipe.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkString.h"
+
+/**
+ *  Measures the time per frame of drawing frames into a raster canvas, either directly, or by
+ *  recording them into an SkGPipeWriter on this thread for a ThreadedPipeController to draw on its
+ *  own thread:
+ *    direct:    draws each frame on this thread.
+ *    latency:   waits for each frame to be drawn before recording the next one, so each loop is
+ *               the end-to-end latency of a frame.
+ *    pipelined: records each frame while the previous one is drawn, waiting only for that.
+ */
+class GPipeFrameBench : public Benchmark {
+public:
+    enum Mode {
+        kDirect_Mode,
+        kLatency_Mode,
+        kPipelined_Mode,
+    };
+
+    GPipeFrameBench(Mode mode) : fMode(mode) {
+        static const char* gNames[] = { "direct", "latency", "pipelined" };
+        fName.printf("gpipe_frame_%s", gNames[mode]);
+    }
+
+    bool isSuitableFor(Backend backend) override {
+        return backend == kNonRendering_Backend;
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onPreDraw() override {
+        fBitmap.allocN32Pixels(kSize, kSize);
+        for (int i = 0; i < kPaths; ++i) {
+            SkPath& path = fPaths[i];
+            path.reset();
+            path.moveTo(SkIntToScalar(i * 7 % kSize), 0);
+            path.quadTo(SkIntToScalar(kSize - i), SkIntToScalar(i * 13 % kSize),
+                        SkIntToScalar(i * 3), SkIntToScalar(kSize));
+            path.lineTo(SkIntToScalar(kSize), SkIntToScalar(i * 5 % kSize));
+        }
+    }
+
+    void onDraw(const int loops, SkCanvas*) override {
+        SkCanvas canvas(fBitmap);
+        if (kDirect_Mode == fMode) {
+            for (int i = 0; i < loops; ++i) {
+                this->drawFrame(&canvas, i);
+            }
+            return;
+        }
+
+        ThreadedPipeController controller(&canvas);
+        SkGPipeWriter writer;
+        SkCanvas* pipeCanvas = writer.startRecording(&controller,
+                                                     SkGPipeWriter::kCrossProcess_Flag,
+                                                     kSize, kSize);
+        for (int i = 0; i < loops; ++i) {
+            this->drawFrame(pipeCanvas, i);
+            const int frame = controller.endFrame(&writer);
+            if (kLatency_Mode == fMode) {
+                controller.waitForFrame(frame);
+            } else if (frame > 0) {
+                controller.waitForFrame(frame - 1);
+            }
+        }
+        writer.endRecording();
+    }
+
+private:
+    enum {
+        kSize = 256,
+        kPaths = 40,
+    };
+
+    void drawFrame(SkCanvas* canvas, int frame) {
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        canvas->drawColor(SK_ColorWHITE);
+        for (int i = 0; i < kPaths; ++i) {
+            paint.setColor(0xFF000000 | (i * 0x060402 + frame * 0x010203));
+            paint.setStyle(i & 1 ? SkPaint::kStroke_Style : SkPaint::kFill_Style);
+            paint.setStrokeWidth(SkIntToScalar(i % 5));
+            canvas->save();
+            canvas->translate(SkIntToScalar(frame % 7), 0);
+            canvas->drawPath(fPaths[i], paint);
+            canvas->restore();
+            canvas->drawCircle(SkIntToScalar(i * 6), SkIntToScalar(i * 11 % kSize), 9, paint);
+        }
+        paint.setTextSize(20);
+        canvas->drawText("frame", 5, 10, 30, paint);
+    }
+
+    Mode     fMode;
+    SkString fName;
+    SkBitmap fBitmap;
+    SkPath   fPaths[kPaths];
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new GPipeFrameBench(GPipeFrameBench::kDirect_Mode); )
+DEF_BENCH( return new GPipeFrameBench(GPipeFrameBench::kLatency_Mode); )
+DEF_BENCH( return new GPipeFrameBench(GPipeFrameBench::kPipelined_Mode); )
@@ -8,11 +8,13 @@
 #include "Benchmark.h"
 #include "SkBitmap.h"
 #include "SkCanvas.h"
+#include "SkColorMatrixFilter.h"
 #include "SkColorPriv.h"
 #include "SkGradientShader.h"
 #include "SkPaint.h"
 #include "SkShader.h"
 #include "SkString.h"
+#include "SkXfermode.h"
 
 struct GradData {
     int             fCount;
@@ -387,3 +389,62 @@ private:
 
 DEF_BENCH( return new Gradient2Bench(false); )
 DEF_BENCH( return new Gradient2Bench(true); )
+
+///////////////////////////////////////////////////////////////////////////////
+
+// A gradient through a color filter and xfermode, which the raster blitters run together.
+class GradientFilterBench : public Benchmark {
+    SkString                    fName;
+    SkAutoTUnref<SkShader>      fShader;
+    SkAutoTUnref<SkColorFilter> fFilter;
+    SkXfermode::Mode            fMode;
+    enum {
+        W   = 400,
+        H   = 400,
+    };
+
+public:
+    GradientFilterBench(bool matrix, SkXfermode::Mode mode) : fMode(mode) {
+        fName.printf("gradient_linear_filter_%s_%s", matrix ? "matrix" : "tint",
+                     SkXfermode::ModeName(mode));
+
+        const SkPoint pts[2] = { { 0, 0 }, { SkIntToScalar(W), SkIntToScalar(H) } };
+        const SkColor colors[] = { 0x80FF0000, SK_ColorBLUE };
+        fShader.reset(SkGradientShader::CreateLinear(pts, colors, NULL, SK_ARRAY_COUNT(colors),
+                                                     SkShader::kClamp_TileMode));
+        if (matrix) {
+            SkColorMatrix cm;
+            cm.setSaturation(0.3f);
+            fFilter.reset(SkColorMatrixFilter::Create(cm));
+        } else {
+            fFilter.reset(SkColorFilter::CreateModeFilter(0x80FF8000, SkXfermode::kSrcATop_Mode));
+        }
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onDraw(const int loops, SkCanvas* canvas) override {
+        SkPaint paint;
+        this->setupPaint(&paint);
+        paint.setShader(fShader);
+        paint.setColorFilter(fFilter);
+        paint.setXfermodeMode(fMode);
+
+        const SkRect r = { 0, 0, SkIntToScalar(W), SkIntToScalar(H) };
+        for (int i = 0; i < loops; i++) {
+            canvas->drawRect(r, paint);
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new GradientFilterBench(false, SkXfermode::kSrcOver_Mode); )
+DEF_BENCH( return new GradientFilterBench(true,  SkXfermode::kSrcOver_Mode); )
+DEF_BENCH( return new GradientFilterBench(false, SkXfermode::kSrcATop_Mode); )
+DEF_BENCH( return new GradientFilterBench(true,  SkXfermode::kSrcATop_Mode); )
+DEF_BENCH( return new GradientFilterBench(true,  SkXfermode::kDstIn_Mode); )
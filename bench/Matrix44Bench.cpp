@@ -292,6 +292,40 @@ private:
     typedef Matrix44Bench INHERITED;
 };
 
+template <typename T>
+class Map2Matrix44Bench : public Matrix44Bench {
+public:
+    Map2Matrix44Bench(const char name[], bool persp)
+        : INHERITED(name)
+        , fMatrix(SkMatrix44::kIdentity_Constructor)
+    {
+        fMatrix.setRotateDegreesAbout(0, 0, 1, 30);
+        fMatrix.postTranslate(1, 2, 3);
+        if (persp) {
+            fMatrix.set(3, 0, 0.01f);
+            fMatrix.set(3, 1, 0.02f);
+        }
+        SkRandom rand;
+        for (int i = 0; i < 2 * N; ++i) {
+            fSrc2[i] = rand.nextSScalar1();
+        }
+    }
+protected:
+    virtual void performTest() {
+        for (int i = 0; i < 100; ++i) {
+            fMatrix.map2(fSrc2, N, fDst4);
+        }
+    }
+private:
+    enum {
+        N = 32
+    };
+    SkMatrix44 fMatrix;
+    T          fSrc2[2 * N];
+    T          fDst4[4 * N];
+    typedef Matrix44Bench INHERITED;
+};
+
 DEF_BENCH( return new SetIdentityMatrix44Bench(); )
 DEF_BENCH( return new EqualsMatrix44Bench(); )
 DEF_BENCH( return new PreScaleMatrix44Bench(); )
@@ -302,3 +336,7 @@ DEF_BENCH( return new InvertScaleTranslateMatrix44Bench(); )
 DEF_BENCH( return new InvertTranslateMatrix44Bench(); )
 DEF_BENCH( return new SetConcatMatrix44Bench(); )
 DEF_BENCH( return new GetTypeMatrix44Bench(); )
+DEF_BENCH( return new Map2Matrix44Bench<float>("map2_affine_float", false); )
+DEF_BENCH( return new Map2Matrix44Bench<float>("map2_persp_float", true); )
+DEF_BENCH( return new Map2Matrix44Bench<double>("map2_affine_double", false); )
+DEF_BENCH( return new Map2Matrix44Bench<double>("map2_persp_double", true); )
@@ -270,6 +270,12 @@ DEF_BENCH( return new InvertMapRectMatrixBench(
 static SkMatrix make_trans() { return SkMatrix::MakeTrans(2, 3); }
 static SkMatrix make_scale() { SkMatrix m(make_trans()); m.postScale(1.5f, 0.5f); return m; }
 static SkMatrix make_afine() { SkMatrix m(make_trans()); m.postRotate(15); return m; }
+static SkMatrix make_persp() {
+    SkMatrix m(make_afine());
+    m.setPerspX(0.001f);
+    m.setPerspY(0.002f);
+    return m;
+}
 
 class MapPointsMatrixBench : public MatrixBench {
 protected:
@@ -298,4 +304,44 @@ DEF_BENCH( return new MapPointsMatrixBench("mappoints_identity", SkMatrix::I());
 DEF_BENCH( return new MapPointsMatrixBench("mappoints_trans", make_trans()); )
 DEF_BENCH( return new MapPointsMatrixBench("mappoints_scale", make_scale()); )
 DEF_BENCH( return new MapPointsMatrixBench("mappoints_affine", make_afine()); )
+DEF_BENCH( return new MapPointsMatrixBench("mappoints_persp", make_persp()); )
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Maps N rects either one at a time with mapRect(), or all at once with mapRects().
+class MapRectsMatrixBench : public MatrixBench {
+    SkMatrix fM;
+    bool     fBatch;
+    enum {
+        N = 32
+    };
+    SkRect fSrc[N], fDst[N];
+public:
+    MapRectsMatrixBench(const char name[], const SkMatrix& m, bool batch)
+        : MatrixBench(name), fM(m), fBatch(batch)
+    {
+        SkRandom rand;
+        for (int i = 0; i < N; ++i) {
+            SkScalar x = rand.nextSScalar1(), y = rand.nextSScalar1();
+            fSrc[i].setLTRB(x, y, x + rand.nextUScalar1(), y + rand.nextUScalar1());
+        }
+    }
 
+    void performTest() override {
+        for (int i = 0; i < 100000; ++i) {
+            if (fBatch) {
+                fM.mapRects(fDst, fSrc, N);
+            } else {
+                for (int j = 0; j < N; ++j) {
+                    fM.mapRect(&fDst[j], fSrc[j]);
+                }
+            }
+        }
+    }
+};
+DEF_BENCH( return new MapRectsMatrixBench("maprect_scale", make_scale(), false); )
+DEF_BENCH( return new MapRectsMatrixBench("maprects_scale", make_scale(), true); )
+DEF_BENCH( return new MapRectsMatrixBench("maprect_affine", make_afine(), false); )
+DEF_BENCH( return new MapRectsMatrixBench("maprects_affine", make_afine(), true); )
+DEF_BENCH( return new MapRectsMatrixBench("maprect_persp", make_persp(), false); )
+DEF_BENCH( return new MapRectsMatrixBench("maprects_persp", make_persp(), true); )
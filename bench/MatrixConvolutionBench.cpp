@@ -13,16 +13,33 @@
 
 class MatrixConvolutionBench : public Benchmark {
 public:
-    MatrixConvolutionBench(SkMatrixConvolutionImageFilter::TileMode tileMode, bool convolveAlpha)
+    MatrixConvolutionBench(SkMatrixConvolutionImageFilter::TileMode tileMode, bool convolveAlpha,
+                           int size = 3, bool separable = false)
         : fName("matrixconvolution") {
-        SkISize kernelSize = SkISize::Make(3, 3);
-        SkScalar kernel[9] = {
-            SkIntToScalar( 1), SkIntToScalar( 1), SkIntToScalar( 1),
-            SkIntToScalar( 1), SkIntToScalar(-7), SkIntToScalar( 1),
-            SkIntToScalar( 1), SkIntToScalar( 1), SkIntToScalar( 1),
-        };
-        SkScalar gain = 0.3f, bias = SkIntToScalar(100);
-        SkIPoint kernelOffset = SkIPoint::Make(1, 1);
+        if (size != 3 || separable) {
+            fName.appendf("_%dx%d%s", size, size, separable ? "_separable" : "");
+        }
+        SkISize kernelSize = SkISize::Make(size, size);
+        SkAutoTMalloc<SkScalar> kernel(size * size);
+        SkScalar sum = 0;
+        for (int y = 0; y < size; ++y) {
+            for (int x = 0; x < size; ++x) {
+                SkScalar k;
+                if (separable) {
+                    // A tent filter, the outer product of two 1D tents.
+                    k = SkIntToScalar((SkTMin(x, size - 1 - x) + 1) * (SkTMin(y, size - 1 - y) + 1));
+                } else {
+                    // Ones, with a center that makes them sum to 1.
+                    k = (x == size / 2 && y == size / 2) ? SkIntToScalar(2 - size * size)
+                                                         : SK_Scalar1;
+                }
+                kernel[y * size + x] = k;
+                sum += k;
+            }
+        }
+        SkScalar gain = separable ? SkScalarInvert(sum) : 0.3f;
+        SkScalar bias = separable ? 0 : SkIntToScalar(100);
+        SkIPoint kernelOffset = SkIPoint::Make(size / 2, size / 2);
         fFilter = SkMatrixConvolutionImageFilter::Create(kernelSize, kernel, gain, bias, kernelOffset, tileMode, convolveAlpha);
     }
 
@@ -58,3 +75,8 @@ DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kCl
 DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kRepeat_TileMode, true); )
 DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kClampToBlack_TileMode, true); )
 DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kClampToBlack_TileMode, false); )
+DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kClamp_TileMode, true, 5); )
+DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kClamp_TileMode, true, 9); )
+DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kClamp_TileMode, true, 3, true); )
+DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kClamp_TileMode, true, 9, true); )
+DEF_BENCH( return new MatrixConvolutionBench(SkMatrixConvolutionImageFilter::kRepeat_TileMode, false, 9, true); )
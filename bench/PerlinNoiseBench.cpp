@@ -7,23 +7,36 @@
 #include "Benchmark.h"
 #include "SkCanvas.h"
 #include "SkPerlinNoiseShader.h"
+#include "SkString.h"
 
 class PerlinNoiseBench : public Benchmark {
     SkISize fSize;
+    SkPerlinNoiseShader::Type fType;
+    bool fStitchTiles;
+    SkString fName;
 
 public:
-    PerlinNoiseBench()  {
+    PerlinNoiseBench(SkPerlinNoiseShader::Type type = SkPerlinNoiseShader::kFractalNoise_Type,
+                     bool stitchTiles = false)
+        : fType(type)
+        , fStitchTiles(stitchTiles) {
         fSize = SkISize::Make(80, 80);
+        fName.set("perlinnoise");
+        if (SkPerlinNoiseShader::kTurbulence_Type == type) {
+            fName.append("_turbulence");
+        }
+        if (stitchTiles) {
+            fName.append("_stitched");
+        }
     }
 
 protected:
     const char* onGetName() override {
-        return "perlinnoise";
+        return fName.c_str();
     }
 
     void onDraw(const int loops, SkCanvas* canvas) override {
-        this->test(loops, canvas, 0, 0, SkPerlinNoiseShader::kFractalNoise_Type,
-                   0.1f, 0.1f, 3, 0, false);
+        this->test(loops, canvas, 0, 0, fType, 0.1f, 0.1f, 3, 0, fStitchTiles);
     }
 
 private:
@@ -60,3 +73,5 @@ private:
 ///////////////////////////////////////////////////////////////////////////////
 
 DEF_BENCH( return new PerlinNoiseBench(); )
+DEF_BENCH( return new PerlinNoiseBench(SkPerlinNoiseShader::kTurbulence_Type); )
+DEF_BENCH( return new PerlinNoiseBench(SkPerlinNoiseShader::kFractalNoise_Type, true); )
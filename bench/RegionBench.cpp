@@ -35,6 +35,42 @@ static bool diffrectbig_proc(SkRegion& a, SkRegion& b) {
     return result.op(a, a.getBounds(), SkRegion::kDifference_Op);
 }
 
+static bool sectrect_proc(SkRegion& a, SkRegion& b) {
+    SkIRect r = a.getBounds();
+    r.inset(r.width()/4, r.height()/4);
+    SkRegion result;
+    return result.op(a, r, SkRegion::kIntersect_Op);
+}
+
+// Accumulates b's rects into a, like a raster clip that is clipped to many rects in a row.
+static bool unionchain_proc(SkRegion& a, SkRegion& b) {
+    SkRegion result(a);
+    for (SkRegion::Iterator iter(b); !iter.done(); iter.next()) {
+        result.op(iter.rect(), SkRegion::kUnion_Op);
+    }
+    return !result.isEmpty();
+}
+
+static bool unionchainscratch_proc(SkRegion& a, SkRegion& b) {
+    SkRegion result(a);
+    SkRegion::OpScratch scratch;
+    for (SkRegion::Iterator iter(b); !iter.done(); iter.next()) {
+        result.op(iter.rect(), SkRegion::kUnion_Op, &scratch);
+    }
+    return !result.isEmpty();
+}
+
+static bool sectchainscratch_proc(SkRegion& a, SkRegion& b) {
+    SkRegion result(a);
+    SkRegion::OpScratch scratch;
+    SkIRect r = a.getBounds();
+    for (int i = 0; i < 8; ++i) {
+        r.inset(r.width()/16, r.height()/16);
+        result.op(r, SkRegion::kIntersect_Op, &scratch);
+    }
+    return !result.isEmpty();
+}
+
 static bool containsrect_proc(SkRegion& a, SkRegion& b) {
     SkIRect r = a.getBounds();
     r.inset(r.width()/4, r.height()/4);
@@ -126,6 +162,10 @@ DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, sect_proc, "intersect")); )
 DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, diff_proc, "difference")); )
 DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, diffrect_proc, "differencerect")); )
 DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, diffrectbig_proc, "differencerectbig")); )
+DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, sectrect_proc, "intersectrect")); )
+DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, unionchain_proc, "unionchain")); )
+DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, unionchainscratch_proc, "unionchainscratch")); )
+DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, sectchainscratch_proc, "intersectchain")); )
 DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, containsrect_proc, "containsrect")); )
 DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, sectsrgn_proc, "intersectsrgn")); )
 DEF_BENCH( return SkNEW_ARGS(RegionBench, (SMALL, sectsrect_proc, "intersectsrect")); )
@@ -15,6 +15,19 @@ static bool sect_proc(SkRegion& a, SkRegion& b) {
     return result.op(a, b, SkRegion::kIntersect_Op);
 }
 
+// Clips the region to a rect that shrinks a little more each time, as a raster clip would be.
+static bool sectchain_proc(SkRegion& a, SkRegion& b) {
+    SkRegion result(a);
+    SkRegion::OpScratch scratch;
+    SkIRect r = b.getBounds();
+    for (int i = 0; i < 10; ++i) {
+        r.fTop += 3;
+        r.fRight -= 7;
+        result.op(r, SkRegion::kIntersect_Op, &scratch);
+    }
+    return !result.isEmpty();
+}
+
 class RegionContainBench : public Benchmark {
 public:
     typedef bool (*Proc)(SkRegion& a, SkRegion& b);
@@ -65,3 +78,4 @@ private:
 };
 
 DEF_BENCH( return SkNEW_ARGS(RegionContainBench, (sect_proc, "sect")); )
+DEF_BENCH( return SkNEW_ARGS(RegionContainBench, (sectchain_proc, "sect_chain")); )
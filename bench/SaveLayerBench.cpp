@@ -0,0 +1,84 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Benchmark.h"
+#include "SkCanvas.h"
+#include "SkPicture.h"
+#include "SkPictureRecorder.h"
+#include "SkRTree.h"
+#include "SkString.h"
+
+// Draws a handful of small, translucent layers each loop, as animations often do. Unbounded
+// layers are as big as the clip, so each one used to cost a full-size allocation and clear.
+// The picture variants replay the same layers from an SkPicture, with and without the
+// SkLayerInfo that lets playback bound each layer to what is drawn into it.
+class SaveLayerBench : public Benchmark {
+public:
+    enum Mode {
+        kDirect_Mode,
+        kPicture_Mode,
+        kPictureLayerInfo_Mode,
+    };
+
+    SaveLayerBench(Mode mode) : fMode(mode) {
+        static const char* kNames[] = { "direct", "picture", "picture_layerinfo" };
+        fName.printf("savelayer_%s", kNames[mode]);
+    }
+
+protected:
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onPreDraw() override {
+        if (kDirect_Mode == fMode) {
+            return;
+        }
+        SkRTreeFactory factory;
+        SkPictureRecorder recorder;
+        uint32_t flags = kPictureLayerInfo_Mode == fMode
+                       ? SkPictureRecorder::kComputeSaveLayerInfo_RecordFlag : 0;
+        this->drawLayers(recorder.beginRecording(640, 480, &factory, flags));
+        fPicture.reset(recorder.endRecording());
+    }
+
+    void onDraw(const int loops, SkCanvas* canvas) override {
+        for (int i = 0; i < loops; ++i) {
+            if (fPicture) {
+                canvas->drawPicture(fPicture);
+            } else {
+                this->drawLayers(canvas);
+            }
+        }
+    }
+
+private:
+    void drawLayers(SkCanvas* canvas) {
+        SkPaint layerPaint;
+        layerPaint.setAlpha(0x80);
+        SkPaint paint;
+        paint.setColor(SK_ColorBLUE);
+        for (int i = 0; i < kLayers; ++i) {
+            // Two overlapping draws, so SkRecordOptimize can't fold the layer away.
+            const SkRect r = SkRect::MakeXYWH(SkIntToScalar(40 * i), SkIntToScalar(30 * i), 50, 50);
+            canvas->saveLayer(NULL, &layerPaint);
+            canvas->drawRect(r, paint);
+            canvas->drawOval(r.makeOffset(10, 10), paint);
+            canvas->restore();
+        }
+    }
+
+    static const int kLayers = 8;
+
+    Mode                    fMode;
+    SkString                fName;
+    SkAutoTUnref<SkPicture> fPicture;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return SkNEW_ARGS(SaveLayerBench, (SaveLayerBench::kDirect_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(SaveLayerBench, (SaveLayerBench::kPicture_Mode)); )
+DEF_BENCH( return SkNEW_ARGS(SaveLayerBench, (SaveLayerBench::kPictureLayerInfo_Mode)); )
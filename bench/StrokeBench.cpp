@@ -7,6 +7,7 @@
 
 #include "Benchmark.h"
 #include "SkCanvas.h"
+#include "SkDashPathEffect.h"
 #include "SkPaint.h"
 #include "SkRRect.h"
 #include "SkString.h"
@@ -102,3 +103,60 @@ DEF_BENCH( return new StrokeRRectBench(SkPaint::kMiter_Join, draw_rrect); )
 DEF_BENCH( return new StrokeRRectBench(SkPaint::kRound_Join, draw_oval); )
 DEF_BENCH( return new StrokeRRectBench(SkPaint::kBevel_Join, draw_oval); )
 DEF_BENCH( return new StrokeRRectBench(SkPaint::kMiter_Join, draw_oval); )
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Draws the same stroked path over and over, like a chart redrawn every frame. Unless the path is
+// volatile, every draw after the first should find its stroke in the cache.
+class StrokeRepeatBench : public Benchmark {
+    SkString fName;
+    SkPath   fPath;
+    SkPaint  fPaint;
+public:
+    StrokeRepeatBench(bool curves, bool dashed, bool isVolatile) {
+        fName.printf("draw_stroke_repeat_%s%s%s", curves ? "quads" : "lines",
+                     dashed ? "_dashed" : "", isVolatile ? "_volatile" : "");
+
+        fPath.moveTo(0, 100);
+        for (int i = 1; i <= 100; ++i) {
+            const SkScalar x = SkIntToScalar(i * 6);
+            const SkScalar y = SkIntToScalar(100 + (i * 37) % 90 - (i * 11) % 50);
+            if (curves) {
+                fPath.quadTo(x - 3, SkIntToScalar((i * 53) % 200), x, y);
+            } else {
+                fPath.lineTo(x, y);
+            }
+        }
+        fPath.setIsVolatile(isVolatile);
+
+        fPaint.setAntiAlias(true);
+        fPaint.setStyle(SkPaint::kStroke_Style);
+        fPaint.setStrokeWidth(3);
+        fPaint.setStrokeJoin(SkPaint::kRound_Join);
+        if (dashed) {
+            const SkScalar intervals[] = { 8, 4 };
+            fPaint.setPathEffect(SkDashPathEffect::Create(intervals, 2, 0))->unref();
+        }
+    }
+
+protected:
+    const char* onGetName() override {
+        return fName.c_str();
+    }
+
+    void onDraw(const int loops, SkCanvas* canvas) override {
+        for (int i = 0; i < loops; ++i) {
+            canvas->drawPath(fPath, fPaint);
+        }
+    }
+
+private:
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new StrokeRepeatBench(false, false, false); )
+DEF_BENCH( return new StrokeRepeatBench(false, false, true); )
+DEF_BENCH( return new StrokeRepeatBench(true, false, false); )
+DEF_BENCH( return new StrokeRepeatBench(true, false, true); )
+DEF_BENCH( return new StrokeRepeatBench(true, true, false); )
+DEF_BENCH( return new StrokeRepeatBench(true, true, true); )
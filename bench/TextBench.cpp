@@ -9,6 +9,7 @@
 #include "Benchmark.h"
 #include "Resources.h"
 #include "SkCanvas.h"
+#include "SkGraphics.h"
 #include "SkPaint.h"
 #include "SkRandom.h"
 #include "SkStream.h"
@@ -48,15 +49,19 @@ class TextBench : public Benchmark {
     FontQuality fFQ;
     bool        fDoPos;
     bool        fDoColorEmoji;
+    bool        fDoPackedGlyphs;
+    bool        fPrevPackedGlyphs;
     SkAutoTUnref<SkTypeface> fColorEmojiTypeface;
     SkPoint*    fPos;
 public:
     TextBench(const char text[], int ps,
-              SkColor color, FontQuality fq, bool doColorEmoji = false, bool doPos = false)  {
+              SkColor color, FontQuality fq, bool doColorEmoji = false, bool doPos = false,
+              bool doPackedGlyphs = false)  {
         fPos = NULL;
         fFQ = fq;
         fDoPos = doPos;
         fDoColorEmoji = doColorEmoji;
+        fDoPackedGlyphs = doPackedGlyphs;
         fText.set(text);
 
         fPaint.setAntiAlias(kBW != fq);
@@ -109,10 +114,28 @@ protected:
         if (fDoColorEmoji && fColorEmojiTypeface) {
             fName.append("_ColorEmoji");
         }
+        if (fDoPackedGlyphs) {
+            fName.append("_packed");
+        }
 
         return fName.c_str();
     }
 
+    virtual void onPerCanvasPreDraw(SkCanvas*) {
+        if (fDoPackedGlyphs) {
+            // Only new strikes pick up the setting.
+            fPrevPackedGlyphs = SkGraphics::SetFontCachePackedImages(true);
+            SkGraphics::PurgeFontCache();
+        }
+    }
+
+    virtual void onPerCanvasPostDraw(SkCanvas*) {
+        if (fDoPackedGlyphs) {
+            SkGraphics::SetFontCachePackedImages(fPrevPackedGlyphs);
+            SkGraphics::PurgeFontCache();
+        }
+    }
+
     virtual void onDraw(const int loops, SkCanvas* canvas) {
         const SkIPoint dim = this->getSize();
         SkRandom rand;
@@ -174,3 +197,8 @@ DEF_BENCH( return new TextBench(STR, 16, 0x88FF0000, kBW, true); )
 
 DEF_BENCH( return new TextBench(STR, 16, 0xFF000000, kBW, true, true); )
 DEF_BENCH( return new TextBench(STR, 16, 0xFF000000, kAA, false, true); )
+
+DEF_BENCH( return new TextBench(STR, 16, 0xFF000000, kBW, false, false, true); )
+DEF_BENCH( return new TextBench(STR, 16, 0xFF000000, kAA, false, false, true); )
+DEF_BENCH( return new TextBench(STR, 48, 0xFF000000, kAA, false, false, true); )
+DEF_BENCH( return new TextBench(STR, 48, 0xFF000000, kAA); )
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "Benchmark.h"
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkPaint.h"
+#include "SkRandom.h"
+#include "SkString.h"
+#include "SkTemplates.h"
+#include "SkTextureCompressor.h"
+
+// Compresses a large anti-aliased alpha mask. With opt, the platform's encoders and several
+// threads are used; without, the portable encoder runs on this thread. The mask is 1008x1008
+// (divisible by both 16 and 12), so megapixels per second is about 1 / the seconds per loop.
+class TextureCompressionBench : public Benchmark {
+public:
+    TextureCompressionBench(SkTextureCompressor::Format format, const char* formatName, bool opt)
+        : fFormat(format)
+        , fOpt(opt)
+        , fName(SkStringPrintf("texturecompression_%s%s", formatName, opt ? "" : "_portable")) {}
+
+    bool isSuitableFor(Backend backend) override { return backend == kNonRendering_Backend; }
+    const char* onGetName() override { return fName.c_str(); }
+
+    void onPreDraw() override {
+        fMask.allocPixels(SkImageInfo::MakeA8(kWidth, kHeight));
+        SkCanvas canvas(fMask);
+        canvas.clear(0);
+        SkPaint paint;
+        paint.setAntiAlias(true);
+        SkRandom rand;
+        for (int i = 0; i < 200; ++i) {
+            paint.setAlpha(rand.nextRangeU(64, 255));
+            canvas.drawCircle(rand.nextUScalar1() * kWidth, rand.nextUScalar1() * kHeight,
+                              rand.nextRangeScalar(4, 80), paint);
+        }
+        fCompressed.reset(SkTextureCompressor::GetCompressedDataSize(fFormat, kWidth, kHeight));
+    }
+
+    void onDraw(const int loops, SkCanvas*) override {
+        SkAutoLockPixels alp(fMask);
+        for (int i = 0; i < loops; ++i) {
+            SkTextureCompressor::CompressBufferToFormat(
+                    fCompressed.get(), static_cast<const uint8_t*>(fMask.getPixels()),
+                    kAlpha_8_SkColorType, kWidth, kHeight, fMask.rowBytes(), fFormat, fOpt);
+        }
+    }
+
+private:
+    static const int kWidth = 1008;
+    static const int kHeight = 1008;
+
+    SkTextureCompressor::Format fFormat;
+    bool                        fOpt;
+    SkString                    fName;
+    SkBitmap                    fMask;
+    SkAutoTMalloc<uint8_t>      fCompressed;
+
+    typedef Benchmark INHERITED;
+};
+
+DEF_BENCH( return new TextureCompressionBench(SkTextureCompressor::kLATC_Format, "latc", true); )
+DEF_BENCH( return new TextureCompressionBench(SkTextureCompressor::kLATC_Format, "latc", false); )
+DEF_BENCH( return new TextureCompressionBench(SkTextureCompressor::kR11_EAC_Format, "r11eac", true); )
+DEF_BENCH( return new TextureCompressionBench(SkTextureCompressor::kR11_EAC_Format, "r11eac", false); )
+DEF_BENCH( return new TextureCompressionBench(SkTextureCompressor::kASTC_12x12_Format, "astc12x12", true); )
+DEF_BENCH( return new TextureCompressionBench(SkTextureCompressor::kASTC_12x12_Format, "astc12x12", false); )
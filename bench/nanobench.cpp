@@ -11,11 +11,13 @@
 
 #include "Benchmark.h"
 #include "CodecBench.h"
+#include "CpuStageTracer.h"
 #include "CrashHandler.h"
 #include "DecodingBench.h"
 #include "DecodingSubsetBench.h"
 #include "GMBench.h"
 #include "ProcStats.h"
+#include "RecordProfiler.h"
 #include "ResultsWriter.h"
 #include "RecordingBench.h"
 #include "SKPBench.h"
@@ -27,8 +29,10 @@
 #include "SkCodec.h"
 #include "SkCommonFlags.h"
 #include "SkData.h"
+#include "SkEventTracer.h"
 #include "SkForceLinking.h"
 #include "SkGraphics.h"
+#include "SkLayerPool.h"
 #include "SkOSFile.h"
 #include "SkPictureRecorder.h"
 #include "SkPictureUtils.h"
@@ -87,6 +91,20 @@ DEFINE_bool(mpd, true, "Use MultiPictureDraw for the SKPs?");
 DEFINE_int32(flushEvery, 10, "Flush --outResultsFile every Nth run.");
 DEFINE_bool(resetGpuContext, true, "Reset the GrContext before running each test.");
 DEFINE_bool(gpuStats, false, "Print GPU stats after each gpu benchmark?");
+DEFINE_bool(cpuStages, false, "Break down the CPU time of each gpu benchmark by Ganesh stage "
+                              "(batching, flush, program lookup, buffer mapping) and log it. "
+                              "Most useful with --config nullgpu.  Adds tracing overhead.");
+
+DEFINE_int32(layerPoolMB, 0, "If positive, let raster saveLayer()s reuse up to this many MB of "
+                             "freed layer memory (see SkGraphics::SetLayerPoolByteLimit).");
+DEFINE_bool(layerStats, false, "Log how many raster saveLayer()s per loop needed fresh memory "
+                               "and how many reused memory from SkLayerPool (see --layerPoolMB).");
+DEFINE_string(hotspots, "", "If given, profile raster playback of each SKP op by op, and write a "
+                            "JSON report of the costliest ops for each SKP and config here.");
+DEFINE_int32(hotspotLoops, 3, "Playbacks per SKP when profiling with --hotspots.");
+
+// Installed as the SkEventTracer (which owns it) when --cpuStages is set.
+static CpuStageTracer* gStageTracer = NULL;
 
 static SkString humanize(double ms) {
     if (FLAGS_verbose) return SkStringPrintf("%llu", (uint64_t)(ms*1e6));
@@ -291,6 +309,9 @@ static int cpu_bench(const double overhead, Target* target, Benchmark* bench, do
         loops = detect_forever_loops(loops);
     }
 
+    if (FLAGS_layerStats) {
+        SkLayerPool::ResetStats();
+    }
     for (int i = 0; i < FLAGS_samples; i++) {
         samples[i] = time(loops, bench, target) / loops;
     }
@@ -337,6 +358,9 @@ static int gpu_bench(Target* target,
     }
 
     // Now, actually do the timing!
+    if (gStageTracer) {
+        gStageTracer->reset();
+    }
     for (int i = 0; i < FLAGS_samples; i++) {
         samples[i] = time(loops, bench, target) / loops;
     }
@@ -344,6 +368,70 @@ static int gpu_bench(Target* target,
     return loops;
 }
 
+// Profiles the SKP's playback into the target's canvas op by op, and writes the hotspots to
+// <--hotspots>/<bench>_<config>.json.
+static void write_hotspots(const SkPicture* pic, SkScalar scale, SkCanvas* canvas,
+                           const char* benchName, const char* config) {
+    RecordProfiler profiler;
+    {
+        SkAutoCanvasRestore acr(canvas, true);
+        canvas->scale(scale, scale);
+        profiler.profile(pic, canvas, FLAGS_hotspotLoops);
+    }
+
+    SkString name = SkStringPrintf("%s_%s", benchName, config);
+    SkString json;
+    profiler.appendJSON(&json, name.c_str());
+    json.append("\n");
+    SkString path = SkOSPath::Join(FLAGS_hotspots[0], name.c_str());
+    path.append(".json");
+    SkFILEWStream out(path.c_str());
+    if (!out.isValid() || !out.write(json.c_str(), json.size())) {
+        SkDebugf("Could not write %s.\n", path.c_str());
+        return;
+    }
+    if (FLAGS_verbose) {
+        profiler.dump(10);
+    }
+}
+
+#if SK_SUPPORT_GPU
+// Logs and prints the per-loop CPU time gStageTracer saw in each Ganesh stage during the timed
+// samples.  Anything not inside flush is charged to recording (SkGpuDevice down to GrBatch).
+static void report_cpu_stages(ResultsWriter* log, double meanMs, int timedLoops) {
+    if (timedLoops <= 0) {
+        return;
+    }
+    const double flushMs = gStageTracer->ms("GrStage::flush") / timedLoops;
+    log->metric("GrStage::recording_ms", SkTMax(0.0, meanMs - flushMs));
+    SkDebugf("\t%s\tGrStage::recording\n", HUMANIZE(SkTMax(0.0, meanMs - flushMs)));
+    for (int i = 0; i < gStageTracer->count(); i++) {
+        const double ms = gStageTracer->ms(i) / timedLoops;
+        log->metric(SkStringPrintf("%s_ms", gStageTracer->name(i)).c_str(), ms);
+        SkDebugf("\t%s\t%s\n", HUMANIZE(ms), gStageTracer->name(i));
+    }
+}
+#endif
+
+// Logs and prints the SkLayerPool activity per loop during cpu_bench's timed samples.
+static void report_layer_stats(ResultsWriter* log, int timedLoops) {
+    if (timedLoops <= 0) {
+        return;
+    }
+    SkLayerPool::Stats stats;
+    SkLayerPool::GetStats(&stats);
+    const double allocs = (double)stats.fAllocations / timedLoops,
+                 allocKB = stats.fAllocatedBytes / 1024.0 / timedLoops,
+                 reuses = (double)stats.fReuses / timedLoops,
+                 reuseKB = stats.fReusedBytes / 1024.0 / timedLoops;
+    log->metric("layer_allocs", allocs);
+    log->metric("layer_alloc_KB", allocKB);
+    log->metric("layer_reuses", reuses);
+    log->metric("layer_reuse_KB", reuseKB);
+    SkDebugf("\tlayers/loop: %.2f allocated (%.1fKB), %.2f reused (%.1fKB)\n",
+             allocs, allocKB, reuses, reuseKB);
+}
+
 static SkString to_lower(const char* str) {
     SkString lower(str);
     for (size_t i = 0; i < lower.size(); i++) {
@@ -566,6 +654,7 @@ public:
     }
 
     Benchmark* next() {
+        fPlaybackPic.reset(NULL);
         if (fBenches) {
             Benchmark* bench = fBenches->factory()(NULL);
             fBenches = fBenches->next();
@@ -624,6 +713,7 @@ public:
                     SkString name = SkOSPath::Basename(path.c_str());
                     fSourceType = "skp";
                     fBenchType = "playback";
+                    fPlaybackPic.reset(SkRef(pic.get()));
                     return SkNEW_ARGS(SKPBench,
                             (name.c_str(), pic.get(), fClip,
                              fScales[fCurrentScale], fUseMPDs[fCurrentUseMPD++]));
@@ -761,6 +851,10 @@ public:
         return NULL;
     }
 
+    // The picture and scale of the current bench, if it plays back an SKP.
+    const SkPicture* playbackPicture() const { return fPlaybackPic; }
+    SkScalar playbackScale() const { return fScales[fCurrentScale]; }
+
     void fillCurrentOptions(ResultsWriter* log) const {
         log->configOption("source_type", fSourceType);
         log->configOption("bench_type",  fBenchType);
@@ -787,6 +881,7 @@ private:
     SkTArray<SkScalar> fScales;
     SkTArray<SkString> fSKPs;
     SkTArray<bool>     fUseMPDs;
+    SkAutoTUnref<SkPicture> fPlaybackPic;
     SkTArray<SkString> fImages;
     SkTArray<SkColorType> fColorTypes;
 
@@ -812,6 +907,12 @@ int nanobench_main() {
     SkTaskGroup::Enabler enabled;
 
 #if SK_SUPPORT_GPU
+    if (FLAGS_cpuStages) {
+        // Must happen before any traced code runs: the trace macros cache their category flag.
+        gStageTracer = SkNEW(CpuStageTracer);
+        SkEventTracer::SetInstance(gStageTracer);
+    }
+
     GrContext::Options grContextOpts;
     grContextOpts.fDrawPathToCompressedTexture = FLAGS_gpuCompressAlphaMasks;
     gGrFactory.reset(SkNEW_ARGS(GrContextFactory, (grContextOpts)));
@@ -821,11 +922,20 @@ int nanobench_main() {
         FLAGS_verbose = true;
     }
 
+    if (FLAGS_layerPoolMB > 0) {
+        SkGraphics::SetLayerPoolByteLimit((size_t)FLAGS_layerPoolMB * 1024 * 1024);
+    }
+
     if (kAutoTuneLoops != FLAGS_loops) {
         FLAGS_samples     = 1;
         FLAGS_gpuFrameLag = 0;
     }
 
+    if (!FLAGS_hotspots.isEmpty() && !sk_mkdir(FLAGS_hotspots[0])) {
+        SkDebugf("Could not create %s. Hotspots won't be written.\n", FLAGS_hotspots[0]);
+        FLAGS_hotspots.set(0, NULL);
+    }
+
     if (!FLAGS_writePath.isEmpty()) {
         SkDebugf("Writing files to %s.\n", FLAGS_writePath[0]);
         if (!sk_mkdir(FLAGS_writePath[0])) {
@@ -960,12 +1070,24 @@ int nanobench_main() {
                         , bench->getUniqueName()
                         );
             }
+            if (FLAGS_layerStats && !targets[j]->needsFrameTiming()) {
+                report_layer_stats(log.get(), loops * FLAGS_samples);
+            }
+            if (!FLAGS_hotspots.isEmpty() && FLAGS_hotspots[0] && canvas &&
+                Benchmark::kRaster_Backend == targets[j]->config.backend &&
+                benchStream.playbackPicture()) {
+                write_hotspots(benchStream.playbackPicture(), benchStream.playbackScale(),
+                               canvas, bench->getUniqueName(), targets[j]->config.name);
+            }
 #if SK_SUPPORT_GPU
             if (FLAGS_gpuStats &&
                 Benchmark::kGPU_Backend == targets[j]->config.backend) {
                 gGrFactory->get(targets[j]->config.ctxType)->printCacheStats();
                 gGrFactory->get(targets[j]->config.ctxType)->printGpuStats();
             }
+            if (gStageTracer && Benchmark::kGPU_Backend == targets[j]->config.backend) {
+                report_cpu_stages(log.get(), stats.mean, loops * FLAGS_samples);
+            }
 #endif
         }
         targets.deleteAll();
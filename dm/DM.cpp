@@ -46,6 +46,17 @@ DEFINE_string(uninterestingHashesFile, "",
         "File containing a list of uninteresting hashes. If a result hashes to something in "
         "this list, no image is written for that result.");
 
+DEFINE_string(shard, "", "If set to i/N, run only the i'th of N deterministic shards of the "
+        "Src/Sink pairs and unit tests, writing FLAGS_writePath[0]/dm-i-of-N.json.");
+
+DEFINE_string(journal, "",
+        "If set, append each task to this file as it finishes, and skip tasks it already lists. "
+        "A crashed run started again with the same journal picks up where it stopped.");
+
+DEFINE_string(mergeJson, "",
+        "Space-separated dm.json files (e.g. from each --shard) to merge into "
+        "FLAGS_writePath[0]/dm.json.  Nothing else is run.");
+
 __SK_FORCE_IMAGE_DECODER_LINKING;
 using namespace DM;
 
@@ -65,11 +76,17 @@ static int32_t gPending = 0;  // Atomic.  Total number of running and queued tas
 SK_DECLARE_STATIC_MUTEX(gRunningMutex);
 static SkTArray<SkString> gRunning;
 
+static SkString task_id(const char* config, const char* src, const char* srcOptions,
+                        const char* name) {
+    return SkStringPrintf("%s %s %s %s", config, src, srcOptions, name);
+}
+
+static SkString gJsonName("dm.json");
+
 static void done(double ms,
                  ImplicitString config, ImplicitString src, ImplicitString srcOptions,
                  ImplicitString name, ImplicitString note, ImplicitString log) {
-    SkString id = SkStringPrintf("%s %s %s %s", config.c_str(), src.c_str(),
-                                                srcOptions.c_str(), name.c_str());
+    SkString id = task_id(config.c_str(), src.c_str(), srcOptions.c_str(), name.c_str());
     {
         SkAutoMutexAcquire lock(gRunningMutex);
         for (int i = 0; i < gRunning.count(); i++) {
@@ -96,14 +113,13 @@ static void done(double ms,
     // We write our dm.json file every once in a while in case we crash.
     // Notice this also handles the final dm.json when pending == 0.
     if (pending % 500 == 0) {
-        JsonWriter::DumpJson();
+        JsonWriter::DumpJson(gJsonName.c_str());
     }
 }
 
 static void start(ImplicitString config, ImplicitString src,
                   ImplicitString srcOptions, ImplicitString name) {
-    SkString id = SkStringPrintf("%s %s %s %s", config.c_str(), src.c_str(),
-                                                srcOptions.c_str(), name.c_str());
+    SkString id = task_id(config.c_str(), src.c_str(), srcOptions.c_str(), name.c_str());
     SkAutoMutexAcquire lock(gRunningMutex);
     gRunning.push_back(id);
 }
@@ -156,6 +172,108 @@ static void gather_uninteresting_hashes() {
 
 /*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
 
+// Tasks are assigned to shards by a hash of their id, so every process given the same flags agrees
+// on the partition no matter what order it gathers its Srcs and Sinks in.
+static int gShard = 0, gShardCount = 1;
+
+static bool parse_shard() {
+    if (FLAGS_shard.isEmpty()) {
+        return true;
+    }
+    if (2 != sscanf(FLAGS_shard[0], "%d/%d", &gShard, &gShardCount) ||
+        gShardCount < 1 || gShard < 0 || gShard >= gShardCount) {
+        SkDebugf("--shard must be i/N with 0 <= i < N, not %s\n", FLAGS_shard[0]);
+        return false;
+    }
+    gJsonName.printf("dm-%d-of-%d.json", gShard, gShardCount);
+    return true;
+}
+
+static bool in_shard(const SkString& id) {
+    return 1 == gShardCount || (int)(SkGoodHash(id) % gShardCount) == gShard;
+}
+
+// Each line of the journal is a finished task: its config, src, srcOptions and name, then the md5
+// and extension of its result if it had one, all separated by tabs.  Results are replayed into the
+// JsonWriter when we resume, so the dm.json we finish with covers the whole run.
+static SkTHashSet<SkString> gJournaled;
+static FILE* gJournal = NULL;
+SK_DECLARE_STATIC_MUTEX(gJournalMutex);
+
+static void split_tabs(const SkString& line, SkTArray<SkString>* fields) {
+    const char* str = line.c_str();
+    for (;;) {
+        const char* tab = strchr(str, '\t');
+        if (!tab) {
+            fields->push_back(SkString(str));
+            return;
+        }
+        fields->push_back(SkString(str, tab - str));
+        str = tab + 1;
+    }
+}
+
+static bool open_journal() {
+    if (FLAGS_journal.isEmpty()) {
+        return true;
+    }
+    SkAutoTUnref<SkData> data(SkData::NewFromFileName(FLAGS_journal[0]));
+    bool cutShort = false;
+    if (data && data->size() > 0) {
+        cutShort = '\n' != data->bytes()[data->size() - 1];
+        SkString text((const char*)data->data(), data->size());
+        SkTArray<SkString> lines;
+        SkStrSplit(text.c_str(), "\n", &lines);
+        for (int i = 0; i < lines.count(); i++) {
+            SkTArray<SkString> fields;
+            split_tabs(lines[i], &fields);
+            if (fields.count() != 6) {
+                continue;  // Probably a line cut short when we crashed.
+            }
+            gJournaled.add(task_id(fields[0].c_str(), fields[1].c_str(),
+                                   fields[2].c_str(), fields[3].c_str()));
+            if (!fields[4].isEmpty()) {
+                JsonWriter::BitmapResult result;
+                result.config        = fields[0];
+                result.sourceType    = fields[1];
+                result.sourceOptions = fields[2];
+                result.name          = fields[3];
+                result.md5           = fields[4];
+                result.ext           = fields[5];
+                JsonWriter::AddBitmapResult(result);
+            }
+        }
+    }
+    gJournal = fopen(FLAGS_journal[0], "ab");
+    if (!gJournal) {
+        SkDebugf("Can't open %s to append to it.\n", FLAGS_journal[0]);
+        return false;
+    }
+    if (cutShort) {
+        fputc('\n', gJournal);  // Don't let our first line run on from a partial one.
+    }
+    return true;
+}
+
+// Returns true if this process should run the task with this id.
+static bool should_run(const SkString& id) {
+    return in_shard(id) && !gJournaled.contains(id);
+}
+
+static void journal(const char* config, const char* src, const char* srcOptions,
+                    const char* name, const char* md5, const char* ext) {
+    if (!gJournal || FLAGS_dryRun) {
+        return;
+    }
+    SkString line = SkStringPrintf("%s\t%s\t%s\t%s\t%s\t%s\n",
+                                   config, src, srcOptions, name, md5, ext);
+    SkAutoMutexAcquire lock(gJournalMutex);
+    fwrite(line.c_str(), 1, line.size(), gJournal);
+    fflush(gJournal);
+}
+
+/*~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~*/
+
 template <typename T>
 struct Tagged : public SkAutoTDelete<T> {
   const char* tag;
@@ -440,6 +558,9 @@ struct Task {
             note.appendf(" (--blacklist %s)", whyBlacklisted.c_str());
         }
         SkString log;
+        SkString md5;
+        const char* ext = "";
+        bool ok = true;
         WallTimer timer;
         timer.start();
         if (!FLAGS_dryRun && whyBlacklisted.isEmpty()) {
@@ -458,6 +579,8 @@ struct Task {
                                         err.c_str()));
                 } else {
                     note.appendf(" (skipped: %s)", err.c_str());
+                    journal(task->sink.tag, task->src.tag, task->src.options, name.c_str(),
+                            "", "");
                 }
                 done(timer.fWall, task->sink.tag, task->src.tag, task->src.options,
                      name, note, log);
@@ -465,7 +588,6 @@ struct Task {
             }
             SkAutoTDelete<SkStreamAsset> data(stream.detachAsStream());
 
-            SkString md5;
             if (!FLAGS_writePath.isEmpty() || !FLAGS_readPath.isEmpty()) {
                 SkMD5 hash;
                 if (data->getLength()) {
@@ -491,23 +613,31 @@ struct Task {
                                     task->src.options,
                                     name.c_str(),
                                     FLAGS_readPath[0]));
+                ok = false;
             }
 
             if (!FLAGS_writePath.isEmpty()) {
-                const char* ext = task->sink->fileExtension();
+                ext = task->sink->fileExtension();
                 if (data->getLength()) {
-                    WriteToDisk(*task, md5, ext, data, data->getLength(), NULL);
+                    ok &= WriteToDisk(*task, md5, ext, data, data->getLength(), NULL);
                     SkASSERT(bitmap.drawsNothing());
                 } else if (!bitmap.drawsNothing()) {
-                    WriteToDisk(*task, md5, ext, NULL, 0, &bitmap);
+                    ok &= WriteToDisk(*task, md5, ext, NULL, 0, &bitmap);
+                } else {
+                    ext = "";  // Nothing to write, so no result to record.
                 }
             }
         }
         timer.end();
+        // Failed tasks stay out of the journal, so a resumed run tries them again.
+        if (ok) {
+            journal(task->sink.tag, task->src.tag, task->src.options, name.c_str(),
+                    *ext ? md5.c_str() : "", ext);
+        }
         done(timer.fWall, task->sink.tag, task->src.tag, task->src.options, name, note, log);
     }
 
-    static void WriteToDisk(const Task& task,
+    static bool WriteToDisk(const Task& task,
                             SkString md5,
                             const char* ext,
                             SkStream* data, size_t len,
@@ -524,7 +654,7 @@ struct Task {
         // If an MD5 is uninteresting, we want it noted in the JSON file,
         // but don't want to dump it out as a .png (or whatever ext is).
         if (gUninterestingHashes.contains(md5)) {
-            return;
+            return true;
         }
 
         const char* dir = FLAGS_writePath[0];
@@ -539,7 +669,7 @@ struct Task {
             path.append(".");
             path.append(ext);
             if (sk_exists(path.c_str())) {
-                return;  // Content-addressed.  If it exists already, we're done.
+                return true;  // Content-addressed.  If it exists already, we're done.
             }
         } else {
             path = SkOSPath::Join(dir, task.sink.tag);
@@ -558,7 +688,7 @@ struct Task {
         SkFILEWStream file(path.c_str());
         if (!file.isValid()) {
             fail(SkStringPrintf("Can't open %s for writing.\n", path.c_str()));
-            return;
+            return false;
         }
 
         if (bitmap) {
@@ -567,20 +697,21 @@ struct Task {
             if (bitmap->info().colorType() == kAlpha_8_SkColorType) {
                 if (!bitmap->copyTo(&converted, kN32_SkColorType)) {
                     fail("Can't convert A8 to 8888.\n");
-                    return;
+                    return false;
                 }
                 bitmap = &converted;
             }
             if (!SkImageEncoder::EncodeStream(&file, *bitmap, SkImageEncoder::kPNG_Type, 100)) {
                 fail(SkStringPrintf("Can't encode PNG to %s.\n", path.c_str()));
-                return;
+                return false;
             }
         } else {
             if (!file.writeStream(data, len)) {
                 fail(SkStringPrintf("Can't write to %s.\n", path.c_str()));
-                return;
+                return false;
             }
         }
+        return true;
     }
 };
 
@@ -607,7 +738,8 @@ static void gather_tests() {
         // Despite its name, factory() is returning a reference to
         // link-time static const POD data.
         const skiatest::Test& test = r->factory();
-        if (SkCommandLineFlags::ShouldSkip(FLAGS_match, test.name)) {
+        if (SkCommandLineFlags::ShouldSkip(FLAGS_match, test.name) ||
+            !should_run(task_id("unit", "test", "", test.name))) {
             continue;
         }
         if (test.needsGpu && gpu_supported()) {
@@ -623,11 +755,13 @@ static void run_test(skiatest::Test* test) {
         void reportFailed(const skiatest::Failure& failure) override {
             fail(failure.toString());
             JsonWriter::AddTestFailure(failure);
+            failed = true;
         }
         bool allowExtendedTest() const override {
             return FLAGS_pathOpsExtended;
         }
         bool verbose() const override { return FLAGS_veryVerbose; }
+        bool failed = false;
     } reporter;
     WallTimer timer;
     timer.start();
@@ -637,6 +771,9 @@ static void run_test(skiatest::Test* test) {
         test->proc(&reporter, &factory);
     }
     timer.end();
+    if (!reporter.failed) {
+        journal("unit", "test", "", test->name, "", "");
+    }
     done(timer.fWall, "unit", "test", "", test->name, "", "");
 }
 
@@ -686,6 +823,24 @@ int dm_main() {
         SkInstCountPrintLeaksOnExit();
     }
 
+    if (!FLAGS_mergeJson.isEmpty()) {
+        if (FLAGS_writePath.isEmpty()) {
+            SkDebugf("--mergeJson needs --writePath to write the merged dm.json to.\n");
+            return 1;
+        }
+        for (int i = 0; i < FLAGS_mergeJson.count(); i++) {
+            if (!JsonWriter::MergeJson(FLAGS_mergeJson[i])) {
+                SkDebugf("Couldn't read %s to merge it.\n", FLAGS_mergeJson[i]);
+                return 1;
+            }
+        }
+        JsonWriter::DumpJson();
+        return 0;
+    }
+    if (!parse_shard() || !open_journal()) {
+        return 1;
+    }
+
     start_keepalive();
 
     gather_gold();
@@ -695,21 +850,40 @@ int dm_main() {
     gather_sinks();
     gather_tests();
 
-    gPending = gSrcs.count() * gSinks.count() + gThreadedTests.count() + gGPUTests.count();
-    SkDebugf("%d srcs * %d sinks + %d tests == %d tasks\n",
-             gSrcs.count(), gSinks.count(), gThreadedTests.count() + gGPUTests.count(), gPending);
-
     // We try to exploit as much parallelism as is safe.  Most Src/Sink pairs run on any thread,
     // but Sinks that identify as part of a particular enclave run serially on a single thread.
     // CPU tests run on any thread.  GPU tests depend on --gpu_threading.
     SkTArray<Task> enclaves[kNumEnclaves];
+    int srcSinkTasks = 0;
     for (int j = 0; j < gSinks.count(); j++) {
         SkTArray<Task>& tasks = enclaves[gSinks[j]->enclave()];
         for (int i = 0; i < gSrcs.count(); i++) {
-            tasks.push_back(Task(gSrcs[i], gSinks[j]));
+            if (should_run(task_id(gSinks[j].tag, gSrcs[i].tag, gSrcs[i].options,
+                                   gSrcs[i]->name().c_str()))) {
+                tasks.push_back(Task(gSrcs[i], gSinks[j]));
+                srcSinkTasks++;
+            }
         }
     }
 
+    gPending = srcSinkTasks + gThreadedTests.count() + gGPUTests.count();
+    SkDebugf("%d srcs * %d sinks + %d tests == %d tasks",
+             gSrcs.count(), gSinks.count(), gThreadedTests.count() + gGPUTests.count(),
+             gSrcs.count() * gSinks.count() + gThreadedTests.count() + gGPUTests.count());
+    if (gShardCount > 1 || gJournaled.count() > 0) {
+        SkDebugf(", %d to run here", gPending);
+    }
+    if (gShardCount > 1) {
+        SkDebugf(" in shard %d/%d", gShard, gShardCount);
+    }
+    if (gJournaled.count() > 0) {
+        SkDebugf(" after %d journaled", gJournaled.count());
+    }
+    SkDebugf("\n");
+    if (0 == gPending) {
+        JsonWriter::DumpJson(gJsonName.c_str());  // done() never will.
+    }
+
     SkTaskGroup tg;
     tg.batch(run_test, gThreadedTests.begin(), gThreadedTests.count());
     for (int i = 0; i < kNumEnclaves; i++) {
@@ -727,6 +901,9 @@ int dm_main() {
     }
     tg.wait();
     // At this point we're back in single-threaded land.
+    if (gJournal) {
+        fclose(gJournal);
+    }
 
     SkDebugf("\n");
     if (gFailures.count() > 0) {
@@ -34,12 +34,58 @@ void JsonWriter::AddTestFailure(const skiatest::Failure& failure) {
     gFailures.push_back(failure);
 }
 
-void JsonWriter::DumpJson() {
+// Everything read by MergeJson, in the form DumpJson writes it.
+static Json::Value gMerged;
+SK_DECLARE_STATIC_MUTEX(gMergedLock);
+
+static bool read_json(const char* path, Json::Value* root) {
+    SkAutoTUnref<SkData> json(SkData::NewFromFileName(path));
+    if (!json) {
+        return false;
+    }
+    Json::Reader reader;
+    const char* data = (const char*)json->data();
+    return reader.parse(data, data+json->size(), *root);
+}
+
+bool JsonWriter::MergeJson(const char* path) {
+    Json::Value root;
+    if (!read_json(path, &root)) {
+        return false;
+    }
+
+    SkAutoMutexAcquire lock(gMergedLock);
+    const Json::Value& results = root["results"];
+    for (unsigned i = 0; i < results.size(); i++) {
+        gMerged["results"].append(results[i]);
+    }
+    const Json::Value& failures = root["test_results"]["failures"];
+    for (unsigned i = 0; i < failures.size(); i++) {
+        gMerged["test_results"]["failures"].append(failures[i]);
+    }
+    if (root.isMember("max_rss_MB")) {
+        gMerged["max_rss_MB"] = SkTMax(gMerged["max_rss_MB"].asInt(), root["max_rss_MB"].asInt());
+    }
+    // Properties and keys are the same for every shard of a run, so the first file's will do.
+    const Json::Value::Members names = root.getMemberNames();
+    for (size_t i = 0; i < names.size(); i++) {
+        if (!gMerged.isMember(names[i])) {
+            gMerged[names[i]] = root[names[i]];
+        }
+    }
+    return true;
+}
+
+void JsonWriter::DumpJson(const char* name) {
     if (FLAGS_writePath.isEmpty()) {
         return;
     }
 
     Json::Value root;
+    {
+        SkAutoMutexAcquire lock(gMergedLock);
+        root = gMerged;
+    }
 
     for (int i = 1; i < FLAGS_properties.count(); i += 2) {
         root[FLAGS_properties[i-1]] = FLAGS_properties[i];
@@ -83,10 +129,10 @@ void JsonWriter::DumpJson() {
 
     int maxResidentSetSizeMB = sk_tools::getMaxResidentSetSizeMB();
     if (maxResidentSetSizeMB != -1) {
-        root["max_rss_MB"] = sk_tools::getMaxResidentSetSizeMB();
+        root["max_rss_MB"] = SkTMax(maxResidentSetSizeMB, root["max_rss_MB"].asInt());
     }
 
-    SkString path = SkOSPath::Join(FLAGS_writePath[0], "dm.json");
+    SkString path = SkOSPath::Join(FLAGS_writePath[0], name);
     sk_mkdir(FLAGS_writePath[0]);
     SkFILEWStream stream(path.c_str());
     stream.writeText(Json::StyledWriter().write(root).c_str());
@@ -94,15 +140,8 @@ void JsonWriter::DumpJson() {
 }
 
 bool JsonWriter::ReadJson(const char* path, void(*callback)(BitmapResult)) {
-    SkAutoTUnref<SkData> json(SkData::NewFromFileName(path));
-    if (!json) {
-        return false;
-    }
-
-    Json::Reader reader;
     Json::Value root;
-    const char* data = (const char*)json->data();
-    if (!reader.parse(data, data+json->size(), root)) {
+    if (!read_json(path, &root)) {
         return false;
     }
 
@@ -42,9 +42,16 @@ public:
     static void AddTestFailure(const skiatest::Failure&);
 
     /**
-     *  Write all collected results to the file FLAGS_writePath[0]/dm.json.
+     *  Write all collected results to the file FLAGS_writePath[0]/name.
      */
-    static void DumpJson();
+    static void DumpJson(const char* name = "dm.json");
+
+    /**
+     *  Add the results and test failures from the JSON file at path written by DumpJson (e.g. by
+     *  another DM process) to those collected here, so the next DumpJson writes them too.
+     *  Return success.
+     */
+    static bool MergeJson(const char* path);
 
     /**
      * Read JSON file at path written by DumpJson, calling callback for each
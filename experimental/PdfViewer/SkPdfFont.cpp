@@ -7,12 +7,17 @@
 
 #include "SkPdfFont.h"
 
+#include "SkMutex.h"
 #include "SkPdfNativeTokenizer.h"
 #include "SkStream.h"
 #include "SkTypeface.h"
 
+SK_DECLARE_STATIC_MUTEX(gStandardFontsMutex);
+
 SkTDict<SkPdfStandardFontEntry>& getStandardFonts() {
     static SkTDict<SkPdfStandardFontEntry> gPdfStandardFonts(100);
+    // Filled on first use, possibly by several rendering threads at once.
+    SkAutoMutexAcquire lock(gStandardFontsMutex);
 
     // TODO (edisonn): , vs - ? what does it mean?
     // TODO (edisonn): MT, PS, Oblique=italic?, ... what does it mean?
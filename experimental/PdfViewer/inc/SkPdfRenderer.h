@@ -13,6 +13,7 @@
 
 class SkBitmap;
 class SkCanvas;
+class SkData;
 class SkPdfNativeDoc;
 struct SkRect;
 class SkStream;
@@ -39,6 +40,10 @@ public:
     static SkPdfRenderer* CreateFromStream(SkStream*);
     // Create a new renderer from a file.
     static SkPdfRenderer* CreateFromFile(const char* filename);
+    // Create a new renderer from the bytes of a pdf. Refs data, so several renderers can share
+    // the same (e.g. mmapped) file. A renderer must only be used by one thread at a time, but
+    // renderers sharing data can render on different threads concurrently.
+    static SkPdfRenderer* CreateFromData(SkData*);
 
     ~SkPdfRenderer();
 
@@ -8,15 +8,19 @@
 #include "SkBitmapDevice.h"
 #include "SkCanvas.h"
 #include "SkCommandLineFlags.h"
+#include "SkData.h"
 #include "SkDevice.h"
 #include "SkGraphics.h"
 #include "SkImageDecoder.h"
 #include "SkImageEncoder.h"
+#include "SkMutex.h"
 #include "SkOSFile.h"
 #include "SkPdfConfig.h"
 #include "SkPdfRenderer.h"
 #include "SkPicture.h"
 #include "SkStream.h"
+#include "SkTaskGroup.h"
+#include "SkTDArray.h"
 #include "SkTypeface.h"
 #include "SkTArray.h"
 #include "SkNulCanvas.h"
@@ -41,6 +45,8 @@ DEFINE_string2(config, c, "8888", "Canvas to render:\n"
                                   "\tnul - render in null canvas, any draw will just return.\n"
                );
 DEFINE_bool2(transparentBackground, t, false, "Make background transparent instead of white.");
+DEFINE_int32(threads, -1, "Render pages on this many extra threads, or one per core if -1.\n"
+             "\t0 renders them one by one on the main thread.");
 
 /**
  * Given list of directories and files to use as input, expects to find .pdf
@@ -172,6 +178,66 @@ static bool render_page(const SkString& outputDir,
     return true;
 }
 
+/** Hands out renderers of one pdf to the threads rendering its pages.
+ *  Rendering a page caches what it parses in the renderer's document (decoded streams, fonts,
+ *  ...), so a renderer must only render one page at a time. When all the renderers are busy, the
+ *  pool creates another one on the same mapped file: documents parse their objects lazily, so this
+ *  only costs reading the xref and the page tree again.
+ */
+class RendererPool : SkNoncopyable {
+public:
+    // Takes ownership of renderer, which must have been created from data.
+    RendererPool(SkData* data, SkPdfRenderer* renderer) : fData(SkRef(data)) {
+        *fRenderers.append() = renderer;
+    }
+
+    ~RendererPool() {
+        fRenderers.deleteAll();
+    }
+
+    // Returns a renderer no other thread is using, or NULL if the pdf could not be loaded again.
+    SkPdfRenderer* acquire() {
+        {
+            SkAutoMutexAcquire lock(fMutex);
+            if (fRenderers.count() > 0) {
+                SkPdfRenderer* renderer;
+                fRenderers.pop(&renderer);
+                return renderer;
+            }
+        }
+        return SkPdfRenderer::CreateFromData(fData);
+    }
+
+    void release(SkPdfRenderer* renderer) {
+        SkAutoMutexAcquire lock(fMutex);
+        *fRenderers.append() = renderer;
+    }
+
+private:
+    SkAutoTUnref<SkData>        fData;
+    SkMutex                     fMutex;
+    SkTDArray<SkPdfRenderer*>   fRenderers;
+};
+
+struct PageTask {
+    const SkString* fOutputDir;
+    const SkString* fInputFilename;
+    RendererPool*   fPool;
+    int             fPage;
+    bool            fSuccess;
+};
+
+static void render_page_task(PageTask* task) {
+    SkPdfRenderer* renderer = task->fPool->acquire();
+    if (NULL == renderer) {
+        task->fSuccess = false;
+        return;
+    }
+    task->fSuccess = render_page(*task->fOutputDir, *task->fInputFilename, *renderer,
+                                 task->fPage);
+    task->fPool->release(renderer);
+}
+
 /** Reads an skp file, renders it to pdf and writes the output to a pdf file
  * @param inputPath The skp file to be read.
  * @param outputDir Output dir.
@@ -181,7 +247,10 @@ static bool process_pdf(const SkString& inputPath, const SkString& outputDir) {
 
     SkString inputFilename = SkOSPath::Basename(inputPath.c_str());
 
-    SkAutoTDelete<SkPdfRenderer> renderer(SkPdfRenderer::CreateFromFile(inputPath.c_str()));
+    // Map the file once; every renderer of it parses its pages straight out of the mapping.
+    SkAutoTUnref<SkData> data(SkData::NewFromFileName(inputPath.c_str()));
+    SkAutoTDelete<SkPdfRenderer> renderer(data.get() ? SkPdfRenderer::CreateFromData(data)
+                                                     : NULL);
     if (NULL == renderer.get()) {
         SkDebugf("Failure loading file %s\n", inputPath.c_str());
         return false;
@@ -212,30 +281,44 @@ static bool process_pdf(const SkString& inputPath, const SkString& outputDir) {
         return false;
     }
 
+    const int pages = renderer->pages();
+    const bool noExtension = FLAGS_noExtensionForOnePagePdf && pages == 1;
+    RendererPool pool(data, renderer.detach());
+
     bool success = true;
+    SkTDArray<PageTask> tasks;
     for (int i = 0; i < FLAGS_benchRender + 1; i++) {
         // TODO(edisonn) if (i == 1) start timer
+        tasks.rewind();
         if (strcmp(FLAGS_pages[0], "all") == 0) {
-            for (int pn = 0; pn < renderer->pages(); ++pn) {
-                success &= render_page(outputDir, inputFilename, *renderer,
-                        FLAGS_noExtensionForOnePagePdf && renderer->pages() == 1 ? -1 : pn);
+            for (int pn = 0; pn < pages; ++pn) {
+                PageTask task = { &outputDir, &inputFilename, &pool, noExtension ? -1 : pn, false };
+                *tasks.append() = task;
             }
         } else if (strcmp(FLAGS_pages[0], "reverse") == 0) {
-            for (int pn = renderer->pages() - 1; pn >= 0; --pn) {
-                success &= render_page(outputDir, inputFilename, *renderer,
-                        FLAGS_noExtensionForOnePagePdf && renderer->pages() == 1 ? -1 : pn);
+            for (int pn = pages - 1; pn >= 0; --pn) {
+                PageTask task = { &outputDir, &inputFilename, &pool, noExtension ? -1 : pn, false };
+                *tasks.append() = task;
             }
-        } else if (strcmp(FLAGS_pages[0], "first") == 0) {
-            success &= render_page(outputDir, inputFilename, *renderer,
-                    FLAGS_noExtensionForOnePagePdf && renderer->pages() == 1 ? -1 : 0);
-        } else if (strcmp(FLAGS_pages[0], "last") == 0) {
-            success &= render_page(outputDir, inputFilename, *renderer,
-                    FLAGS_noExtensionForOnePagePdf && renderer->pages() == 1 ? -1
-                    : renderer->pages() - 1);
         } else {
-            int pn = atoi(FLAGS_pages[0]);
-            success &= render_page(outputDir, inputFilename, *renderer,
-                    FLAGS_noExtensionForOnePagePdf && renderer->pages() == 1 ? -1 : pn);
+            int pn;
+            if (strcmp(FLAGS_pages[0], "first") == 0) {
+                pn = 0;
+            } else if (strcmp(FLAGS_pages[0], "last") == 0) {
+                pn = pages - 1;
+            } else {
+                pn = atoi(FLAGS_pages[0]);
+            }
+            PageTask task = { &outputDir, &inputFilename, &pool, noExtension ? -1 : pn, false };
+            *tasks.append() = task;
+        }
+
+        // Pages are independent, so rasterize them concurrently.
+        SkTaskGroup tg;
+        tg.batch(render_page_task, tasks.begin(), tasks.count());
+        tg.wait();
+        for (int t = 0; t < tasks.count(); t++) {
+            success &= tasks[t].fSuccess;
         }
     }
 
@@ -275,6 +358,7 @@ int tool_main(int argc, char** argv);
 int tool_main(int argc, char** argv) {
     SkCommandLineFlags::SetUsage("Parse and Render .pdf files (pdf viewer).");
     SkCommandLineFlags::Parse(argc, argv);
+    SkTaskGroup::Enabler enabled(FLAGS_threads);
 
     if (FLAGS_readPath.isEmpty()) {
         SkDebugf(".pdf files or directories are required.\n");
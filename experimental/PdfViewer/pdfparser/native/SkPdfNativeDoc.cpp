@@ -7,10 +7,7 @@
 
 #include "SkPdfNativeDoc.h"
 
-#include <stdio.h>
 #include <string.h>
-#include <sys/types.h>
-#include <sys/stat.h>
 
 #include "SkPdfMapper_autogen.h"
 #include "SkPdfNativeObject.h"
@@ -25,13 +22,6 @@
 //#include "SkPdfPageTreeNodeDictionary_autogen.h"
 #include "SkPdfHeaders_autogen.h"
 
-static long getFileSize(const char* filename)
-{
-    struct stat stat_buf;
-    int rc = stat(filename, &stat_buf);
-    return rc == 0 ? (long)stat_buf.st_size : -1;
-}
-
 static const unsigned char* lineHome(const unsigned char* start, const unsigned char* current) {
     while (current > start && !isPdfEOL(*(current - 1))) {
         current--;
@@ -76,11 +66,14 @@ SkPdfNativeDoc::SkPdfNativeDoc(SkStream* stream)
         , fContentLength(0)
         , fRootCatalogRef(NULL)
         , fRootCatalog(NULL) {
-    size_t size = stream->getLength();
-    void* ptr = sk_malloc_throw(size);
-    stream->read(ptr, size);
+    SkAutoTUnref<SkData> data(SkData::NewFromStream(stream, stream->getLength()));
+    if (NULL == data.get()) {
+        SkPdfReport(kFatalError_SkPdfIssueSeverity, kReadStreamError_SkPdfIssue,
+                    "could not read stream", NULL, NULL);
+        return;  // Doc will have 0 pages
+    }
 
-    init(ptr, size);
+    init(data);
 }
 
 SkPdfNativeDoc::SkPdfNativeDoc(const char* path)
@@ -90,29 +83,36 @@ SkPdfNativeDoc::SkPdfNativeDoc(const char* path)
         , fRootCatalogRef(NULL)
         , fRootCatalog(NULL) {
     gDoc = this;
-    FILE* file = fopen(path, "r");
-    // TODO(edisonn): put this in a function that can return NULL
-    if (file) {
-        size_t size = getFileSize(path);
-        void* content = sk_malloc_throw(size);
-        bool ok = (0 != fread(content, size, 1, file));
-        fclose(file);
-        if (!ok) {
-            sk_free(content);
-            SkPdfReport(kFatalError_SkPdfIssueSeverity, kReadStreamError_SkPdfIssue,
-                        "could not read file", NULL, NULL);
-            // TODO(edisonn): not nice to return like this from constructor, create a static
-            // function that can report NULL for failures.
-            return;  // Doc will have 0 pages
-        }
+    // Map the file rather than reading it, so opening a large pdf only touches the pages holding
+    // its xref, trailer, and the objects we actually parse.
+    SkAutoTUnref<SkData> data(SkData::NewFromFileName(path));
+    if (NULL == data.get()) {
+        SkPdfReport(kFatalError_SkPdfIssueSeverity, kReadStreamError_SkPdfIssue,
+                    "could not read file", NULL, NULL);
+        // TODO(edisonn): not nice to return like this from constructor, create a static
+        // function that can report NULL for failures.
+        return;  // Doc will have 0 pages
+    }
+
+    init(data);
+}
 
-        init(content, size);
-    }
+SkPdfNativeDoc::SkPdfNativeDoc(SkData* data)
+        : fAllocator(new SkPdfAllocator())
+        , fFileContent(NULL)
+        , fContentLength(0)
+        , fRootCatalogRef(NULL)
+        , fRootCatalog(NULL) {
+    init(data);
 }
 
-void SkPdfNativeDoc::init(const void* bytes, size_t length) {
-    fFileContent = (const unsigned char*)bytes;
-    fContentLength = length;
+void SkPdfNativeDoc::init(SkData* data) {
+    if (0 == data->size()) {
+        return;  // Doc will have 0 pages
+    }
+    fData.reset(SkRef(data));
+    fFileContent = data->bytes();
+    fContentLength = data->size();
     const unsigned char* eofLine = lineHome(fFileContent, fFileContent + fContentLength - 1);
     const unsigned char* xrefByteOffsetLine = previousLineHome(fFileContent, eofLine);
     const unsigned char* xrefstartKeywordLine = previousLineHome(fFileContent, xrefByteOffsetLine);
@@ -234,7 +234,6 @@ void SkPdfNativeDoc::loadWithoutXRef() {
 }
 
 SkPdfNativeDoc::~SkPdfNativeDoc() {
-    sk_free((void*)fFileContent);
     delete fAllocator;
 }
 
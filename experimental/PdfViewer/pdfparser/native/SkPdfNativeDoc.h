@@ -8,6 +8,7 @@
 #ifndef SkPdfNativeDoc_DEFINED
 #define SkPdfNativeDoc_DEFINED
 
+#include "SkData.h"
 #include "SkRect.h"
 #include "SkTDArray.h"
 
@@ -65,8 +66,14 @@ private:
 
 public:
     // TODO(edisonn) should be deprecated
+    // Maps the file in memory, rather than reading it.
     SkPdfNativeDoc(const char* path);
 
+    // Refs data, and parses the pdf directly out of its bytes. Objects are parsed lazily, the
+    // first time they are referenced, so several docs can cheaply share the same (e.g. mmapped)
+    // data, for example to render different pages on different threads.
+    SkPdfNativeDoc(SkData* data);
+
     // TODO(edisonn) should be deprecated
     // FIXME: Untested.
     // Does not affect ownership of stream.
@@ -121,8 +128,8 @@ public:
 
 private:
 
-    // Takes ownership of bytes.
-    void init(const void* bytes, size_t length);
+    // Refs data.
+    void init(SkData* data);
 
     // loads a pdf that has missing xref
     void loadWithoutXRef();
@@ -148,6 +155,7 @@ private:
 
     SkPdfAllocator* fAllocator;
     SkPdfMapper* fMapper;
+    SkAutoTUnref<SkData> fData;
     const unsigned char* fFileContent;
     size_t fContentLength;
     SkPdfNativeObject* fRootCatalogRef;
@@ -6,6 +6,7 @@
  */
 
 #include "SkPdfContext.h"
+#include "SkMutex.h"
 #include "SkPdfNativeDoc.h"
 #include "SkPdfReporter.h"
 #include "SkPdfTokenLooper.h"
@@ -58,6 +59,8 @@ public:
 };
 
 SkTDictWithDefaultConstructor<int> gRenderStats[kCount_SkPdfResult];
+// Shared by every page being rendered, whatever thread it is rendered on.
+SK_DECLARE_STATIC_MUTEX(gRenderStatsMutex);
 
 const char* gRenderStatsNames[kCount_SkPdfResult] = {
     "Success",
@@ -91,10 +94,12 @@ SkPdfResult PdfMainLooper::consumeToken(PdfToken& token) {
             // Main work is done by pdfOperatorRenderer(...)
             SkPdfResult result = pdfOperatorRenderer(fPdfContext, fCanvas, this);
 
+            SkAutoMutexAcquire lock(gRenderStatsMutex);
             int cnt = 0;
             gRenderStats[result].find(token.fKeyword, token.fKeywordLength, &cnt);
             gRenderStats[result].set(token.fKeyword, token.fKeywordLength, cnt + 1);
         } else {
+            SkAutoMutexAcquire lock(gRenderStatsMutex);
             int cnt = 0;
             gRenderStats[kUnsupported_SkPdfResult].find(token.fKeyword,
                                                         token.fKeywordLength,
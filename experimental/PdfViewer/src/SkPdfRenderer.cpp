@@ -7,6 +7,7 @@
 
 #include "SkPdfRenderer.h"
 
+#include "SkAtomics.h"
 #include "SkBitmapDevice.h"
 #include "SkCanvas.h"
 #include "SkColorPriv.h"
@@ -15,6 +16,7 @@
 #include "SkGraphics.h"
 #include "SkImageDecoder.h"
 #include "SkImageEncoder.h"
+#include "SkMutex.h"
 #include "SkOSFile.h"
 #include "SkPicture.h"
 #include "SkPdfFont.h"
@@ -356,9 +358,12 @@ SkPdfResult PdfOp_Q(SkPdfContext* pdfContext, SkCanvas* canvas, SkPdfTokenLooper
 SkPdfResult PdfOp_Tw(SkPdfContext* pdfContext, SkCanvas* canvas, SkPdfTokenLooper* parentLooper);
 SkPdfResult PdfOp_Tc(SkPdfContext* pdfContext, SkCanvas* canvas, SkPdfTokenLooper* parentLooper);
 
+SK_DECLARE_STATIC_MUTEX(gGrayColortableMutex);
+
 // TODO(edisonn): perf!!!
 static SkColorTable* getGrayColortable() {
     static SkColorTable* grayColortable = NULL;
+    SkAutoMutexAcquire lock(gGrayColortableMutex);
     if (grayColortable == NULL) {
         SkPMColor* colors = new SkPMColor[256];
         for (int i = 0 ; i < 256; i++) {
@@ -2765,6 +2770,25 @@ void PdfCompatibilitySectionLooper::loop() {
 // TODO(edisonn): for debugging - remove or put it in a #ifdef
 SkPdfContext* gPdfContext = NULL;
 
+// Points gPdfContext at the page being rendered, unless another thread's page already owns it:
+// pages rendered concurrently leave it alone, so a debugger always sees one live context.
+class AutoPublishPdfContext : SkNoncopyable {
+public:
+    explicit AutoPublishPdfContext(SkPdfContext* pdfContext) {
+        SkPdfContext* expected = NULL;
+        fPublished = sk_atomic_compare_exchange(&gPdfContext, &expected, pdfContext);
+    }
+
+    ~AutoPublishPdfContext() {
+        if (fPublished) {
+            sk_atomic_store(&gPdfContext, (SkPdfContext*)NULL);
+        }
+    }
+
+private:
+    bool fPublished;
+};
+
 bool SkPdfRenderer::renderPage(int page, SkCanvas* canvas, const SkRect& dst) const {
     if (!fPdfDoc) {
         return false;
@@ -2780,7 +2804,7 @@ bool SkPdfRenderer::renderPage(int page, SkCanvas* canvas, const SkRect& dst) co
     pdfContext.fOriginalMatrix = SkMatrix::I();
     pdfContext.fGraphicsState.fResources = fPdfDoc->pageResources(page);
 
-    gPdfContext = &pdfContext;
+    AutoPublishPdfContext publishContext(&pdfContext);
 
     SkScalar z = SkIntToScalar(0);
     SkScalar w = dst.width();
@@ -2867,6 +2891,16 @@ SkPdfRenderer* SkPdfRenderer::CreateFromStream(SkStream* stream) {
     return SkNEW_ARGS(SkPdfRenderer, (pdfDoc));
 }
 
+SkPdfRenderer* SkPdfRenderer::CreateFromData(SkData* data) {
+    SkPdfNativeDoc* pdfDoc = SkNEW_ARGS(SkPdfNativeDoc, (data));
+    if (pdfDoc->pages() == 0) {
+        SkDELETE(pdfDoc);
+        return NULL;
+    }
+
+    return SkNEW_ARGS(SkPdfRenderer, (pdfDoc));
+}
+
 SkPdfRenderer::SkPdfRenderer(SkPdfNativeDoc* doc)
     :fPdfDoc(doc) {
 }
@@ -21,6 +21,7 @@
         '../bench/RecordingBench.cpp',
         '../bench/SKPBench.cpp',
         '../bench/nanobench.cpp',
+        '../src/pipe/utils/SamplePipeControllers.cpp',
       ],
       'includes': [
         'bench.gypi',
@@ -30,8 +31,10 @@
         'flags.gyp:flags_common',
         'jsoncpp.gyp:jsoncpp',
         'skia_lib.gyp:skia_lib',
+        'tools.gyp:cpu_stage_tracer',
         'tools.gyp:crash_handler',
         'tools.gyp:proc_stats',
+        'tools.gyp:record_profiler',
         'tools.gyp:timer',
       ],
       'conditions': [
@@ -18,7 +18,9 @@
         'etc1.gyp:libetc1',
         'ktx.gyp:libSkKTX',
         'libwebp.gyp:libwebp',
+        'skflate.gyp:skflate',
         'utils.gyp:utils',
+        'zlib.gyp:zlib',
       ],
       'include_dirs': [
         '../include/images',
@@ -67,6 +69,7 @@
         '../src/images/SkImageDecoder_libpng.cpp',
 
         '../src/images/SkImageEncoder.cpp',
+        '../src/images/SkImageEncoderPriv.h',
         '../src/images/SkImageEncoder_Factory.cpp',
         '../src/images/SkImageEncoder_argb.cpp',
         '../src/images/SkJpegUtility.cpp',
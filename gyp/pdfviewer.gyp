@@ -23,6 +23,7 @@
         '../experimental/PdfViewer/inc',
         '../experimental/PdfViewer/pdfparser',
         '../experimental/PdfViewer/pdfparser/native',
+        '../src/core',
       ],
       'dependencies': [
         'chop_transparency',
@@ -9,7 +9,8 @@
       'target_name': 'skflate',
       'type': 'static_library',
       'dependencies': [
-        'skia_lib.gyp:skia_lib',
+        # Not skia_lib: images depends on us for the PNG encoder.
+        'core.gyp:*',
         'zlib.gyp:zlib',
       ],
       'sources': [ '../src/core/SkFlate.cpp' ],
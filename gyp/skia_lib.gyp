@@ -21,6 +21,7 @@
         'component_libs': [
           'opts.gyp:opts_ssse3',
           'opts.gyp:opts_sse41',
+          'opts.gyp:opts_avx2',
         ],
       }],
       [ 'arm_neon == 1', {
@@ -30,6 +30,7 @@
         'skdiff',
         'skhello',
         'skp2svg',
+        'skp_hotspots',
         'skpdiff',
         'skpinfo',
         'skpmaker',
@@ -147,6 +148,9 @@
         '../tools/skdiff_utils.cpp',
         '../tools/skdiff_utils.h',
       ],
+      'include_dirs': [
+        '../src/core/', # needed for SkTaskGroup.h
+      ],
       'dependencies': [
         'skia_lib.gyp:skia_lib',
       ],
@@ -360,6 +364,7 @@
         '../src/pipe/utils/',
       ],
       'dependencies': [
+        'timer',
         'flags.gyp:flags',
         'skia_lib.gyp:skia_lib',
         'tools.gyp:picture_renderer',
@@ -415,6 +420,24 @@
         'skia_lib.gyp:skia_lib',
       ],
     },
+    {
+      'target_name': 'skp_hotspots',
+      'type': 'executable',
+      'sources': [
+        '../tools/skp_hotspots.cpp',
+        '../tools/LazyDecodeBitmap.cpp',
+      ],
+      'include_dirs': [
+        '../src/core/',
+        '../src/images',
+        '../src/lazy',
+      ],
+      'dependencies': [
+        'record_profiler',
+        'flags.gyp:flags',
+        'skia_lib.gyp:skia_lib',
+      ],
+    },
     {
       'target_name': 'picture_renderer',
       'type': 'static_library',
@@ -602,6 +625,46 @@
         'include_dirs': [ '../tools', ],
       },
     },
+    {
+      'target_name': 'cpu_stage_tracer',
+      'type': 'static_library',
+      'sources': [
+        '../tools/CpuStageTracer.h',
+        '../tools/CpuStageTracer.cpp',
+      ],
+      'include_dirs': [
+        '../src/core',
+      ],
+      'dependencies': [
+        'skia_lib.gyp:skia_lib',
+        'timer',
+      ],
+      'direct_dependent_settings': {
+        'include_dirs': [ '../tools', ],
+      },
+      'export_dependent_settings': [
+        'timer',
+      ],
+    },
+    {
+      'target_name': 'record_profiler',
+      'type': 'static_library',
+      'sources': [
+        '../tools/RecordProfiler.h',
+        '../tools/RecordProfiler.cpp',
+      ],
+      'include_dirs': [
+        '../src/core',
+        '../src/utils',
+      ],
+      'dependencies': [
+        'skia_lib.gyp:skia_lib',
+        'timer',
+      ],
+      'direct_dependent_settings': {
+        'include_dirs': [ '../tools', ],
+      },
+    },
     {
       'target_name': 'test_public_includes',
       'type': 'static_library',
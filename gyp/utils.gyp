@@ -105,6 +105,8 @@
             '../src/utils/win/SkDWriteGeometrySink.h',
             '../src/utils/win/SkHRESULT.cpp',
             '../src/utils/win/SkIStream.cpp',
+            '../src/utils/win/SkModuleVersion.cpp',
+            '../src/utils/win/SkModuleVersion.h',
           ],
         }],
         ['skia_run_pdfviewer_in_gm', {
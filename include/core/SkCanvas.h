@@ -1252,6 +1252,8 @@ private:
     class MCRec;
 
     SkAutoTUnref<SkClipStack> fClipStack;
+    // Shared by the ops on every level's raster clip, so a chain of clips reuses one buffer.
+    SkRegion::OpScratch fClipScratch;
     SkDeque     fMCStack;
     // points to top of stack
     MCRec*      fMCRec;
@@ -128,6 +128,16 @@ private:
                      bool pathIsMutable, bool drawCoverage,
                      SkBlitter* customBlitter = NULL) const;
 
+    /**
+     *  If paint's path effect is a dash that would make a lot of segments, and drawing them in
+     *  batches looks the same as drawing them all at once, draws them a batch at a time (keeping
+     *  memory use bounded) and returns true. Otherwise returns false without drawing anything.
+     */
+    bool    drawStreamedDash(const SkPath&, const SkPaint&, const SkMatrix&,
+                             bool drawCoverage, SkBlitter* customBlitter) const;
+
+    class DashSegmentDrawer;
+
     /**
      *  Return the current clip bounds, in local coordinates, with slop to account
      *  for antialiasing or hairlines (i.e. device-bounds outset by 1, and then
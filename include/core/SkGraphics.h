@@ -70,6 +70,33 @@ public:
      */
     static int SetFontCacheCountLimit(int count);
 
+    /**
+     *  Return true if the font cache stores A8 and BW glyph images compressed.
+     */
+    static bool GetFontCachePackedImages();
+
+    /**
+     *  Specify whether the font cache should store A8 and BW glyph images
+     *  compressed (run-length encoded) when that saves space, and return the
+     *  previous setting. Packed glyphs are unpacked a row at a time as they are
+     *  drawn, so this trades some draw speed for fitting more glyphs into the
+     *  same cache budget (about twice as many for large anti-aliased text),
+     *  which helps text with many unique glyphs (e.g. CJK). Only affects strikes
+     *  created after the call; call PurgeFontCache() to apply it to existing
+     *  ones. Default is false.
+     */
+    static bool SetFontCachePackedImages(bool pack);
+
+    /**
+     *  Specify a file in which rasterized glyph images are kept across runs,
+     *  or NULL to stop using one. The file is memory mapped and may be shared
+     *  by several processes at once; strikes created after this call look
+     *  glyphs up there before rasterizing them, and add the ones they had to
+     *  rasterize in the background. Glyphs not yet written out are flushed
+     *  when the path is changed, and by Term().
+     */
+    static void SetFontCacheDiskPath(const char path[]);
+
     /**
      *  For debugging purposes, this will attempt to purge the font cache. It
      *  does not change the limit, but will cause subsequent font measures and
@@ -111,6 +138,29 @@ public:
     static size_t GetResourceCacheSingleAllocationByteLimit();
     static size_t SetResourceCacheSingleAllocationByteLimit(size_t newLimit);
 
+    /**
+     *  Raster saveLayer()s can keep the pixel memory of freed layers around, up to this many
+     *  bytes, for later layers to reuse instead of going back to malloc. This is 0 (no pooling)
+     *  by default. Setting a smaller limit frees pooled memory right away.
+     */
+    static size_t GetLayerPoolByteLimit();
+    static size_t SetLayerPoolByteLimit(size_t newLimit);
+
+    /**
+     *  Frees as much memory as possible from the font cache, the resource cache and the layer
+     *  pool, e.g. when the system is low on memory. It does not change any of their limits.
+     */
+    static void PurgeAllCaches();
+
+    /**
+     *  When enabled, SkCanvas caches the clips it builds from paths in the resource cache, so
+     *  that replaying the same clips (every playback of a picture, every tile of a tiled render)
+     *  does not rasterize the same paths again. Every clip then pays for copying and hashing its
+     *  device geometry, so this is off by default. Returns the previous setting.
+     */
+    static bool GetRasterClipCacheEnabled();
+    static bool SetRasterClipCacheEnabled(bool enabled);
+
     /**
      *  Applications with command line options may pass optional state, such
      *  as cache sizes, here, for instance:
@@ -13,6 +13,7 @@
 
 class SkBitmap;
 class SkData;
+class SkPicture;
 class SkWStream;
 
 class SkImageEncoder {
@@ -31,6 +32,26 @@ public:
     };
     static SkImageEncoder* Create(Type);
 
+    /**
+     *  Supplies the image to encode a band of rows at a time, from top to
+     *  bottom, so an encoder that consumes rows incrementally never needs the
+     *  whole image in memory at once.
+     */
+    class RowSource {
+    public:
+        virtual ~RowSource() {}
+
+        /** The dimensions, color type and alpha type of the whole image. */
+        virtual SkImageInfo info() const = 0;
+
+        /**
+         *  Set 'band' to the next one or more rows of the image: info().width()
+         *  pixels wide, in info().colorType(). The pixels only need to stay
+         *  valid until the next call. Returns false on failure.
+         */
+        virtual bool nextBand(SkBitmap* band) = 0;
+    };
+
     virtual ~SkImageEncoder();
 
     /*  Quality ranges from 0..100 */
@@ -60,6 +81,14 @@ public:
      */
     bool encodeStream(SkWStream* stream, const SkBitmap& bm, int quality);
 
+    /**
+     * Encode the rows supplied by 'source' in the desired format, writing
+     * results to stream 'stream', at quality level 'quality' (which can be in
+     * range 0-100). PNG and JPEG encode one band at a time; other formats
+     * first gather all the rows into a single bitmap. Returns false on failure.
+     */
+    bool encodeStream(SkWStream* stream, RowSource* source, int quality);
+
     static SkData* EncodeData(const SkImageInfo&, const void* pixels, size_t rowBytes,
                               Type, int quality);
     static SkData* EncodeData(const SkBitmap&, Type, int quality);
@@ -68,6 +97,17 @@ public:
                            int quality);
     static bool EncodeStream(SkWStream*, const SkBitmap&, Type,
                            int quality);
+    static bool EncodeStream(SkWStream*, RowSource*, Type, int quality);
+
+    /**
+     *  Encode 'picture' as an image described by 'info', rendering it
+     *  'bandHeight' rows at a time. Only the ops that intersect each band are
+     *  played back (using the picture's bounding box hierarchy, if any), and
+     *  peak memory is proportional to the band height rather than the image
+     *  height. Each band starts out transparent.
+     */
+    static bool EncodePicture(SkWStream*, const SkPicture*, const SkImageInfo& info, Type,
+                              int quality, int bandHeight = 256);
 
 protected:
     /**
@@ -78,6 +118,13 @@ protected:
      * This must be overridden by each SkImageEncoder implementation.
      */
     virtual bool onEncode(SkWStream* stream, const SkBitmap& bm, int quality) = 0;
+
+    /**
+     * Encode the rows supplied by 'source'. Encoders that can consume rows
+     * incrementally override this. The default gathers all the rows into one
+     * bitmap and calls onEncode().
+     */
+    virtual bool onEncodeRows(SkWStream* stream, RowSource* source, int quality);
 };
 
 // This macro declares a global (i.e., non-class owned) creation entry point
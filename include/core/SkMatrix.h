@@ -533,6 +533,19 @@ public:
         return this->mapRect(rect, *rect);
     }
 
+    /** Apply this matrix to each of the count rectangles in src, and write the
+        transformed rectangles into dst. This gives the same results as calling
+        mapRect() on each of them, but maps many rectangles much faster.
+        @param dst  Where the transformed rectangles are written. It must
+                    contain at least count entries
+        @param src  The original rectangles to be transformed. It must contain
+                    at least count entries
+        @param count The number of rectangles in src to read, and then
+                     transform into dst.
+        @return the result of calling rectStaysRect()
+    */
+    bool mapRects(SkRect dst[], const SkRect src[], int count) const;
+
     /** Apply this matrix to the src rectangle, and write the four transformed
         points into dst. The points written to dst will be the original top-left, top-right,
         bottom-right, and bottom-left points transformed by the matrix.
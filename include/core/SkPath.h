@@ -996,6 +996,7 @@ private:
     friend class Iter;
 
     friend class SkPathStroker;
+    friend class SkStrokeCache;
 
     /*  Append, in reverse order, the first contour of path, ignoring path's
         last point. If no moveTo() call has been made for this contour, the
@@ -9,6 +9,7 @@
 #ifndef SkPathRef_DEFINED
 #define SkPathRef_DEFINED
 
+#include "SkAtomics.h"
 #include "SkMatrix.h"
 #include "SkPoint.h"
 #include "SkRect.h"
@@ -184,6 +185,7 @@ public:
 
     virtual ~SkPathRef() {
         SkDEBUGCODE(this->validate();)
+        this->notifyGenIDIsStale();
         sk_free(fPoints);
 
         SkDEBUGCODE(fPoints = NULL;)
@@ -253,6 +255,14 @@ public:
      */
     uint32_t genID() const;
 
+    /**
+     * Call this when caching something keyed by genID(), so that it gets purged when this path ref
+     * changes or is deleted.
+     */
+    void notifyAddedToCache() const {
+        fAddedToCache.store(true);
+    }
+
     SkDEBUGCODE(void validate() const;)
 
 private:
@@ -270,6 +280,7 @@ private:
         fPoints = NULL;
         fFreeSpace = 0;
         fGenerationID = kEmptyGenID;
+        fAddedToCache.store(false);
         fSegmentMask = 0;
         fIsOval = false;
         SkDEBUGCODE(fEditorsAttached = 0;)
@@ -321,6 +332,7 @@ private:
                      int reserveVerbs = 0, int reservePoints = 0) {
         SkDEBUGCODE(this->validate();)
         fBoundsIsDirty = true;      // this also invalidates fIsFinite
+        this->notifyGenIDIsStale();
         fGenerationID = 0;
 
         fSegmentMask = 0;
@@ -424,6 +436,9 @@ private:
 
     void setIsOval(bool isOval) { fIsOval = isOval; }
 
+    // Purges anything cached for our genID. Call this *before* the genID gets changed or zeroed.
+    void notifyGenIDIsStale();
+
     SkPoint* getPoints() {
         SkDEBUGCODE(this->validate();)
         fIsOval = false;
@@ -452,6 +467,7 @@ private:
         kEmptyGenID = 1, // GenID reserved for path ref with zero points and zero verbs.
     };
     mutable uint32_t    fGenerationID;
+    mutable SkAtomic<bool> fAddedToCache;
     SkDEBUGCODE(int32_t fEditorsAttached;) // assert that only one editor in use at any time.
 
     friend class PathRefTest_Private;
@@ -297,6 +297,40 @@ public:
      */
     bool op(const SkRegion& rgna, const SkRegion& rgnb, Op op);
 
+    /**
+     *  Holds the runs that ops compute their results in before copying them into the result
+     *  region. A chain of ops (e.g. accumulating many clips into one region) can share one
+     *  OpScratch, so that they reuse a single buffer rather than each allocating their own.
+     *  Ops needing more than kMaxRunCount runs allocate their own, so the buffer stays small.
+     */
+    class SK_API OpScratch : SkNoncopyable {
+    public:
+        OpScratch() : fRuns(NULL), fCount(0) {}
+        ~OpScratch();
+
+        enum {
+            kMaxRunCount = 16 * 1024
+        };
+
+    private:
+        RunType* reserve(int count);
+
+        RunType* fRuns;
+        int      fCount;
+
+        friend class SkRegion;
+    };
+
+    /**
+     *  Same as op(rect, op), but computes the result in scratch's runs.
+     */
+    bool op(const SkIRect& rect, Op op, OpScratch* scratch);
+
+    /**
+     *  Same as op(rgn, op), but computes the result in scratch's runs.
+     */
+    bool op(const SkRegion& rgn, Op op, OpScratch* scratch);
+
 #ifdef SK_BUILD_FOR_ANDROID
     /** Returns a new char* containing the list of rectangles in this region
      */
@@ -438,10 +472,12 @@ private:
                              SkIRect* bounds);
 
     /**
-     *  If the last arg is null, just return if the result is non-empty,
-     *  else store the result in the last arg.
+     *  If the result arg is null, just return if the result is non-empty,
+     *  else store the result in the result arg. If scratch is not null, its
+     *  runs are used to compute the result in.
      */
-    static bool Oper(const SkRegion&, const SkRegion&, SkRegion::Op, SkRegion*);
+    static bool Oper(const SkRegion&, const SkRegion&, SkRegion::Op, SkRegion* result,
+                     OpScratch* scratch = NULL);
 
     friend struct RunHead;
     friend class Iterator;
@@ -90,6 +90,9 @@ protected:
 private:
     SkISize   fKernelSize;
     SkScalar* fKernel;
+    // If fKernel is the outer product of a column and a row, the row's fKernelSize.fWidth
+    // values followed by the column's fKernelSize.fHeight values. Otherwise NULL.
+    SkScalar* fSeparableKernel;
     SkScalar  fGain;
     SkScalar  fBias;
     SkIPoint  fKernelOffset;
@@ -115,6 +118,22 @@ private:
                             SkBitmap* result,
                             const SkIRect& rect,
                             const SkIRect& bounds) const;
+    template <class PixelFetcher, bool convolveAlpha>
+    void filterSeparablePixels(const SkBitmap& src,
+                               SkBitmap* result,
+                               const SkIRect& rect,
+                               const SkIRect& bounds) const;
+    void filterSeparablePixels(const SkBitmap& src,
+                               SkBitmap* result,
+                               const SkIRect& rect,
+                               const SkIRect& bounds) const;
+    void filterRows(const SkBitmap& src,
+                    SkBitmap* result,
+                    int top, int bottom,
+                    const SkIRect& bounds) const;
+
+    struct Band;
+    static void FilterBand(Band*);
 };
 
 #endif
@@ -19,6 +19,20 @@ public:
      *  SkRecord holds a reference to (e.g. paths, or pixels backing bitmaps).
      */
     static size_t ApproximateBytesUsed(const SkPicture* pict);
+
+    /**
+     *  Decodes the lazily decoded bitmaps and images (e.g. from SkImage::NewFromGenerator or
+     *  SkInstallDiscardablePixelRef) that drawing pict with this matrix will use, and builds the
+     *  mipmaps and scaled copies its filtered bitmap draws will look up, so that playing pict back
+     *  does not stop to make them. Each bitmap or image is handled by its own SkTaskGroup task,
+     *  and this returns once they all have finished.
+     *
+     *  The results are kept wherever those pixels are normally cached (discardable memory or
+     *  SkResourceCache), so they may be purged again before pict is drawn.
+     *
+     *  Returns the number of distinct bitmaps and images visited.
+     */
+    static int PreDecodeImages(const SkPicture* pict, const SkMatrix& matrix = SkMatrix::I());
 };
 
 #endif
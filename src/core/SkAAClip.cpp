@@ -638,6 +638,13 @@ SkAAClip::~SkAAClip() {
     this->freeRuns();
 }
 
+size_t SkAAClip::bytesUsed() const {
+    if (NULL == fRunHead) {
+        return 0;
+    }
+    return sizeof(RunHead) + fRunHead->fRowCount * sizeof(YOffset) + fRunHead->fDataSize;
+}
+
 SkAAClip& SkAAClip::operator=(const SkAAClip& src) {
     AUTO_AACLIP_VALIDATE(*this);
     src.validate();
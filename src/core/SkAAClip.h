@@ -29,6 +29,9 @@ public:
     bool isEmpty() const { return NULL == fRunHead; }
     const SkIRect& getBounds() const { return fBounds; }
 
+    // Returns the size of the (possibly shared) run data backing this clip.
+    size_t bytesUsed() const;
+
     // Returns true iff the clip is not empty, and is just a hard-edged rect (no partial alpha).
     // If true, getBounds() can be used in place of this clip.
     bool isRect() const;
@@ -9,6 +9,7 @@
 #include "SkConfig8888.h"
 #include "SkDeviceProperties.h"
 #include "SkDraw.h"
+#include "SkLayerPool.h"
 #include "SkRasterClip.h"
 #include "SkShader.h"
 #include "SkSurface.h"
@@ -69,28 +70,41 @@ SkBitmapDevice::SkBitmapDevice(const SkBitmap& bitmap, const SkDeviceProperties&
     SkASSERT(valid_for_bitmap_device(bitmap.info(), NULL));
 }
 
-SkBitmapDevice* SkBitmapDevice::Create(const SkImageInfo& origInfo,
-                                       const SkDeviceProperties* props) {
+// Layers (devices made by onCreateDevice) come and go constantly, so their pixels are pooled.
+static bool alloc_device_bitmap(const SkImageInfo& origInfo, bool pooled, SkBitmap* bitmap) {
     SkAlphaType newAT = origInfo.alphaType();
     if (!valid_for_bitmap_device(origInfo, &newAT)) {
-        return NULL;
+        return false;
     }
 
     const SkImageInfo info = origInfo.makeAlphaType(newAT);
-    SkBitmap bitmap;
 
     if (kUnknown_SkColorType == info.colorType()) {
-        if (!bitmap.setInfo(info)) {
-            return NULL;
+        if (!bitmap->setInfo(info)) {
+            return false;
+        }
+    } else if (pooled) {
+        // SkLayerPool clears the pixels for us.
+        if (!bitmap->setInfo(info) || !SkLayerPool::AllocPixels(bitmap)) {
+            return false;
         }
     } else {
-        if (!bitmap.tryAllocPixels(info)) {
-            return NULL;
+        if (!bitmap->tryAllocPixels(info)) {
+            return false;
         }
-        if (!bitmap.info().isOpaque()) {
-            bitmap.eraseColor(SK_ColorTRANSPARENT);
+        if (!bitmap->info().isOpaque()) {
+            bitmap->eraseColor(SK_ColorTRANSPARENT);
         }
     }
+    return true;
+}
+
+SkBitmapDevice* SkBitmapDevice::Create(const SkImageInfo& info,
+                                       const SkDeviceProperties* props) {
+    SkBitmap bitmap;
+    if (!alloc_device_bitmap(info, false, &bitmap)) {
+        return NULL;
+    }
 
     if (props) {
         return SkNEW_ARGS(SkBitmapDevice, (bitmap, *props));
@@ -116,8 +130,12 @@ void SkBitmapDevice::replaceBitmapBackendForRasterSurface(const SkBitmap& bm) {
 }
 
 SkBaseDevice* SkBitmapDevice::onCreateDevice(const CreateInfo& cinfo, const SkPaint*) {
+    SkBitmap bitmap;
+    if (!alloc_device_bitmap(cinfo.fInfo, true, &bitmap)) {
+        return NULL;
+    }
     SkDeviceProperties leaky(cinfo.fPixelGeometry);
-    return SkBitmapDevice::Create(cinfo.fInfo, &leaky);
+    return SkNEW_ARGS(SkBitmapDevice, (bitmap, leaky));
 }
 
 void SkBitmapDevice::lockPixels() {
@@ -194,6 +212,7 @@ void SkBitmapDevice::drawOval(const SkDraw& draw, const SkRect& oval, const SkPa
 
     SkPath path;
     path.addOval(oval);
+    path.setIsVolatile(true);
     // call the VIRTUAL version, so any subclasses who do handle drawPath aren't
     // required to override drawOval.
     this->drawPath(draw, path, paint, NULL, true);
@@ -206,6 +225,7 @@ void SkBitmapDevice::drawRRect(const SkDraw& draw, const SkRRect& rrect, const S
     SkPath  path;
 
     path.addRRect(rrect);
+    path.setIsVolatile(true);
     // call the VIRTUAL version, so any subclasses who do handle drawPath aren't
     // required to override drawRRect.
     this->drawPath(draw, path, paint, NULL, true);
@@ -906,7 +906,23 @@ SkBlitter* SkBlitter::Choose(const SkBitmap& device,
         }
     }
 
-    if (cf) {
+    /*
+     *  On N32, the pipeline blitter can apply a simple color filter and coefficient xfermode to
+     *  the shader's output itself, in one pass, instead of filtering through an SkFilterShader.
+     *  Without a color filter, SkARGB32_Shader_Blitter's 8-bit xfermodes are faster.
+     *
+     *  The pipeline filters and blends in float, so its results can differ from the 8-bit path
+     *  by a few units per channel. SK_SUPPORT_LEGACY_COLORFILTER_BLITS keeps the old path for
+     *  clients whose expectations have not been rebaselined yet.
+     */
+#ifdef SK_SUPPORT_LEGACY_COLORFILTER_BLITS
+    const bool usePipeline = false;
+#else
+    const bool usePipeline = cf && kN32_SkColorType == device.colorType() && !shader3D &&
+                             SkRasterPipeline::CanFuse(cf, mode);
+#endif
+
+    if (cf && !usePipeline) {
         SkASSERT(shader);
         shader = SkNEW_ARGS(SkFilterShader, (shader, cf));
         paint.writable()->setShader(shader)->unref();
@@ -955,7 +971,10 @@ SkBlitter* SkBlitter::Choose(const SkBitmap& device,
             break;
 
         case kN32_SkColorType:
-            if (shader) {
+            if (usePipeline) {
+                blitter = allocator->createT<SkARGB32_Pipeline_Blitter>(
+                        device, *paint, shaderContext);
+            } else if (shader) {
                 blitter = allocator->createT<SkARGB32_Shader_Blitter>(
                         device, *paint, shaderContext);
             } else if (paint->getColor() == SK_ColorBLACK) {
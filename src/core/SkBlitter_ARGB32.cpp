@@ -633,3 +633,149 @@ void SkARGB32_Shader_Blitter::blitV(int x, int y, int height, SkAlpha alpha) {
         }
     }
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Small enough that the shaded chunk stays in L1 while the pipeline runs over it.
+static const int kPipelineChunk = 64;
+
+SkARGB32_Pipeline_Blitter::SkARGB32_Pipeline_Blitter(const SkBitmap& device,
+        const SkPaint& paint, SkShader::Context* shaderContext)
+    : INHERITED(device, paint, shaderContext)
+    , fPipeline(paint.getColorFilter(), paint.getXfermode())
+    , fXferPipeline(NULL, paint.getXfermode())
+{
+    fBuffer = (SkPMColor*)sk_malloc_throw(device.width() * (sizeof(SkPMColor)));
+    fConstInY = SkToBool(shaderContext->getFlags() & SkShader::kConstInY32_Flag);
+
+    // Src-over's 8-bit blit row procs beat running it in floats, so for src-over the pipeline
+    // just filters.
+    fProc32 = fProc32Blend = NULL;
+    if (fPipeline.xferIsSrcOver()) {
+        fProc32 = SkBlitRow::Factory32(SkBlitRow::kSrcPixelAlpha_Flag32);
+        fProc32Blend = SkBlitRow::Factory32(SkBlitRow::kSrcPixelAlpha_Flag32 |
+                                            SkBlitRow::kGlobalAlpha_Flag32);
+    }
+}
+
+SkARGB32_Pipeline_Blitter::~SkARGB32_Pipeline_Blitter() {
+    sk_free(fBuffer);
+}
+
+void SkARGB32_Pipeline_Blitter::shadeAndRun(int x, int y, SkPMColor device[], int count,
+                                            const SkAlpha aa[], SkAlpha constAA) {
+    SkPMColor span[kPipelineChunk];
+    while (count > 0) {
+        const int n = SkTMin(count, kPipelineChunk);
+        fShaderContext->shadeSpan(x, y, span, n);
+        if (fProc32 && NULL == aa) {
+            fPipeline.filter(span, span, n);
+            (0xFF == constAA ? fProc32 : fProc32Blend)(device, span, n, constAA);
+        } else if (aa) {
+            fPipeline.run(device, span, n, aa);
+            aa += n;
+        } else {
+            fPipeline.run(device, span, n, constAA);
+        }
+        x += n;
+        device += n;
+        count -= n;
+    }
+}
+
+void SkARGB32_Pipeline_Blitter::blitH(int x, int y, int width) {
+    SkASSERT(x >= 0 && y >= 0 && x + width <= fDevice.width());
+    this->shadeAndRun(x, y, fDevice.getAddr32(x, y), width, NULL, 0xFF);
+}
+
+void SkARGB32_Pipeline_Blitter::blitRect(int x, int y, int width, int height) {
+    SkASSERT(x >= 0 && y >= 0 &&
+             x + width <= fDevice.width() && y + height <= fDevice.height());
+
+    uint32_t*   device = fDevice.getAddr32(x, y);
+    size_t      deviceRB = fDevice.rowBytes();
+
+    if (fConstInY) {
+        // Every row is shaded and filtered the same, so do that once, then just transfer the
+        // filtered span onto each row.
+        SkPMColor* span = fBuffer;
+        fShaderContext->shadeSpan(x, y, span, width);
+        fPipeline.filter(span, span, width);
+        do {
+            if (fProc32) {
+                fProc32(device, span, width, 0xFF);
+            } else {
+                fXferPipeline.run(device, span, width, 0xFF);
+            }
+            device = (uint32_t*)((char*)device + deviceRB);
+        } while (--height > 0);
+        return;
+    }
+
+    do {
+        this->shadeAndRun(x, y, device, width, NULL, 0xFF);
+        y += 1;
+        device = (uint32_t*)((char*)device + deviceRB);
+    } while (--height > 0);
+}
+
+void SkARGB32_Pipeline_Blitter::blitAntiH(int x, int y, const SkAlpha antialias[],
+                                          const int16_t runs[]) {
+    uint32_t* device = fDevice.getAddr32(x, y);
+    for (;;) {
+        int count = *runs;
+        if (count <= 0) {
+            break;
+        }
+        int aa = *antialias;
+        if (aa) {
+            this->shadeAndRun(x, y, device, count, NULL, aa);
+        }
+        device += count;
+        runs += count;
+        antialias += count;
+        x += count;
+    }
+}
+
+void SkARGB32_Pipeline_Blitter::blitMask(const SkMask& mask, const SkIRect& clip) {
+    SkASSERT(mask.fBounds.contains(clip));
+
+    SkBlitMask::RowProc proc = NULL;
+    if (SkMask::kA8_Format != mask.fFormat) {
+        // Other masks (e.g. LCD) need their own row procs, which only know src-over.  Filter
+        // the shaded span first, then hand it to them.
+        if (fPipeline.xferIsSrcOver()) {
+            proc = SkBlitMask::RowFactory(kN32_SkColorType, mask.fFormat,
+                                          (SkBlitMask::RowFlags)0);
+        }
+        if (NULL == proc) {
+            this->INHERITED::blitMask(mask, clip);
+            return;
+        }
+    }
+
+    const int x = clip.fLeft;
+    const int width = clip.width();
+    int y = clip.fTop;
+    int height = clip.height();
+
+    char* dstRow = (char*)fDevice.getAddr32(x, y);
+    const size_t dstRB = fDevice.rowBytes();
+    const uint8_t* maskRow = (const uint8_t*)mask.getAddr(x, y);
+    const size_t maskRB = mask.fRowBytes;
+
+    do {
+        if (proc) {
+            SkPMColor* span = fBuffer;
+            fShaderContext->shadeSpan(x, y, span, width);
+            fPipeline.filter(span, span, width);
+            proc(dstRow, maskRow, span, width);
+        } else {
+            this->shadeAndRun(x, y, (SkPMColor*)dstRow, width, maskRow, 0xFF);
+        }
+        dstRow += dstRB;
+        maskRow += maskRB;
+        y += 1;
+    } while (--height > 0);
+}
@@ -14,12 +14,14 @@
 #include "SkDrawFilter.h"
 #include "SkDrawLooper.h"
 #include "SkErrorInternals.h"
+#include "SkGraphics.h"
 #include "SkImage.h"
 #include "SkMetaData.h"
 #include "SkPathOps.h"
 #include "SkPatchUtils.h"
 #include "SkPicture.h"
 #include "SkRasterClip.h"
+#include "SkRasterClipCache.h"
 #include "SkReadPixelsRec.h"
 #include "SkRRect.h"
 #include "SkSmallAllocator.h"
@@ -204,6 +206,8 @@ public:
     */
     DeviceCM*       fTopLayer;
     SkRasterClip    fRasterClip;
+    // How fRasterClip was built, for SkRasterClipCache (NULL if unknown or not caching).
+    SkAutoTUnref<const SkRasterClipCache::History> fRasterClipHistory;
     SkMatrix        fMatrix;
     int             fDeferredSaveCount;
 
@@ -217,7 +221,10 @@ public:
         // don't bother initializing fNext
         inc_rec();
     }
-    MCRec(const MCRec& prev) : fRasterClip(prev.fRasterClip), fMatrix(prev.fMatrix) {
+    MCRec(const MCRec& prev)
+        : fRasterClip(prev.fRasterClip)
+        , fRasterClipHistory(SkSafeRef(prev.fRasterClipHistory.get()))
+        , fMatrix(prev.fMatrix) {
         fFilter = SkSafeRef(prev.fFilter);
         fLayer = NULL;
         fTopLayer = prev.fTopLayer;
@@ -232,12 +239,19 @@ public:
         dec_rec();
     }
 
+    void setRasterClipRect(const SkIRect& bounds) {
+        fRasterClip.setRect(bounds);
+        fRasterClipHistory.reset(SkGraphics::GetRasterClipCacheEnabled()
+                ? SkRasterClipCache::NewRectHistory(bounds, fRasterClip.isForceConservativeRects())
+                : NULL);
+    }
+
     void reset(const SkIRect& bounds) {
         SkASSERT(fLayer);
         SkASSERT(fDeferredSaveCount == 0);
 
         fMatrix.reset();
-        fRasterClip.setRect(bounds);
+        this->setRasterClipRect(bounds);
         fLayer->reset(bounds);
     }
 };
@@ -483,7 +497,7 @@ SkBaseDevice* SkCanvas::init(SkBaseDevice* device, InitFlags flags) {
         }
         device->onAttachToCanvas(this);
         fMCRec->fLayer->fDevice = SkRef(device);
-        fMCRec->fRasterClip.setRect(device->getGlobalBounds());
+        fMCRec->setRasterClipRect(device->getGlobalBounds());
     }
     return device;
 }
@@ -884,7 +898,7 @@ bool SkCanvas::clipRectBounds(const SkRect* bounds, SaveFlags flags,
         if (!ir.intersect(clipBounds)) {
             if (bounds_affects_clip(flags)) {
                 fCachedLocalClipBoundsDirty = true;
-                fMCRec->fRasterClip.setEmpty();
+                fMCRec->setRasterClipRect(SkIRect::MakeEmpty());
             }
             return false;
         }
@@ -897,7 +911,7 @@ bool SkCanvas::clipRectBounds(const SkRect* bounds, SaveFlags flags,
         // Simplify the current clips since they will be applied properly during restore()
         fCachedLocalClipBoundsDirty = true;
         fClipStack->clipDevRect(ir, SkRegion::kReplace_Op);
-        fMCRec->fRasterClip.setRect(ir);
+        fMCRec->setRasterClipRect(ir);
     }
 
     if (intersection) {
@@ -1293,6 +1307,7 @@ void SkCanvas::onClipRect(const SkRect& rect, SkRegion::Op op, ClipEdgeStyle edg
             fCachedLocalClipBoundsDirty = true;
 
             fClipStack->clipEmpty();
+            fMCRec->fRasterClipHistory.reset(NULL);
             return fMCRec->fRasterClip.setEmpty();
         }
     }
@@ -1315,7 +1330,11 @@ void SkCanvas::onClipRect(const SkRect& rect, SkRegion::Op op, ClipEdgeStyle edg
 
         fMCRec->fMatrix.mapRect(&r, rect);
         fClipStack->clipDevRect(r, op, kSoft_ClipEdgeStyle == edgeStyle);
-        fMCRec->fRasterClip.op(r, this->getBaseLayerSize(), op, kSoft_ClipEdgeStyle == edgeStyle);
+        fMCRec->fRasterClipHistory.reset(SkRasterClipCache::NewOpHistory(
+                fMCRec->fRasterClipHistory.get(), r, this->getBaseLayerSize(), op,
+                kSoft_ClipEdgeStyle == edgeStyle));
+        fMCRec->fRasterClip.op(r, this->getBaseLayerSize(), op, kSoft_ClipEdgeStyle == edgeStyle,
+                               &fClipScratch);
     } else {
         // since we're rotated or some such thing, we convert the rect to a path
         // and clip against that, since it can handle any matrix. However, to
@@ -1328,9 +1347,20 @@ void SkCanvas::onClipRect(const SkRect& rect, SkRegion::Op op, ClipEdgeStyle edg
     }
 }
 
-static void rasterclip_path(SkRasterClip* rc, const SkCanvas* canvas, const SkPath& devPath,
-                            SkRegion::Op op, bool doAA) {
-    rc->op(devPath, canvas->getBaseLayerSize(), op, doAA);
+static void rasterclip_path(SkRasterClip* rc,
+                            SkAutoTUnref<const SkRasterClipCache::History>* rcHistory,
+                            const SkCanvas* canvas, const SkPath& devPath, SkRegion::Op op,
+                            bool doAA, SkRegion::OpScratch* scratch) {
+    rcHistory->reset(SkRasterClipCache::NewOpHistory(rcHistory->get(), devPath,
+                                                     canvas->getBaseLayerSize(), op, doAA));
+    const bool useCache = rcHistory->get() && SkRasterClipCache::ShouldCache(devPath, doAA);
+    if (useCache && SkRasterClipCache::Find(rcHistory->get(), rc)) {
+        return;
+    }
+    rc->op(devPath, canvas->getBaseLayerSize(), op, doAA, scratch);
+    if (useCache) {
+        SkRasterClipCache::Add(rcHistory->get(), *rc);
+    }
 }
 
 void SkCanvas::clipRRect(const SkRRect& rrect, SkRegion::Op op, bool doAA) {
@@ -1359,7 +1389,8 @@ void SkCanvas::onClipRRect(const SkRRect& rrect, SkRegion::Op op, ClipEdgeStyle
         SkPath devPath;
         devPath.addRRect(transformedRRect);
 
-        rasterclip_path(&fMCRec->fRasterClip, this, devPath, op, kSoft_ClipEdgeStyle == edgeStyle);
+        rasterclip_path(&fMCRec->fRasterClip, &fMCRec->fRasterClipHistory, this, devPath, op,
+                        kSoft_ClipEdgeStyle == edgeStyle, &fClipScratch);
         return;
     }
 
@@ -1392,6 +1423,7 @@ void SkCanvas::onClipPath(const SkPath& path, SkRegion::Op op, ClipEdgeStyle edg
             fCachedLocalClipBoundsDirty = true;
 
             fClipStack->clipEmpty();
+            fMCRec->fRasterClipHistory.reset(NULL);
             return fMCRec->fRasterClip.setEmpty();
         }
     }
@@ -1430,7 +1462,8 @@ void SkCanvas::onClipPath(const SkPath& path, SkRegion::Op op, ClipEdgeStyle edg
         op = SkRegion::kReplace_Op;
     }
 
-    rasterclip_path(&fMCRec->fRasterClip, this, devPath, op, edgeStyle);
+    rasterclip_path(&fMCRec->fRasterClip, &fMCRec->fRasterClipHistory, this, devPath, op,
+                    edgeStyle, &fClipScratch);
 }
 
 void SkCanvas::clipRegion(const SkRegion& rgn, SkRegion::Op op) {
@@ -1448,7 +1481,8 @@ void SkCanvas::onClipRegion(const SkRegion& rgn, SkRegion::Op op) {
     // we have to ignore it, and use the region directly?
     fClipStack->clipDevRect(rgn.getBounds(), op);
 
-    fMCRec->fRasterClip.op(rgn, op);
+    fMCRec->fRasterClipHistory.reset(NULL);
+    fMCRec->fRasterClip.op(rgn, op, &fClipScratch);
 }
 
 #ifdef SK_DEBUG
@@ -1478,7 +1512,10 @@ void SkCanvas::validateClip() const {
             default: {
                 SkPath path;
                 element->asPath(&path);
-                rasterclip_path(&tmpClip, this, path, element->getOp(), element->isAA());
+                // Don't validate against the cache.
+                SkAutoTUnref<const SkRasterClipCache::History> unknownHistory;
+                rasterclip_path(&tmpClip, &unknownHistory, this, path, element->getOp(),
+                                element->isAA(), NULL);
                 break;
             }
         }
@@ -11,6 +11,7 @@
 #include "SkBitmapProcShader.h"
 #include "SkBlitter.h"
 #include "SkBlitRow.h"
+#include "SkRasterPipeline.h"
 #include "SkShader.h"
 #include "SkSmallAllocator.h"
 
@@ -180,6 +181,40 @@ private:
     typedef SkShaderBlitter INHERITED;
 };
 
+/**
+ *  Shades spans a chunk at a time into a small buffer, then runs the paint's color filter,
+ *  xfermode, and coverage over them with an SkRasterPipeline, in a single pass.  (Src-over just
+ *  filters the chunk in place and hands it to the usual blit row procs.)  Used instead of
+ *  SkARGB32_Shader_Blitter and an SkFilterShader when the paint has a color filter the pipeline
+ *  can fuse with its xfermode; see SkRasterPipeline::CanFuse().
+ */
+class SkARGB32_Pipeline_Blitter : public SkShaderBlitter {
+public:
+    SkARGB32_Pipeline_Blitter(const SkBitmap& device, const SkPaint& paint,
+                              SkShader::Context* shaderContext);
+    virtual ~SkARGB32_Pipeline_Blitter();
+    void blitH(int x, int y, int width) override;
+    void blitRect(int x, int y, int width, int height) override;
+    void blitAntiH(int x, int y, const SkAlpha[], const int16_t[]) override;
+    void blitMask(const SkMask&, const SkIRect&) override;
+
+private:
+    void shadeAndRun(int x, int y, SkPMColor device[], int count,
+                     const SkAlpha aa[], SkAlpha constAA);
+
+    SkRasterPipeline    fPipeline;
+    SkRasterPipeline    fXferPipeline;  // fPipeline without the color filter.
+    SkPMColor*          fBuffer;
+    SkBlitRow::Proc32   fProc32;
+    SkBlitRow::Proc32   fProc32Blend;
+    bool                fConstInY;
+
+    // illegal
+    SkARGB32_Pipeline_Blitter& operator=(const SkARGB32_Pipeline_Blitter&);
+
+    typedef SkShaderBlitter INHERITED;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /*  These return the correct subclass of blitter for their device config.
@@ -190,6 +225,7 @@ private:
     1. If there is an xfermode, there will also be a shader
     2. If there is a colorfilter, there will be a shader that itself handles
        calling the filter, so the blitter can always ignore the colorfilter obj
+       (except SkARGB32_Pipeline_Blitter, which applies the filter itself)
 
     These pre-conditions must be handled by the caller, in our case
     SkBlitter::Choose(...)
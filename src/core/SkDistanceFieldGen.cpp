@@ -7,6 +7,8 @@
 
 #include "SkDistanceFieldGen.h"
 #include "SkPoint.h"
+#include "SkTaskGroup.h"
+#include "SkTemplates.h"
 
 struct DFData {
     float   fAlpha;      // alpha value of source texel
@@ -38,29 +40,26 @@ static bool found_edge(const unsigned char* imagePtr, int width, int neighborFla
     const int offsets[8] = {-1, 1, -width-1, -width, -width+1, width-1, width, width+1 };
     SkASSERT(kNum8ConnectedNeighbors == kNeighborFlagCount);
 
-    // search for an edge
-    unsigned char currVal = *imagePtr;
-    unsigned char currCheck = (currVal >> 7);
+    // find the range of the neighbors, treating those outside the image as 0
+    unsigned char minVal = 255;
+    unsigned char maxVal = 0;
     for (int i = 0; i < kNum8ConnectedNeighbors; ++i) {
-        unsigned char neighborVal;
-        if ((1 << i) & neighborFlags) {
-            const unsigned char* checkPtr = imagePtr + offsets[i];
-            neighborVal = *checkPtr;
-        } else {
-            neighborVal = 0;
-        }
-        unsigned char neighborCheck = (neighborVal >> 7);
-        SkASSERT(currCheck == 0 || currCheck == 1);
-        SkASSERT(neighborCheck == 0 || neighborCheck == 1);
-        // if sharp transition
-        if (currCheck != neighborCheck ||
-            // or both <128 and >0
-            (!currCheck && !neighborCheck && currVal && neighborVal)) {
-            return true;
-        }
+        unsigned char neighborVal = ((1 << i) & neighborFlags) ? imagePtr[offsets[i]] : 0;
+        minVal = SkTMin(minVal, neighborVal);
+        maxVal = SkTMax(maxVal, neighborVal);
     }
 
-    return false;
+    unsigned char currVal = *imagePtr;
+    if (currVal >= 128) {
+        // sharp transition to any neighbor <128
+        return minVal < 128;
+    }
+    if (0 == currVal) {
+        // sharp transition to any neighbor >=128
+        return maxVal >= 128;
+    }
+    // sharp transition, or both <128 and >0
+    return maxVal > 0;
 }
 
 static void init_glyph_data(DFData* data, unsigned char* edges, const unsigned char* image,
@@ -327,6 +326,28 @@ static unsigned char pack_distance_field_val(float dist, float distanceMagnitude
 }
 #endif
 
+// we expand our temp data by one more on each side to simplify
+// the scanning code -- will always be treated as infinitely far away
+static const int kDataPad = SK_DistanceFieldPad + 1;
+
+// clears and fills in the temp data for a padded 8-bit image, with distances set at the edges
+static void init_data(DFData* dataPtr, unsigned char* edgePtr, const unsigned char* copyPtr,
+                      int width, int height, int dataWidth, int dataHeight) {
+    sk_bzero(dataPtr, dataWidth*dataHeight*sizeof(DFData));
+    sk_bzero(edgePtr, dataWidth*dataHeight*sizeof(char));
+
+    // copy glyph into distance field storage
+    init_glyph_data(dataPtr, edgePtr, copyPtr,
+                    dataWidth, dataHeight,
+                    width+2, height+2, SK_DistanceFieldPad);
+
+    // create initial distance data, particularly at edges
+    init_distances(dataPtr, edgePtr, dataWidth, dataHeight);
+}
+
+static void pack_distance_field(unsigned char* distanceField, const DFData* dataPtr,
+                                const unsigned char* edgePtr, int dataWidth, int dataHeight);
+
 // assumes a padded 8-bit image and distance field
 // width and height are the original width and height of the image
 static bool generate_distance_field_from_image(unsigned char* distanceField,
@@ -335,31 +356,16 @@ static bool generate_distance_field_from_image(unsigned char* distanceField,
     SkASSERT(distanceField);
     SkASSERT(copyPtr);
 
-    // we expand our temp data by one more on each side to simplify
-    // the scanning code -- will always be treated as infinitely far away
-    int pad = SK_DistanceFieldPad + 1;
-
     // set params for distance field data
-    int dataWidth = width + 2*pad;
-    int dataHeight = height + 2*pad;
+    int dataWidth = width + 2*kDataPad;
+    int dataHeight = height + 2*kDataPad;
 
     // create temp data
-    size_t dataSize = dataWidth*dataHeight*sizeof(DFData);
-    SkAutoSMalloc<1024> dfStorage(dataSize);
+    SkAutoSMalloc<1024> dfStorage(dataWidth*dataHeight*sizeof(DFData));
     DFData* dataPtr = (DFData*) dfStorage.get();
-    sk_bzero(dataPtr, dataSize);
-
     SkAutoSMalloc<1024> edgeStorage(dataWidth*dataHeight*sizeof(char));
     unsigned char* edgePtr = (unsigned char*) edgeStorage.get();
-    sk_bzero(edgePtr, dataWidth*dataHeight*sizeof(char));
-
-    // copy glyph into distance field storage
-    init_glyph_data(dataPtr, edgePtr, copyPtr,
-                    dataWidth, dataHeight,
-                    width+2, height+2, SK_DistanceFieldPad);
-
-    // create initial distance data, particularly at edges
-    init_distances(dataPtr, edgePtr, dataWidth, dataHeight);
+    init_data(dataPtr, edgePtr, copyPtr, width, height, dataWidth, dataHeight);
 
     // now perform Euclidean distance transform to propagate distances
 
@@ -423,9 +429,15 @@ static bool generate_distance_field_from_image(unsigned char* distanceField,
         currEdge -= dataWidth-1;
     }
 
-    // copy results to final distance field data
-    currData = dataPtr + dataWidth+1;
-    currEdge = edgePtr + dataWidth+1;
+    pack_distance_field(distanceField, dataPtr, edgePtr, dataWidth, dataHeight);
+    return true;
+}
+
+// copy results to final distance field data
+static void pack_distance_field(unsigned char* distanceField, const DFData* dataPtr,
+                                const unsigned char* edgePtr, int dataWidth, int dataHeight) {
+    const DFData* currData = dataPtr + dataWidth+1;
+    const unsigned char* currEdge = edgePtr + dataWidth+1;
     unsigned char *dfPtr = distanceField;
     for (int j = 1; j < dataHeight-1; ++j) {
         for (int i = 1; i < dataWidth-1; ++i) {
@@ -454,51 +466,27 @@ static bool generate_distance_field_from_image(unsigned char* distanceField,
         currData += 2;
         currEdge += 2;
     }
-
-    return true;
 }
 
-// assumes an 8-bit image and distance field
-bool SkGenerateDistanceFieldFromA8Image(unsigned char* distanceField,
-                                        const unsigned char* image,
-                                        int width, int height, size_t rowBytes) {
-    SkASSERT(distanceField);
-    SkASSERT(image);
-
-    // create temp data
-    SkAutoSMalloc<1024> copyStorage((width+2)*(height+2)*sizeof(char));
-    unsigned char* copyPtr = (unsigned char*) copyStorage.get();
-
-    // we copy our source image into a padded copy to ensure we catch edge transitions
-    // around the outside
+// we copy our source image into a padded copy to ensure we catch edge transitions
+// around the outside
+static void copy_a8_image(unsigned char* copyPtr, const unsigned char* image,
+                          int width, int height, size_t rowBytes) {
     const unsigned char* currSrcScanLine = image;
     sk_bzero(copyPtr, (width+2)*sizeof(char));
     unsigned char* currDestPtr = copyPtr + width + 2;
     for (int i = 0; i < height; ++i) {
         *currDestPtr++ = 0;
-        memcpy(currDestPtr, currSrcScanLine, rowBytes);
+        memcpy(currDestPtr, currSrcScanLine, width);
         currSrcScanLine += rowBytes;
         currDestPtr += width;
         *currDestPtr++ = 0;
     }
     sk_bzero(currDestPtr, (width+2)*sizeof(char));
-
-    return generate_distance_field_from_image(distanceField, copyPtr, width, height);
 }
 
-// assumes a 1-bit image and 8-bit distance field
-bool SkGenerateDistanceFieldFromBWImage(unsigned char* distanceField,
-                                        const unsigned char* image,
-                                        int width, int height, size_t rowBytes) {
-    SkASSERT(distanceField);
-    SkASSERT(image);
-
-    // create temp data
-    SkAutoSMalloc<1024> copyStorage((width+2)*(height+2)*sizeof(char));
-    unsigned char* copyPtr = (unsigned char*) copyStorage.get();
-
-    // we copy our source image into a padded copy to ensure we catch edge transitions
-    // around the outside
+static void copy_bw_image(unsigned char* copyPtr, const unsigned char* image,
+                          int width, int height, size_t rowBytes) {
     const unsigned char* currSrcScanLine = image;
     sk_bzero(copyPtr, (width+2)*sizeof(char));
     unsigned char* currDestPtr = copyPtr + width + 2;
@@ -516,6 +504,274 @@ bool SkGenerateDistanceFieldFromBWImage(unsigned char* distanceField,
         *currDestPtr++ = 0;
     }
     sk_bzero(currDestPtr, (width+2)*sizeof(char));
+}
+
+// assumes an 8-bit image and distance field
+bool SkGenerateDistanceFieldFromA8Image(unsigned char* distanceField,
+                                        const unsigned char* image,
+                                        int width, int height, size_t rowBytes) {
+    SkASSERT(distanceField);
+    SkASSERT(image);
+
+    // create temp data
+    SkAutoSMalloc<1024> copyStorage((width+2)*(height+2)*sizeof(char));
+    unsigned char* copyPtr = (unsigned char*) copyStorage.get();
+    copy_a8_image(copyPtr, image, width, height, rowBytes);
+
+    return generate_distance_field_from_image(distanceField, copyPtr, width, height);
+}
+
+// assumes a 1-bit image and 8-bit distance field
+bool SkGenerateDistanceFieldFromBWImage(unsigned char* distanceField,
+                                        const unsigned char* image,
+                                        int width, int height, size_t rowBytes) {
+    SkASSERT(distanceField);
+    SkASSERT(image);
+
+    // create temp data
+    SkAutoSMalloc<1024> copyStorage((width+2)*(height+2)*sizeof(char));
+    unsigned char* copyPtr = (unsigned char*) copyStorage.get();
+    copy_bw_image(copyPtr, image, width, height, rowBytes);
 
     return generate_distance_field_from_image(distanceField, copyPtr, width, height);
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Rather than sweeping distances across the image, find each texel's nearest edge texel with
+// the exact distance transform of Felzenszwalb and Huttenlocher ("Distance Transforms of
+// Sampled Functions", 2012), which is separable:
+// 1. For every texel, the nearest edge texel in its column, found by sweeping down and up a
+//    whole row at a time.
+// 2. For every row, the lower envelope of the parabolas (x - q)^2 + dy(q)^2 over its columns q,
+//    which gives each texel the column of its nearest edge texel in the whole image.
+// The nearest edge texel's distance vector, offset to this texel, is then its distance vector,
+// just as the sweeps would propagate it.
+
+static const int kNoEdge = SK_MaxS32 / 4;
+
+// Edges are less than a texel from their edge texel's center, so beyond this squared distance
+// from the nearest center the distance is out of range whichever edge texel it's measured to.
+static const int kFarDistSq = (SK_DistanceFieldMagnitude + 1)*(SK_DistanceFieldMagnitude + 1);
+
+// Fills nearestY with the row of the nearest edge texel in each column, or kNoEdge if none.
+// below is scratch space for a row.
+static void find_nearest_edge_rows(int* nearestY, const unsigned char* edges,
+                                   int dataWidth, int dataHeight, int* below) {
+    // Down: the nearest edge texel at or above.
+    int* above = nearestY;
+    for (int i = 0; i < dataWidth; ++i) {
+        above[i] = edges[i] ? 0 : -kNoEdge;
+    }
+    for (int j = 1; j < dataHeight; ++j) {
+        const int* prev = nearestY + (j-1)*dataWidth;
+        int* curr = nearestY + j*dataWidth;
+        const unsigned char* edgeRow = edges + j*dataWidth;
+        for (int i = 0; i < dataWidth; ++i) {
+            curr[i] = edgeRow[i] ? j : prev[i];
+        }
+    }
+
+    // Up: keep whichever of that and the nearest edge texel below is closer.
+    for (int i = 0; i < dataWidth; ++i) {
+        below[i] = 2*kNoEdge;
+    }
+    for (int j = dataHeight-1; j >= 0; --j) {
+        int* curr = nearestY + j*dataWidth;
+        const unsigned char* edgeRow = edges + j*dataWidth;
+        for (int i = 0; i < dataWidth; ++i) {
+            below[i] = edgeRow[i] ? j : below[i];
+            curr[i] = (below[i] - j < j - curr[i]) ? below[i] : curr[i];
+            curr[i] = (curr[i] < 0 || curr[i] >= dataHeight) ? kNoEdge : curr[i];
+        }
+    }
+}
+
+// For one row, fills nearestX with the column of the nearest edge texel to each texel, or
+// leaves it untouched and returns false if there are no edge texels at all.
+static bool find_nearest_edge_columns(int* nearestX, const int* nearestY, int j, int dataWidth,
+                                      int* envelope, float* bounds) {
+    // envelope[0..k] are the columns whose parabolas make up the lower envelope, and parabola
+    // envelope[k] is lowest from bounds[k] to bounds[k+1].
+    int k = -1;
+    for (int q = 0; q < dataWidth; ++q) {
+        if (kNoEdge == nearestY[q]) {
+            continue;
+        }
+        const int fq = (nearestY[q] - j)*(nearestY[q] - j) + q*q;
+        if (k < 0) {
+            k = 0;
+            envelope[0] = q;
+            bounds[0] = -SK_ScalarInfinity;
+            bounds[1] = SK_ScalarInfinity;
+            continue;
+        }
+        // Drop the parabolas that q's hides. bounds[0] is -infinity, so k stays >= 0.
+        float s;
+        for (;;) {
+            const int p = envelope[k];
+            const int fp = (nearestY[p] - j)*(nearestY[p] - j) + p*p;
+            s = (float)(fq - fp) / (float)(2*(q - p));
+            if (s > bounds[k]) {
+                break;
+            }
+            --k;
+        }
+        ++k;
+        envelope[k] = q;
+        bounds[k] = s;
+        bounds[k+1] = SK_ScalarInfinity;
+    }
+    if (k < 0) {
+        return false;
+    }
+
+    k = 0;
+    for (int i = 0; i < dataWidth; ++i) {
+        while (bounds[k+1] < i) {
+            ++k;
+        }
+        nearestX[i] = envelope[k];
+    }
+    return true;
+}
+
+bool SkDistanceFieldGenerator::generate(unsigned char* distanceField, int width, int height) {
+    const int dataWidth = width + 2*kDataPad;
+    const int dataHeight = height + 2*kDataPad;
+    const int dataCount = dataWidth*dataHeight;
+
+    DFData* dataPtr = (DFData*)fData.reset(dataCount*sizeof(DFData), SkAutoMalloc::kReuse_OnShrink);
+    unsigned char* edgePtr = (unsigned char*)fEdges.reset(dataCount*sizeof(char),
+                                                          SkAutoMalloc::kReuse_OnShrink);
+    int* nearestY = (int*)fNearestY.reset(dataCount*sizeof(int), SkAutoMalloc::kReuse_OnShrink);
+    int* rowScratch = (int*)fRowScratch.reset(dataWidth*(2*sizeof(int) + sizeof(float)) +
+                                              sizeof(float), SkAutoMalloc::kReuse_OnShrink);
+    int* nearestX = rowScratch;
+    int* envelope = rowScratch + dataWidth;
+    float* bounds = (float*)(rowScratch + 2*dataWidth);
+
+    init_data(dataPtr, edgePtr, (const unsigned char*)fCopy.get(), width, height,
+              dataWidth, dataHeight);
+    find_nearest_edge_rows(nearestY, edgePtr, dataWidth, dataHeight, nearestX);
+
+    for (int j = 0; j < dataHeight; ++j) {
+        const int* nearestYRow = nearestY + j*dataWidth;
+        if (!find_nearest_edge_columns(nearestX, nearestYRow, j, dataWidth, envelope, bounds)) {
+            // No edges anywhere; everything stays far away.
+            break;
+        }
+        DFData* currData = dataPtr + j*dataWidth;
+        const unsigned char* currEdge = edgePtr + j*dataWidth;
+        for (int i = 0; i < dataWidth; ++i) {
+            // don't need to calculate distance for edge pixels
+            if (currEdge[i]) {
+                continue;
+            }
+            const int edgeX = nearestX[i];
+            const int edgeY = nearestYRow[edgeX];
+            const int centerDistSq = (edgeX - i)*(edgeX - i) + (edgeY - j)*(edgeY - j);
+            if (centerDistSq > kFarDistSq) {
+                SkPoint distVec = dataPtr[edgeY*dataWidth + edgeX].fDistVector;
+                distVec.fX += (float)(edgeX - i);
+                distVec.fY += (float)(edgeY - j);
+                currData[i].fDistVector = distVec;
+                currData[i].fDistSq = distVec.lengthSqd();
+                continue;
+            }
+            // The nearest edge texel's center may not be the nearest edge, so also try the edge
+            // texels around it.
+            for (int y = edgeY - 1; y <= edgeY + 1; ++y) {
+                for (int x = edgeX - 1; x <= edgeX + 1; ++x) {
+                    if (!edgePtr[y*dataWidth + x]) {
+                        continue;
+                    }
+                    SkPoint distVec = dataPtr[y*dataWidth + x].fDistVector;
+                    distVec.fX += (float)(x - i);
+                    distVec.fY += (float)(y - j);
+                    const float distSq = distVec.lengthSqd();
+                    if (distSq < currData[i].fDistSq) {
+                        currData[i].fDistVector = distVec;
+                        currData[i].fDistSq = distSq;
+                    }
+                }
+            }
+        }
+    }
+
+    pack_distance_field(distanceField, dataPtr, edgePtr, dataWidth, dataHeight);
+    return true;
+}
+
+bool SkDistanceFieldGenerator::generateFromA8Image(unsigned char* distanceField,
+                                                   const unsigned char* image,
+                                                   int width, int height, size_t rowBytes) {
+    SkASSERT(distanceField);
+    SkASSERT(image);
+
+    unsigned char* copyPtr = (unsigned char*)fCopy.reset((width+2)*(height+2)*sizeof(char),
+                                                         SkAutoMalloc::kReuse_OnShrink);
+    copy_a8_image(copyPtr, image, width, height, rowBytes);
+    return this->generate(distanceField, width, height);
+}
+
+bool SkDistanceFieldGenerator::generateFromBWImage(unsigned char* distanceField,
+                                                   const unsigned char* image,
+                                                   int width, int height, size_t rowBytes) {
+    SkASSERT(distanceField);
+    SkASSERT(image);
+
+    unsigned char* copyPtr = (unsigned char*)fCopy.reset((width+2)*(height+2)*sizeof(char),
+                                                         SkAutoMalloc::kReuse_OnShrink);
+    copy_bw_image(copyPtr, image, width, height, rowBytes);
+    return this->generate(distanceField, width, height);
+}
+
+namespace {
+
+// A run of jobs, done in order with one generator so they share its scratch memory.
+struct JobBatch {
+    const SkDistanceFieldJob* fJobs;
+    int                       fCount;
+    bool                      fSuccess;
+};
+
+}  // namespace
+
+static void generate_batch(JobBatch* batch) {
+    SkDistanceFieldGenerator generator;
+    batch->fSuccess = true;
+    for (int i = 0; i < batch->fCount; ++i) {
+        const SkDistanceFieldJob& job = batch->fJobs[i];
+        bool success = job.fIsBW
+                     ? generator.generateFromBWImage(job.fDistanceField, job.fImage,
+                                                     job.fWidth, job.fHeight, job.fRowBytes)
+                     : generator.generateFromA8Image(job.fDistanceField, job.fImage,
+                                                     job.fWidth, job.fHeight, job.fRowBytes);
+        batch->fSuccess = batch->fSuccess && success;
+    }
+}
+
+bool SkGenerateDistanceFields(const SkDistanceFieldJob jobs[], int count) {
+    static const int kMaxBatches = 32;
+    const int batchCount = SkTMin(count, kMaxBatches);
+    if (batchCount <= 0) {
+        return true;
+    }
+
+    SkAutoSTMalloc<kMaxBatches, JobBatch> batches(batchCount);
+    for (int i = 0; i < batchCount; ++i) {
+        const int first = count * i / batchCount;
+        batches[i].fJobs = jobs + first;
+        batches[i].fCount = count * (i + 1) / batchCount - first;
+    }
+    SkTaskGroup tg;
+    tg.batch(generate_batch, batches.get(), batchCount);
+    tg.wait();
+
+    bool success = true;
+    for (int i = 0; i < batchCount; ++i) {
+        success = success && batches[i].fSuccess;
+    }
+    return success;
+}
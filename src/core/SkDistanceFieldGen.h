@@ -50,6 +50,50 @@ bool SkGenerateDistanceFieldFromBWImage(unsigned char* distanceField,
                                         const unsigned char* image,
                                         int w, int h, size_t rowBytes);
 
+/** Generates the same distance fields as the functions above, but finds each texel's nearest
+ *  edge texel with an exact Euclidean distance transform that runs in time linear in the size
+ *  of the field, rather than with the approximate 8SSEDT sweeps. Results may differ slightly
+ *  from the sweeps', which can settle on an edge texel that is not quite the nearest.
+ *
+ *  A generator keeps its scratch memory from one field to the next, so use one generator for
+ *  many glyphs. It is not thread safe.
+ */
+class SkDistanceFieldGenerator : SkNoncopyable {
+public:
+    /** Like SkGenerateDistanceFieldFromA8Image(). */
+    bool generateFromA8Image(unsigned char* distanceField, const unsigned char* image,
+                             int w, int h, size_t rowBytes);
+
+    /** Like SkGenerateDistanceFieldFromBWImage(). */
+    bool generateFromBWImage(unsigned char* distanceField, const unsigned char* image,
+                             int w, int h, size_t rowBytes);
+
+private:
+    // Generates from the padded copy of the image in fCopy.
+    bool generate(unsigned char* distanceField, int w, int h);
+
+    SkAutoMalloc fCopy;
+    SkAutoMalloc fData;
+    SkAutoMalloc fEdges;
+    SkAutoMalloc fNearestY;
+    SkAutoMalloc fRowScratch;
+};
+
+/** One distance field for SkGenerateDistanceFields() to generate. */
+struct SkDistanceFieldJob {
+    unsigned char*       fDistanceField;    // Allocated with SkComputeDistanceFieldSize().
+    const unsigned char* fImage;
+    int                  fWidth;
+    int                  fHeight;
+    size_t               fRowBytes;
+    bool                 fIsBW;             // 1-bit rather than 8-bit mask.
+};
+
+/** Generates many distance fields, in parallel, with SkDistanceFieldGenerators.
+ *  Returns false if any of them failed.
+ */
+bool SkGenerateDistanceFields(const SkDistanceFieldJob jobs[], int count);
+
 /** Given width and height of original image, return size (in bytes) of distance field
  *  @param w                 Width of the original image.
  *  @param h                 Height of the original image.
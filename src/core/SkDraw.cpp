@@ -10,6 +10,7 @@
 #include "SkBlitter.h"
 #include "SkCanvas.h"
 #include "SkColorPriv.h"
+#include "SkDashPathPriv.h"
 #include "SkDevice.h"
 #include "SkDeviceLooper.h"
 #include "SkFixed.h"
@@ -24,6 +25,7 @@
 #include "SkSmallAllocator.h"
 #include "SkString.h"
 #include "SkStroke.h"
+#include "SkStrokeCache.h"
 #include "SkTextMapStateProc.h"
 #include "SkTLazy.h"
 #include "SkUtils.h"
@@ -823,6 +825,7 @@ void SkDraw::drawRect(const SkRect& prePaintRect, const SkPaint& paint,
         SkPath  tmp;
         tmp.addRect(prePaintRect);
         tmp.setFillType(SkPath::kWinding_FillType);
+        tmp.setIsVolatile(true);
         draw.drawPath(tmp, paint, NULL, true);
         return;
     }
@@ -1001,6 +1004,7 @@ DRAW_PATH:
     // Now fall back to the default case of using a path.
     SkPath path;
     path.addRRect(rrect);
+    path.setIsVolatile(true);
     this->drawPath(path, paint, NULL, true);
 }
 
@@ -1015,6 +1019,84 @@ static SkScalar compute_res_scale_for_stroking(const SkMatrix& matrix) {
     return 1;
 }
 
+// Draws each batch of segments from SkDashPath::StreamDashPath() as a path of its own.
+class SkDraw::DashSegmentDrawer : public SkDashPath::SegmentSink {
+public:
+    DashSegmentDrawer(const SkDraw& draw, const SkMatrix& matrix, const SkPaint& paint,
+                      bool drawCoverage, SkBlitter* customBlitter)
+        : fDraw(draw)
+        , fPaint(paint)
+        , fStyle(paint.getStyle())
+        , fDrawCoverage(drawCoverage)
+        , fCustomBlitter(customBlitter) {
+        fDraw.fMatrix = &matrix;
+        fPaint.setPathEffect(NULL);
+    }
+
+    void drawSegments(const SkPath& segments, const SkStrokeRec& rec) override {
+        fPaint.setStyle(rec.isFillStyle() ? SkPaint::kFill_Style : fStyle);
+        fDraw.drawPath(segments, fPaint, NULL, false, fDrawCoverage, fCustomBlitter);
+    }
+
+private:
+    SkDraw          fDraw;
+    SkPaint         fPaint;
+    SkPaint::Style  fStyle;
+    bool            fDrawCoverage;
+    SkBlitter*      fCustomBlitter;
+};
+
+// The dasher strokes a line with butt caps itself, into a rect per dash. If the rects are far
+// enough apart that no pixel touches two of them, filling them separately changes nothing.
+static bool dashes_are_separate_rects(const SkPath& path, const SkPaint& paint,
+                                      const SkMatrix& matrix, const SkPathEffect::DashInfo& info) {
+    SkPoint pts[2];
+    if (!path.isLine(pts) || pts[0] == pts[1] || SkPaint::kButt_Cap != paint.getStrokeCap() ||
+            matrix.hasPerspective()) {
+        return false;
+    }
+
+    SkVector tangent = pts[1] - pts[0];
+    tangent.normalize();
+    matrix.mapVectors(&tangent, 1);
+    SkScalar minGap = SK_ScalarMax;
+    for (int i = 1; i < info.fCount; i += 2) {
+        minGap = SkTMin(minGap, info.fIntervals[i]);
+    }
+    return minGap * tangent.length() > SK_ScalarSqrt2;
+}
+
+bool SkDraw::drawStreamedDash(const SkPath& path, const SkPaint& paint, const SkMatrix& matrix,
+                              bool drawCoverage, SkBlitter* customBlitter) const {
+    // Rasterizers and mask filters need the whole dashed path.
+    SkPathEffect::DashInfo info;
+    if (paint.getRasterizer() || paint.getMaskFilter() ||
+            SkPathEffect::kDash_DashType != paint.getPathEffect()->asADash(&info)) {
+        return false;
+    }
+    SkAutoSTArray<16, SkScalar> intervals(info.fCount);
+    info.fIntervals = intervals.get();
+    paint.getPathEffect()->asADash(&info);
+
+    if (SkDashPath::MaxDashCount(path, info) <= SkDashPath::kMaxSegmentsPerBatch) {
+        return false;
+    }
+
+    // Hairline segments are always drawn one at a time, so they can be batched any way we like.
+    SkStrokeRec rec(paint, compute_res_scale_for_stroking(*fMatrix));
+    if (!rec.isHairlineStyle() && !dashes_are_separate_rects(path, paint, matrix, info)) {
+        return false;
+    }
+
+    SkRect cullRect;
+    const SkRect* cullRectPtr = NULL;
+    if (this->computeConservativeLocalClipBounds(&cullRect)) {
+        cullRectPtr = &cullRect;
+    }
+    DashSegmentDrawer drawer(*this, matrix, paint, drawCoverage, customBlitter);
+    return SkDashPath::StreamDashPath(path, &rec, cullRectPtr, info, &drawer);
+}
+
 void SkDraw::drawPath(const SkPath& origSrcPath, const SkPaint& origPaint,
                       const SkMatrix* prePathMatrix, bool pathIsMutable,
                       bool drawCoverage, SkBlitter* customBlitter) const {
@@ -1077,14 +1159,20 @@ void SkDraw::drawPath(const SkPath& origSrcPath, const SkPaint& origPaint,
         }
     }
 
+    // Long dashed paths can have millions of segments; draw them without building that path.
+    if (paint->getPathEffect() &&
+            this->drawStreamedDash(*pathPtr, *paint, *matrix, drawCoverage, customBlitter)) {
+        return;
+    }
+
     if (paint->getPathEffect() || paint->getStyle() != SkPaint::kFill_Style) {
         SkRect cullRect;
         const SkRect* cullRectPtr = NULL;
         if (this->computeConservativeLocalClipBounds(&cullRect)) {
             cullRectPtr = &cullRect;
         }
-        doFill = paint->getFillPath(*pathPtr, &tmpPath, cullRectPtr,
-                                    compute_res_scale_for_stroking(*fMatrix));
+        doFill = SkStrokeCache::GetFillPath(*paint, *pathPtr, &tmpPath, cullRectPtr,
+                                            compute_res_scale_for_stroking(*fMatrix));
         pathPtr = &tmpPath;
     }
 
@@ -1443,6 +1531,101 @@ void SkDraw::drawText_asPaths(const char text[], size_t byteLength,
 
 //////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Walks data written by SkPackBits::Pack8 span by span, so that packed glyph images can be
+// unpacked a row at a time.
+class PackedSpanReader {
+public:
+    PackedSpanReader(const void* packed)
+        : fSrc((const uint8_t*)packed), fCount(0), fRepeat(false) {}
+
+    /** Returns the length (at most max) of the next span. If the span repeats one value, sets
+        *value and sets *literal to NULL. Otherwise *literal points at the span's bytes.
+     */
+    int next(int max, uint8_t* value, const uint8_t** literal) {
+        if (0 == fCount) {
+            unsigned n = *fSrc++;
+            fRepeat = n <= 127;
+            fCount = fRepeat ? n + 1 : n - 127;
+        }
+        int len = SkMin32(fCount, max);
+        fCount -= len;
+        if (fRepeat) {
+            *value = *fSrc;
+            *literal = NULL;
+            if (0 == fCount) {
+                fSrc += 1;
+            }
+        } else {
+            *literal = fSrc;
+            fSrc += len;
+        }
+        return len;
+    }
+
+    void skip(int count) {
+        uint8_t value;
+        const uint8_t* literal;
+        while (count > 0) {
+            count -= this->next(count, &value, &literal);
+        }
+    }
+
+    /** Unpacks the next count bytes into dst. Returns false if they are known to be all zero. */
+    bool read(uint8_t* dst, int count) {
+        uint8_t value;
+        const uint8_t* literal;
+        bool nonZero = false;
+        while (count > 0) {
+            int n = this->next(count, &value, &literal);
+            if (literal) {
+                memcpy(dst, literal, n);
+                nonZero = true;
+            } else {
+                memset(dst, value, n);
+                nonZero |= (0 != value);
+            }
+            dst += n;
+            count -= n;
+        }
+        return nonZero;
+    }
+
+private:
+    const uint8_t*  fSrc;
+    int             fCount;     // bytes left in the current span
+    bool            fRepeat;
+};
+
+}  // namespace
+
+/** Blits the part of a packed kA8 or kBW glyph at (left, top) that falls in clip. Rows are
+    unpacked one at a time and blitted as one-row masks, so the result matches blitting the
+    unpacked glyph, and rows that are entirely empty are skipped.
+ */
+static void blit_packed_glyph(SkBlitter* blitter, const SkGlyph& glyph, int left, int top,
+                              const SkIRect& clip) {
+    SkASSERT(glyph.isImagePacked());
+    SkASSERT(clip.fTop >= top && clip.fBottom <= top + glyph.fHeight);
+    const int rowBytes = glyph.rowBytes();
+
+    PackedSpanReader reader(glyph.fImage);
+    reader.skip((clip.fTop - top) * rowBytes);
+
+    SkAutoSTMalloc<128, uint8_t> row(rowBytes);
+    SkMask mask;
+    mask.fImage = row.get();
+    mask.fRowBytes = rowBytes;
+    mask.fFormat = static_cast<SkMask::Format>(glyph.fMaskFormat);
+    for (int y = clip.fTop; y < clip.fBottom; ++y) {
+        if (reader.read(row.get(), rowBytes)) {
+            mask.fBounds.set(left, y, left + glyph.fWidth, y + 1);
+            blitter->blitMask(mask, SkIRect::MakeLTRB(clip.fLeft, y, clip.fRight, y + 1));
+        }
+    }
+}
+
 static void D1G_RectClip(const SkDraw1Glyph& state, Sk48Dot16 fx, Sk48Dot16 fy, const SkGlyph& glyph) {
     // Prevent glyphs from being drawn outside of or straddling the edge of device space.
     if ((fx >> 16) > INT_MAX - (INT16_MAX + UINT16_MAX) ||
@@ -1485,6 +1668,9 @@ static void D1G_RectClip(const SkDraw1Glyph& state, Sk48Dot16 fx, Sk48Dot16 fy,
         if (NULL == aa) {
             return; // can't rasterize glyph
         }
+    } else if (glyph.isImagePacked()) {
+        blit_packed_glyph(state.fBlitter, glyph, left, top, *bounds);
+        return;
     }
 
     mask.fRowBytes = glyph.rowBytes();
@@ -1515,6 +1701,12 @@ static void D1G_RgnClip(const SkDraw1Glyph& state, Sk48Dot16 fx, Sk48Dot16 fy, c
             if (NULL == aa) {
                 return;
             }
+        } else if (glyph.isImagePacked()) {
+            do {
+                blit_packed_glyph(state.fBlitter, glyph, left, top, clipper.rect());
+                clipper.next();
+            } while (!clipper.done());
+            return;
         }
 
         mask.fRowBytes = glyph.rowBytes();
@@ -10,6 +10,8 @@
 #include "SkData.h"
 #include "SkFlate.h"
 #include "SkStream.h"
+#include "SkTaskGroup.h"
+#include "SkTDArray.h"
 
 namespace {
 
@@ -108,22 +110,162 @@ bool doFlate(bool compress, SkStream* src, SkWStream* dst) {
     return false;
 }
 
+
+// Inputs are split into blocks of this size which are deflated independently (and in parallel
+// when SkTaskGroup has threads), each primed with the preceding kDictionarySize bytes of input.
+// Every block but the last ends with a Z_SYNC_FLUSH so the raw deflate streams are byte aligned
+// and concatenate into one valid zlib stream, a la pigz.
+const size_t kParallelBlockSize = 128 * 1024;
+const size_t kDictionarySize    = 32 * 1024;  // The deflate window.
+
+// SkFlate::Deflate() uses the parallel path for in-memory inputs of at least this many bytes.
+const size_t kParallelMinInputSize = 2 * kParallelBlockSize;
+
+// SkDeflateWStream buffers up to this many blocks of input before compressing them as a batch.
+const int kBlocksPerBatch = 4;
+
+struct DeflateBlock {
+    DeflateBlock() : fDict(NULL), fDictLen(0), fInput(NULL), fInputLen(0), fFinish(false)
+                   , fAdler(0), fSuccess(false) {}
+
+    const uint8_t* fDict;
+    size_t fDictLen;
+    const uint8_t* fInput;
+    size_t fInputLen;
+    bool fFinish;
+
+    // Outputs.
+    uLong fAdler;
+    bool fSuccess;
+    SkDynamicMemoryWStream fOut;
+};
+
+void deflate_block(DeflateBlock* block) {
+    z_stream flateData;
+    flateData.zalloc = &skia_alloc_func;
+    flateData.zfree = &skia_free_func;
+    flateData.opaque = NULL;
+    // Negative window bits: raw deflate, no zlib header or trailer.  We write those once for
+    // the whole stream in write_zlib_header() and write_zlib_trailer().
+    if (deflateInit2(&flateData, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+        return;
+    }
+    if (block->fDictLen > 0 &&
+        deflateSetDictionary(&flateData, block->fDict, SkToUInt(block->fDictLen)) != Z_OK) {
+        deflateEnd(&flateData);
+        return;
+    }
+    block->fAdler = adler32(adler32(0L, NULL, 0), block->fInput, SkToUInt(block->fInputLen));
+
+    uint8_t outputBuffer[kBufferSize];
+    flateData.next_in = const_cast<uint8_t*>(block->fInput);
+    flateData.avail_in = SkToUInt(block->fInputLen);
+    const int flush = block->fFinish ? Z_FINISH : Z_SYNC_FLUSH;
+    int rc;
+    do {
+        flateData.next_out = outputBuffer;
+        flateData.avail_out = kBufferSize;
+        rc = deflate(&flateData, flush);
+        block->fOut.write(outputBuffer, kBufferSize - flateData.avail_out);
+    } while (rc == Z_OK && (flateData.avail_in || !flateData.avail_out));
+    deflateEnd(&flateData);
+
+    // A sync flush that exactly filled the output buffer reports Z_BUF_ERROR on the next call.
+    block->fSuccess = block->fFinish ? rc == Z_STREAM_END : (rc == Z_OK || rc == Z_BUF_ERROR);
+}
+
+bool write_zlib_header(SkWStream* dst) {
+    // CMF = deflate with a 32K window, FLG = default compression level, no preset dictionary,
+    // with the check bits set so that (CMF * 256 + FLG) % 31 == 0.
+    static const uint8_t kHeader[] = { 0x78, 0x9C };
+    return dst->write(kHeader, sizeof(kHeader));
+}
+
+bool write_zlib_trailer(uLong adler, SkWStream* dst) {
+    const uint8_t trailer[] = {
+        (uint8_t)(adler >> 24), (uint8_t)(adler >> 16), (uint8_t)(adler >> 8), (uint8_t)adler,
+    };
+    return dst->write(trailer, sizeof(trailer));
+}
+
+// Deflate the len bytes of input following the historyLen bytes at data, in kParallelBlockSize
+// blocks.  The history is only used to prime the first block's dictionary.  If finish is true,
+// the last block ends the deflate stream (even if len is 0).  The Adler-32 checksum of the
+// input is folded into *adler.
+bool deflate_blocks(const uint8_t* data, size_t historyLen, size_t len, bool finish,
+                    SkWStream* dst, uLong* adler) {
+    int count = SkToInt((len + kParallelBlockSize - 1) / kParallelBlockSize);
+    if (0 == count) {
+        if (!finish) {
+            return true;
+        }
+        count = 1;
+    }
+
+    SkAutoTArray<DeflateBlock> blocks(count);
+    const uint8_t* input = data + historyLen;
+    for (int i = 0; i < count; i++) {
+        size_t offset = i * kParallelBlockSize;
+        size_t available = historyLen + offset;
+        blocks[i].fDictLen = SkTMin(available, kDictionarySize);
+        blocks[i].fDict = input + offset - blocks[i].fDictLen;
+        blocks[i].fInput = input + offset;
+        blocks[i].fInputLen = SkTMin(len - offset, kParallelBlockSize);
+        blocks[i].fFinish = finish && i == count - 1;
+    }
+
+    if (count > 1) {
+        SkTaskGroup().batch(deflate_block, blocks.get(), count);
+    } else {
+        deflate_block(&blocks[0]);
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (!blocks[i].fSuccess) {
+            return false;
+        }
+        SkAutoTUnref<SkData> out(blocks[i].fOut.copyToData());
+        if (!dst->write(out->data(), out->size())) {
+            return false;
+        }
+        *adler = adler32_combine(*adler, blocks[i].fAdler, (z_off_t)blocks[i].fInputLen);
+    }
+    return true;
+}
+
+bool deflate_parallel(const uint8_t* input, size_t len, SkWStream* dst) {
+    uLong adler = adler32(0L, NULL, 0);
+    return write_zlib_header(dst) &&
+           deflate_blocks(input, 0, len, true, dst, &adler) &&
+           write_zlib_trailer(adler, dst);
+}
+
+bool deflate_stream(SkStream* src, SkWStream* dst) {
+    const uint8_t* input = (const uint8_t*)src->getMemoryBase();
+    size_t inputLength = src->getLength();
+    if (input != NULL && inputLength >= kParallelMinInputSize) {
+        return deflate_parallel(input, inputLength, dst);
+    }
+    return doFlate(true, src, dst);
+}
+
 }
 
 // static
 bool SkFlate::Deflate(SkStream* src, SkWStream* dst) {
-    return doFlate(true, src, dst);
+    return deflate_stream(src, dst);
 }
 
 bool SkFlate::Deflate(const void* ptr, size_t len, SkWStream* dst) {
     SkMemoryStream stream(ptr, len);
-    return doFlate(true, &stream, dst);
+    return deflate_stream(&stream, dst);
 }
 
 bool SkFlate::Deflate(const SkData* data, SkWStream* dst) {
     if (data) {
         SkMemoryStream stream(data->data(), data->size());
-        return doFlate(true, &stream, dst);
+        return deflate_stream(&stream, dst);
     }
     return false;
 }
@@ -134,92 +276,78 @@ bool SkFlate::Inflate(SkStream* src, SkWStream* dst) {
 }
 
 
-#define SKDEFLATEWSTREAM_INPUT_BUFFER_SIZE 4096
-#define SKDEFLATEWSTREAM_OUTPUT_BUFFER_SIZE 4224  // 4096 + 128, usually big
-                                                  // enough to always do a
-                                                  // single loop.
+// Hide all zlib impl details.
+struct SkDeflateWStream::Impl {
+    Impl() : fOut(NULL), fHistoryLen(0), fTotalIn(0), fAdler(adler32(0L, NULL, 0)) {}
 
-// called by both write() and finalize()
-static void do_deflate(int flush,
-                       z_stream* zStream,
-                       SkWStream* out,
-                       unsigned char* inBuffer,
-                       size_t inBufferSize) {
-    zStream->next_in = inBuffer;
-    zStream->avail_in = SkToInt(inBufferSize);
-    unsigned char outBuffer[SKDEFLATEWSTREAM_OUTPUT_BUFFER_SIZE];
-    SkDEBUGCODE(int returnValue;)
-    do {
-        zStream->next_out = outBuffer;
-        zStream->avail_out = sizeof(outBuffer);
-        SkDEBUGCODE(returnValue =) deflate(zStream, flush);
-        SkASSERT(!zStream->msg);
+    // Deflate the buffered input: only whole blocks unless finish is true.
+    bool flush(bool finish) {
+        size_t pending = fInput.count() - fHistoryLen;
+        size_t len = finish ? pending : pending - pending % kParallelBlockSize;
+        if (!deflate_blocks(fInput.begin(), fHistoryLen, len, finish, fOut, &fAdler)) {
+            return false;
+        }
+        fTotalIn += len;
 
-        out->write(outBuffer, sizeof(outBuffer) - zStream->avail_out);
-    } while (zStream->avail_in || !zStream->avail_out);
-    SkASSERT(flush == Z_FINISH
-                 ? returnValue == Z_STREAM_END
-                 : returnValue == Z_OK);
-}
+        // Keep the tail of what we just compressed to prime the next block's dictionary.
+        size_t consumed = fHistoryLen + len;
+        size_t discard = consumed - SkTMin(consumed, kDictionarySize);
+        memmove(fInput.begin(), fInput.begin() + discard, fInput.count() - discard);
+        fInput.setCount(fInput.count() - SkToInt(discard));
+        fHistoryLen = consumed - discard;
+        return true;
+    }
 
-// Hide all zlib impl details.
-struct SkDeflateWStream::Impl {
     SkWStream* fOut;
-    unsigned char fInBuffer[SKDEFLATEWSTREAM_INPUT_BUFFER_SIZE];
-    size_t fInBufferIndex;
-    z_stream fZStream;
+    SkTDArray<uint8_t> fInput;  // fHistoryLen bytes of dictionary, then pending input.
+    size_t fHistoryLen;
+    size_t fTotalIn;
+    uLong fAdler;
 };
 
 SkDeflateWStream::SkDeflateWStream(SkWStream* out)
     : fImpl(SkNEW(SkDeflateWStream::Impl)) {
     fImpl->fOut = out;
-    fImpl->fInBufferIndex = 0;
     if (!fImpl->fOut) {
         return;
     }
-    fImpl->fZStream.zalloc = &skia_alloc_func;
-    fImpl->fZStream.zfree = &skia_free_func;
-    fImpl->fZStream.opaque = NULL;
-    SkDEBUGCODE(int r =) deflateInit(&fImpl->fZStream, Z_DEFAULT_COMPRESSION);
-    SkASSERT(Z_OK == r);
+    SkDEBUGCODE(bool r =) write_zlib_header(fImpl->fOut);
+    SkASSERT(r);
 }
 
 SkDeflateWStream::~SkDeflateWStream() { this->finalize(); }
 
-void SkDeflateWStream::finalize() {
+bool SkDeflateWStream::finalize() {
     if (!fImpl->fOut) {
-        return;
+        return true;
     }
-    do_deflate(Z_FINISH, &fImpl->fZStream, fImpl->fOut, fImpl->fInBuffer,
-               fImpl->fInBufferIndex);
-    (void)deflateEnd(&fImpl->fZStream);
+    bool success = fImpl->flush(true) && write_zlib_trailer(fImpl->fAdler, fImpl->fOut);
+    fImpl->fInput.reset();
     fImpl->fOut = NULL;
+    return success;
 }
 
 bool SkDeflateWStream::write(const void* void_buffer, size_t len) {
     if (!fImpl->fOut) {
         return false;
     }
-    const char* buffer = (const char*)void_buffer;
+    const size_t kBatchSize = kBlocksPerBatch * kParallelBlockSize;
+    const uint8_t* buffer = (const uint8_t*)void_buffer;
     while (len > 0) {
-        size_t tocopy =
-                SkTMin(len, sizeof(fImpl->fInBuffer) - fImpl->fInBufferIndex);
-        memcpy(fImpl->fInBuffer + fImpl->fInBufferIndex, buffer, tocopy);
+        size_t pending = fImpl->fInput.count() - fImpl->fHistoryLen;
+        size_t tocopy = SkTMin(len, kBatchSize - pending);
+        fImpl->fInput.append(SkToInt(tocopy), buffer);
         len -= tocopy;
         buffer += tocopy;
-        fImpl->fInBufferIndex += tocopy;
-        SkASSERT(fImpl->fInBufferIndex <= sizeof(fImpl->fInBuffer));
-
-        // if the buffer isn't filled, don't call into zlib yet.
-        if (sizeof(fImpl->fInBuffer) == fImpl->fInBufferIndex) {
-            do_deflate(Z_NO_FLUSH, &fImpl->fZStream, fImpl->fOut,
-                       fImpl->fInBuffer, fImpl->fInBufferIndex);
-            fImpl->fInBufferIndex = 0;
+
+        // if the batch isn't filled, don't call into zlib yet.
+        if (kBatchSize == pending + tocopy && !fImpl->flush(false)) {
+            return false;
         }
     }
     return true;
 }
 
 size_t SkDeflateWStream::bytesWritten() const {
-    return fImpl->fZStream.total_in + fImpl->fInBufferIndex;
+    return fImpl->fTotalIn + fImpl->fInput.count() - fImpl->fHistoryLen;
 }
@@ -17,6 +17,9 @@ class SkData;
 
 /** \class SkFlate
     A class to provide access to the flate compression algorithm.
+
+    Large in-memory inputs are deflated in independent blocks on SkTaskGroup,
+    which are concatenated into a single zlib stream.
 */
 class SkFlate {
 public:
@@ -47,7 +50,8 @@ public:
 /**
   * Wrap a stream in this class to compress the information written to
   * this stream using the Deflate algorithm.  Uses Zlib's
-  * Z_DEFAULT_COMPRESSION level.
+  * Z_DEFAULT_COMPRESSION level.  Input is buffered and compressed in
+  * batches of blocks, in parallel on SkTaskGroup when threads are enabled.
   *
   * See http://en.wikipedia.org/wiki/DEFLATE
   */
@@ -60,8 +64,9 @@ public:
     ~SkDeflateWStream();
 
     /** Write the end of the compressed stream.  All subsequent calls to
-        write() will fail. Subsequent calls to finalize() do nothing. */
-    void finalize();
+        write() will fail. Subsequent calls to finalize() do nothing and
+        return true. Returns false if the wrapped stream could not be written. */
+    bool finalize();
 
     // The SkWStream interface:
     bool write(const void*, size_t) override;
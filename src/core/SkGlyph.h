@@ -45,7 +45,10 @@ class SkGlyph {
 
     uint8_t     fMaskFormat;
     int8_t      fRsbDelta, fLsbDelta;  // used by auto-kerning
-    int8_t      fForceBW;
+    uint8_t     fForceBW : 1;
+    // If set, fImage holds the SkPackBits::Pack8 encoding of the image rather than its pixels.
+    // Only SkGlyphCache sets this, and only for kA8 and kBW glyphs.
+    uint8_t     fImageIsPacked : 1;
 
     void initWithGlyphID(uint32_t glyph_id) {
         this->initCommon(MakeID(glyph_id));
@@ -88,6 +91,10 @@ class SkGlyph {
         return MASK_FORMAT_JUST_ADVANCE != fMaskFormat;
     }
 
+    bool isImagePacked() const {
+        return fImageIsPacked;
+    }
+
     uint16_t getGlyphID() const {
         return ID2Code(fID);
     }
@@ -124,6 +131,7 @@ class SkGlyph {
         fPath           = NULL;
         fMaskFormat     = MASK_FORMAT_UNKNOWN;
         fForceBW        = 0;
+        fImageIsPacked  = 0;
     }
 
     static unsigned ID2Code(uint32_t id) {
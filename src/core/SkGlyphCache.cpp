@@ -7,8 +7,10 @@
 
 #include "SkGlyphCache.h"
 #include "SkGlyphCache_Globals.h"
+#include "SkGlyphDiskCache.h"
 #include "SkGraphics.h"
 #include "SkLazyPtr.h"
+#include "SkPackBits.h"
 #include "SkPaint.h"
 #include "SkPath.h"
 #include "SkTemplates.h"
@@ -57,7 +59,9 @@ static SkGlyphCache_Globals& getGlobals() {
 #define kMinAllocAmount     ((sizeof(SkGlyph) + kMinGlyphImageSize) * kMinGlyphCount)
 
 SkGlyphCache::SkGlyphCache(SkTypeface* typeface, const SkDescriptor* desc, SkScalerContext* ctx)
-        : fScalerContext(ctx), fGlyphAlloc(kMinAllocAmount) {
+        : fScalerContext(ctx), fGlyphAlloc(kMinAllocAmount)
+        , fPackImages(false), fUnpackedImageSize(0)
+        , fDiskCache(SkGlyphDiskCache::RefGlobal()) {
     SkASSERT(typeface);
     SkASSERT(desc);
     SkASSERT(ctx);
@@ -66,6 +70,17 @@ SkGlyphCache::SkGlyphCache(SkTypeface* typeface, const SkDescriptor* desc, SkSca
 
     fDesc = desc->copy();
     fScalerContext->getFontMetrics(&fFontMetrics);
+    if (fDiskCache) {
+        // Without an engine version, images cached by an older engine could never be told apart
+        // from our own, so don't use the disk at all.
+        SkString engine;
+        ctx->getEngineVersion(&engine);
+        if (engine.isEmpty()) {
+            fDiskCache.reset(NULL);
+        } else {
+            fDiskStrikeKey.reset(SkGlyphDiskCache::NewStrikeKey(ctx, *desc));
+        }
+    }
 
     // Create the sentinel SkGlyph.
     SkGlyph* sentinel = fGlyphArray.insert(0);
@@ -316,22 +331,91 @@ const void* SkGlyphCache::findImage(const SkGlyph& glyph) {
     if (glyph.fWidth > 0 && glyph.fWidth < kMaxGlyphWidth) {
         if (NULL == glyph.fImage) {
             size_t  size = glyph.computeImageSize();
+            if (fPackImages && (SkMask::kA8_Format == glyph.fMaskFormat ||
+                                SkMask::kBW_Format == glyph.fMaskFormat)) {
+                return this->generateImage(glyph, size);
+            }
             const_cast<SkGlyph&>(glyph).fImage = fGlyphAlloc.alloc(size,
                                         SkChunkAlloc::kReturnNil_AllocFailType);
             // check that alloc() actually succeeded
             if (glyph.fImage) {
-                fScalerContext->getImage(glyph);
+                this->rasterizeImage(glyph);
                 // TODO: the scaler may have changed the maskformat during
                 // getImage (e.g. from AA or LCD to BW) which means we may have
                 // overallocated the buffer. Check if the new computedImageSize
                 // is smaller, and if so, strink the alloc size in fImageAlloc.
                 fMemoryUsed += size;
             }
+        } else if (glyph.isImagePacked()) {
+            size_t size = glyph.computeImageSize();
+            uint8_t* pixels = (uint8_t*)this->getUnpackedImageStorage(size);
+            SkPackBits::Unpack8(pixels, 0, size, (const uint8_t*)glyph.fImage);
+            return pixels;
         }
     }
     return glyph.fImage;
 }
 
+void SkGlyphCache::rasterizeImage(const SkGlyph& glyph) {
+    if (fDiskCache && fDiskCache->readImage(fDiskStrikeKey, glyph)) {
+        return;
+    }
+    fScalerContext->getImage(glyph);
+    if (fDiskCache) {
+        fDiskCache->addImage(fDiskStrikeKey, glyph);
+    }
+}
+
+// Only bother with the packed form if it saves at least this fraction of the image.
+#define kMinPackedSavingsShift  2
+
+void* SkGlyphCache::generateImage(const SkGlyph& constGlyph, size_t size) {
+    SkGlyph& glyph = const_cast<SkGlyph&>(constGlyph);
+    SkASSERT(NULL == glyph.fImage);
+
+    // Rasterize into our scratch space, then decide how to store it.
+    void* pixels = this->getUnpackedImageStorage(size);
+    glyph.fImage = pixels;
+    this->rasterizeImage(glyph);
+    glyph.fImage = NULL;
+    // The scaler may have changed the mask format (e.g. from AA to BW).
+    size = glyph.computeImageSize();
+
+    const SkMask::Format format = static_cast<SkMask::Format>(glyph.fMaskFormat);
+    if (SkMask::kA8_Format == format || SkMask::kBW_Format == format) {
+        SkAutoSMalloc<1024> packStorage(SkPackBits::ComputeMaxSize8(SkToInt(size)));
+        uint8_t* packed = (uint8_t*)packStorage.get();
+        size_t packedSize = SkPackBits::Pack8((const uint8_t*)pixels, SkToInt(size), packed);
+        if (packedSize <= size - (size >> kMinPackedSavingsShift)) {
+            glyph.fImage = fGlyphAlloc.alloc(packedSize, SkChunkAlloc::kReturnNil_AllocFailType);
+            if (NULL == glyph.fImage) {
+                return NULL;
+            }
+            memcpy(glyph.fImage, packed, packedSize);
+            glyph.fImageIsPacked = true;
+            fMemoryUsed += packedSize;
+            return pixels;
+        }
+    }
+
+    glyph.fImage = fGlyphAlloc.alloc(size, SkChunkAlloc::kReturnNil_AllocFailType);
+    if (NULL == glyph.fImage) {
+        return NULL;
+    }
+    memcpy(glyph.fImage, pixels, size);
+    fMemoryUsed += size;
+    return glyph.fImage;
+}
+
+void* SkGlyphCache::getUnpackedImageStorage(size_t size) {
+    if (size > fUnpackedImageSize) {
+        fMemoryUsed += size - fUnpackedImageSize;
+        fUnpackedImageSize = size;
+        fUnpackedImage.reset(size);
+    }
+    return fUnpackedImage.get();
+}
+
 const SkPath* SkGlyphCache::findPath(const SkGlyph& glyph) {
     if (glyph.fWidth) {
         if (glyph.fPath == NULL) {
@@ -433,6 +517,14 @@ size_t SkGlyphCache_Globals::setCacheSizeLimit(size_t newLimit) {
     return prevLimit;
 }
 
+bool SkGlyphCache_Globals::setPackImages(bool pack) {
+    SkAutoMutexAcquire    ac(fMutex);
+
+    bool prev = fPackImages;
+    fPackImages = pack;
+    return prev;
+}
+
 int SkGlyphCache_Globals::setCacheCountLimit(int newCount) {
     if (newCount < 0) {
         newCount = 0;
@@ -470,6 +562,7 @@ SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
     SkAutoMutexAcquire    ac(globals.fMutex);
     SkGlyphCache*         cache;
     bool                  insideMutex = true;
+    bool                  packImages;
 
     globals.validate();
 
@@ -483,6 +576,7 @@ SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
     /* Release the mutex now, before we create a new entry (which might have
         side-effects like trying to access the cache/mutex (yikes!)
     */
+    packImages = globals.getPackImages();
     ac.release();           // release the mutex now
     insideMutex = false;    // can't use globals anymore
 
@@ -499,6 +593,7 @@ SkGlyphCache* SkGlyphCache::VisitCache(SkTypeface* typeface,
             SkASSERT(ctx);
         }
         cache = SkNEW_ARGS(SkGlyphCache, (typeface, desc, ctx));
+        cache->fPackImages = packImages;
     }
 
 FOUND_IT:
@@ -713,6 +808,18 @@ int SkGraphics::SetFontCacheCountLimit(int count) {
     return getSharedGlobals().setCacheCountLimit(count);
 }
 
+bool SkGraphics::GetFontCachePackedImages() {
+    return getSharedGlobals().getPackImages();
+}
+
+bool SkGraphics::SetFontCachePackedImages(bool pack) {
+    return getSharedGlobals().setPackImages(pack);
+}
+
+void SkGraphics::SetFontCacheDiskPath(const char path[]) {
+    SkGlyphDiskCache::SetGlobalPath(path);
+}
+
 int SkGraphics::GetFontCacheCountUsed() {
     return getSharedGlobals().getCacheCountUsed();
 }
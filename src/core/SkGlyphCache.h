@@ -20,7 +20,9 @@
 struct SkDeviceProperties;
 class SkPaint;
 
+class SkData;
 class SkGlyphCache_Globals;
+class SkGlyphDiskCache;
 
 // Enable this locally to add stats for hash-table hit rates. It also extends the dump()
 // output to show those stats.
@@ -48,7 +50,9 @@ public:
 
     /** Returns a glyph with all fields valid except fImage and fPath, which
         may be null. If they are null, call findImage or findPath for those.
-        If they are not null, then they are valid.
+        If they are not null, then they are valid. Note that if
+        glyph.isImagePacked(), fImage holds packed data; call findImage for
+        pixels.
 
         This call is potentially slower than the matching ...Advance call. If
         you only need the fAdvance/fDevKern fields, call those instead.
@@ -81,6 +85,10 @@ public:
 
     /** Return the image associated with the glyph. If it has not been generated
         this will trigger that.
+
+        If the strike packs its images (see SkGraphics::SetFontCachePackedImages)
+        the pixels are unpacked into storage owned by the cache, and the returned
+        pointer is only valid until the next call to findImage.
     */
     const void* findImage(const SkGlyph&);
     /** Return the Path associated with the glyph. If it has not been generated
@@ -239,6 +247,23 @@ private:
     // used to track (approx) how much ram is tied-up in this cache
     size_t  fMemoryUsed;
 
+    // If true, kA8 and kBW images that compress well are stored SkPackBits-encoded.
+    bool        fPackImages;
+    // Scratch space used to generate packed images, and to unpack them for findImage.
+    SkAutoMalloc fUnpackedImage;
+    size_t      fUnpackedImageSize;
+
+    void* generateImage(const SkGlyph&, size_t size);
+    void* getUnpackedImageStorage(size_t size);
+
+    // If SkGraphics::SetFontCacheDiskPath() was set when this strike was made, images are looked
+    // up there (under fDiskStrikeKey) before being rasterized, and added to it afterwards.
+    SkAutoTUnref<SkGlyphDiskCache> fDiskCache;
+    SkAutoTUnref<SkData> fDiskStrikeKey;
+
+    // Fills in glyph.fImage, which must already point to enough memory.
+    void rasterizeImage(const SkGlyph&);
+
 #ifdef SK_GLYPHCACHE_TRACK_HASH_STATS
     int fHashHitCount;
     int fHashMissCount;
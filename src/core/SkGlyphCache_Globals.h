@@ -36,6 +36,7 @@ public:
         fCacheSizeLimit = SK_DEFAULT_FONT_CACHE_LIMIT;
         fCacheCount = 0;
         fCacheCountLimit = SK_DEFAULT_FONT_CACHE_COUNT_LIMIT;
+        fPackImages = false;
 
         fMutex = (kYes_UseMutex == um) ? SkNEW(SkMutex) : NULL;
     }
@@ -71,6 +72,10 @@ public:
     size_t  getCacheSizeLimit() const { return fCacheSizeLimit; }
     size_t  setCacheSizeLimit(size_t limit);
 
+    // Only applies to strikes created after the change.
+    bool getPackImages() const { return fPackImages; }
+    bool setPackImages(bool pack);
+
     // returns true if this cache is over-budget either due to size limit
     // or count limit.
     bool isOverBudget() const {
@@ -104,6 +109,7 @@ private:
     size_t  fCacheSizeLimit;
     int32_t fCacheCountLimit;
     int32_t fCacheCount;
+    bool    fPackImages;
 
     // Checkout budgets, modulated by the specified min-bytes-needed-to-purge,
     // and attempt to purge caches to match.
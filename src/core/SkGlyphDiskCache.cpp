@@ -0,0 +1,447 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkGlyphDiskCache.h"
+
+#include "SkChecksum.h"
+#include "SkDescriptor.h"
+#include "SkEndian.h"
+#include "SkGlyph.h"
+#include "SkScalerContext.h"
+#include "SkStream.h"
+#include "SkTSort.h"
+#include "SkTime.h"
+#include "SkTypeface.h"
+
+#include <stdio.h>
+
+// Bump kVersion whenever the layout of the file, or what a strike key covers, changes.
+static const uint32_t kMagic   = SkSetFourByteTag('s', 'k', 'g', 'c');
+static const uint32_t kVersion = 2;
+
+// Part of every strike key. Bump it whenever Skia's own glyph rasterization changes (how it scales,
+// filters, or applies gamma to what the font engine produces), so that old images are not reused.
+// Changes in the font engine itself are covered by SkScalerContext::getEngineVersion().
+static const uint32_t kRasterVersion = 1;
+
+// Start a background write once this much has been added...
+static const size_t kWriteThreshold = 256 * 1024;
+// ...and never let the file grow beyond this.
+static const size_t kMaxFileSize = 32 * 1024 * 1024;
+
+namespace {
+
+struct Header {
+    uint32_t fMagic;
+    uint32_t fVersion;
+    uint32_t fEntrySize;
+    uint32_t fCount;
+};
+
+}  // namespace
+
+struct SkGlyphDiskCache::Entry {
+    uint64_t fStrikeKey;
+    uint32_t fGlyphKey;
+    uint32_t fStrikeOffset;   // Of the whole strike key, from the start of the file (or of
+    uint32_t fStrikeSize;     // fPendingStrikes). Entries of one strike share it.
+    uint32_t fOffset;     // Of the image, from the start of the file (or of fPendingImages).
+    uint32_t fSize;
+    uint16_t fWidth, fHeight;
+    int16_t  fLeft, fTop;
+    uint8_t  fFormat;
+    uint8_t  fPad[3];
+
+    bool operator<(const Entry& other) const {
+        return fStrikeKey != other.fStrikeKey ? fStrikeKey < other.fStrikeKey
+                                              : fGlyphKey < other.fGlyphKey;
+    }
+
+    bool matches(const SkGlyph& glyph) const {
+        return fWidth == glyph.fWidth && fHeight == glyph.fHeight &&
+               fLeft == glyph.fLeft && fTop == glyph.fTop &&
+               fFormat == glyph.fMaskFormat && fSize == glyph.computeImageSize();
+    }
+};
+
+static uint64_t strike_hash(const SkData* strikeKey) {
+    uint64_t hash;
+    memcpy(&hash, strikeKey->data(), sizeof(hash));
+    return hash;
+}
+
+SkGlyphDiskCache::Key SkGlyphDiskCache::MakeKey(const SkData* strikeKey, const SkGlyph& glyph) {
+    Key key;
+    key.fStrikeKey = strike_hash(strikeKey);
+    // Glyph IDs are 16 bits, subpixel positions 2 bits each.
+    key.fGlyphKey = glyph.getGlyphID() |
+                    ((uint32_t)(glyph.getSubXFixed() >> 14) << 16) |
+                    ((uint32_t)(glyph.getSubYFixed() >> 14) << 18);
+    key.fPad = 0;
+    return key;
+}
+
+bool SkGlyphDiskCache::IsValidFile(const SkData* file) {
+    if (NULL == file || file->size() < sizeof(Header)) {
+        return false;
+    }
+    const Header* header = (const Header*)file->data();
+    return kMagic == header->fMagic && kVersion == header->fVersion &&
+           sizeof(Entry) == header->fEntrySize &&
+           header->fCount <= (file->size() - sizeof(Header)) / sizeof(Entry);
+}
+
+const SkGlyphDiskCache::Entry* SkGlyphDiskCache::FindEntry(const SkData* file, const Key& key) {
+    if (NULL == file) {
+        return NULL;
+    }
+    const Header* header = (const Header*)file->data();
+    const Entry* entries = (const Entry*)(header + 1);
+
+    Entry target;
+    target.fStrikeKey = key.fStrikeKey;
+    target.fGlyphKey = key.fGlyphKey;
+    int lo = 0;
+    int hi = header->fCount;
+    while (lo < hi) {
+        int mid = lo + ((hi - lo) >> 1);
+        if (entries[mid] < target) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == (int)header->fCount ||
+        entries[lo].fStrikeKey != key.fStrikeKey || entries[lo].fGlyphKey != key.fGlyphKey) {
+        return NULL;
+    }
+    // Don't trust the file: it may have been truncated or clobbered by someone else.
+    const Entry* entry = &entries[lo];
+    if (entry->fOffset > file->size() || entry->fSize > file->size() - entry->fOffset ||
+        entry->fStrikeOffset > file->size() ||
+        entry->fStrikeSize > file->size() - entry->fStrikeOffset) {
+        return NULL;
+    }
+    return entry;
+}
+
+bool SkGlyphDiskCache::SameStrike(const uint8_t* strikes, size_t size, const Entry& entry,
+                                  const SkData* key) {
+    SkASSERT(entry.fStrikeOffset <= size && entry.fStrikeSize <= size - entry.fStrikeOffset);
+    return entry.fStrikeSize == key->size() &&
+           0 == memcmp(strikes + entry.fStrikeOffset, key->data(), key->size());
+}
+
+static void append_bytes(SkTDArray<uint8_t>* bytes, const void* data, size_t size) {
+    memcpy(bytes->append(SkToInt(size)), data, size);
+}
+
+static void append_string(SkTDArray<uint8_t>* bytes, const SkString& str) {
+    const uint32_t size = SkToU32(str.size());
+    append_bytes(bytes, &size, sizeof(size));
+    append_bytes(bytes, str.c_str(), size);
+}
+
+SkData* SkGlyphDiskCache::NewStrikeKey(SkScalerContext* ctx, const SkDescriptor& desc) {
+    SkTDArray<uint8_t> bytes;
+    bytes.setCount(sizeof(uint64_t));   // The hash, filled in last.
+
+    SkString engine;
+    ctx->getEngineVersion(&engine);
+    append_bytes(&bytes, &kRasterVersion, sizeof(kRasterVersion));
+    append_string(&bytes, engine);
+
+    // Things that identify the font itself.
+    SkTypeface* typeface = ctx->getTypeface();
+    SkString family;
+    typeface->getFamilyName(&family);
+    // 'head' checkSumAdjustment is a checksum of the whole font file.
+    uint32_t identity[2] = { (uint32_t)typeface->style(), 0 };
+    typeface->getTableData(SkSetFourByteTag('h', 'e', 'a', 'd'), 8, sizeof(identity[1]),
+                           &identity[1]);
+    append_string(&bytes, family);
+    append_bytes(&bytes, identity, sizeof(identity));
+
+    // The descriptor embeds the typeface's unique ID, which is only meaningful within this
+    // process, so zero it, and skip the descriptor's leading checksum, which covers the ID.
+    const size_t descStart = bytes.count();
+    append_bytes(&bytes, &desc, desc.getLength());
+    const void* rec = desc.findEntry(kRec_SkDescriptorTag, NULL);
+    if (rec) {
+        const size_t idOffset = descStart + ((const char*)rec - (const char*)&desc) +
+                                SK_OFFSETOF(SkScalerContext::Rec, fFontID);
+        sk_bzero(bytes.begin() + idOffset, sizeof(uint32_t));
+    }
+    bytes.remove(SkToInt(descStart), sizeof(uint32_t));
+
+    const size_t length = bytes.count() - sizeof(uint64_t);
+    const uint32_t lo = SkChecksum::Murmur3(bytes.begin() + sizeof(uint64_t), length, 0x4c6f6f6b);
+    const uint32_t hi = SkChecksum::Murmur3(bytes.begin() + sizeof(uint64_t), length, 0x476c7966);
+    const uint64_t hash = ((uint64_t)hi << 32) | lo;
+    memcpy(bytes.begin(), &hash, sizeof(hash));
+    return SkData::NewWithCopy(bytes.begin(), bytes.count());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SkGlyphDiskCache::SkGlyphDiskCache(const char path[])
+    : fPath(path)
+    , fWriteScheduled(false) {
+    fFile.reset(SkData::NewFromFileName(path));
+    if (!IsValidFile(fFile)) {
+        fFile.reset(NULL);
+    }
+}
+
+SkGlyphDiskCache::~SkGlyphDiskCache() {
+    this->flush();
+}
+
+bool SkGlyphDiskCache::readImage(const SkData* strikeKey, const SkGlyph& glyph) {
+    SkASSERT(glyph.fImage);
+    const Key key = MakeKey(strikeKey, glyph);
+
+    SkAutoMutexAcquire lock(fMutex);
+    const Entry* entry = FindEntry(fFile, key);
+    if (entry && entry->matches(glyph) &&
+        SameStrike(fFile->bytes(), fFile->size(), *entry, strikeKey)) {
+        memcpy(glyph.fImage, fFile->bytes() + entry->fOffset, entry->fSize);
+        return true;
+    }
+    if (const int* index = fPendingIndex.find(key)) {
+        entry = &fPendingEntries[*index];
+        if (entry->matches(glyph) &&
+            SameStrike(fPendingStrikes.begin(), fPendingStrikes.count(), *entry, strikeKey)) {
+            memcpy(glyph.fImage, fPendingImages.begin() + entry->fOffset, entry->fSize);
+            return true;
+        }
+    }
+    return false;
+}
+
+void SkGlyphDiskCache::addImage(const SkData* strikeKey, const SkGlyph& glyph) {
+    if (NULL == glyph.fImage) {
+        return;
+    }
+    const Key key = MakeKey(strikeKey, glyph);
+    const size_t size = glyph.computeImageSize();
+
+    {
+        SkAutoMutexAcquire lock(fMutex);
+        if (fPendingIndex.find(key) || FindEntry(fFile, key) ||
+            fPendingImages.bytes() + size > kMaxFileSize) {
+            return;
+        }
+        Entry strike;
+        if (const Entry* found = fPendingStrikeIndex.find(key.fStrikeKey)) {
+            strike = *found;
+            if (!SameStrike(fPendingStrikes.begin(), fPendingStrikes.count(), strike, strikeKey)) {
+                return;  // Another strike whose key hashes alike got here first.
+            }
+        } else {
+            strike.fStrikeOffset = fPendingStrikes.count();
+            strike.fStrikeSize = SkToU32(strikeKey->size());
+            fPendingStrikeIndex.set(key.fStrikeKey, strike);
+            append_bytes(&fPendingStrikes, strikeKey->data(), strikeKey->size());
+        }
+        fPendingIndex.set(key, fPendingEntries.count());
+        Entry* entry = fPendingEntries.append();
+        entry->fStrikeKey = key.fStrikeKey;
+        entry->fGlyphKey = key.fGlyphKey;
+        entry->fStrikeOffset = strike.fStrikeOffset;
+        entry->fStrikeSize = strike.fStrikeSize;
+        entry->fOffset = fPendingImages.count();
+        entry->fSize = SkToU32(size);
+        entry->fWidth = glyph.fWidth;
+        entry->fHeight = glyph.fHeight;
+        entry->fLeft = glyph.fLeft;
+        entry->fTop = glyph.fTop;
+        entry->fFormat = glyph.fMaskFormat;
+        sk_bzero(entry->fPad, sizeof(entry->fPad));
+        memcpy(fPendingImages.append(SkToInt(size)), glyph.fImage, size);
+
+        if (fWriteScheduled || fPendingImages.bytes() < kWriteThreshold) {
+            return;
+        }
+        fWriteScheduled = true;
+    }
+    // Outside the lock: without a thread pool this writes right away.
+    fWriter.add(WriteProc, this);
+}
+
+void SkGlyphDiskCache::flush() {
+    fWriter.wait();
+    this->writeFile();
+}
+
+void SkGlyphDiskCache::WriteProc(SkGlyphDiskCache* cache) {
+    cache->writeFile();
+}
+
+void SkGlyphDiskCache::writeFile() {
+    SkTDArray<Entry> pendingEntries;
+    SkTDArray<uint8_t> pendingImages;
+    SkTDArray<uint8_t> pendingStrikes;
+    {
+        SkAutoMutexAcquire lock(fMutex);
+        fWriteScheduled = false;
+        if (fPendingEntries.isEmpty()) {
+            return;
+        }
+        pendingEntries.swap(fPendingEntries);
+        pendingImages.swap(fPendingImages);
+        pendingStrikes.swap(fPendingStrikes);
+        fPendingIndex.reset();
+        fPendingStrikeIndex.reset();
+    }
+
+    // Merge with what is on disk now, which another process may have updated since we mapped it.
+    SkAutoTUnref<SkData> onDisk(SkData::NewFromFileName(fPath.c_str()));
+    if (!IsValidFile(onDisk)) {
+        onDisk.reset(NULL);
+    }
+
+    struct Source {
+        Entry           fEntry;
+        const uint8_t*  fImage;
+        const uint8_t*  fStrike;
+        bool operator<(const Source& other) const { return fEntry < other.fEntry; }
+    };
+    SkTDArray<Source> sources;
+    size_t fileSize = sizeof(Header);
+    const uint8_t* lastStrike = NULL;   // Strike keys are mostly shared by consecutive entries.
+    if (onDisk) {
+        const Header* header = (const Header*)onDisk->data();
+        const Entry* entries = (const Entry*)(header + 1);
+        for (uint32_t i = 0; i < header->fCount; ++i) {
+            const Entry& entry = entries[i];
+            const size_t size = onDisk->size();
+            if (entry.fOffset > size || entry.fSize > size - entry.fOffset ||
+                entry.fStrikeOffset > size || entry.fStrikeSize > size - entry.fStrikeOffset) {
+                continue;
+            }
+            Source* source = sources.append();
+            source->fEntry = entry;
+            source->fImage = onDisk->bytes() + entry.fOffset;
+            source->fStrike = onDisk->bytes() + entry.fStrikeOffset;
+            fileSize += sizeof(Entry) + entry.fSize;
+            if (source->fStrike != lastStrike) {
+                fileSize += entry.fStrikeSize;
+                lastStrike = source->fStrike;
+            }
+        }
+    }
+    for (int i = 0; i < pendingEntries.count(); ++i) {
+        const Entry& entry = pendingEntries[i];
+        Key key = { entry.fStrikeKey, entry.fGlyphKey, 0 };
+        if (FindEntry(onDisk, key)) {
+            continue;
+        }
+        const uint8_t* strike = pendingStrikes.begin() + entry.fStrikeOffset;
+        const size_t size = sizeof(Entry) + entry.fSize +
+                            (strike != lastStrike ? entry.fStrikeSize : 0);
+        if (fileSize + size > kMaxFileSize) {
+            break;
+        }
+        Source* source = sources.append();
+        source->fEntry = entry;
+        source->fImage = pendingImages.begin() + entry.fOffset;
+        source->fStrike = strike;
+        fileSize += size;
+        lastStrike = strike;
+    }
+    if (sources.isEmpty()) {
+        return;
+    }
+    SkTQSort(sources.begin(), sources.end() - 1);
+
+    // Sorting puts a strike's entries next to each other, so each strike key is written once,
+    // after the entries and before the images.
+    uint32_t offset = SkToU32(sizeof(Header) + sources.count() * sizeof(Entry));
+    SkTDArray<int> strikesToWrite;
+    for (int i = 0; i < sources.count(); ++i) {
+        Entry& entry = sources[i].fEntry;
+        const Entry* prev = i > 0 ? &sources[i - 1].fEntry : NULL;
+        if (prev && prev->fStrikeSize == entry.fStrikeSize &&
+            0 == memcmp(sources[i - 1].fStrike, sources[i].fStrike, entry.fStrikeSize)) {
+            entry.fStrikeOffset = prev->fStrikeOffset;
+            continue;
+        }
+        *strikesToWrite.append() = i;
+        entry.fStrikeOffset = offset;
+        offset += entry.fStrikeSize;
+    }
+    for (int i = 0; i < sources.count(); ++i) {
+        sources[i].fEntry.fOffset = offset;
+        offset += sources[i].fEntry.fSize;
+    }
+
+    // Write next to the real file, then move it into place.
+    SkString tmpPath;
+    tmpPath.printf("%s.%08x.tmp", fPath.c_str(),
+                   SkChecksum::Mix((uint32_t)(uintptr_t)this ^ SkTime::GetMSecs()));
+    {
+        SkFILEWStream out(tmpPath.c_str());
+        if (!out.isValid()) {
+            return;
+        }
+        Header header = { kMagic, kVersion, sizeof(Entry), SkToU32(sources.count()) };
+        bool ok = out.write(&header, sizeof(header));
+        for (int i = 0; ok && i < sources.count(); ++i) {
+            ok = out.write(&sources[i].fEntry, sizeof(Entry));
+        }
+        for (int i = 0; ok && i < strikesToWrite.count(); ++i) {
+            const Source& source = sources[strikesToWrite[i]];
+            ok = out.write(source.fStrike, source.fEntry.fStrikeSize);
+        }
+        for (int i = 0; ok && i < sources.count(); ++i) {
+            ok = out.write(sources[i].fImage, sources[i].fEntry.fSize);
+        }
+        if (!ok) {
+            remove(tmpPath.c_str());
+            return;
+        }
+    }
+    if (0 != rename(tmpPath.c_str(), fPath.c_str())) {
+        // Windows won't rename over an existing file.
+        remove(fPath.c_str());
+        if (0 != rename(tmpPath.c_str(), fPath.c_str())) {
+            remove(tmpPath.c_str());
+            return;
+        }
+    }
+
+    SkAutoTUnref<SkData> written(SkData::NewFromFileName(fPath.c_str()));
+    if (IsValidFile(written)) {
+        SkAutoMutexAcquire lock(fMutex);
+        fFile.reset(written.detach());
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+SK_DECLARE_STATIC_MUTEX(gGlobalMutex);
+static SkGlyphDiskCache* gGlobal = NULL;
+
+SkGlyphDiskCache* SkGlyphDiskCache::RefGlobal() {
+    SkAutoMutexAcquire lock(gGlobalMutex);
+    return SkSafeRef(gGlobal);
+}
+
+void SkGlyphDiskCache::SetGlobalPath(const char path[]) {
+    SkGlyphDiskCache* prev;
+    {
+        SkAutoMutexAcquire lock(gGlobalMutex);
+        prev = gGlobal;
+        gGlobal = path ? SkNEW_ARGS(SkGlyphDiskCache, (path)) : NULL;
+    }
+    if (prev) {
+        // Strikes may still hold refs, but write out what we have now.
+        prev->flush();
+        prev->unref();
+    }
+}
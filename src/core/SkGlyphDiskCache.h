@@ -0,0 +1,108 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkGlyphDiskCache_DEFINED
+#define SkGlyphDiskCache_DEFINED
+
+#include "SkData.h"
+#include "SkMutex.h"
+#include "SkRefCnt.h"
+#include "SkString.h"
+#include "SkTaskGroup.h"
+#include "SkTDArray.h"
+#include "SkTHash.h"
+
+class SkDescriptor;
+class SkGlyph;
+class SkScalerContext;
+
+/**
+ *  A persistent cache of rasterized glyph images, shared between processes through one file.
+ *
+ *  The file is versioned, memory mapped and only ever read in place: it holds an index sorted by
+ *  (strike key, glyph) followed by the images. Images rasterized by this process are kept in
+ *  memory and written out in the background once enough have accumulated (and on flush()). A
+ *  write merges them with whatever is in the file at the time, writes a new file next to it and
+ *  renames it into place, so readers, including other processes, never see a partial file.
+ *  Concurrent writers may drop each other's additions, which only costs a re-rasterization.
+ *
+ *  Strike keys come from NewStrikeKey(). Unlike SkDescriptor::getChecksum(), they do not depend on
+ *  the per-process typeface ID, and they do cover the font file and the engine that rasterizes it.
+ *  Strikes whose scaler context reports no engine version are never cached on disk.
+ *  The file keeps each strike's whole key and a read only hits if it matches, so two strikes whose
+ *  keys hash alike just miss.
+ */
+class SkGlyphDiskCache : public SkRefCnt {
+public:
+    SK_DECLARE_INST_COUNT(SkGlyphDiskCache)
+
+    /** Returns a ref to the cache set by SkGraphics::SetFontCacheDiskPath(), or NULL. */
+    static SkGlyphDiskCache* RefGlobal();
+
+    /** Replaces the global cache with one using path (or none, if path is NULL). Anything the
+        previous cache had not yet written is flushed first.
+     */
+    static void SetGlobalPath(const char path[]);
+
+    /** Returns a key for the strike ctx rasterizes for desc that is stable across processes: the
+        bytes that identify it, preceded by their 64-bit hash.
+     */
+    static SkData* NewStrikeKey(SkScalerContext* ctx, const SkDescriptor& desc);
+
+    explicit SkGlyphDiskCache(const char path[]);
+    virtual ~SkGlyphDiskCache();
+
+    /** If the cache holds an image for glyph with matching metrics, copies it into glyph.fImage
+        (which must be glyph.computeImageSize() bytes) and returns true.
+     */
+    bool readImage(const SkData* strikeKey, const SkGlyph& glyph);
+
+    /** Remembers glyph's freshly rasterized image, to be written to the file later. */
+    void addImage(const SkData* strikeKey, const SkGlyph& glyph);
+
+    /** Writes out every image added so far and waits for that to finish. */
+    void flush();
+
+private:
+    struct Entry;
+    struct Key {
+        uint64_t fStrikeKey;
+        uint32_t fGlyphKey;
+        uint32_t fPad;  // always 0, so Keys hash and compare as plain bytes
+
+        bool operator==(const Key& other) const {
+            return fStrikeKey == other.fStrikeKey && fGlyphKey == other.fGlyphKey;
+        }
+    };
+
+    static Key MakeKey(const SkData* strikeKey, const SkGlyph&);
+    static const Entry* FindEntry(const SkData* file, const Key&);
+    static bool SameStrike(const uint8_t* strikes, size_t size, const Entry&, const SkData* key);
+    static bool IsValidFile(const SkData*);
+    static void WriteProc(SkGlyphDiskCache*);
+
+    void writeFile();
+
+    const SkString          fPath;
+    SkMutex                 fMutex;
+    SkAutoTUnref<SkData>    fFile;      // The mapped file, or NULL.
+
+    // Images added but not yet written out. Entries' offsets are into fPendingImages, and their
+    // strike offsets into fPendingStrikes. fPendingStrikeIndex maps a strike key's hash to the
+    // strike offset and size its entries use.
+    SkTDArray<Entry>        fPendingEntries;
+    SkTDArray<uint8_t>      fPendingImages;
+    SkTDArray<uint8_t>      fPendingStrikes;
+    SkTHashMap<Key, int>    fPendingIndex;
+    SkTHashMap<uint64_t, Entry> fPendingStrikeIndex;
+    bool                    fWriteScheduled;
+    SkTaskGroup             fWriter;
+
+    typedef SkRefCnt INHERITED;
+};
+
+#endif
@@ -12,6 +12,7 @@
 #include "SkBlitter.h"
 #include "SkCanvas.h"
 #include "SkGeometry.h"
+#include "SkLayerPool.h"
 #include "SkMath.h"
 #include "SkMatrix.h"
 #include "SkPath.h"
@@ -126,9 +127,15 @@ void SkGraphics::Init() {
 }
 
 void SkGraphics::Term() {
+    SetFontCacheDiskPath(NULL);
+    PurgeAllCaches();
+    SkPaint::Term();
+}
+
+void SkGraphics::PurgeAllCaches() {
     PurgeFontCache();
     PurgeResourceCache();
-    SkPaint::Term();
+    SkLayerPool::Purge();
 }
 
 ///////////////////////////////////////////////////////////////////////////////
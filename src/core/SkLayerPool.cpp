@@ -0,0 +1,231 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkLayerPool.h"
+
+#include "SkAtomics.h"
+#include "SkBitmap.h"
+#include "SkGraphics.h"
+#include "SkLazyPtr.h"
+#include "SkMallocPixelRef.h"
+#include "SkMath.h"
+#include "SkMutex.h"
+#include "SkTDArray.h"
+
+// Pooling is opt-in, see SkGraphics::SetLayerPoolByteLimit().
+#ifndef SK_DEFAULT_LAYER_POOL_LIMIT
+    #define SK_DEFAULT_LAYER_POOL_LIMIT     0
+#endif
+
+// Smaller layers are cheap enough to get straight from malloc.
+#define kMinPooledSize  (16 * 1024)
+
+// Rounds size up to the next of 4 steps between powers of two, so a reused block wastes at most
+// a quarter of itself, and layers that differ by a few pixels still share blocks.
+static size_t bucket_size(size_t size) {
+    SkASSERT(size >= kMinPooledSize && size <= SK_MaxS32);
+    const size_t step = (size_t)1 << (31 - SkCLZ(SkToU32(size)) - 2);
+    return (size + step - 1) & ~(step - 1);
+}
+
+namespace {
+
+class LayerPool {
+public:
+    LayerPool() : fByteLimit(SK_DEFAULT_LAYER_POOL_LIMIT), fBytesUsed(0) {
+        sk_bzero(&fStats, sizeof(fStats));
+    }
+
+    // Returns bucketSize bytes, and whether they came from the pool.
+    void* alloc(size_t bucketSize, bool* reused) {
+        SkAutoMutexAcquire lock(fMutex);
+        // Most recently freed first: it's likeliest to still be in cache.
+        for (int i = fFree.count() - 1; i >= 0; --i) {
+            if (fFree[i].fSize == bucketSize) {
+                void* addr = fFree[i].fAddr;
+                fFree.remove(i);
+                fBytesUsed -= bucketSize;
+                fStats.fReuses++;
+                fStats.fReusedBytes += bucketSize;
+                *reused = true;
+                return addr;
+            }
+        }
+        fStats.fAllocations++;
+        fStats.fAllocatedBytes += bucketSize;
+        *reused = false;
+        return NULL;
+    }
+
+    void free(void* addr, size_t bucketSize) {
+        SkTDArray<void*> evicted;
+        {
+            SkAutoMutexAcquire lock(fMutex);
+            if (bucketSize > fByteLimit) {
+                *evicted.append() = addr;
+            } else {
+                Block* block = fFree.append();
+                block->fAddr = addr;
+                block->fSize = bucketSize;
+                fBytesUsed += bucketSize;
+                this->trim(fByteLimit, &evicted);
+            }
+        }
+        // Free outside the lock; large blocks can take a while to unmap.
+        for (int i = 0; i < evicted.count(); ++i) {
+            sk_free(evicted[i]);
+        }
+    }
+
+    // Doesn't take the lock, so layers skip the pool entirely while it's disabled.
+    size_t getByteLimit() {
+        return sk_atomic_load(&fByteLimit, sk_memory_order_relaxed);
+    }
+
+    size_t setByteLimit(size_t newLimit) {
+        SkTDArray<void*> evicted;
+        size_t prevLimit;
+        {
+            SkAutoMutexAcquire lock(fMutex);
+            prevLimit = fByteLimit;
+            sk_atomic_store(&fByteLimit, newLimit, sk_memory_order_relaxed);
+            this->trim(newLimit, &evicted);
+        }
+        for (int i = 0; i < evicted.count(); ++i) {
+            sk_free(evicted[i]);
+        }
+        return prevLimit;
+    }
+
+    void purge() {
+        SkTDArray<void*> evicted;
+        {
+            SkAutoMutexAcquire lock(fMutex);
+            this->trim(0, &evicted);
+        }
+        for (int i = 0; i < evicted.count(); ++i) {
+            sk_free(evicted[i]);
+        }
+    }
+
+    size_t getBytesUsed() {
+        SkAutoMutexAcquire lock(fMutex);
+        return fBytesUsed;
+    }
+
+    void getStats(SkLayerPool::Stats* stats) {
+        SkAutoMutexAcquire lock(fMutex);
+        *stats = fStats;
+    }
+
+    void resetStats() {
+        SkAutoMutexAcquire lock(fMutex);
+        sk_bzero(&fStats, sizeof(fStats));
+    }
+
+private:
+    struct Block {
+        void*   fAddr;
+        size_t  fSize;
+    };
+
+    // Drops the least recently freed blocks until at most limit bytes remain.
+    void trim(size_t limit, SkTDArray<void*>* evicted) {
+        int count = 0;
+        while (fBytesUsed > limit) {
+            *evicted->append() = fFree[count].fAddr;
+            fBytesUsed -= fFree[count].fSize;
+            count++;
+        }
+        fFree.remove(0, count);
+    }
+
+    SkMutex             fMutex;
+    SkTDArray<Block>    fFree;      // In the order they were freed.
+    size_t              fByteLimit; // Written under fMutex, but read atomically without it.
+    size_t              fBytesUsed;
+    SkLayerPool::Stats  fStats;
+};
+
+}  // namespace
+
+SK_DECLARE_STATIC_LAZY_PTR(LayerPool, gPool);
+
+static void release_to_pool(void* addr, void* context) {
+    gPool.get()->free(addr, (size_t)context);
+}
+
+static void* alloc_block(size_t size, bool isOpaque) {
+    // calloc can hand back pages that are already zero.
+    return isOpaque ? sk_malloc_flags(size, 0) : sk_calloc(size);
+}
+
+// When malloc fails, memory is tight: give back whatever the pool holds and try once more.
+static bool alloc_unpooled(SkBitmap* bitmap) {
+    if (!bitmap->tryAllocPixels(bitmap->info())) {
+        gPool.get()->purge();
+        if (!bitmap->tryAllocPixels(bitmap->info())) {
+            return false;
+        }
+    }
+    if (!bitmap->info().isOpaque()) {
+        bitmap->eraseColor(SK_ColorTRANSPARENT);
+    }
+    return true;
+}
+
+bool SkLayerPool::AllocPixels(SkBitmap* bitmap) {
+    const SkImageInfo& info = bitmap->info();
+    const size_t rowBytes = info.minRowBytes();
+    const uint64_t size64 = sk_64_mul(rowBytes, info.height());
+    if (!sk_64_isS32(size64) || 0 == size64) {
+        return false;
+    }
+    const size_t size = (size_t)size64;
+    if (size < kMinPooledSize || 0 == gPool.get()->getByteLimit()) {
+        return alloc_unpooled(bitmap);
+    }
+
+    const size_t bucketSize = bucket_size(size);
+    bool reused;
+    void* addr = gPool.get()->alloc(bucketSize, &reused);
+    if (!reused) {
+        addr = alloc_block(bucketSize, info.isOpaque());
+        if (NULL == addr) {
+            gPool.get()->purge();
+            addr = alloc_block(bucketSize, info.isOpaque());
+        }
+        if (NULL == addr) {
+            return false;
+        }
+    } else if (!info.isOpaque()) {
+        sk_bzero(addr, size);
+    }
+
+    SkAutoTUnref<SkPixelRef> pr(SkMallocPixelRef::NewWithProc(info, rowBytes, NULL, addr,
+                                                              release_to_pool,
+                                                              (void*)bucketSize));
+    if (!pr) {
+        release_to_pool(addr, (void*)bucketSize);
+        return false;
+    }
+    bitmap->setPixelRef(pr);
+    bitmap->lockPixels();
+    return true;
+}
+
+size_t SkLayerPool::GetByteLimit() { return gPool.get()->getByteLimit(); }
+size_t SkLayerPool::SetByteLimit(size_t newLimit) { return gPool.get()->setByteLimit(newLimit); }
+size_t SkLayerPool::GetBytesUsed() { return gPool.get()->getBytesUsed(); }
+void SkLayerPool::Purge() { gPool.get()->purge(); }
+void SkLayerPool::GetStats(Stats* stats) { gPool.get()->getStats(stats); }
+void SkLayerPool::ResetStats() { gPool.get()->resetStats(); }
+
+size_t SkGraphics::GetLayerPoolByteLimit() { return SkLayerPool::GetByteLimit(); }
+size_t SkGraphics::SetLayerPoolByteLimit(size_t newLimit) {
+    return SkLayerPool::SetByteLimit(newLimit);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkLayerPool_DEFINED
+#define SkLayerPool_DEFINED
+
+#include "SkTypes.h"
+
+class SkBitmap;
+
+/**
+ *  A process-wide pool of pixel memory for raster saveLayer()s.
+ *
+ *  Layers are allocated and freed at a high rate (often several per frame, each the size of the
+ *  clip), so rather than returning their pixels to malloc, SkBitmapDevice gives them back to
+ *  this pool, which keeps up to GetByteLimit() bytes around in power-of-two-ish size buckets
+ *  for the next layer to reuse. Until a client opts in through SkGraphics::SetLayerPoolByteLimit(),
+ *  the limit is 0 and layers come straight from malloc.
+ */
+class SkLayerPool {
+public:
+    /**
+     *  Allocates pixels for bitmap, whose info must already be set, from the pool. They are
+     *  cleared to transparent unless the bitmap is opaque, and go back to the pool when its
+     *  pixel ref is destroyed. Returns false on failure.
+     */
+    static bool AllocPixels(SkBitmap* bitmap);
+
+    static size_t GetByteLimit();
+    static size_t SetByteLimit(size_t newLimit);    // Returns the previous limit.
+    static size_t GetBytesUsed();                   // Free memory currently held by the pool.
+    static void Purge();
+
+    /**
+     *  Counts since the last ResetStats(). Layers too small to be pooled, or allocated while
+     *  the pool is disabled, aren't counted.
+     */
+    struct Stats {
+        int     fAllocations;       // Layers that needed fresh memory.
+        size_t  fAllocatedBytes;
+        int     fReuses;            // Layers that reused memory from the pool.
+        size_t  fReusedBytes;
+    };
+    static void GetStats(Stats*);
+    static void ResetStats();
+};
+
+#endif
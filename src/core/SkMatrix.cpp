@@ -937,32 +937,103 @@ void SkMatrix::Scale_pts(const SkMatrix& m, SkPoint dst[], const SkPoint src[],
     }
 }
 
-void SkMatrix::Persp_pts(const SkMatrix& m, SkPoint dst[],
-                         const SkPoint src[], int count) {
-    SkASSERT(m.hasPerspective());
+// Maps one point with perspective, mapping a point at infinity to (0, 0).
+static inline void persp_pt1(const SkScalar mat[9], SkPoint* dst, const SkPoint& src) {
+    SkScalar sy = src.fY;
+    SkScalar sx = src.fX;
+
+    SkScalar x = sdot(sx, mat[SkMatrix::kMScaleX], sy, mat[SkMatrix::kMSkewX]) +
+                 mat[SkMatrix::kMTransX];
+    SkScalar y = sdot(sx, mat[SkMatrix::kMSkewY],  sy, mat[SkMatrix::kMScaleY]) +
+                 mat[SkMatrix::kMTransY];
+#ifdef SK_LEGACY_MATRIX_MATH_ORDER
+    SkScalar z = sx * mat[SkMatrix::kMPersp0] +
+                 (sy * mat[SkMatrix::kMPersp1] + mat[SkMatrix::kMPersp2]);
+#else
+    SkScalar z = sdot(sx, mat[SkMatrix::kMPersp0], sy, mat[SkMatrix::kMPersp1]) +
+                 mat[SkMatrix::kMPersp2];
+#endif
+    if (z) {
+        z = SkScalarFastInvert(z);
+    }
 
-    if (count > 0) {
-        do {
-            SkScalar sy = src->fY;
-            SkScalar sx = src->fX;
-            src += 1;
+    dst->fY = y * z;
+    dst->fX = x * z;
+}
+
+// On ARMv7, Sk4s division is an estimate refined by Newton steps rather than an exact divide, so
+// mapping two points at a time would not match mapping them one at a time.
+#if defined(SK_ARM_HAS_NEON) && !defined(SK_CPU_ARM64) && !defined(SKNX_NO_SIMD)
+    #define SK_PERSP_PTS_ONE_AT_A_TIME
+#endif
 
-            SkScalar x = sdot(sx, m.fMat[kMScaleX], sy, m.fMat[kMSkewX])  + m.fMat[kMTransX];
-            SkScalar y = sdot(sx, m.fMat[kMSkewY],  sy, m.fMat[kMScaleY]) + m.fMat[kMTransY];
+#ifndef SK_PERSP_PTS_ONE_AT_A_TIME
+// Maps src[0] and src[1] with perspective into dst[0] and dst[1]. Each Sk4s holds both points as
+// (x0, y0, x1, y1), and x4 and y4 hold their coordinates duplicated as (x0, x0, x1, x1) and
+// (y0, y0, y1, y1), so that one multiply-add maps both x and y of both points.
+static inline void persp_pts2(const SkScalar mat[9], SkPoint dst[2], const SkPoint src[2]) {
+    const Sk4s x4(src[0].fX, src[0].fX, src[1].fX, src[1].fX);
+    const Sk4s y4(src[0].fY, src[0].fY, src[1].fY, src[1].fY);
+
+    const Sk4s xy = x4 * Sk4s(mat[SkMatrix::kMScaleX], mat[SkMatrix::kMSkewY],
+                              mat[SkMatrix::kMScaleX], mat[SkMatrix::kMSkewY])
+                  + y4 * Sk4s(mat[SkMatrix::kMSkewX], mat[SkMatrix::kMScaleY],
+                              mat[SkMatrix::kMSkewX], mat[SkMatrix::kMScaleY])
+                  + Sk4s(mat[SkMatrix::kMTransX], mat[SkMatrix::kMTransY],
+                         mat[SkMatrix::kMTransX], mat[SkMatrix::kMTransY]);
 #ifdef SK_LEGACY_MATRIX_MATH_ORDER
-            SkScalar z = sx * m.fMat[kMPersp0] + (sy * m.fMat[kMPersp1] + m.fMat[kMPersp2]);
+    const Sk4s z = x4 * Sk4s(mat[SkMatrix::kMPersp0])
+                 + (y4 * Sk4s(mat[SkMatrix::kMPersp1]) + Sk4s(mat[SkMatrix::kMPersp2]));
 #else
-            SkScalar z = sdot(sx, m.fMat[kMPersp0], sy, m.fMat[kMPersp1]) + m.fMat[kMPersp2];
+    const Sk4s z = x4 * Sk4s(mat[SkMatrix::kMPersp0]) + y4 * Sk4s(mat[SkMatrix::kMPersp1])
+                 + Sk4s(mat[SkMatrix::kMPersp2]);
+#endif
+
+    if ((z != Sk4s(0)).allTrue()) {
+        // Divide rather than invert(), which may only be an estimate, to match persp_pt1.
+        (xy * (Sk4s(1) / z)).store(&dst->fX);
+        return;
+    }
+    // Like persp_pt1, map points at infinity to (0, 0).
+    SkScalar xyArray[4], zArray[4];
+    xy.store(xyArray);
+    z.store(zArray);
+    for (int i = 0; i < 4; ++i) {
+        (&dst->fX)[i] = zArray[i] ? xyArray[i] * SkScalarFastInvert(zArray[i]) : 0;
+    }
+}
 #endif
-            if (z) {
-                z = SkScalarFastInvert(z);
-            }
 
-            dst->fY = y * z;
-            dst->fX = x * z;
+void SkMatrix::Persp_pts(const SkMatrix& m, SkPoint dst[],
+                         const SkPoint src[], int count) {
+    SkASSERT(m.hasPerspective());
+
+#ifdef SK_PERSP_PTS_ONE_AT_A_TIME
+    for (int i = 0; i < count; ++i) {
+        persp_pt1(m.fMat, &dst[i], src[i]);
+    }
+#else
+    if (count > 0) {
+        if (count & 1) {
+            persp_pt1(m.fMat, dst, *src);
+            src += 1;
             dst += 1;
-        } while (--count);
+        }
+        count >>= 1;
+        if (count & 1) {
+            persp_pts2(m.fMat, dst, src);
+            src += 2;
+            dst += 2;
+        }
+        count >>= 1;
+        for (int i = 0; i < count; ++i) {
+            persp_pts2(m.fMat, &dst[0], &src[0]);
+            persp_pts2(m.fMat, &dst[2], &src[2]);
+            src += 4;
+            dst += 4;
+        }
     }
+#endif
 }
 
 void SkMatrix::Affine_vpts(const SkMatrix& m, SkPoint dst[], const SkPoint src[], int count) {
@@ -1078,6 +1149,44 @@ bool SkMatrix::mapRect(SkRect* dst, const SkRect& src) const {
     }
 }
 
+bool SkMatrix::mapRects(SkRect dst[], const SkRect src[], int count) const {
+    SkASSERT((dst && src && count > 0) || 0 == count);
+    // no partial overlap
+    SkASSERT(src == dst || &dst[count] <= &src[0] || &src[count] <= &dst[0]);
+
+    if (this->getType() <= (kScale_Mask | kTranslate_Mask)) {
+        // Each corner maps with one multiply-add, and sorting them is just a min and a max.
+        Sk2s scale2(fMat[kMScaleX], fMat[kMScaleY]);
+        Sk2s trans2(fMat[kMTransX], fMat[kMTransY]);
+        for (int i = 0; i < count; ++i) {
+            Sk2s lt = Sk2s::Load(&src[i].fLeft)  * scale2 + trans2;
+            Sk2s rb = Sk2s::Load(&src[i].fRight) * scale2 + trans2;
+            Sk2s::Min(lt, rb).store(&dst[i].fLeft);
+            Sk2s::Max(lt, rb).store(&dst[i].fRight);
+        }
+        return true;
+    }
+
+    // Otherwise map the corners of a batch of rects at a time, so that the map proc runs its
+    // vector loop over all of them.
+    static const int kMaxRectsPerBatch = 16;
+    SkPoint quads[4 * kMaxRectsPerBatch];
+    while (count > 0) {
+        const int n = SkTMin(count, kMaxRectsPerBatch);
+        for (int i = 0; i < n; ++i) {
+            src[i].toQuad(&quads[4 * i]);
+        }
+        this->mapPoints(quads, 4 * n);
+        for (int i = 0; i < n; ++i) {
+            dst[i].set(&quads[4 * i], 4);
+        }
+        src += n;
+        dst += n;
+        count -= n;
+    }
+    return this->rectStaysRect();
+}
+
 SkScalar SkMatrix::mapRadius(SkScalar radius) const {
     SkVector    vec[2];
 
@@ -40,6 +40,9 @@ public:
     float g() const { return this->kth<SK_G32_SHIFT / 8>(); }
     float b() const { return this->kth<SK_B32_SHIFT / 8>(); }
 
+    // Alpha in all four components, for scaling the components by.  Cheaper than Sk4f(a()).
+    Sk4f alphas() const;
+
     // N.B. All methods returning an SkPMColor call SkPMColorAssert on that result before returning.
 
     // round() and roundClamp() round component values to the nearest integer.
@@ -9,6 +9,7 @@
 #include "SkLazyPtr.h"
 #include "SkPath.h"
 #include "SkPathRef.h"
+#include "SkStrokeCache.h"
 
 //////////////////////////////////////////////////////////////////////////////
 SkPathRef::Editor::Editor(SkAutoTUnref<SkPathRef>* pathRef,
@@ -23,6 +24,7 @@ SkPathRef::Editor::Editor(SkAutoTUnref<SkPathRef>* pathRef,
         pathRef->reset(copy);
     }
     fPathRef = *pathRef;
+    fPathRef->notifyGenIDIsStale();
     fPathRef->fGenerationID = 0;
     SkDEBUGCODE(sk_atomic_inc(&fPathRef->fEditorsAttached);)
 }
@@ -63,6 +65,10 @@ void SkPathRef::CreateTransformedCopy(SkAutoTUnref<SkPathRef>* dst,
         (*dst)->resetToSize(src.fVerbCnt, src.fPointCnt, src.fConicWeights.count());
         memcpy((*dst)->verbsMemWritable(), src.verbsMemBegin(), src.fVerbCnt * sizeof(uint8_t));
         (*dst)->fConicWeights = src.fConicWeights;
+    } else {
+        // We're about to transform our points in place.
+        (*dst)->notifyGenIDIsStale();
+        (*dst)->fGenerationID = 0;
     }
 
     SkASSERT((*dst)->countPoints() == src.countPoints());
@@ -158,6 +164,7 @@ void SkPathRef::Rewind(SkAutoTUnref<SkPathRef>* pathRef) {
         (*pathRef)->fVerbCnt = 0;
         (*pathRef)->fPointCnt = 0;
         (*pathRef)->fFreeSpace = (*pathRef)->currSize();
+        (*pathRef)->notifyGenIDIsStale();
         (*pathRef)->fGenerationID = 0;
         (*pathRef)->fConicWeights.rewind();
         (*pathRef)->fSegmentMask = 0;
@@ -171,6 +178,16 @@ void SkPathRef::Rewind(SkAutoTUnref<SkPathRef>* pathRef) {
     }
 }
 
+// Sets *genID to id unless it already has a (nonzero) ID, and returns the ID it ends up with.
+static uint32_t set_gen_id_if_zero(uint32_t* genID, uint32_t id) {
+    uint32_t expected = 0;
+    if (sk_atomic_compare_exchange(genID, &expected, id,
+                                   sk_memory_order_relaxed, sk_memory_order_relaxed)) {
+        return id;
+    }
+    return expected;
+}
+
 bool SkPathRef::operator== (const SkPathRef& ref) const {
     SkDEBUGCODE(this->validate();)
     SkDEBUGCODE(ref.validate();)
@@ -182,7 +199,9 @@ bool SkPathRef::operator== (const SkPathRef& ref) const {
         return false;
     }
 
-    bool genIDMatch = fGenerationID && fGenerationID == ref.fGenerationID;
+    const uint32_t genID = sk_atomic_load(&fGenerationID, sk_memory_order_relaxed);
+    bool genIDMatch = genID &&
+                      genID == sk_atomic_load(&ref.fGenerationID, sk_memory_order_relaxed);
 #ifdef SK_RELEASE
     if (genIDMatch) {
         return true;
@@ -217,10 +236,10 @@ bool SkPathRef::operator== (const SkPathRef& ref) const {
     }
     // We've done the work to determine that these are equal. If either has a zero genID, copy
     // the other's. If both are 0 then genID() will compute the next ID.
-    if (0 == fGenerationID) {
-        fGenerationID = ref.genID();
-    } else if (0 == ref.fGenerationID) {
-        ref.fGenerationID = this->genID();
+    if (0 == genID) {
+        set_gen_id_if_zero(&fGenerationID, ref.genID());
+    } else {
+        set_gen_id_if_zero(&ref.fGenerationID, genID);
     }
     return true;
 }
@@ -421,19 +440,30 @@ SkPoint* SkPathRef::growForVerb(int /* SkPath::Verb*/ verb, SkScalar weight) {
 uint32_t SkPathRef::genID() const {
     SkASSERT(!fEditorsAttached);
     static const uint32_t kMask = (static_cast<int64_t>(1) << SkPath::kPathRefGenIDBitCnt) - 1;
-    if (!fGenerationID) {
+    uint32_t id = sk_atomic_load(&fGenerationID, sk_memory_order_relaxed);
+    if (!id) {
         if (0 == fPointCnt && 0 == fVerbCnt) {
-            fGenerationID = kEmptyGenID;
+            id = kEmptyGenID;
         } else {
             static int32_t  gPathRefGenerationID;
             // do a loop in case our global wraps around, as we never want to return a 0 or the
             // empty ID
             do {
-                fGenerationID = (sk_atomic_inc(&gPathRefGenerationID) + 1) & kMask;
-            } while (fGenerationID <= kEmptyGenID);
+                id = (sk_atomic_inc(&gPathRefGenerationID) + 1) & kMask;
+            } while (id <= kEmptyGenID);
         }
+        // A path shared between threads (e.g. drawn by several playbacks of one picture) can
+        // race to assign its ID. Everyone must see the same one, so the first to set it wins.
+        id = set_gen_id_if_zero(&fGenerationID, id);
+    }
+    return id;
+}
+
+void SkPathRef::notifyGenIDIsStale() {
+    if (fAddedToCache.load()) {
+        SkNotifyPathGenIDIsStale(fGenerationID);
+        fAddedToCache.store(false);
     }
-    return fGenerationID;
 }
 
 #ifdef SK_DEBUG
@@ -36,6 +36,7 @@
 #include "GrContext.h"
 #endif
 
+#include "SkLayerInfo.h"
 #include "SkRecord.h"
 #include "SkRecordDraw.h"
 #include "SkRecordOpts.h"
@@ -301,8 +302,15 @@ void SkPicture::playback(SkCanvas* canvas, AbortCallback* callback) const {
     (void)canvas->getClipBounds(&clipBounds);
     const bool useBBH = !clipBounds.contains(this->cullRect());
 
+    // Ganesh hoists layers itself; on other backends, bound each layer by what's drawn into it.
+    const SkLayerInfo* layerInfo = NULL;
+    if (NULL == canvas->getGrContext()) {
+        layerInfo = static_cast<const SkLayerInfo*>(
+                this->EXPERIMENTAL_getAccelData(SkLayerInfo::ComputeKey()));
+    }
+
     SkRecordDraw(*fRecord, canvas, this->drawablePicts(), NULL, this->drawableCount(),
-                 useBBH ? fBBH.get() : NULL, callback);
+                 useBBH ? fBBH.get() : NULL, callback, layerInfo);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -52,6 +52,22 @@ const SkIRect& SkRasterClip::getBounds() const {
     return fIsBW ? fBW.getBounds() : fAA.getBounds();
 }
 
+bool SkRasterClip::set(const SkRasterClip& src) {
+    AUTO_RASTERCLIP_VALIDATE(src);
+
+    fForceConservativeRects = src.fForceConservativeRects;
+    fIsBW = src.fIsBW;
+    if (fIsBW) {
+        fBW.set(src.fBW);
+        fAA.setEmpty();
+    } else {
+        fAA.set(src.fAA);
+        fBW.setEmpty();
+    }
+    // src already collapsed any rect-shaped AA clip, so copy it exactly as it is.
+    return this->updateCacheAndReturnNonEmpty(false);
+}
+
 bool SkRasterClip::setEmpty() {
     AUTO_RASTERCLIP_VALIDATE(*this);
 
@@ -161,7 +177,8 @@ bool SkRasterClip::setPath(const SkPath& path, const SkRegion& clip, bool doAA)
     return this->updateCacheAndReturnNonEmpty();
 }
 
-bool SkRasterClip::op(const SkPath& path, const SkISize& size, SkRegion::Op op, bool doAA) {
+bool SkRasterClip::op(const SkPath& path, const SkISize& size, SkRegion::Op op, bool doAA,
+                      SkRegion::OpScratch* scratch) {
     // base is used to limit the size (and therefore memory allocation) of the
     // region that results from scan converting devPath.
     SkRegion base;
@@ -178,7 +195,7 @@ bool SkRasterClip::op(const SkPath& path, const SkISize& size, SkRegion::Op op,
                 ir = path.getBounds().roundOut();
                 break;
         }
-        return this->op(ir, op);
+        return this->op(ir, op, scratch);
     }
 
     if (SkRegion::kIntersect_Op == op) {
@@ -194,7 +211,7 @@ bool SkRasterClip::op(const SkPath& path, const SkISize& size, SkRegion::Op op,
             base.setRect(this->getBounds());
             SkRasterClip clip(fForceConservativeRects);
             clip.setPath(path, base, doAA);
-            return this->op(clip, op);
+            return this->op(clip, op, scratch);
         }
     } else {
         base.setRect(0, 0, size.width(), size.height());
@@ -204,7 +221,7 @@ bool SkRasterClip::op(const SkPath& path, const SkISize& size, SkRegion::Op op,
         } else {
             SkRasterClip clip(fForceConservativeRects);
             clip.setPath(path, base, doAA);
-            return this->op(clip, op);
+            return this->op(clip, op, scratch);
         }
     }
 }
@@ -215,18 +232,18 @@ bool SkRasterClip::setPath(const SkPath& path, const SkIRect& clip, bool doAA) {
     return this->setPath(path, tmp, doAA);
 }
 
-bool SkRasterClip::op(const SkIRect& rect, SkRegion::Op op) {
+bool SkRasterClip::op(const SkIRect& rect, SkRegion::Op op, SkRegion::OpScratch* scratch) {
     AUTO_RASTERCLIP_VALIDATE(*this);
 
-    fIsBW ? fBW.op(rect, op) : fAA.op(rect, op);
+    fIsBW ? fBW.op(rect, op, scratch) : fAA.op(rect, op);
     return this->updateCacheAndReturnNonEmpty();
 }
 
-bool SkRasterClip::op(const SkRegion& rgn, SkRegion::Op op) {
+bool SkRasterClip::op(const SkRegion& rgn, SkRegion::Op op, SkRegion::OpScratch* scratch) {
     AUTO_RASTERCLIP_VALIDATE(*this);
 
     if (fIsBW) {
-        (void)fBW.op(rgn, op);
+        (void)fBW.op(rgn, op, scratch);
     } else {
         SkAAClip tmp;
         tmp.setRegion(rgn);
@@ -235,12 +252,12 @@ bool SkRasterClip::op(const SkRegion& rgn, SkRegion::Op op) {
     return this->updateCacheAndReturnNonEmpty();
 }
 
-bool SkRasterClip::op(const SkRasterClip& clip, SkRegion::Op op) {
+bool SkRasterClip::op(const SkRasterClip& clip, SkRegion::Op op, SkRegion::OpScratch* scratch) {
     AUTO_RASTERCLIP_VALIDATE(*this);
     clip.validate();
 
     if (this->isBW() && clip.isBW()) {
-        (void)fBW.op(clip.fBW, op);
+        (void)fBW.op(clip.fBW, op, scratch);
     } else {
         SkAAClip tmp;
         const SkAAClip* other;
@@ -272,7 +289,8 @@ static bool nearly_integral(SkScalar x) {
     return x - SkScalarFloorToScalar(x) < domain;
 }
 
-bool SkRasterClip::op(const SkRect& r, const SkISize& size, SkRegion::Op op, bool doAA) {
+bool SkRasterClip::op(const SkRect& r, const SkISize& size, SkRegion::Op op, bool doAA,
+                      SkRegion::OpScratch* scratch) {
     AUTO_RASTERCLIP_VALIDATE(*this);
 
     if (fForceConservativeRects) {
@@ -287,7 +305,7 @@ bool SkRasterClip::op(const SkRect& r, const SkISize& size, SkRegion::Op op, boo
                 ir = r.roundOut();
                 break;
         }
-        return this->op(ir, op);
+        return this->op(ir, op, scratch);
     }
     
     if (fIsBW && doAA) {
@@ -302,7 +320,7 @@ bool SkRasterClip::op(const SkRect& r, const SkISize& size, SkRegion::Op op, boo
     if (fIsBW && !doAA) {
         SkIRect ir;
         r.round(&ir);
-        (void)fBW.op(ir, op);
+        (void)fBW.op(ir, op, scratch);
     } else {
         if (fIsBW) {
             this->convertToAA();
@@ -40,11 +40,16 @@ public:
 
     bool setEmpty();
     bool setRect(const SkIRect&);
-
-    bool op(const SkIRect&, SkRegion::Op);
-    bool op(const SkRegion&, SkRegion::Op);
-    bool op(const SkRect&, const SkISize&, SkRegion::Op, bool doAA);
-    bool op(const SkPath&, const SkISize&, SkRegion::Op, bool doAA);
+    bool set(const SkRasterClip&);
+
+    // If scratch is not null, the BW ops compute their runs in it, so that a chain of clips
+    // (e.g. a canvas's) reuses one buffer.
+    bool op(const SkIRect&, SkRegion::Op, SkRegion::OpScratch* scratch = NULL);
+    bool op(const SkRegion&, SkRegion::Op, SkRegion::OpScratch* scratch = NULL);
+    bool op(const SkRect&, const SkISize&, SkRegion::Op, bool doAA,
+            SkRegion::OpScratch* scratch = NULL);
+    bool op(const SkPath&, const SkISize&, SkRegion::Op, bool doAA,
+            SkRegion::OpScratch* scratch = NULL);
     
     void translate(int dx, int dy, SkRasterClip* dst) const;
     void translate(int dx, int dy) {
@@ -109,7 +114,7 @@ private:
 
     bool setPath(const SkPath& path, const SkRegion& clip, bool doAA);
     bool setPath(const SkPath& path, const SkIRect& clip, bool doAA);
-    bool op(const SkRasterClip&, SkRegion::Op);
+    bool op(const SkRasterClip&, SkRegion::Op, SkRegion::OpScratch*);
     bool setConservativeRect(const SkRect& r, const SkIRect& clipR, bool isInverse);
 };
 
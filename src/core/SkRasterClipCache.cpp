@@ -0,0 +1,205 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkRasterClipCache.h"
+
+#include "SkAtomics.h"
+#include "SkChecksum.h"
+#include "SkGraphics.h"
+#include "SkPath.h"
+#include "SkRasterClip.h"
+#include "SkResourceCache.h"
+
+#define CHECK_LOCAL(localCache, localName, globalName, ...) \
+    ((localCache) ? localCache->localName(__VA_ARGS__) : SkResourceCache::globalName(__VA_ARGS__))
+
+// Paths with at least this many points are worth caching even when they're not anti-aliased.
+#define kMinPointsToCacheBW     16
+
+static bool gRasterClipCacheEnabled = false;
+
+bool SkGraphics::GetRasterClipCacheEnabled() {
+    return sk_atomic_load(&gRasterClipCacheEnabled, sk_memory_order_relaxed);
+}
+
+bool SkGraphics::SetRasterClipCacheEnabled(bool enabled) {
+    return sk_atomic_exchange(&gRasterClipCacheEnabled, enabled, sk_memory_order_relaxed);
+}
+
+static const uint32_t kSeedLo = 0x52436c70;   // 'RClp'
+static const uint32_t kSeedHi = 0x43616368;   // 'Cach'
+
+static uint64_t hash64(const void* data, size_t bytes, uint64_t seed) {
+    uint32_t lo = SkChecksum::Murmur3(data, bytes, (uint32_t)seed ^ kSeedLo);
+    uint32_t hi = SkChecksum::Murmur3(data, bytes, (uint32_t)(seed >> 32) ^ kSeedHi);
+    return ((uint64_t)hi << 32) | lo;
+}
+
+namespace {
+
+enum Kind {
+    kReset_Kind,
+    kRectOp_Kind,
+    kPathOp_Kind,
+};
+
+struct ResetRecord {
+    int32_t fKind;
+    int32_t fLeft, fTop, fRight, fBottom;
+    int32_t fForceConservativeRects;
+};
+
+struct OpHeader {
+    int32_t  fKind;
+    int32_t  fWidth, fHeight;
+    int32_t  fOp;
+    int32_t  fAA;
+
+    OpHeader(const SkISize& size, SkRegion::Op op, bool doAA, Kind kind) {
+        fKind = kind;
+        fWidth = size.width();
+        fHeight = size.height();
+        fOp = op;
+        fAA = doAA;
+    }
+};
+
+}  // namespace
+
+SkRasterClipCache::History::History(const History* prev, SkData* op)
+    : fPrev(SkSafeRef(prev))
+    , fOp(op)
+    , fHash(hash64(op->data(), op->size(), prev ? prev->fHash : 0))
+    , fBytesUsed(sizeof(History) + op->size() + (prev ? prev->fBytesUsed : 0)) {
+}
+
+bool SkRasterClipCache::History::equals(const History* other) const {
+    const History* history = this;
+    // Histories are often shared, so stop as soon as both chains reach the same one.
+    while (history != other) {
+        if (NULL == history || NULL == other ||
+            history->fHash != other->fHash || !history->fOp->equals(other->fOp)) {
+            return false;
+        }
+        history = history->fPrev;
+        other = other->fPrev;
+    }
+    return true;
+}
+
+const SkRasterClipCache::History* SkRasterClipCache::NewRectHistory(const SkIRect& rect,
+                                                                    bool forceConservativeRects) {
+    ResetRecord record = {
+        kReset_Kind, rect.fLeft, rect.fTop, rect.fRight, rect.fBottom, forceConservativeRects
+    };
+    return SkNEW_ARGS(History, (NULL, SkData::NewWithCopy(&record, sizeof(record))));
+}
+
+const SkRasterClipCache::History* SkRasterClipCache::NewOpHistory(const History* prev,
+                                                                  const SkRect& devRect,
+                                                                  const SkISize& size,
+                                                                  SkRegion::Op op, bool doAA) {
+    if (NULL == prev) {
+        return NULL;
+    }
+    OpHeader header(size, op, doAA, kRectOp_Kind);
+    SkData* data = SkData::NewUninitialized(sizeof(header) + sizeof(devRect));
+    char* dst = (char*)data->writable_data();
+    memcpy(dst, &header, sizeof(header));
+    memcpy(dst + sizeof(header), &devRect, sizeof(devRect));
+    return SkNEW_ARGS(History, (prev, data));
+}
+
+const SkRasterClipCache::History* SkRasterClipCache::NewOpHistory(const History* prev,
+                                                                  const SkPath& devPath,
+                                                                  const SkISize& size,
+                                                                  SkRegion::Op op, bool doAA) {
+    if (NULL == prev) {
+        return NULL;
+    }
+    OpHeader header(size, op, doAA, kPathOp_Kind);
+    // The serialized path is its fill type, verbs, points and conic weights.
+    size_t pathSize = devPath.writeToMemory(NULL);
+    SkData* data = SkData::NewUninitialized(sizeof(header) + pathSize);
+    char* dst = (char*)data->writable_data();
+    memcpy(dst, &header, sizeof(header));
+    devPath.writeToMemory(dst + sizeof(header));
+    return SkNEW_ARGS(History, (prev, data));
+}
+
+bool SkRasterClipCache::ShouldCache(const SkPath& devPath, bool doAA) {
+    return doAA || devPath.countPoints() >= kMinPointsToCacheBW;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+static unsigned gRasterClipKeyNamespaceLabel;
+
+struct RasterClipKey : public SkResourceCache::Key {
+public:
+    RasterClipKey(uint64_t hash) : fHash(hash) {
+        this->init(&gRasterClipKeyNamespaceLabel, 0, sizeof(fHash));
+    }
+
+    uint64_t fHash;
+};
+
+struct RasterClipRec : public SkResourceCache::Rec {
+    RasterClipRec(const SkRasterClipCache::History* history, const SkRasterClip& clip)
+        : fKey(history->hash())
+        , fHistory(SkRef(history))
+        , fClip(clip)
+    {}
+
+    RasterClipKey                                  fKey;
+    SkAutoTUnref<const SkRasterClipCache::History> fHistory;
+    // Shares its region or runs with the clips built from it.
+    SkRasterClip                                   fClip;
+
+    const Key& getKey() const override { return fKey; }
+    size_t bytesUsed() const override {
+        return sizeof(*this) + fHistory->bytesUsed() +
+               (fClip.isBW() ? fClip.bwRgn().writeToMemory(NULL) : fClip.aaRgn().bytesUsed());
+    }
+
+    struct Context {
+        const SkRasterClipCache::History* fHistory;
+        SkRasterClip*                     fClip;
+    };
+
+    static bool Visitor(const SkResourceCache::Rec& baseRec, void* contextData) {
+        const RasterClipRec& rec = static_cast<const RasterClipRec&>(baseRec);
+        Context* context = (Context*)contextData;
+        // The key is only a hash of the history, so a hit has to check the whole history.
+        // Returning false drops the colliding rec, so the caller's clip can take its place.
+        if (!rec.fHistory->equals(context->fHistory)) {
+            return false;
+        }
+        context->fClip->set(rec.fClip);
+        return true;
+    }
+};
+} // namespace
+
+bool SkRasterClipCache::Find(const History* history, SkRasterClip* clip,
+                             SkResourceCache* localCache) {
+    if (NULL == history) {
+        return false;
+    }
+    RasterClipRec::Context context = { history, clip };
+    return CHECK_LOCAL(localCache, find, Find, RasterClipKey(history->hash()),
+                       RasterClipRec::Visitor, &context);
+}
+
+void SkRasterClipCache::Add(const History* history, const SkRasterClip& clip,
+                            SkResourceCache* localCache) {
+    if (NULL == history) {
+        return;
+    }
+    return CHECK_LOCAL(localCache, add, Add, SkNEW_ARGS(RasterClipRec, (history, clip)));
+}
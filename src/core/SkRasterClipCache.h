@@ -0,0 +1,87 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkRasterClipCache_DEFINED
+#define SkRasterClipCache_DEFINED
+
+#include "SkData.h"
+#include "SkRefCnt.h"
+#include "SkRegion.h"
+
+class SkPath;
+class SkRasterClip;
+class SkResourceCache;
+
+/**
+ *  Caches the SkRasterClips that SkCanvas builds for path clips, so that replaying the same clips
+ *  (every frame of an animation, every tile of a tiled render, every playback of a picture) does
+ *  not rebuild the same SkAAClip or SkRegion again. SkCanvas only uses it when
+ *  SkGraphics::SetRasterClipCacheEnabled() has turned it on.
+ *
+ *  SkClipStack generation IDs are unique per clip call, so they never repeat across playbacks or
+ *  canvases. Instead a clip is identified by how it was built: its History records the device
+ *  rect the clip was reset to, followed by every op's device-space geometry. Clips are looked up
+ *  by a hash of their history, and a hit only counts if the whole history matches. A NULL history
+ *  means "unknown" (e.g. after a region clip); nothing is cached until the clip is reset to a rect
+ *  again.
+ */
+class SkRasterClipCache {
+public:
+    /**
+     *  How a clip was built. Histories are immutable, and each op's history refs the one it was
+     *  applied to, so saving a canvas only has to ref its current history.
+     */
+    class History : public SkRefCnt {
+    public:
+        SK_DECLARE_INST_COUNT(History)
+
+        uint64_t hash() const { return fHash; }
+
+        /** Returns the bytes used by this history and all of the histories it was built from. */
+        size_t bytesUsed() const { return fBytesUsed; }
+
+        /** Returns true if other was built from the same rect with the same sequence of ops. */
+        bool equals(const History* other) const;
+
+    private:
+        History(const History* prev, SkData* op);
+
+        SkAutoTUnref<const History> fPrev;
+        SkAutoTUnref<SkData>        fOp;
+        uint64_t                    fHash;
+        size_t                      fBytesUsed;
+
+        friend class SkRasterClipCache;
+
+        typedef SkRefCnt INHERITED;
+    };
+
+    /** Returns the history of a clip reset to rect. The caller must unref it. */
+    static const History* NewRectHistory(const SkIRect& rect, bool forceConservativeRects);
+
+    /**
+     *  Returns the history of the clip built by applying this op to the clip with prev, or NULL
+     *  if prev is NULL. The caller must unref the returned history.
+     */
+    static const History* NewOpHistory(const History* prev, const SkRect& devRect,
+                                       const SkISize& size, SkRegion::Op, bool doAA);
+    static const History* NewOpHistory(const History* prev, const SkPath& devPath,
+                                       const SkISize& size, SkRegion::Op, bool doAA);
+
+    /**
+     *  Returns true if a clip with this path is worth looking up. Cheap clips are not cached, so
+     *  that canvases that never repeat their clips don't fill the cache with them.
+     */
+    static bool ShouldCache(const SkPath& devPath, bool doAA);
+
+    /** If a clip with this history is cached, copy it into clip and return true. */
+    static bool Find(const History*, SkRasterClip* clip, SkResourceCache* localCache = NULL);
+
+    static void Add(const History*, const SkRasterClip& clip, SkResourceCache* localCache = NULL);
+};
+
+#endif
@@ -0,0 +1,336 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkRasterPipeline.h"
+
+#include "SkColorFilter.h"
+#include "SkColorPriv.h"
+#include "SkPMFloat.h"
+
+// Slightly less than 1/255, so that premultiplying never makes a component bigger than alpha.
+// (See SkColorMatrixFilter.cpp.)
+static const float gInv255 = 0.0039215683f;
+
+static bool get_factor(SkXfermode::Coeff coeff, SkRasterPipeline::Factor* factor) {
+    SkRasterPipeline::Factor f = { 0, 0, 0, 0, 0 };
+    switch (coeff) {
+        case SkXfermode::kZero_Coeff:                           break;
+        case SkXfermode::kOne_Coeff:    f.fOne = 1;             break;
+        case SkXfermode::kSC_Coeff:     f.fSC = 1;              break;
+        case SkXfermode::kISC_Coeff:    f.fOne = 1; f.fSC = -1; break;
+        case SkXfermode::kDC_Coeff:     f.fDC = 1;              break;
+        case SkXfermode::kIDC_Coeff:    f.fOne = 1; f.fDC = -1; break;
+        case SkXfermode::kSA_Coeff:     f.fSA = 1;              break;
+        case SkXfermode::kISA_Coeff:    f.fOne = 1; f.fSA = -1; break;
+        case SkXfermode::kDA_Coeff:     f.fDA = 1;              break;
+        case SkXfermode::kIDA_Coeff:    f.fOne = 1; f.fDA = -1; break;
+        default:                        return false;
+    }
+    *factor = f;
+    return true;
+}
+
+static bool mode_as_factors(SkXfermode::Mode mode,
+                            SkRasterPipeline::Factor* src, SkRasterPipeline::Factor* dst) {
+    SkXfermode::Coeff srcCoeff, dstCoeff;
+    return SkXfermode::ModeAsCoeff(mode, &srcCoeff, &dstCoeff) &&
+           get_factor(srcCoeff, src) && get_factor(dstCoeff, dst);
+}
+
+bool SkRasterPipeline::CanFuse(const SkColorFilter* filter, const SkXfermode* xfermode) {
+    Factor src, dst;
+    SkXfermode::Mode mode;
+    if (xfermode && !(xfermode->asMode(&mode) && mode_as_factors(mode, &src, &dst))) {
+        return false;
+    }
+    SkColor color;
+    return NULL == filter ||
+           filter->asColorMatrix(NULL) ||
+           (filter->asColorMode(&color, &mode) && mode_as_factors(mode, &src, &dst));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Each stage is a functor constructed once per span, so its constants can live in registers, and
+// is forced inline so that a pixel stays in registers from load to store.
+struct SkRasterPipelineStages {
+    static SK_ALWAYS_INLINE Sk4f Clamp(const Sk4f& c) {
+        return Sk4f::Max(Sk4f(0), Sk4f::Min(Sk4f(255), c));
+    }
+
+    // Components computed separately in floats can round to just past alpha, so every stored
+    // color is pinned to valid premul.  Every stage keeps its results in [0, 255].
+    static SK_ALWAYS_INLINE SkPMFloat Pin(const SkPMFloat& c) {
+        return Sk4f::Min(c, c.alphas());
+    }
+
+    // s * srcFactor + d * dstFactor, where each factor is built as described by Factor.
+    class Coeffs {
+    public:
+        Coeffs(const SkRasterPipeline::Factor& src, const SkRasterPipeline::Factor& dst)
+            : fSrcOne(src.fOne * 255), fSrcSC(src.fSC), fSrcDC(src.fDC)
+            , fSrcSA(src.fSA), fSrcDA(src.fDA)
+            , fDstOne(dst.fOne * 255), fDstSC(dst.fSC), fDstDC(dst.fDC)
+            , fDstSA(dst.fSA), fDstDA(dst.fDA) {}
+
+        SK_ALWAYS_INLINE SkPMFloat operator()(const SkPMFloat& s, const SkPMFloat& d) const {
+            const Sk4f sa = s.alphas(), da = d.alphas();
+            const Sk4f sf = fSrcOne + fSrcSC * s + fSrcDC * d + fSrcSA * sa + fSrcDA * da;
+            const Sk4f df = fDstOne + fDstSC * s + fDstDC * d + fDstSA * sa + fDstDA * da;
+            return Clamp((s * sf + d * df) * Sk4f(gInv255));
+        }
+
+    private:
+        const Sk4f fSrcOne, fSrcSC, fSrcDC, fSrcSA, fSrcDA;
+        const Sk4f fDstOne, fDstSC, fDstDC, fDstSA, fDstDA;
+    };
+
+    // Color filter stages.
+
+    struct NoFilter {
+        explicit NoFilter(const SkRasterPipeline&) {}
+        SkPMFloat operator()(const SkPMFloat& c) const { return c; }
+    };
+
+    // The same math as SkColorMatrixFilter::filterSpan(), including its shortcuts for
+    // transparent and opaque pixels.
+    class MatrixFilter {
+    public:
+        explicit MatrixFilter(const SkRasterPipeline& p)
+            : fC0(Sk4f::Load(p.fMatrix +  0))
+            , fC1(Sk4f::Load(p.fMatrix +  4))
+            , fC2(Sk4f::Load(p.fMatrix +  8))
+            , fC3(Sk4f::Load(p.fMatrix + 12))
+            , fC4(Sk4f::Load(p.fMatrix + 16))
+            , fTranslate(Premul(fC4)) {}
+
+        SK_ALWAYS_INLINE SkPMFloat operator()(const SkPMFloat& c) const {
+            const float a = c.a();
+            if (0 == a) {
+                return fTranslate;
+            }
+            SkPMFloat unpremul = c;
+            if (a < 255) {
+                const float scale = 255 / a;
+                unpremul = c * Sk4f(scale, scale, scale, 1);
+            }
+            return Premul(fC0 * Sk4f(unpremul.r()) + fC1 * Sk4f(unpremul.g()) +
+                          fC2 * Sk4f(unpremul.b()) + fC3 * Sk4f(a) + fC4);
+        }
+
+    private:
+        static SK_ALWAYS_INLINE SkPMFloat Premul(const Sk4f& c) {
+            const SkPMFloat clamped = Clamp(c);
+            const float scale = clamped.a() * gInv255;
+            return clamped * Sk4f(scale, scale, scale, 1);
+        }
+
+        const Sk4f      fC0, fC1, fC2, fC3, fC4;
+        const SkPMFloat fTranslate;
+    };
+
+    // SkModeColorFilter: the filter's color transferred onto the shader's.
+    class ModeFilter {
+    public:
+        explicit ModeFilter(const SkRasterPipeline& p)
+            : fColor(p.fFilterColor), fCoeffs(p.fFilterSrc, p.fFilterDst) {}
+
+        SK_ALWAYS_INLINE SkPMFloat operator()(const SkPMFloat& c) const {
+            return fCoeffs(fColor, c);
+        }
+
+    private:
+        const SkPMFloat fColor;
+        const Coeffs    fCoeffs;
+    };
+
+    // Xfermode stages.  Each coefficient mode gets its own, with the factors known at compile
+    // time, so that e.g. DstIn is just d * sa.
+
+    // x * coeff / 255.
+    template <SkXfermode::Coeff kCoeff>
+    static SK_ALWAYS_INLINE Sk4f Scale(const Sk4f& x, const SkPMFloat& s, const SkPMFloat& d) {
+        switch (kCoeff) {
+            case SkXfermode::kZero_Coeff: return Sk4f(0);
+            case SkXfermode::kOne_Coeff:  return x;
+            case SkXfermode::kSC_Coeff:   return x * s * Sk4f(gInv255);
+            case SkXfermode::kISC_Coeff:  return x * (Sk4f(255) - s) * Sk4f(gInv255);
+            case SkXfermode::kDC_Coeff:   return x * d * Sk4f(gInv255);
+            case SkXfermode::kIDC_Coeff:  return x * (Sk4f(255) - d) * Sk4f(gInv255);
+            case SkXfermode::kSA_Coeff:   return x * s.alphas() * Sk4f(gInv255);
+            case SkXfermode::kISA_Coeff:  return x * (Sk4f(255) - s.alphas()) * Sk4f(gInv255);
+            case SkXfermode::kDA_Coeff:   return x * d.alphas() * Sk4f(gInv255);
+            case SkXfermode::kIDA_Coeff:  return x * (Sk4f(255) - d.alphas()) * Sk4f(gInv255);
+            default:                      SkFAIL("not a coefficient"); return x;
+        }
+    }
+
+    template <SkXfermode::Coeff kSrc, SkXfermode::Coeff kDst>
+    struct Coeff {
+        explicit Coeff(const SkRasterPipeline&) {}
+        SK_ALWAYS_INLINE SkPMFloat operator()(const SkPMFloat& s, const SkPMFloat& d) const {
+            const Sk4f result = Scale<kSrc>(s, s, d) + Scale<kDst>(d, s, d);
+            // Only Plus can overflow.
+            if (SkXfermode::kOne_Coeff == kSrc && SkXfermode::kOne_Coeff == kDst) {
+                return Sk4f::Min(result, Sk4f(255));
+            }
+            return result;
+        }
+    };
+
+    // Coverage stages: lerp between dst and the xfermode's result, as
+    // SkProcCoeffXfermode::xfer32() does.
+
+    struct FullCoverage {
+        Sk4f operator()(int, const SkPMFloat&, const Sk4f& result) const { return result; }
+    };
+
+    class ConstCoverage {
+    public:
+        explicit ConstCoverage(SkAlpha aa) : fCoverage(aa * gInv255) {}
+        SK_ALWAYS_INLINE Sk4f operator()(int, const SkPMFloat& d, const Sk4f& result) const {
+            return d + (result - d) * fCoverage;
+        }
+
+    private:
+        const Sk4f fCoverage;
+    };
+
+    class MaskCoverage {
+    public:
+        explicit MaskCoverage(const SkAlpha aa[]) : fAA(aa) {}
+        SK_ALWAYS_INLINE Sk4f operator()(int i, const SkPMFloat& d, const Sk4f& result) const {
+            return d + (result - d) * Sk4f(fAA[i] * gInv255);
+        }
+
+    private:
+        const SkAlpha* fAA;
+    };
+
+    // Four pixels at a time, so the loads and stores can use SkPMFloat's 4-at-a-time versions.
+    template <typename Filter, typename Xfer, typename Coverage>
+    static void Loop(const Filter& filter, const Xfer& xfer, const Coverage& coverage,
+                     SkPMColor dst[], const SkPMColor src[], int count) {
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            SkPMFloat s0, s1, s2, s3, d0, d1, d2, d3;
+            SkPMFloat::From4PMColors(src + i, &s0, &s1, &s2, &s3);
+            SkPMFloat::From4PMColors(dst + i, &d0, &d1, &d2, &d3);
+            SkPMFloat::RoundClampTo4PMColors(Pin(coverage(i + 0, d0, xfer(filter(s0), d0))),
+                                             Pin(coverage(i + 1, d1, xfer(filter(s1), d1))),
+                                             Pin(coverage(i + 2, d2, xfer(filter(s2), d2))),
+                                             Pin(coverage(i + 3, d3, xfer(filter(s3), d3))),
+                                             dst + i);
+        }
+        for (; i < count; ++i) {
+            const SkPMFloat d(dst[i]);
+            dst[i] = Pin(coverage(i, d, xfer(filter(SkPMFloat(src[i])), d))).roundClamp();
+        }
+    }
+
+    template <typename Filter, typename Xfer>
+    static void Run(const SkRasterPipeline& p, SkPMColor dst[], const SkPMColor src[], int count,
+                    const SkAlpha aa[], SkAlpha constAA) {
+        const Filter filter(p);
+        const Xfer xfer(p);
+        if (aa) {
+            Loop(filter, xfer, MaskCoverage(aa), dst, src, count);
+        } else if (0xFF == constAA) {
+            Loop(filter, xfer, FullCoverage(), dst, src, count);
+        } else {
+            Loop(filter, xfer, ConstCoverage(constAA), dst, src, count);
+        }
+    }
+
+    template <typename Filter>
+    static void FilterOnly(const SkRasterPipeline& p, SkPMColor dst[], const SkPMColor src[],
+                           int count) {
+        const Filter filter(p);
+        for (int i = 0; i < count; ++i) {
+            dst[i] = Pin(filter(SkPMFloat(src[i]))).roundClamp();
+        }
+    }
+
+    template <typename Filter>
+    static void Choose(const SkRasterPipeline& p, SkRasterPipeline::RunProc* run,
+                       SkRasterPipeline::FilterProc* filter) {
+        // The same coefficients as SkXfermode::ModeAsCoeff(); RasterPipelineTest checks each mode.
+        typedef SkXfermode X;
+        #define CASE(mode, src, dst)                                                \
+            case X::k##mode##_Mode:                                                 \
+                *run = Run<Filter, Coeff<X::k##src##_Coeff, X::k##dst##_Coeff> >;   \
+                break
+        switch (p.fXferMode) {
+            CASE(Clear,    Zero, Zero);
+            CASE(Src,      One,  Zero);
+            CASE(Dst,      Zero, One);
+            CASE(SrcOver,  One,  ISA);
+            CASE(DstOver,  IDA,  One);
+            CASE(SrcIn,    DA,   Zero);
+            CASE(DstIn,    Zero, SA);
+            CASE(SrcOut,   IDA,  Zero);
+            CASE(DstOut,   Zero, ISA);
+            CASE(SrcATop,  DA,   ISA);
+            CASE(DstATop,  IDA,  SA);
+            CASE(Xor,      IDA,  ISA);
+            CASE(Plus,     One,  One);
+            CASE(Modulate, Zero, SC);
+            CASE(Screen,   One,  ISC);
+            default:
+                SkFAIL("not a coefficient mode");
+                *run = Run<Filter, Coeff<X::kOne_Coeff, X::kISA_Coeff> >;
+                break;
+        }
+        #undef CASE
+        *filter = FilterOnly<Filter>;
+    }
+};
+
+SkRasterPipeline::SkRasterPipeline(const SkColorFilter* filter, const SkXfermode* xfermode) {
+    SkASSERT(CanFuse(filter, xfermode));
+
+    fXferMode = SkXfermode::kSrcOver_Mode;
+    if (xfermode) {
+        SkAssertResult(xfermode->asMode(&fXferMode));
+    }
+
+    fFilterType = kNone_FilterType;
+    SkScalar matrix[20];
+    SkXfermode::Mode mode;
+    SkColor color;
+    if (NULL == filter) {
+        // Nothing to do.
+    } else if (filter->asColorMatrix(matrix)) {
+        // Transpose into the order of SkPMColor's components, as SkColorMatrixFilter does.
+        const int kIndex[4] = { SK_A32_SHIFT / 8, SK_R32_SHIFT / 8,
+                                SK_G32_SHIFT / 8, SK_B32_SHIFT / 8 };
+        const float* rows[4] = { matrix + 15, matrix + 0, matrix + 5, matrix + 10 };  // A,R,G,B
+        for (int col = 0; col < 5; ++col) {
+            for (int k = 0; k < 4; ++k) {
+                fMatrix[col * 4 + kIndex[k]] = rows[k][col];
+            }
+        }
+        fFilterType = kMatrix_FilterType;
+    } else if (filter->asColorMode(&color, &mode)) {
+        SkAssertResult(mode_as_factors(mode, &fFilterSrc, &fFilterDst));
+        fFilterColor = SkPreMultiplyColor(color);
+        fFilterType = kMode_FilterType;
+    }
+
+    typedef SkRasterPipelineStages Stages;
+    switch (fFilterType) {
+        case kNone_FilterType:
+            Stages::Choose<Stages::NoFilter>(*this, &fRun, &fFilter);
+            break;
+        case kMatrix_FilterType:
+            Stages::Choose<Stages::MatrixFilter>(*this, &fRun, &fFilter);
+            break;
+        case kMode_FilterType:
+            Stages::Choose<Stages::ModeFilter>(*this, &fRun, &fFilter);
+            break;
+    }
+}
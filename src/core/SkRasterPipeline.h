@@ -0,0 +1,86 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkRasterPipeline_DEFINED
+#define SkRasterPipeline_DEFINED
+
+#include "SkColor.h"
+#include "SkXfermode.h"
+
+class SkColorFilter;
+
+/**
+ *  The stages a shader's pixels go through on their way into an N32 device: color filter,
+ *  xfermode, coverage and store.  The stages are chosen once per draw, then run together in one
+ *  pass per span, with each pixel held in an SkPMFloat from load to store, rather than as a
+ *  pass over memory (and a virtual call) per stage.
+ *
+ *  Only color filters that are a color matrix or a coefficient mode, and xfermodes that are
+ *  coefficient modes, can be fused; see CanFuse().
+ */
+class SkRasterPipeline {
+public:
+    /** Can the pipeline apply this color filter and xfermode?  Either may be NULL. */
+    static bool CanFuse(const SkColorFilter*, const SkXfermode*);
+
+    /** The color filter and xfermode must pass CanFuse(). */
+    SkRasterPipeline(const SkColorFilter*, const SkXfermode*);
+
+    /**
+     *  Filters and transfers count shaded src pixels onto dst, lerping the result with dst by
+     *  the coverage in aa[], or by 255 if aa is NULL.
+     */
+    void run(SkPMColor dst[], const SkPMColor src[], int count, const SkAlpha aa[]) const {
+        fRun(*this, dst, src, count, aa, 0xFF);
+    }
+
+    /** As above, but with the same coverage for every pixel. */
+    void run(SkPMColor dst[], const SkPMColor src[], int count, SkAlpha aa) const {
+        fRun(*this, dst, src, count, NULL, aa);
+    }
+
+    /** Just the color filter stage, for callers that must transfer the pixels themselves. */
+    void filter(SkPMColor dst[], const SkPMColor src[], int count) const {
+        fFilter(*this, dst, src, count);
+    }
+
+    bool hasFilter() const { return kNone_FilterType != fFilterType; }
+
+    bool xferIsSrcOver() const { return SkXfermode::kSrcOver_Mode == fXferMode; }
+
+    // Each factor of a color filter's coefficient mode, in [0, 255], is
+    //     fOne * 255 + fSC * src + fDC * dst + fSA * srcAlpha + fDA * dstAlpha.
+    struct Factor {
+        float fOne, fSC, fDC, fSA, fDA;
+    };
+
+private:
+    enum FilterType {
+        kNone_FilterType,
+        kMatrix_FilterType,
+        kMode_FilterType,
+    };
+
+    typedef void (*RunProc)(const SkRasterPipeline&, SkPMColor[], const SkPMColor[], int,
+                            const SkAlpha[], SkAlpha);
+    typedef void (*FilterProc)(const SkRasterPipeline&, SkPMColor[], const SkPMColor[], int);
+
+    FilterType          fFilterType;
+    SkXfermode::Mode    fXferMode;
+    RunProc             fRun;
+    FilterProc          fFilter;
+
+    // kMatrix_FilterType: the color matrix, transposed into SkPMColor order.
+    float               fMatrix[20];
+    // kMode_FilterType: the filter's color, transferred with the shader's color as dst.
+    SkPMColor           fFilterColor;
+    Factor              fFilterSrc, fFilterDst;
+
+    friend struct SkRasterPipelineStages;
+};
+
+#endif
@@ -8,6 +8,7 @@
 #include "SkLayerInfo.h"
 #include "SkRecordDraw.h"
 #include "SkPatchUtils.h"
+#include "SkTHash.h"
 
 void SkRecordDraw(const SkRecord& record,
                   SkCanvas* canvas,
@@ -15,9 +16,21 @@ void SkRecordDraw(const SkRecord& record,
                   SkDrawable* const drawables[],
                   int drawableCount,
                   const SkBBoxHierarchy* bbh,
-                  SkPicture::AbortCallback* callback) {
+                  SkPicture::AbortCallback* callback,
+                  const SkLayerInfo* layerInfo) {
     SkAutoCanvasRestore saveRestore(canvas, true /*save now, restore at exit*/);
 
+    // Bounds of the saveLayers in this record (not in nested pictures), by op index.
+    SkTHashMap<unsigned, SkRect> layerBounds;
+    if (layerInfo) {
+        for (int i = 0; i < layerInfo->numBlocks(); ++i) {
+            const SkLayerInfo::BlockInfo& block = layerInfo->block(i);
+            if (NULL == block.fPicture) {
+                layerBounds.set(SkToUInt(block.fSaveLayerOpID), block.fBounds);
+            }
+        }
+    }
+
     if (bbh) {
         // Draw only ops that affect pixels in the canvas's current clip.
         // The SkRecord and BBH were recorded in identity space.  This canvas
@@ -37,6 +50,9 @@ void SkRecordDraw(const SkRecord& record,
             if (callback && callback->abort()) {
                 return;
             }
+            if (layerBounds.count()) {
+                draw.setNextLayerBounds(layerBounds.find(ops[i]));
+            }
             // This visit call uses the SkRecords::Draw::operator() to call
             // methods on the |canvas|, wrapped by methods defined with the
             // DRAW() macro.
@@ -49,6 +65,9 @@ void SkRecordDraw(const SkRecord& record,
             if (callback && callback->abort()) {
                 return;
             }
+            if (layerBounds.count()) {
+                draw.setNextLayerBounds(layerBounds.find(i));
+            }
             // This visit call uses the SkRecords::Draw::operator() to call
             // methods on the |canvas|, wrapped by methods defined with the
             // DRAW() macro.
@@ -78,7 +97,29 @@ template <> void Draw::draw(const NoOp&) {}
 #define DRAW(T, call) template <> void Draw::draw(const T& r) { fCanvas->call; }
 DRAW(Restore, restore());
 DRAW(Save, save());
-DRAW(SaveLayer, saveLayer(r.bounds, r.paint, r.flags));
+
+template <> void Draw::draw(const SaveLayer& r) {
+    const SkRect* bounds = r.bounds;
+    SkRect tightBounds;
+    if (fNextLayerBounds) {
+        // Map the layer's content bounds to device space, pad them for rounding, and back into
+        // the local space that saveLayer() expects.
+        SkRect devBounds;
+        fInitialCTM.mapRect(&devBounds, *fNextLayerBounds);
+        devBounds.outset(SK_Scalar1, SK_Scalar1);
+        SkMatrix inverse;
+        if (fCanvas->getTotalMatrix().invert(&inverse)) {
+            inverse.mapRect(&tightBounds, devBounds);
+            if (r.bounds && !tightBounds.intersect(*r.bounds)) {
+                // Nothing drawn into the layer lands inside its bounds.
+                tightBounds.setEmpty();
+            }
+            bounds = &tightBounds;
+        }
+        fNextLayerBounds = NULL;
+    }
+    fCanvas->saveLayer(bounds, r.paint, r.flags);
+}
 DRAW(SetMatrix, setMatrix(SkMatrix::Concat(fInitialCTM, r.matrix)));
 
 DRAW(ClipPath, clipPath(r.path, r.opAA.op, r.opAA.aa));
@@ -24,9 +24,12 @@ void SkRecordComputeLayers(const SkRect& cullRect, const SkRecord& record,
                            SkBBoxHierarchy* bbh, SkLayerInfo* data);
 
 // Draw an SkRecord into an SkCanvas.  A convenience wrapper around SkRecords::Draw.
+// If layerInfo (computed by SkRecordComputeLayers) is given, each saveLayer is bounded by the
+// bounds of what is drawn into it, so it allocates no more than it needs.
 void SkRecordDraw(const SkRecord&, SkCanvas*, SkPicture const* const drawablePicts[],
                   SkDrawable* const drawables[], int drawableCount,
-                  const SkBBoxHierarchy*, SkPicture::AbortCallback*);
+                  const SkBBoxHierarchy*, SkPicture::AbortCallback*,
+                  const SkLayerInfo* layerInfo = NULL);
 
 // Draw a portion of an SkRecord into an SkCanvas.
 // When drawing a portion of an SkRecord the CTM on the passed in canvas must be
@@ -50,8 +53,13 @@ public:
         , fDrawablePicts(drawablePicts)
         , fDrawables(drawables)
         , fDrawableCount(drawableCount)
+        , fNextLayerBounds(NULL)
     {}
 
+    // If not NULL, the next SaveLayer is limited to these bounds, which are in the space of
+    // the initial CTM (like SkLayerInfo::BlockInfo::fBounds for the top-most picture).
+    void setNextLayerBounds(const SkRect* bounds) { fNextLayerBounds = bounds; }
+
     // This operator calls methods on the |canvas|. The various draw() wrapper
     // methods around SkCanvas are defined by the DRAW() macro in
     // SkRecordDraw.cpp.
@@ -72,6 +80,7 @@ private:
     SkPicture const* const* fDrawablePicts;
     SkDrawable* const* fDrawables;
     int fDrawableCount;
+    const SkRect* fNextLayerBounds;
 };
 
 }  // namespace SkRecords
@@ -281,9 +281,14 @@ bool SkRegion::setRuns(RunType runs[], int count) {
 
     //  if we get here, we need to become a complex region
 
-    if (!this->isComplex() || fRunHead->fRunCount != count) {
+    // Write over our own runs if no other region shares them and they have room, as long as
+    // that doesn't hold on to more than twice what we need. Otherwise allocate new ones.
+    if (!this->isComplex() || fRunHead->fRefCnt > 1 ||
+            fRunHead->fCapacity < count || fRunHead->fCapacity > 2 * count) {
         this->freeRuns();
         this->allocateRuns(count);
+    } else {
+        fRunHead->fRunCount = count;
     }
 
     // must call this before we can write directly into runs()
@@ -590,8 +595,9 @@ bool SkRegion::setRects(const SkIRect rects[], int count) {
         this->setEmpty();
     } else {
         this->setRect(rects[0]);
+        OpScratch scratch;
         for (int i = 1; i < count; i++) {
-            this->op(rects[i], kUnion_Op);
+            this->op(rects[i], kUnion_Op, &scratch);
         }
     }
     return !this->isEmpty();
@@ -630,13 +636,6 @@ struct spanRec {
         fB_runs = b_runs;
     }
 
-    bool done() const {
-        SkASSERT(fA_left <= SkRegion::kRunTypeSentinel);
-        SkASSERT(fB_left <= SkRegion::kRunTypeSentinel);
-        return fA_left == SkRegion::kRunTypeSentinel &&
-               fB_left == SkRegion::kRunTypeSentinel;
-    }
-
     void next() {
         assert_valid_pair(fA_left, fA_rite);
         assert_valid_pair(fB_left, fB_rite);
@@ -704,6 +703,38 @@ struct spanRec {
     }
 };
 
+/*  Once one of the spans has run out of intervals, the rest of the other span is either all in
+    the result or all out of it. If it is in, append it to dst (the first of them possibly
+    extending the last interval already there) in one block.
+ */
+static SkRegion::RunType* flush_span_tail(const spanRec& rec, SkRegion::RunType dst[],
+                                          bool firstInterval, int min, int max) {
+    const bool a_done = SkRegion::kRunTypeSentinel == rec.fA_left;
+    const int inside = a_done ? 2 : 1;
+    if ((unsigned)(inside - min) > (unsigned)(max - min)) {
+        return dst;
+    }
+
+    const int left = a_done ? rec.fB_left : rec.fA_left;
+    const int rite = a_done ? rec.fB_rite : rec.fA_rite;
+    const SkRegion::RunType* runs = a_done ? rec.fB_runs : rec.fA_runs;
+    assert_valid_pair(left, rite);
+
+    if (firstInterval || dst[-1] < left) {
+        *dst++ = (SkRegion::RunType)(left);
+        *dst++ = (SkRegion::RunType)(rite);
+    } else {
+        dst[-1] = (SkRegion::RunType)(rite);
+    }
+
+    const SkRegion::RunType* stop = runs;
+    while (*stop != SkRegion::kRunTypeSentinel) {
+        stop += 2;
+    }
+    memcpy(dst, runs, (stop - runs) * sizeof(SkRegion::RunType));
+    return dst + (stop - runs);
+}
+
 static SkRegion::RunType* operate_on_span(const SkRegion::RunType a_runs[],
                                           const SkRegion::RunType b_runs[],
                                           SkRegion::RunType dst[],
@@ -713,7 +744,16 @@ static SkRegion::RunType* operate_on_span(const SkRegion::RunType a_runs[],
 
     rec.init(a_runs, b_runs);
 
-    while (!rec.done()) {
+    for (;;) {
+        // Merge intervals until either span runs out of them.
+        const bool a_done = SkRegion::kRunTypeSentinel == rec.fA_left;
+        const bool b_done = SkRegion::kRunTypeSentinel == rec.fB_left;
+        if (a_done || b_done) {
+            if (!(a_done && b_done)) {
+                dst = flush_span_tail(rec, dst, firstInterval, min, max);
+            }
+            break;
+        }
         rec.next();
 
         int left = rec.fLeft;
@@ -772,10 +812,19 @@ public:
 
     void addSpan(int bottom, const SkRegion::RunType a_runs[],
                  const SkRegion::RunType b_runs[]) {
+        SkRegion::RunType*  start = this->spanStart();
+        this->acceptSpan(bottom, start, operate_on_span(a_runs, b_runs, start, fMin, fMax));
+    }
+
+    // Where the intervals of the next span are to be written.
+    SkRegion::RunType* spanStart() const {
         // skip X values and slots for the next Y+intervalCount
-        SkRegion::RunType*  start = fPrevDst + fPrevLen + 2;
-        // start points to beginning of dst interval
-        SkRegion::RunType*  stop = operate_on_span(a_runs, b_runs, start, fMin, fMax);
+        return fPrevDst + fPrevLen + 2;
+    }
+
+    // Accepts the intervals written from spanStart() up to stop (which is just past their
+    // sentinel) as the span ending at bottom.
+    void acceptSpan(int bottom, SkRegion::RunType* start, SkRegion::RunType* stop) {
         size_t              len = stop - start;
         SkASSERT(len >= 1 && (len & 1) == 1);
         SkASSERT(SkRegion::kRunTypeSentinel == stop[-1]);
@@ -927,6 +976,57 @@ static int operate(const SkRegion::RunType a_runs[],
     return oper.flush();
 }
 
+/*  Writes the intervals of one span (given its first interval) that lie within [left, right)
+    to dst, followed by a sentinel, and returns the end of what was written. Only the first and
+    last of them need clipping; those in between are copied in one block.
+ */
+static SkRegion::RunType* clip_span(const SkRegion::RunType runs[], int left, int right,
+                                    SkRegion::RunType dst[]) {
+    while (runs[0] != SkRegion::kRunTypeSentinel && runs[1] <= left) {
+        runs += 2;
+    }
+    const SkRegion::RunType* stop = runs;
+    while (stop[0] < right && stop[1] <= right) {
+        stop += 2;
+    }
+    SkRegion::RunType* start = dst;
+    memcpy(dst, runs, (stop - runs) * sizeof(SkRegion::RunType));
+    dst += stop - runs;
+    if (stop[0] < right) {
+        *dst++ = stop[0];
+        *dst++ = (SkRegion::RunType)(right);
+    }
+    if (dst > start && start[0] < left) {
+        start[0] = (SkRegion::RunType)(left);
+    }
+    *dst++ = SkRegion::kRunTypeSentinel;
+    return dst;
+}
+
+/*  Intersects the runs of a complex region with a rect that overlaps it, by clipping each of
+    its spans, which is much cheaper than merging them with the rect's span. Never writes more
+    runs than the region has.
+ */
+static int intersect_with_rect(const SkRegion::RunType runs[], const SkIRect& rect,
+                               SkRegion::RunType dst[]) {
+    int top = *runs++;
+    while (runs[0] <= rect.fTop) {
+        top = runs[0];
+        runs = skip_intervals(runs + 2);
+    }
+
+    RgnOper oper(SkMax32(top, rect.fTop), dst, SkRegion::kIntersect_Op);
+    while (runs[0] < SkRegion::kRunTypeSentinel && top < rect.fBottom) {
+        const SkRegion::RunType* intervals = runs + 2;
+        SkRegion::RunType* start = oper.spanStart();
+        oper.acceptSpan(SkMin32(runs[0], rect.fBottom), start,
+                        clip_span(intervals, rect.fLeft, rect.fRight, start));
+        top = runs[0];
+        runs = skip_intervals(intervals);
+    }
+    return oper.flush();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /*  Given count RunTypes in a complex region, return the worst case number of
@@ -977,7 +1077,7 @@ static bool setRegionCheck(SkRegion* result, const SkRegion& rgn) {
 }
 
 bool SkRegion::Oper(const SkRegion& rgnaOrig, const SkRegion& rgnbOrig, Op op,
-                    SkRegion* result) {
+                    SkRegion* result, OpScratch* scratch) {
     SkASSERT((unsigned)op < kOpCount);
 
     if (kReplace_Op == op) {
@@ -995,7 +1095,7 @@ bool SkRegion::Oper(const SkRegion& rgnaOrig, const SkRegion& rgnbOrig, Op op,
         op = kDifference_Op;
     }
 
-    SkIRect bounds;
+    SkIRect bounds = SkIRect::MakeEmpty();
     bool    a_empty = rgna->isEmpty();
     bool    b_empty = rgnb->isEmpty();
     bool    a_rect = rgna->isRect();
@@ -1066,20 +1166,35 @@ bool SkRegion::Oper(const SkRegion& rgnaOrig, const SkRegion& rgnbOrig, Op op,
     const RunType* a_runs = rgna->getRuns(tmpA, &a_intervals);
     const RunType* b_runs = rgnb->getRuns(tmpB, &b_intervals);
 
-    int dstCount = compute_worst_case_count(a_intervals, b_intervals);
-    SkAutoSTMalloc<256, RunType> array(dstCount);
+    // Intersecting a complex region with a rect just clips its spans.
+    const SkRegion* complexRgn = NULL;
+    if (kIntersect_Op == op && result && (a_rect || b_rect)) {
+        complexRgn = a_rect ? rgnb : rgna;
+    }
+
+    int dstCount = complexRgn ? complexRgn->fRunHead->fRunCount
+                              : compute_worst_case_count(a_intervals, b_intervals);
+    SkAutoSTMalloc<256, RunType> array;
+    // Keep scratch small, since its owner may hold on to it for a long time.
+    RunType* dst = scratch && dstCount <= OpScratch::kMaxRunCount ? scratch->reserve(dstCount)
+                                                                 : array.reset(dstCount);
 
 #ifdef SK_DEBUG
 //  Sometimes helpful to seed everything with a known value when debugging
-//  sk_memset32((uint32_t*)array.get(), 0x7FFFFFFF, dstCount);
+//  sk_memset32((uint32_t*)dst, 0x7FFFFFFF, dstCount);
 #endif
 
-    int count = operate(a_runs, b_runs, array.get(), op, NULL == result);
+    int count;
+    if (complexRgn) {
+        count = intersect_with_rect(complexRgn == rgna ? a_runs : b_runs, bounds, dst);
+    } else {
+        count = operate(a_runs, b_runs, dst, op, NULL == result);
+    }
     SkASSERT(count <= dstCount);
 
     if (result) {
         SkASSERT(count >= 0);
-        return result->setRuns(array.get(), count);
+        return result->setRuns(dst, count);
     } else {
         return (QUICK_EXIT_TRUE_COUNT == count) || !isRunCountEmpty(count);
     }
@@ -1090,6 +1205,30 @@ bool SkRegion::op(const SkRegion& rgna, const SkRegion& rgnb, Op op) {
     return SkRegion::Oper(rgna, rgnb, op, this);
 }
 
+bool SkRegion::op(const SkIRect& rect, Op op, OpScratch* scratch) {
+    SkDEBUGCODE(this->validate();)
+    SkRegion tmp(rect);
+    return SkRegion::Oper(*this, tmp, op, this, scratch);
+}
+
+bool SkRegion::op(const SkRegion& rgn, Op op, OpScratch* scratch) {
+    SkDEBUGCODE(this->validate();)
+    return SkRegion::Oper(*this, rgn, op, this, scratch);
+}
+
+SkRegion::OpScratch::~OpScratch() {
+    sk_free(fRuns);
+}
+
+SkRegion::RunType* SkRegion::OpScratch::reserve(int count) {
+    if (count > fCount) {
+        sk_free(fRuns);
+        fRuns = (RunType*)sk_malloc_throw(count * sizeof(RunType));
+        fCount = count;
+    }
+    return fRuns;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SkBuffer.h"
@@ -39,6 +39,7 @@ private:
 public:
     int32_t fRefCnt;
     int32_t fRunCount;
+    int32_t fCapacity;  // number of runs allocated, at least fRunCount
 
     /**
      *  Number of spans with different Y values. This does not count the initial
@@ -68,6 +69,7 @@ public:
         RunHead* head = (RunHead*)sk_malloc_throw(sizeof(RunHead) + count * sizeof(RunType));
         head->fRefCnt = 1;
         head->fRunCount = count;
+        head->fCapacity = count;
         // these must be filled in later, otherwise we will be invalid
         head->fYSpanCount = 0;
         head->fIntervalCount = 0;
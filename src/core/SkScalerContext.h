@@ -19,6 +19,7 @@ class SkDescriptor;
 class SkMaskFilter;
 class SkPathEffect;
 class SkRasterizer;
+class SkString;
 
 /*
  *  To allow this to be forward-declared, it must be its own typename, rather
@@ -245,6 +246,13 @@ public:
 
     const Rec& getRec() const { return fRec; }
 
+    /** Appends to version whatever identifies the code that rasterizes glyphs for this context,
+        e.g. the version of the font engine it uses, so that caches of glyph images that outlive
+        this process can tell when they must be thrown away. The default appends nothing, which
+        keeps this context's glyphs out of such caches.
+     */
+    virtual void getEngineVersion(SkString* version) const {}
+
 protected:
     Rec         fRec;
 
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkStrokeCache.h"
+
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkPathEffect.h"
+#include "SkResourceCache.h"
+#include "SkWriteBuffer.h"
+
+#define CHECK_LOCAL(localCache, localName, globalName, ...) \
+    ((localCache) ? localCache->localName(__VA_ARGS__) : SkResourceCache::globalName(__VA_ARGS__))
+
+/**
+ *  Use this for stroke cache entries.
+ */
+uint64_t SkMakeResourceCacheSharedIDForPath(uint32_t pathRefGenID) {
+    uint64_t sharedID = SkSetFourByteTag('p', 'a', 't', 'h');
+    return (sharedID << 32) | pathRefGenID;
+}
+
+void SkNotifyPathGenIDIsStale(uint32_t pathRefGenID) {
+    SkResourceCache::PostPurgeSharedID(SkMakeResourceCacheSharedIDForPath(pathRefGenID));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+static unsigned gStrokeKeyNamespaceLabel;
+
+// Followed in memory by the path effect's flattened contents, fEffectSize bytes, so that effects
+// are compared byte for byte rather than by a hash. The flattened contents start with the
+// effect's factory.
+struct StrokeKey : public SkResourceCache::Key {
+public:
+    StrokeKey(uint32_t genID, const SkPaint& paint, SkPath::FillType fillType, SkScalar resScale,
+              const SkRect* cullRect, SkWriteBuffer& effect)
+        : fGenID(genID)
+        , fWidth(paint.getStrokeWidth())
+        , fMiter(paint.getStrokeMiter())
+        , fResScale(resScale)
+        , fStyle(paint.getStyle() | (paint.getStrokeCap() << 2) | (paint.getStrokeJoin() << 4) |
+                 (fillType << 6) | ((NULL != cullRect) << 8))
+        , fEffectSize(SkToU32(effect.bytesWritten()))
+    {
+        // Path effects may use the cull rect, but the stroker never does.
+        if (cullRect) {
+            fCullRect = *cullRect;
+        } else {
+            fCullRect.setEmpty();
+        }
+        // The fields must pack with no padding, since all of these bytes are hashed and compared.
+        SkASSERT(sizeof(StrokeKey) == SK_OFFSETOF(StrokeKey, fCullRect) + sizeof(fCullRect));
+        SkASSERT(SkIsAlign4(fEffectSize));
+        effect.writeToMemory(this + 1);
+        this->init(&gStrokeKeyNamespaceLabel, SkMakeResourceCacheSharedIDForPath(genID),
+                   sizeof(StrokeKey) - sizeof(SkResourceCache::Key) + fEffectSize);
+    }
+
+    // Bytes needed for a key whose flattened path effect is effectSize bytes.
+    static size_t SizeWithEffect(size_t effectSize) { return sizeof(StrokeKey) + effectSize; }
+    size_t size() const { return SizeWithEffect(fEffectSize); }
+
+    uint32_t    fGenID;
+    SkScalar    fWidth;
+    SkScalar    fMiter;
+    SkScalar    fResScale;
+    uint32_t    fStyle;     // style, cap, join, fill type, and whether we have a cull rect
+    uint32_t    fEffectSize;
+    SkRect      fCullRect;
+};
+
+struct StrokeResult {
+    SkPath* fPath;
+    bool    fDoFill;
+};
+
+struct StrokeRec : public SkResourceCache::Rec {
+    StrokeRec(const StrokeKey& key, const SkPath& path, bool doFill)
+        : fKeyStorage(key.size())
+        , fPath(path)
+        , fDoFill(doFill)
+    {
+        memcpy(fKeyStorage.get(), &key, key.size());
+        // Compute these now, since several threads may draw fPath's SkPathRef at once.
+        fPath.updateBoundsCache();
+        (void)fPath.getGenerationID();
+    }
+
+    SkAutoTMalloc<char> fKeyStorage;    // A copy of the variable-length StrokeKey.
+    SkPath              fPath;          // Shares its SkPathRef with the paths found from it.
+    bool                fDoFill;
+
+    const StrokeKey& strokeKey() const { return *(const StrokeKey*)fKeyStorage.get(); }
+
+    const Key& getKey() const override { return this->strokeKey(); }
+    size_t bytesUsed() const override {
+        return sizeof(*this) + this->strokeKey().size() + fPath.writeToMemory(NULL);
+    }
+
+    static bool Visitor(const SkResourceCache::Rec& baseRec, void* contextData) {
+        const StrokeRec& rec = static_cast<const StrokeRec&>(baseRec);
+        StrokeResult* result = (StrokeResult*)contextData;
+        const bool isVolatile = result->fPath->isVolatile();
+        *result->fPath = rec.fPath;
+        result->fPath->setIsVolatile(isVolatile);
+        result->fDoFill = rec.fDoFill;
+        return true;
+    }
+};
+} // namespace
+
+bool SkStrokeCache::ShouldCache(const SkPaint& paint, const SkPath& src) {
+    if (src.isVolatile() || src.isEmpty()) {
+        return false;
+    }
+    if (paint.getPathEffect()) {
+        return true;
+    }
+    // Without a path effect, fills and hairlines are just copies of src.
+    return SkPaint::kFill_Style != paint.getStyle() && paint.getStrokeWidth() > 0;
+}
+
+bool SkStrokeCache::GetFillPath(const SkPaint& paint, const SkPath& src, SkPath* dst,
+                                const SkRect* cullRect, SkScalar resScale,
+                                SkResourceCache* localCache) {
+    if (!ShouldCache(paint, src)) {
+        return paint.getFillPath(src, dst, cullRect, resScale);
+    }
+
+    const SkPathEffect* effect = paint.getPathEffect();
+    SkWriteBuffer effectBuffer;
+    if (effect) {
+        effectBuffer.writeFlattenable(effect);
+    }
+    SkAutoSMalloc<sizeof(StrokeKey) + 256> keyStorage(
+            StrokeKey::SizeWithEffect(effectBuffer.bytesWritten()));
+    const StrokeKey* key = SkNEW_PLACEMENT_ARGS(keyStorage.get(), StrokeKey,
+                                                (src.fPathRef->genID(), paint, src.getFillType(),
+                                                 resScale, effect ? cullRect : NULL,
+                                                 effectBuffer));
+
+    StrokeResult result = { dst, false };
+    if (CHECK_LOCAL(localCache, find, Find, *key, StrokeRec::Visitor, &result)) {
+        return result.fDoFill;
+    }
+
+    const bool doFill = paint.getFillPath(src, dst, cullRect, resScale);
+    CHECK_LOCAL(localCache, add, Add, SkNEW_ARGS(StrokeRec, (*key, *dst, doFill)));
+    src.fPathRef->notifyAddedToCache();
+    return doFill;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkStrokeCache_DEFINED
+#define SkStrokeCache_DEFINED
+
+#include "SkScalar.h"
+
+class SkPaint;
+class SkPath;
+class SkResourceCache;
+struct SkRect;
+
+uint64_t SkMakeResourceCacheSharedIDForPath(uint32_t pathRefGenID);
+
+void SkNotifyPathGenIDIsStale(uint32_t pathRefGenID);
+
+/**
+ *  Caches the fill paths that SkPaint::getFillPath() computes for stroked (or path-effected)
+ *  paths, so that drawing the same path with the same stroke again (every frame of a chart, every
+ *  playback of a picture) does not recompute its offset curves, joins and caps.
+ *
+ *  Results are keyed by the src path's SkPathRef generation ID, its fill type, the paint's stroke
+ *  parameters and path effect, and the resolution scale. They are purged when that SkPathRef is
+ *  edited or deleted.
+ */
+class SkStrokeCache {
+public:
+    /**
+     *  Returns true if the fill path of src drawn with paint is worth caching: src must not be
+     *  volatile, and the paint must stroke it or have a path effect.
+     */
+    static bool ShouldCache(const SkPaint& paint, const SkPath& src);
+
+    /**
+     *  Same as paint.getFillPath(src, dst, cullRect, resScale), but returns a cached result if
+     *  there is one, and caches the result otherwise.
+     */
+    static bool GetFillPath(const SkPaint& paint, const SkPath& src, SkPath* dst,
+                            const SkRect* cullRect, SkScalar resScale,
+                            SkResourceCache* localCache = NULL);
+};
+
+#endif
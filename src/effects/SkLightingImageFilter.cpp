@@ -8,10 +8,12 @@
 #include "SkLightingImageFilter.h"
 #include "SkBitmap.h"
 #include "SkColorPriv.h"
+#include "SkNx.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
+#include "SkTaskGroup.h"
 #include "SkTypes.h"
 
 #if SK_SUPPORT_GPU
@@ -58,21 +60,72 @@ inline void shiftMatrixLeft(int m[9]) {
     m[7] = m[8];
 }
 
+// Four SkPoint3s, one per lane, so the lighting math can run on four pixels at a time.
+// The operations are done in the same order as SkPoint3's, but Sk4f's divide and sqrt may be
+// estimates (e.g. on NEON), so the resulting colors can differ from the scalar path by 1.
+struct Point3x4 {
+    Point3x4() {}
+    Point3x4(const Sk4f& x, const Sk4f& y, const Sk4f& z) : fX(x), fY(y), fZ(z) {}
+    explicit Point3x4(const SkPoint3& p) : fX(p.fX), fY(p.fY), fZ(p.fZ) {}
+
+    static Point3x4 Load(const SkPoint3 pts[4]) {
+        return Point3x4(Sk4f(pts[0].fX, pts[1].fX, pts[2].fX, pts[3].fX),
+                        Sk4f(pts[0].fY, pts[1].fY, pts[2].fY, pts[3].fY),
+                        Sk4f(pts[0].fZ, pts[1].fZ, pts[2].fZ, pts[3].fZ));
+    }
+    void store(SkPoint3 pts[4]) const {
+        SkScalar x[4], y[4], z[4];
+        fX.store(x);
+        fY.store(y);
+        fZ.store(z);
+        for (int i = 0; i < 4; ++i) {
+            pts[i] = SkPoint3(x[i], y[i], z[i]);
+        }
+    }
+
+    Sk4f dot(const Point3x4& other) const {
+        return fX * other.fX + fY * other.fY + fZ * other.fZ;
+    }
+    void normalize() {
+        Sk4f scale = Sk4f(SK_Scalar1) / (this->dot(*this).sqrt() + Sk4f(SK_ScalarNearlyZero));
+        fX = fX * scale;
+        fY = fY * scale;
+        fZ = fZ * scale;
+    }
+
+    Sk4f fX, fY, fZ;
+};
+
+inline SkPMColor packLightColor(SkScalar alpha, const SkPoint3& color) {
+    return SkPackARGB32(SkClampMax(SkScalarRoundToInt(alpha), 255),
+                        SkClampMax(SkScalarRoundToInt(color.fX), 255),
+                        SkClampMax(SkScalarRoundToInt(color.fY), 255),
+                        SkClampMax(SkScalarRoundToInt(color.fZ), 255));
+}
+
 class DiffuseLightingType {
 public:
     DiffuseLightingType(SkScalar kd)
         : fKD(kd) {}
     SkPMColor light(const SkPoint3& normal, const SkPoint3& surfaceTolight,
                     const SkPoint3& lightColor) const {
-        SkScalar colorScale = SkScalarMul(fKD, normal.dot(surfaceTolight));
-        colorScale = SkScalarClampMax(colorScale, SK_Scalar1);
-        SkPoint3 color(lightColor * colorScale);
-        return SkPackARGB32(255,
-                            SkClampMax(SkScalarRoundToInt(color.fX), 255),
-                            SkClampMax(SkScalarRoundToInt(color.fY), 255),
-                            SkClampMax(SkScalarRoundToInt(color.fZ), 255));
+        return shade(SkScalarMul(fKD, normal.dot(surfaceTolight)), lightColor);
+    }
+    void light4(const Point3x4& normal, const Point3x4& surfaceTolight,
+                const Point3x4& lightColor, SkPMColor dst[4]) const {
+        SkScalar colorScale[4];
+        (Sk4f(fKD) * normal.dot(surfaceTolight)).store(colorScale);
+        SkPoint3 colors[4];
+        lightColor.store(colors);
+        for (int i = 0; i < 4; ++i) {
+            dst[i] = shade(colorScale[i], colors[i]);
+        }
     }
 private:
+    static SkPMColor shade(SkScalar colorScale, const SkPoint3& lightColor) {
+        colorScale = SkScalarClampMax(colorScale, SK_Scalar1);
+        return packLightColor(255, lightColor * colorScale);
+    }
     SkScalar fKD;
 };
 
@@ -85,16 +138,29 @@ public:
         SkPoint3 halfDir(surfaceTolight);
         halfDir.fZ += SK_Scalar1;        // eye position is always (0, 0, 1)
         halfDir.normalize();
-        SkScalar colorScale = SkScalarMul(fKS,
-            SkScalarPow(normal.dot(halfDir), fShininess));
+        return this->shade(normal.dot(halfDir), lightColor);
+    }
+    void light4(const Point3x4& normal, const Point3x4& surfaceTolight,
+                const Point3x4& lightColor, SkPMColor dst[4]) const {
+        Point3x4 halfDir(surfaceTolight.fX, surfaceTolight.fY,
+                         surfaceTolight.fZ + Sk4f(SK_Scalar1));
+        halfDir.normalize();
+        SkScalar cosAngle[4];
+        normal.dot(halfDir).store(cosAngle);
+        SkPoint3 colors[4];
+        lightColor.store(colors);
+        // There's no vector pow(), so this part stays scalar.
+        for (int i = 0; i < 4; ++i) {
+            dst[i] = this->shade(cosAngle[i], colors[i]);
+        }
+    }
+private:
+    SkPMColor shade(SkScalar cosAngle, const SkPoint3& lightColor) const {
+        SkScalar colorScale = SkScalarMul(fKS, SkScalarPow(cosAngle, fShininess));
         colorScale = SkScalarClampMax(colorScale, SK_Scalar1);
         SkPoint3 color(lightColor * colorScale);
-        return SkPackARGB32(SkClampMax(SkScalarRoundToInt(color.maxComponent()), 255),
-                            SkClampMax(SkScalarRoundToInt(color.fX), 255),
-                            SkClampMax(SkScalarRoundToInt(color.fY), 255),
-                            SkClampMax(SkScalarRoundToInt(color.fZ), 255));
+        return packLightColor(color.maxComponent(), color);
     }
-private:
     SkScalar fKS;
     SkScalar fShininess;
 };
@@ -166,100 +232,217 @@ inline SkPoint3 bottomRightNormal(int m[9], SkScalar surfaceScale) {
                          surfaceScale);
 }
 
-template <class LightingType, class LightType> void lightBitmap(
-        const LightingType& lightingType, const SkLight* light, const SkBitmap& src, SkBitmap* dst,
-        SkScalar surfaceScale, const SkIRect& bounds) {
-    SkASSERT(dst->width() == bounds.width() && dst->height() == bounds.height());
-    const LightType* l = static_cast<const LightType*>(light);
-    int left = bounds.left(), right = bounds.right();
-    int bottom = bounds.bottom();
-    int y = bounds.top();
-    SkPMColor* dptr = dst->getAddr32(0, 0);
+template <class LightingType, class LightType> void lightTopRow(
+        const LightingType& lightingType, const LightType* l, const SkBitmap& src,
+        SkScalar surfaceScale, int left, int right, int y, SkPMColor* dptr) {
+    int x = left;
+    const SkPMColor* row1 = src.getAddr32(x, y);
+    const SkPMColor* row2 = src.getAddr32(x, y + 1);
+    int m[9];
+    m[4] = SkGetPackedA32(*row1++);
+    m[5] = SkGetPackedA32(*row1++);
+    m[7] = SkGetPackedA32(*row2++);
+    m[8] = SkGetPackedA32(*row2++);
+    SkPoint3 surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
+    *dptr++ = lightingType.light(topLeftNormal(m, surfaceScale), surfaceToLight,
+                                 l->lightColor(surfaceToLight));
+    for (++x; x < right - 1; ++x)
     {
-        int x = left;
-        const SkPMColor* row1 = src.getAddr32(x, y);
-        const SkPMColor* row2 = src.getAddr32(x, y + 1);
-        int m[9];
-        m[4] = SkGetPackedA32(*row1++);
+        shiftMatrixLeft(m);
         m[5] = SkGetPackedA32(*row1++);
-        m[7] = SkGetPackedA32(*row2++);
         m[8] = SkGetPackedA32(*row2++);
-        SkPoint3 surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(topLeftNormal(m, surfaceScale), surfaceToLight,
-                                     l->lightColor(surfaceToLight));
-        for (++x; x < right - 1; ++x)
-        {
-            shiftMatrixLeft(m);
-            m[5] = SkGetPackedA32(*row1++);
-            m[8] = SkGetPackedA32(*row2++);
-            surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-            *dptr++ = lightingType.light(topNormal(m, surfaceScale), surfaceToLight,
-                                         l->lightColor(surfaceToLight));
-        }
-        shiftMatrixLeft(m);
         surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(topRightNormal(m, surfaceScale), surfaceToLight,
+        *dptr++ = lightingType.light(topNormal(m, surfaceScale), surfaceToLight,
                                      l->lightColor(surfaceToLight));
     }
-
-    for (++y; y < bottom - 1; ++y) {
-        int x = left;
-        const SkPMColor* row0 = src.getAddr32(x, y - 1);
-        const SkPMColor* row1 = src.getAddr32(x, y);
-        const SkPMColor* row2 = src.getAddr32(x, y + 1);
-        int m[9];
-        m[1] = SkGetPackedA32(*row0++);
+    shiftMatrixLeft(m);
+    surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
+    *dptr++ = lightingType.light(topRightNormal(m, surfaceScale), surfaceToLight,
+                                 l->lightColor(surfaceToLight));
+}
+
+template <class LightingType, class LightType> void lightBottomRow(
+        const LightingType& lightingType, const LightType* l, const SkBitmap& src,
+        SkScalar surfaceScale, int left, int right, int y, SkPMColor* dptr) {
+    int x = left;
+    const SkPMColor* row0 = src.getAddr32(x, y - 1);
+    const SkPMColor* row1 = src.getAddr32(x, y);
+    int m[9];
+    m[1] = SkGetPackedA32(*row0++);
+    m[2] = SkGetPackedA32(*row0++);
+    m[4] = SkGetPackedA32(*row1++);
+    m[5] = SkGetPackedA32(*row1++);
+    SkPoint3 surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
+    *dptr++ = lightingType.light(bottomLeftNormal(m, surfaceScale), surfaceToLight,
+                                 l->lightColor(surfaceToLight));
+    for (++x; x < right - 1; ++x)
+    {
+        shiftMatrixLeft(m);
         m[2] = SkGetPackedA32(*row0++);
-        m[4] = SkGetPackedA32(*row1++);
         m[5] = SkGetPackedA32(*row1++);
-        m[7] = SkGetPackedA32(*row2++);
-        m[8] = SkGetPackedA32(*row2++);
-        SkPoint3 surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(leftNormal(m, surfaceScale), surfaceToLight,
-                                     l->lightColor(surfaceToLight));
-        for (++x; x < right - 1; ++x) {
-            shiftMatrixLeft(m);
-            m[2] = SkGetPackedA32(*row0++);
-            m[5] = SkGetPackedA32(*row1++);
-            m[8] = SkGetPackedA32(*row2++);
-            surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-            *dptr++ = lightingType.light(interiorNormal(m, surfaceScale), surfaceToLight,
-                                         l->lightColor(surfaceToLight));
-        }
-        shiftMatrixLeft(m);
         surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(rightNormal(m, surfaceScale), surfaceToLight,
+        *dptr++ = lightingType.light(bottomNormal(m, surfaceScale), surfaceToLight,
                                      l->lightColor(surfaceToLight));
     }
+    shiftMatrixLeft(m);
+    surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
+    *dptr++ = lightingType.light(bottomRightNormal(m, surfaceScale), surfaceToLight,
+                                 l->lightColor(surfaceToLight));
+}
 
-    {
-        int x = left;
-        const SkPMColor* row0 = src.getAddr32(x, bottom - 2);
-        const SkPMColor* row1 = src.getAddr32(x, bottom - 1);
-        int m[9];
-        m[1] = SkGetPackedA32(*row0++);
-        m[2] = SkGetPackedA32(*row0++);
-        m[4] = SkGetPackedA32(*row1++);
-        m[5] = SkGetPackedA32(*row1++);
-        SkPoint3 surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(bottomLeftNormal(m, surfaceScale), surfaceToLight,
+inline void loadAlphaRow(const SkBitmap& src, int left, int y, int width, SkScalar* alphas) {
+    const SkPMColor* row = src.getAddr32(left, y);
+    for (int i = 0; i < width; ++i) {
+        alphas[i] = SkIntToScalar(SkGetPackedA32(row[i]));
+    }
+}
+
+// Lights a row that has rows above and below it. rows[] holds the alphas of those three rows,
+// starting at left. Interior pixels are lit four at a time.
+template <class LightingType, class LightType> void lightInteriorRow(
+        const LightingType& lightingType, const LightType* l, const SkBitmap& src,
+        SkScalar surfaceScale, int left, int right, int y, SkScalar* const rows[3],
+        SkPMColor* dptr) {
+    const SkPMColor* row0 = src.getAddr32(left, y - 1);
+    const SkPMColor* row1 = src.getAddr32(left, y);
+    const SkPMColor* row2 = src.getAddr32(left, y + 1);
+    int m[9];
+    m[1] = SkGetPackedA32(row0[0]);
+    m[2] = SkGetPackedA32(row0[1]);
+    m[4] = SkGetPackedA32(row1[0]);
+    m[5] = SkGetPackedA32(row1[1]);
+    m[7] = SkGetPackedA32(row2[0]);
+    m[8] = SkGetPackedA32(row2[1]);
+    SkPoint3 surfaceToLight = l->surfaceToLight(left, y, m[4], surfaceScale);
+    dptr[0] = lightingType.light(leftNormal(m, surfaceScale), surfaceToLight,
+                                 l->lightColor(surfaceToLight));
+
+    const int width = right - left;
+    const Sk4f two(2), quarter(gOneQuarter), scale(surfaceScale), fy(SkIntToScalar(y));
+    int i = 1;
+    for (; i + 4 <= width - 1; i += 4) {
+        const SkScalar* a0 = rows[0] + i;
+        const SkScalar* a1 = rows[1] + i;
+        const SkScalar* a2 = rows[2] + i;
+        Sk4f topLeft = Sk4f::Load(a0 - 1), top    = Sk4f::Load(a0), topRight = Sk4f::Load(a0 + 1),
+             midLeft = Sk4f::Load(a1 - 1), center = Sk4f::Load(a1), midRight = Sk4f::Load(a1 + 1),
+             botLeft = Sk4f::Load(a2 - 1), bot    = Sk4f::Load(a2), botRight = Sk4f::Load(a2 + 1);
+        // interiorNormal(), four at a time. The sobel sums are small integers, so exact.
+        Sk4f nx = ((topRight - topLeft) + two * (midRight - midLeft) + (botRight - botLeft)) * quarter;
+        Sk4f ny = ((botLeft - topLeft) + two * (bot - top) + (botRight - topRight)) * quarter;
+        Point3x4 normal((Sk4f(0) - nx) * scale, (Sk4f(0) - ny) * scale, Sk4f(SK_Scalar1));
+        normal.normalize();
+
+        const SkScalar x = SkIntToScalar(left + i);
+        Sk4f fx(x, x + 1, x + 2, x + 3);
+        Point3x4 surfaceToLight4 = l->surfaceToLight4(fx, fy, center, surfaceScale);
+        lightingType.light4(normal, surfaceToLight4, l->lightColor4(surfaceToLight4), dptr + i);
+    }
+    for (; i < width - 1; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            m[j * 3 + 0] = SkScalarTruncToInt(rows[j][i - 1]);
+            m[j * 3 + 1] = SkScalarTruncToInt(rows[j][i]);
+            m[j * 3 + 2] = SkScalarTruncToInt(rows[j][i + 1]);
+        }
+        surfaceToLight = l->surfaceToLight(left + i, y, m[4], surfaceScale);
+        dptr[i] = lightingType.light(interiorNormal(m, surfaceScale), surfaceToLight,
                                      l->lightColor(surfaceToLight));
-        for (++x; x < right - 1; ++x)
-        {
-            shiftMatrixLeft(m);
-            m[2] = SkGetPackedA32(*row0++);
-            m[5] = SkGetPackedA32(*row1++);
-            surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-            *dptr++ = lightingType.light(bottomNormal(m, surfaceScale), surfaceToLight,
+    }
+
+    m[0] = SkGetPackedA32(row0[width - 2]);
+    m[1] = SkGetPackedA32(row0[width - 1]);
+    m[3] = SkGetPackedA32(row1[width - 2]);
+    m[4] = SkGetPackedA32(row1[width - 1]);
+    m[6] = SkGetPackedA32(row2[width - 2]);
+    m[7] = SkGetPackedA32(row2[width - 1]);
+    surfaceToLight = l->surfaceToLight(right - 1, y, m[4], surfaceScale);
+    dptr[width - 1] = lightingType.light(rightNormal(m, surfaceScale), surfaceToLight,
                                          l->lightColor(surfaceToLight));
+}
+
+// Lights rows [startY, endY) of bounds, which must be at least 2x2, into the same rows of dst.
+template <class LightingType, class LightType> void lightRows(
+        const LightingType& lightingType, const LightType* l, const SkBitmap& src, SkBitmap* dst,
+        SkScalar surfaceScale, const SkIRect& bounds, int startY, int endY) {
+    const int left = bounds.left(), right = bounds.right(), width = bounds.width();
+    SkAutoTMalloc<SkScalar> storage(3 * width);
+    SkScalar* rows[3] = { storage.get(), storage.get() + width, storage.get() + 2 * width };
+    bool haveRows = false;  // Whether rows[] holds the alphas around y.
+
+    for (int y = startY; y < endY; ++y) {
+        SkPMColor* dptr = dst->getAddr32(0, y - bounds.top());
+        if (y == bounds.top()) {
+            lightTopRow(lightingType, l, src, surfaceScale, left, right, y, dptr);
+        } else if (y == bounds.bottom() - 1) {
+            lightBottomRow(lightingType, l, src, surfaceScale, left, right, y, dptr);
+        } else {
+            if (haveRows) {
+                SkScalar* recycled = rows[0];
+                rows[0] = rows[1];
+                rows[1] = rows[2];
+                rows[2] = recycled;
+                loadAlphaRow(src, left, y + 1, width, rows[2]);
+            } else {
+                for (int j = 0; j < 3; ++j) {
+                    loadAlphaRow(src, left, y - 1 + j, width, rows[j]);
+                }
+                haveRows = true;
+            }
+            lightInteriorRow(lightingType, l, src, surfaceScale, left, right, y, rows, dptr);
         }
-        shiftMatrixLeft(m);
-        surfaceToLight = l->surfaceToLight(x, y, m[4], surfaceScale);
-        *dptr++ = lightingType.light(bottomRightNormal(m, surfaceScale), surfaceToLight,
-                                     l->lightColor(surfaceToLight));
     }
 }
 
+template <class LightingType, class LightType> struct LightBand {
+    const LightingType* fLightingType;
+    const LightType*    fLight;
+    const SkBitmap*     fSrc;
+    SkBitmap*           fDst;
+    SkScalar            fSurfaceScale;
+    SkIRect             fBounds;
+    int                 fStartY, fEndY;
+};
+
+template <class LightingType, class LightType> void lightBand(
+        LightBand<LightingType, LightType>* band) {
+    lightRows(*band->fLightingType, band->fLight, *band->fSrc, band->fDst, band->fSurfaceScale,
+              band->fBounds, band->fStartY, band->fEndY);
+}
+
+template <class LightingType, class LightType> void lightBitmap(
+        const LightingType& lightingType, const SkLight* light, const SkBitmap& src, SkBitmap* dst,
+        SkScalar surfaceScale, const SkIRect& bounds) {
+    SkASSERT(dst->width() == bounds.width() && dst->height() == bounds.height());
+    const LightType* l = static_cast<const LightType*>(light);
+
+    // Every row is independent, so big bitmaps are lit in bands on SkTaskGroup's threads.
+    static const int kMinPixelsPerBand = 16 * 1024;
+    static const int kMaxBands = 32;
+    const int64_t pixels = sk_64_mul(bounds.width(), bounds.height());
+    const int bands = (int)SkTMin<int64_t>(SkTMin(kMaxBands, bounds.height()),
+                                           pixels / kMinPixelsPerBand);
+    if (bands <= 1) {
+        lightRows(lightingType, l, src, dst, surfaceScale, bounds, bounds.top(), bounds.bottom());
+        return;
+    }
+
+    SkAutoSTMalloc<kMaxBands, LightBand<LightingType, LightType> > args(bands);
+    for (int i = 0; i < bands; ++i) {
+        LightBand<LightingType, LightType>& band = args[i];
+        band.fLightingType = &lightingType;
+        band.fLight = l;
+        band.fSrc = &src;
+        band.fDst = dst;
+        band.fSurfaceScale = surfaceScale;
+        band.fBounds = bounds;
+        band.fStartY = bounds.top() + bounds.height() * i / bands;
+        band.fEndY = bounds.top() + bounds.height() * (i + 1) / bands;
+    }
+    SkTaskGroup tg;
+    tg.batch(lightBand<LightingType, LightType>, args.get(), bands);
+    tg.wait();
+}
+
 SkPoint3 readPoint3(SkReadBuffer& buffer) {
     SkPoint3 point;
     point.fX = buffer.readScalar();
@@ -724,6 +907,10 @@ public:
         return fDirection;
     };
     SkPoint3 lightColor(const SkPoint3&) const { return color(); }
+    Point3x4 surfaceToLight4(const Sk4f&, const Sk4f&, const Sk4f&, SkScalar) const {
+        return Point3x4(fDirection);
+    }
+    Point3x4 lightColor4(const Point3x4&) const { return Point3x4(color()); }
     LightType type() const override { return kDistant_LightType; }
     const SkPoint3& direction() const { return fDirection; }
     GrGLLight* createGLLight() const override {
@@ -780,7 +967,16 @@ public:
         direction.normalize();
         return direction;
     };
+    Point3x4 surfaceToLight4(const Sk4f& x, const Sk4f& y, const Sk4f& z,
+                             SkScalar surfaceScale) const {
+        Point3x4 direction(Sk4f(fLocation.fX) - x,
+                           Sk4f(fLocation.fY) - y,
+                           Sk4f(fLocation.fZ) - z * Sk4f(surfaceScale));
+        direction.normalize();
+        return direction;
+    }
     SkPoint3 lightColor(const SkPoint3&) const { return color(); }
+    Point3x4 lightColor4(const Point3x4&) const { return Point3x4(color()); }
     LightType type() const override { return kPoint_LightType; }
     const SkPoint3& location() const { return fLocation; }
     GrGLLight* createGLLight() const override {
@@ -879,8 +1075,27 @@ public:
         direction.normalize();
         return direction;
     };
+    Point3x4 surfaceToLight4(const Sk4f& x, const Sk4f& y, const Sk4f& z,
+                             SkScalar surfaceScale) const {
+        Point3x4 direction(Sk4f(fLocation.fX) - x,
+                           Sk4f(fLocation.fY) - y,
+                           Sk4f(fLocation.fZ) - z * Sk4f(surfaceScale));
+        direction.normalize();
+        return direction;
+    }
     SkPoint3 lightColor(const SkPoint3& surfaceToLight) const {
-        SkScalar cosAngle = -surfaceToLight.dot(fS);
+        return this->coneColor(-surfaceToLight.dot(fS));
+    }
+    Point3x4 lightColor4(const Point3x4& surfaceToLight) const {
+        SkScalar cosAngle[4];
+        (Sk4f(0) - surfaceToLight.dot(Point3x4(fS))).store(cosAngle);
+        SkPoint3 colors[4];
+        for (int i = 0; i < 4; ++i) {
+            colors[i] = this->coneColor(cosAngle[i]);
+        }
+        return Point3x4::Load(colors);
+    }
+    SkPoint3 coneColor(SkScalar cosAngle) const {
         if (cosAngle < fCosOuterConeAngle) {
             return SkPoint3(0, 0, 0);
         }
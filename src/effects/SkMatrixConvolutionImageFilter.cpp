@@ -8,9 +8,11 @@
 #include "SkMatrixConvolutionImageFilter.h"
 #include "SkBitmap.h"
 #include "SkColorPriv.h"
+#include "SkPMFloat.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
 #include "SkRect.h"
+#include "SkTaskGroup.h"
 #include "SkUnPreMultiply.h"
 
 #if SK_SUPPORT_GPU
@@ -21,6 +23,48 @@
 // by the size of a scalar to know how many scalars we can read.
 static const int32_t gMaxKernelSize = SK_MaxS32 / sizeof(SkScalar);
 
+// If kernel is the outer product of a column and a row (and so can be applied as two 1D passes,
+// which is cheaper), stores the row followed by the column in separable and returns true.
+static bool find_separable_kernel(const SkISize& size, const SkScalar* kernel,
+                                  SkScalar* separable) {
+    const int width = size.width(), height = size.height();
+    if (width < 2 || height < 2 || width + height >= width * height) {
+        return false;
+    }
+    // Divide by the largest entry, to lose the least precision.
+    int pivotX = 0, pivotY = 0;
+    SkScalar maxAbs = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (SkScalarAbs(kernel[y * width + x]) > maxAbs) {
+                maxAbs = SkScalarAbs(kernel[y * width + x]);
+                pivotX = x;
+                pivotY = y;
+            }
+        }
+    }
+    if (!(maxAbs > 0) || !SkScalarIsFinite(maxAbs)) {
+        return false;
+    }
+    SkScalar* row = separable;
+    SkScalar* column = separable + width;
+    for (int x = 0; x < width; ++x) {
+        row[x] = kernel[pivotY * width + x];
+    }
+    for (int y = 0; y < height; ++y) {
+        column[y] = kernel[y * width + pivotX] / kernel[pivotY * width + pivotX];
+    }
+    const SkScalar tolerance = maxAbs * 1e-6f;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (SkScalarAbs(column[y] * row[x] - kernel[y * width + x]) > tolerance) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 SkMatrixConvolutionImageFilter::SkMatrixConvolutionImageFilter(
     const SkISize& kernelSize,
     const SkScalar* kernel,
@@ -41,6 +85,11 @@ SkMatrixConvolutionImageFilter::SkMatrixConvolutionImageFilter(
     size_t size = (size_t) sk_64_mul(fKernelSize.width(), fKernelSize.height());
     fKernel = SkNEW_ARRAY(SkScalar, size);
     memcpy(fKernel, kernel, size * sizeof(SkScalar));
+    fSeparableKernel = SkNEW_ARRAY(SkScalar, fKernelSize.width() + fKernelSize.height());
+    if (!find_separable_kernel(fKernelSize, fKernel, fSeparableKernel)) {
+        delete[] fSeparableKernel;
+        fSeparableKernel = NULL;
+    }
     SkASSERT(kernelSize.fWidth >= 1 && kernelSize.fHeight >= 1);
     SkASSERT(kernelOffset.fX >= 0 && kernelOffset.fX < kernelSize.fWidth);
     SkASSERT(kernelOffset.fY >= 0 && kernelOffset.fY < kernelSize.fHeight);
@@ -115,6 +164,7 @@ void SkMatrixConvolutionImageFilter::flatten(SkWriteBuffer& buffer) const {
 
 SkMatrixConvolutionImageFilter::~SkMatrixConvolutionImageFilter() {
     delete[] fKernel;
+    delete[] fSeparableKernel;
 }
 
 class UncheckedPixelFetcher {
@@ -159,6 +209,33 @@ public:
     }
 };
 
+// Without convolveAlpha the source is unpremultiplied. Its alpha isn't convolved, so it's made
+// opaque to load the color as a valid SkPMColor.
+template<bool convolveAlpha>
+static inline Sk4f load_color(SkPMColor src) {
+    if (!convolveAlpha) {
+        src |= SK_A32_MASK << SK_A32_SHIFT;
+    }
+    return SkPMFloat::FromPMColor(src);
+}
+
+// Scales, biases and clamps the convolved color. Without convolveAlpha, the color's alpha comes
+// from the source pixel at the same place.
+template<bool convolveAlpha>
+static inline SkPMColor pack_convolved(const SkPMFloat& sum, SkScalar gain, SkScalar bias,
+                                       SkPMColor src) {
+    int a = convolveAlpha
+          ? SkClampMax(SkScalarFloorToInt(SkScalarMul(sum.a(), gain) + bias), 255)
+          : 255;
+    int r = SkClampMax(SkScalarFloorToInt(SkScalarMul(sum.r(), gain) + bias), a);
+    int g = SkClampMax(SkScalarFloorToInt(SkScalarMul(sum.g(), gain) + bias), a);
+    int b = SkClampMax(SkScalarFloorToInt(SkScalarMul(sum.b(), gain) + bias), a);
+    if (!convolveAlpha) {
+        return SkPreMultiplyARGB(SkGetPackedA32(src), r, g, b);
+    }
+    return SkPackARGB32(a, r, g, b);
+}
+
 template<class PixelFetcher, bool convolveAlpha>
 void SkMatrixConvolutionImageFilter::filterPixels(const SkBitmap& src,
                                                   SkBitmap* result,
@@ -171,7 +248,8 @@ void SkMatrixConvolutionImageFilter::filterPixels(const SkBitmap& src,
     for (int y = rect.fTop; y < rect.fBottom; ++y) {
         SkPMColor* dptr = result->getAddr32(rect.fLeft - bounds.fLeft, y - bounds.fTop);
         for (int x = rect.fLeft; x < rect.fRight; ++x) {
-            SkScalar sumA = 0, sumR = 0, sumG = 0, sumB = 0;
+            // All four channels at once. Without convolveAlpha the alpha sum is just ignored.
+            Sk4f sum(0);
             for (int cy = 0; cy < fKernelSize.fHeight; cy++) {
                 for (int cx = 0; cx < fKernelSize.fWidth; cx++) {
                     SkPMColor s = PixelFetcher::fetch(src,
@@ -179,26 +257,11 @@ void SkMatrixConvolutionImageFilter::filterPixels(const SkBitmap& src,
                                                       y + cy - fKernelOffset.fY,
                                                       bounds);
                     SkScalar k = fKernel[cy * fKernelSize.fWidth + cx];
-                    if (convolveAlpha) {
-                        sumA += SkScalarMul(SkIntToScalar(SkGetPackedA32(s)), k);
-                    }
-                    sumR += SkScalarMul(SkIntToScalar(SkGetPackedR32(s)), k);
-                    sumG += SkScalarMul(SkIntToScalar(SkGetPackedG32(s)), k);
-                    sumB += SkScalarMul(SkIntToScalar(SkGetPackedB32(s)), k);
+                    sum += load_color<convolveAlpha>(s) * Sk4f(k);
                 }
             }
-            int a = convolveAlpha
-                  ? SkClampMax(SkScalarFloorToInt(SkScalarMul(sumA, fGain) + fBias), 255)
-                  : 255;
-            int r = SkClampMax(SkScalarFloorToInt(SkScalarMul(sumR, fGain) + fBias), a);
-            int g = SkClampMax(SkScalarFloorToInt(SkScalarMul(sumG, fGain) + fBias), a);
-            int b = SkClampMax(SkScalarFloorToInt(SkScalarMul(sumB, fGain) + fBias), a);
-            if (!convolveAlpha) {
-                a = SkGetPackedA32(PixelFetcher::fetch(src, x, y, bounds));
-                *dptr++ = SkPreMultiplyARGB(a, r, g, b);
-            } else {
-                *dptr++ = SkPackARGB32(a, r, g, b);
-            }
+            *dptr++ = pack_convolved<convolveAlpha>(
+                    sum, fGain, fBias, convolveAlpha ? 0 : PixelFetcher::fetch(src, x, y, bounds));
         }
     }
 }
@@ -239,6 +302,134 @@ void SkMatrixConvolutionImageFilter::filterBorderPixels(const SkBitmap& src,
     }
 }
 
+template<class PixelFetcher, bool convolveAlpha>
+void SkMatrixConvolutionImageFilter::filterSeparablePixels(const SkBitmap& src,
+                                                           SkBitmap* result,
+                                                           const SkIRect& r,
+                                                           const SkIRect& bounds) const {
+    SkIRect rect(r);
+    if (!rect.intersect(bounds)) {
+        return;
+    }
+    const int kernelWidth = fKernelSize.width(), kernelHeight = fKernelSize.height();
+    const SkScalar* kernelX = fSeparableKernel;
+    const SkScalar* kernelY = fSeparableKernel + kernelWidth;
+    const int width = rect.width();
+
+    // Each source row is fetched once, convolved horizontally, and kept in a ring of the last
+    // kernelHeight rows (four floats per pixel), which the vertical pass then reads.
+    SkAutoTMalloc<SkPMColor> srcRow(width + kernelWidth - 1);
+    SkAutoTMalloc<float> rows(4 * width * kernelHeight);
+    SkAutoSTMalloc<16, const float*> taps(kernelHeight);
+
+    const int firstY = rect.fTop - fKernelOffset.fY;
+    const int lastY = rect.fBottom - fKernelOffset.fY + kernelHeight - 1;
+    for (int sy = firstY; sy < lastY; ++sy) {
+        for (int i = 0; i < width + kernelWidth - 1; ++i) {
+            srcRow[i] = PixelFetcher::fetch(src, rect.fLeft - fKernelOffset.fX + i, sy, bounds);
+        }
+        float* row = rows.get() + 4 * width * ((sy - firstY) % kernelHeight);
+        for (int x = 0; x < width; ++x) {
+            Sk4f sum(0);
+            for (int cx = 0; cx < kernelWidth; ++cx) {
+                sum += load_color<convolveAlpha>(srcRow[x + cx]) * Sk4f(kernelX[cx]);
+            }
+            sum.store(row + 4 * x);
+        }
+
+        // The output row whose last tap is this source row.
+        const int y = sy - kernelHeight + 1 + fKernelOffset.fY;
+        if (y < rect.fTop) {
+            continue;
+        }
+        for (int cy = 0; cy < kernelHeight; ++cy) {
+            taps[cy] = rows.get() + 4 * width * ((y - rect.fTop + cy) % kernelHeight);
+        }
+        SkPMColor* dptr = result->getAddr32(rect.fLeft - bounds.fLeft, y - bounds.fTop);
+        for (int x = 0; x < width; ++x) {
+            Sk4f sum(0);
+            for (int cy = 0; cy < kernelHeight; ++cy) {
+                sum += Sk4f::Load(taps[cy] + 4 * x) * Sk4f(kernelY[cy]);
+            }
+            dptr[x] = pack_convolved<convolveAlpha>(
+                    sum, fGain, fBias,
+                    convolveAlpha ? 0 : PixelFetcher::fetch(src, rect.fLeft + x, y, bounds));
+        }
+    }
+}
+
+void SkMatrixConvolutionImageFilter::filterSeparablePixels(const SkBitmap& src,
+                                                           SkBitmap* result,
+                                                           const SkIRect& rect,
+                                                           const SkIRect& bounds) const {
+    switch (fTileMode) {
+        case kClamp_TileMode:
+            if (fConvolveAlpha) {
+                filterSeparablePixels<ClampPixelFetcher, true>(src, result, rect, bounds);
+            } else {
+                filterSeparablePixels<ClampPixelFetcher, false>(src, result, rect, bounds);
+            }
+            break;
+        case kRepeat_TileMode:
+            if (fConvolveAlpha) {
+                filterSeparablePixels<RepeatPixelFetcher, true>(src, result, rect, bounds);
+            } else {
+                filterSeparablePixels<RepeatPixelFetcher, false>(src, result, rect, bounds);
+            }
+            break;
+        case kClampToBlack_TileMode:
+            if (fConvolveAlpha) {
+                filterSeparablePixels<ClampToBlackPixelFetcher, true>(src, result, rect, bounds);
+            } else {
+                filterSeparablePixels<ClampToBlackPixelFetcher, false>(src, result, rect, bounds);
+            }
+            break;
+    }
+}
+
+void SkMatrixConvolutionImageFilter::filterRows(const SkBitmap& src,
+                                                SkBitmap* result,
+                                                int top, int bottom,
+                                                const SkIRect& bounds) const {
+    const SkIRect rows = SkIRect::MakeLTRB(bounds.left(), top, bounds.right(), bottom);
+    if (fSeparableKernel) {
+        this->filterSeparablePixels(src, result, rows, bounds);
+        return;
+    }
+
+    SkIRect interior = SkIRect::MakeXYWH(bounds.left() + fKernelOffset.fX,
+                                         bounds.top() + fKernelOffset.fY,
+                                         bounds.width() - fKernelSize.fWidth + 1,
+                                         bounds.height() - fKernelSize.fHeight + 1);
+    SkIRect borders[] = {
+        SkIRect::MakeLTRB(bounds.left(), bounds.top(), bounds.right(), interior.top()),
+        SkIRect::MakeLTRB(bounds.left(), interior.top(), interior.left(), interior.bottom()),
+        SkIRect::MakeLTRB(interior.right(), interior.top(), bounds.right(), interior.bottom()),
+        SkIRect::MakeLTRB(bounds.left(), interior.bottom(), bounds.right(), bounds.bottom()),
+    };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(borders); ++i) {
+        if (borders[i].intersect(rows)) {
+            filterBorderPixels(src, result, borders[i], bounds);
+        }
+    }
+    if (interior.intersect(rows)) {
+        filterInteriorPixels(src, result, interior, bounds);
+    }
+}
+
+struct SkMatrixConvolutionImageFilter::Band {
+    const SkMatrixConvolutionImageFilter* fFilter;
+    const SkBitmap* fSrc;
+    SkBitmap*       fResult;
+    SkIRect         fBounds;
+    int             fTop, fBottom;
+};
+
+void SkMatrixConvolutionImageFilter::FilterBand(Band* band) {
+    band->fFilter->filterRows(*band->fSrc, band->fResult, band->fTop, band->fBottom,
+                              band->fBounds);
+}
+
 // FIXME:  This should be refactored to SkImageFilterUtils for
 // use by other filters.  For now, we assume the input is always
 // premultiplied and unpremultiply it
@@ -298,22 +489,31 @@ bool SkMatrixConvolutionImageFilter::onFilterImage(Proxy* proxy,
     offset->fX = bounds.fLeft;
     offset->fY = bounds.fTop;
     bounds.offset(-srcOffset);
-    SkIRect interior = SkIRect::MakeXYWH(bounds.left() + fKernelOffset.fX,
-                                         bounds.top() + fKernelOffset.fY,
-                                         bounds.width() - fKernelSize.fWidth + 1,
-                                         bounds.height() - fKernelSize.fHeight + 1);
-    SkIRect top = SkIRect::MakeLTRB(bounds.left(), bounds.top(), bounds.right(), interior.top());
-    SkIRect bottom = SkIRect::MakeLTRB(bounds.left(), interior.bottom(),
-                                       bounds.right(), bounds.bottom());
-    SkIRect left = SkIRect::MakeLTRB(bounds.left(), interior.top(),
-                                     interior.left(), interior.bottom());
-    SkIRect right = SkIRect::MakeLTRB(interior.right(), interior.top(),
-                                      bounds.right(), interior.bottom());
-    filterBorderPixels(src, result, top, bounds);
-    filterBorderPixels(src, result, left, bounds);
-    filterInteriorPixels(src, result, interior, bounds);
-    filterBorderPixels(src, result, right, bounds);
-    filterBorderPixels(src, result, bottom, bounds);
+
+    // Rows are independent, so big jobs are split into bands of rows on SkTaskGroup's threads.
+    static const int64_t kMinTapsPerBand = 1 << 20;
+    static const int kMaxBands = 32;
+    const int64_t taps = sk_64_mul(bounds.width(), bounds.height()) *
+                         (fSeparableKernel ? fKernelSize.width() + fKernelSize.height()
+                                           : fKernelSize.width() * fKernelSize.height());
+    const int bandCount = (int)SkTMin<int64_t>(SkTMin(kMaxBands, bounds.height()),
+                                               taps / kMinTapsPerBand);
+    if (bandCount <= 1) {
+        this->filterRows(src, result, bounds.top(), bounds.bottom(), bounds);
+        return true;
+    }
+    SkAutoSTMalloc<kMaxBands, Band> bands(bandCount);
+    for (int i = 0; i < bandCount; ++i) {
+        bands[i].fFilter = this;
+        bands[i].fSrc = &src;
+        bands[i].fResult = result;
+        bands[i].fBounds = bounds;
+        bands[i].fTop = bounds.top() + bounds.height() * i / bandCount;
+        bands[i].fBottom = bounds.top() + bounds.height() * (i + 1) / bandCount;
+    }
+    SkTaskGroup tg;
+    tg.batch(FilterBand, bands.get(), bandCount);
+    tg.wait();
     return true;
 }
 
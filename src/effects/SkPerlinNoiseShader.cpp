@@ -8,6 +8,7 @@
 #include "SkDither.h"
 #include "SkPerlinNoiseShader.h"
 #include "SkColorFilter.h"
+#include "SkNx.h"
 #include "SkReadBuffer.h"
 #include "SkWriteBuffer.h"
 #include "SkShader.h"
@@ -103,7 +104,9 @@ struct SkPerlinNoiseShader::PaintingData {
     int         fSeed;
     uint8_t     fLatticeSelector[kBlockSize];
     uint16_t    fNoise[4][kBlockSize][2];
-    SkPoint     fGradient[4][kBlockSize];
+    // The gradient at each lattice point, for all four channels, so they can be loaded at once.
+    SkScalar    fGradientX[kBlockSize][4];
+    SkScalar    fGradientY[kBlockSize][4];
     SkISize     fTileSize;
     SkVector    fBaseFrequency;
     StitchData  fStitchDataInit;
@@ -184,17 +187,19 @@ private:
         // Compute gradients from permutated noise data
         for (int channel = 0; channel < 4; ++channel) {
             for (int i = 0; i < kBlockSize; ++i) {
-                fGradient[channel][i] = SkPoint::Make(
+                SkPoint gradient = SkPoint::Make(
                     SkScalarMul(SkIntToScalar(fNoise[channel][i][0] - kBlockSize),
                                 gInvBlockSizef),
                     SkScalarMul(SkIntToScalar(fNoise[channel][i][1] - kBlockSize),
                                 gInvBlockSizef));
-                fGradient[channel][i].normalize();
+                gradient.normalize();
+                fGradientX[i][channel] = gradient.fX;
+                fGradientY[i][channel] = gradient.fY;
                 // Put the normalized gradient back into the noise data
                 fNoise[channel][i][0] = SkScalarRoundToInt(SkScalarMul(
-                    fGradient[channel][i].fX + SK_Scalar1, gHalfMax16bits));
+                    gradient.fX + SK_Scalar1, gHalfMax16bits));
                 fNoise[channel][i][1] = SkScalarRoundToInt(SkScalarMul(
-                    fGradient[channel][i].fY + SK_Scalar1, gHalfMax16bits));
+                    gradient.fY + SK_Scalar1, gHalfMax16bits));
             }
         }
     }
@@ -313,8 +318,23 @@ void SkPerlinNoiseShader::flatten(SkWriteBuffer& buffer) const {
     buffer.writeInt(fTileSize.fHeight);
 }
 
-SkScalar SkPerlinNoiseShader::PerlinNoiseShaderContext::noise2D(
-        int channel, const StitchData& stitchData, const SkPoint& noiseVector) const {
+namespace {
+
+inline Sk4f interp4(const Sk4f& a, const Sk4f& b, SkScalar t) {
+    return a + (b - a) * Sk4f(t);   // As SkScalarInterp().
+}
+
+// The dot product of each channel's gradient at lattice point b with (fx, fy).
+inline Sk4f gradientDot(const SkPerlinNoiseShader::PaintingData& paintingData, int b,
+                        SkScalar fx, SkScalar fy) {
+    return Sk4f::Load(paintingData.fGradientX[b]) * Sk4f(fx) +
+           Sk4f::Load(paintingData.fGradientY[b]) * Sk4f(fy);
+}
+
+// Computes the noise for all four channels at once: they share the lattice lookups, and only
+// differ in their gradients.
+Sk4f noise2D(const SkPerlinNoiseShader::PaintingData& paintingData, bool stitchTiles,
+             const SkPerlinNoiseShader::StitchData& stitchData, const SkPoint& noiseVector) {
     struct Noise {
         int noisePositionIntegerValue;
         int nextNoisePositionIntegerValue;
@@ -329,10 +349,8 @@ SkScalar SkPerlinNoiseShader::PerlinNoiseShaderContext::noise2D(
     };
     Noise noiseX(noiseVector.x());
     Noise noiseY(noiseVector.y());
-    SkScalar u, v;
-    const SkPerlinNoiseShader& perlinNoiseShader = static_cast<const SkPerlinNoiseShader&>(fShader);
     // If stitching, adjust lattice points accordingly.
-    if (perlinNoiseShader.fStitchTiles) {
+    if (stitchTiles) {
         noiseX.noisePositionIntegerValue =
             checkNoise(noiseX.noisePositionIntegerValue, stitchData.fWrapX, stitchData.fWidth);
         noiseY.noisePositionIntegerValue =
@@ -347,9 +365,9 @@ SkScalar SkPerlinNoiseShader::PerlinNoiseShaderContext::noise2D(
     noiseX.nextNoisePositionIntegerValue &= kBlockMask;
     noiseY.nextNoisePositionIntegerValue &= kBlockMask;
     int i =
-        fPaintingData->fLatticeSelector[noiseX.noisePositionIntegerValue];
+        paintingData.fLatticeSelector[noiseX.noisePositionIntegerValue];
     int j =
-        fPaintingData->fLatticeSelector[noiseX.nextNoisePositionIntegerValue];
+        paintingData.fLatticeSelector[noiseX.nextNoisePositionIntegerValue];
     int b00 = (i + noiseY.noisePositionIntegerValue) & kBlockMask;
     int b10 = (j + noiseY.noisePositionIntegerValue) & kBlockMask;
     int b01 = (i + noiseY.nextNoisePositionIntegerValue) & kBlockMask;
@@ -357,39 +375,42 @@ SkScalar SkPerlinNoiseShader::PerlinNoiseShaderContext::noise2D(
     SkScalar sx = smoothCurve(noiseX.noisePositionFractionValue);
     SkScalar sy = smoothCurve(noiseY.noisePositionFractionValue);
     // This is taken 1:1 from SVG spec: http://www.w3.org/TR/SVG11/filters.html#feTurbulenceElement
-    SkPoint fractionValue = SkPoint::Make(noiseX.noisePositionFractionValue,
-                                          noiseY.noisePositionFractionValue); // Offset (0,0)
-    u = fPaintingData->fGradient[channel][b00].dot(fractionValue);
-    fractionValue.fX -= SK_Scalar1; // Offset (-1,0)
-    v = fPaintingData->fGradient[channel][b10].dot(fractionValue);
-    SkScalar a = SkScalarInterp(u, v, sx);
-    fractionValue.fY -= SK_Scalar1; // Offset (-1,-1)
-    v = fPaintingData->fGradient[channel][b11].dot(fractionValue);
-    fractionValue.fX = noiseX.noisePositionFractionValue; // Offset (0,-1)
-    u = fPaintingData->fGradient[channel][b01].dot(fractionValue);
-    SkScalar b = SkScalarInterp(u, v, sx);
-    return SkScalarInterp(a, b, sy);
+    const SkScalar fx = noiseX.noisePositionFractionValue;
+    const SkScalar fy = noiseY.noisePositionFractionValue;
+    Sk4f u = gradientDot(paintingData, b00, fx, fy);                            // Offset (0,0)
+    Sk4f v = gradientDot(paintingData, b10, fx - SK_Scalar1, fy);               // Offset (-1,0)
+    Sk4f a = interp4(u, v, sx);
+    v = gradientDot(paintingData, b11, fx - SK_Scalar1, fy - SK_Scalar1);       // Offset (-1,-1)
+    u = gradientDot(paintingData, b01, fx, fy - SK_Scalar1);                    // Offset (0,-1)
+    Sk4f b = interp4(u, v, sx);
+    return interp4(a, b, sy);
 }
 
-SkScalar SkPerlinNoiseShader::PerlinNoiseShaderContext::calculateTurbulenceValueForPoint(
-        int channel, StitchData& stitchData, const SkPoint& point) const {
-    const SkPerlinNoiseShader& perlinNoiseShader = static_cast<const SkPerlinNoiseShader&>(fShader);
-    if (perlinNoiseShader.fStitchTiles) {
+// Returns the RGBA values at point, all four channels at once.
+Sk4f calculateTurbulenceValueForPoint(const SkPerlinNoiseShader::PaintingData& paintingData,
+                                      SkPerlinNoiseShader::Type type, int numOctaves,
+                                      bool stitchTiles, SkPerlinNoiseShader::StitchData& stitchData,
+                                      const SkPoint& point, U8CPU paintAlpha) {
+    if (stitchTiles) {
         // Set up TurbulenceInitial stitch values.
-        stitchData = fPaintingData->fStitchDataInit;
+        stitchData = paintingData.fStitchDataInit;
     }
-    SkScalar turbulenceFunctionResult = 0;
-    SkPoint noiseVector(SkPoint::Make(SkScalarMul(point.x(), fPaintingData->fBaseFrequency.fX),
-                                      SkScalarMul(point.y(), fPaintingData->fBaseFrequency.fY)));
+    Sk4f turbulenceFunctionResult(0);
+    SkPoint noiseVector(SkPoint::Make(SkScalarMul(point.x(), paintingData.fBaseFrequency.fX),
+                                      SkScalarMul(point.y(), paintingData.fBaseFrequency.fY)));
     SkScalar ratio = SK_Scalar1;
-    for (int octave = 0; octave < perlinNoiseShader.fNumOctaves; ++octave) {
-        SkScalar noise = noise2D(channel, stitchData, noiseVector);
-        turbulenceFunctionResult += SkScalarDiv(
-            (perlinNoiseShader.fType == kFractalNoise_Type) ? noise : SkScalarAbs(noise), ratio);
+    for (int octave = 0; octave < numOctaves; ++octave) {
+        Sk4f noise = noise2D(paintingData, stitchTiles, stitchData, noiseVector);
+        if (type != SkPerlinNoiseShader::kFractalNoise_Type) {
+            noise = Sk4f::Max(noise, Sk4f(0) - noise);  // abs(noise)
+        }
+        // ratio is a power of two, so multiplying by its reciprocal is exact (Sk4f's divide
+        // may only be an estimate, e.g. on NEON).
+        turbulenceFunctionResult += noise * Sk4f(SK_Scalar1 / ratio);
         noiseVector.fX *= 2;
         noiseVector.fY *= 2;
         ratio *= 2;
-        if (perlinNoiseShader.fStitchTiles) {
+        if (stitchTiles) {
             // Update stitch values
             stitchData.fWidth  *= 2;
             stitchData.fWrapX   = stitchData.fWidth + kPerlinNoise;
@@ -400,20 +421,22 @@ SkScalar SkPerlinNoiseShader::PerlinNoiseShaderContext::calculateTurbulenceValue
 
     // The value of turbulenceFunctionResult comes from ((turbulenceFunctionResult) + 1) / 2
     // by fractalNoise and (turbulenceFunctionResult) by turbulence.
-    if (perlinNoiseShader.fType == kFractalNoise_Type) {
+    if (type == SkPerlinNoiseShader::kFractalNoise_Type) {
         turbulenceFunctionResult =
-            SkScalarMul(turbulenceFunctionResult, SK_ScalarHalf) + SK_ScalarHalf;
+            turbulenceFunctionResult * Sk4f(SK_ScalarHalf) + Sk4f(SK_ScalarHalf);
     }
 
-    if (channel == 3) { // Scale alpha by paint value
-        turbulenceFunctionResult = SkScalarMul(turbulenceFunctionResult,
-            SkScalarDiv(SkIntToScalar(getPaintAlpha()), SkIntToScalar(255)));
-    }
+    // Scale alpha by paint value
+    turbulenceFunctionResult = turbulenceFunctionResult *
+        Sk4f(SK_Scalar1, SK_Scalar1, SK_Scalar1,
+             SkScalarDiv(SkIntToScalar(paintAlpha), SkIntToScalar(255)));
 
     // Clamp result
-    return SkScalarPin(turbulenceFunctionResult, 0, SK_Scalar1);
+    return Sk4f::Min(Sk4f::Max(turbulenceFunctionResult, Sk4f(0)), Sk4f(SK_Scalar1));
 }
 
+} // end namespace
+
 SkPMColor SkPerlinNoiseShader::PerlinNoiseShaderContext::shade(
         const SkPoint& point, StitchData& stitchData) const {
     SkPoint newPoint;
@@ -421,12 +444,14 @@ SkPMColor SkPerlinNoiseShader::PerlinNoiseShaderContext::shade(
     newPoint.fX = SkScalarRoundToScalar(newPoint.fX);
     newPoint.fY = SkScalarRoundToScalar(newPoint.fY);
 
-    U8CPU rgba[4];
-    for (int channel = 3; channel >= 0; --channel) {
-        rgba[channel] = SkScalarFloorToInt(255 *
-            calculateTurbulenceValueForPoint(channel, stitchData, newPoint));
-    }
-    return SkPreMultiplyARGB(rgba[3], rgba[0], rgba[1], rgba[2]);
+    const SkPerlinNoiseShader& perlinNoiseShader = static_cast<const SkPerlinNoiseShader&>(fShader);
+    SkScalar rgba[4];
+    (Sk4f(255) * calculateTurbulenceValueForPoint(*fPaintingData, perlinNoiseShader.fType,
+                                                  perlinNoiseShader.fNumOctaves,
+                                                  perlinNoiseShader.fStitchTiles, stitchData,
+                                                  newPoint, this->getPaintAlpha())).store(rgba);
+    return SkPreMultiplyARGB(SkScalarFloorToInt(rgba[3]), SkScalarFloorToInt(rgba[0]),
+                             SkScalarFloorToInt(rgba[1]), SkScalarFloorToInt(rgba[2]));
 }
 
 SkShader::Context* SkPerlinNoiseShader::onCreateContext(const ContextRec& rec,
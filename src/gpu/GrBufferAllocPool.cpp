@@ -114,6 +114,7 @@ void GrBufferAllocPool::reset() {
 }
 
 void GrBufferAllocPool::unmap() {
+    TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("skia.gpu.stages"), "GrStage::bufferMap");
     VALIDATE();
 
     if (fBufferPtr) {
@@ -277,7 +278,7 @@ void GrBufferAllocPool::putBack(size_t bytes) {
 }
 
 bool GrBufferAllocPool::createBlock(size_t requestSize) {
-
+    TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("skia.gpu.stages"), "GrStage::bufferMap");
     size_t size = SkTMax(requestSize, fMinBlockSize);
     SkASSERT(size >= GrBufferAllocPool_MIN_BLOCK_SIZE);
 
@@ -12,6 +12,7 @@
 #include "GrInOrderDrawBuffer.h"
 #include "GrTemplates.h"
 #include "SkPoint.h"
+#include "SkTraceEvent.h"
 
 void GrTargetCommands::closeBatch() {
     if (fDrawBatch) {
@@ -109,6 +110,7 @@ GrTargetCommands::Cmd* GrTargetCommands::recordDrawBatch(
                                                   GrInOrderDrawBuffer* iodb,
                                                   GrBatch* batch,
                                                   const GrDrawTarget::PipelineInfo& pipelineInfo) {
+    TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("skia.gpu.stages"), "GrStage::batching");
     if (!this->setupPipelineAndShouldDraw(iodb, batch, pipelineInfo)) {
         return NULL;
     }
@@ -285,6 +287,7 @@ void GrTargetCommands::flush(GrInOrderDrawBuffer* iodb) {
     if (fCmdBuffer.empty()) {
         return;
     }
+    TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("skia.gpu.stages"), "GrStage::flush");
 
     // TODO this is temporary while batch is being rolled out
     this->closeBatch();
@@ -18,6 +18,7 @@
 #include "GrTypes.h"
 #include "SkStrokeRec.h"
 #include "SkTemplates.h"
+#include "SkTraceEvent.h"
 
 #define GL_CALL(X) GR_GL_CALL(this->glInterface(), X)
 #define GL_CALL_RET(RET, X) GR_GL_CALL_RET(this->glInterface(), RET, X)
@@ -1416,7 +1417,10 @@ bool GrGLGpu::flushGLState(const DrawArgs& args) {
     this->flushColorWrite(blendInfo.fWriteColor);
     this->flushDrawFace(pipeline.getDrawFace());
 
-    fCurrentProgram.reset(fProgramCache->getProgram(args));
+    {
+        TRACE_EVENT0(TRACE_DISABLED_BY_DEFAULT("skia.gpu.stages"), "GrStage::programLookup");
+        fCurrentProgram.reset(fProgramCache->getProgram(args));
+    }
     if (NULL == fCurrentProgram.get()) {
         SkDEBUGFAIL("Failed to create program!");
         return false;
@@ -8,6 +8,7 @@
 
 #include "SkImageDecoder.h"
 #include "SkImageEncoder.h"
+#include "SkImageEncoderPriv.h"
 #include "SkJpegUtility.h"
 #include "SkColorPriv.h"
 #include "SkDither.h"
@@ -1343,8 +1344,8 @@ static void Write_Index_YUV(uint8_t* SK_RESTRICT dst,
     }
 }
 
-static WriteScanline ChooseWriter(const SkBitmap& bm) {
-    switch (bm.colorType()) {
+static WriteScanline ChooseWriter(SkColorType ct) {
+    switch (ct) {
         case kN32_SkColorType:
             return Write_32_YUV;
         case kRGB_565_SkColorType:
@@ -1361,12 +1362,22 @@ static WriteScanline ChooseWriter(const SkBitmap& bm) {
 class SkJPEGImageEncoder : public SkImageEncoder {
 protected:
     virtual bool onEncode(SkWStream* stream, const SkBitmap& bm, int quality) {
+        SkAutoLockPixels alp(bm);
+        if (NULL == bm.getPixels()) {
+            return false;
+        }
+        SkBitmapRowSource source(bm);
+        return this->onEncodeRows(stream, &source, quality);
+    }
+
+    // libjpeg consumes scanlines one at a time, so we only ever need one band of the image.
+    bool onEncodeRows(SkWStream* stream, RowSource* source, int quality) override {
 #ifdef TIME_ENCODE
         SkAutoTime atm("JPEG Encode");
 #endif
 
-        SkAutoLockPixels alp(bm);
-        if (NULL == bm.getPixels()) {
+        const SkImageInfo info = source->info();
+        if (info.isEmpty()) {
             return false;
         }
 
@@ -1376,6 +1387,7 @@ protected:
 
         // allocate these before set call setjmp
         SkAutoMalloc    oneRow;
+        SkBitmap        band;
 
         cinfo.err = jpeg_std_error(&sk_err);
         sk_err.error_exit = skjpeg_error_exit;
@@ -1384,15 +1396,15 @@ protected:
         }
 
         // Keep after setjmp or mark volatile.
-        const WriteScanline writer = ChooseWriter(bm);
+        const WriteScanline writer = ChooseWriter(info.colorType());
         if (NULL == writer) {
             return false;
         }
 
         jpeg_create_compress(&cinfo);
         cinfo.dest = &sk_wstream;
-        cinfo.image_width = bm.width();
-        cinfo.image_height = bm.height();
+        cinfo.image_width = info.width();
+        cinfo.image_height = info.height();
         cinfo.input_components = 3;
 #ifdef WE_CONVERT_TO_YUV
         cinfo.in_color_space = JCS_YCbCr;
@@ -1409,19 +1421,29 @@ protected:
 
         jpeg_start_compress(&cinfo, TRUE);
 
-        const int       width = bm.width();
+        const int       width = info.width();
         uint8_t*        oneRowP = (uint8_t*)oneRow.reset(width * 3);
 
-        const SkPMColor* colors = bm.getColorTable() ? bm.getColorTable()->readColors() : NULL;
-        const void*      srcRow = bm.getPixels();
-
         while (cinfo.next_scanline < cinfo.image_height) {
-            JSAMPROW row_pointer[1];    /* pointer to JSAMPLE row[s] */
+            const int rowsLeft = cinfo.image_height - cinfo.next_scanline;
+            if (!SkNextRowBand(source, rowsLeft, &band)) {
+                jpeg_destroy_compress(&cinfo);
+                return false;
+            }
+            SkAutoLockPixels alpBand(band);
+            const SkPMColor* colors = band.getColorTable() ? band.getColorTable()->readColors()
+                                                           : NULL;
+            if (kIndex_8_SkColorType == info.colorType() && NULL == colors) {
+                jpeg_destroy_compress(&cinfo);
+                return false;
+            }
+            for (int y = 0; y < band.height(); y++) {
+                JSAMPROW row_pointer[1];    /* pointer to JSAMPLE row[s] */
 
-            writer(oneRowP, srcRow, width, colors);
-            row_pointer[0] = oneRowP;
-            (void) jpeg_write_scanlines(&cinfo, row_pointer, 1);
-            srcRow = (const void*)((const char*)srcRow + bm.rowBytes());
+                writer(oneRowP, band.getAddr(0, y), width, colors);
+                row_pointer[0] = oneRowP;
+                (void) jpeg_write_scanlines(&cinfo, row_pointer, 1);
+            }
         }
 
         jpeg_finish_compress(&cinfo);
@@ -7,9 +7,11 @@
 
 #include "SkImageDecoder.h"
 #include "SkImageEncoder.h"
+#include "SkImageEncoderPriv.h"
 #include "SkColor.h"
 #include "SkColorPriv.h"
 #include "SkDither.h"
+#include "SkFlate.h"
 #include "SkMath.h"
 #include "SkRTConf.h"
 #include "SkScaledBitmapSampler.h"
@@ -24,6 +26,12 @@
 #endif
 #include "png.h"
 
+#ifdef ZLIB_INCLUDE
+    #include ZLIB_INCLUDE
+#else
+    #include "zlib.h"
+#endif
+
 /* These were dropped in libpng >= 1.4 */
 #ifndef png_infopp_NULL
 #define png_infopp_NULL NULL
@@ -1102,11 +1110,175 @@ static inline int pack_palette(SkColorTable* ctable,
     return num_trans;
 }
 
+// Images whose filtered scanlines add up to at least this many bytes skip libpng's
+// single-threaded zlib and are deflated by SkDeflateWStream, which compresses blocks of rows
+// in parallel.  The resulting zlib stream is written out as IDAT chunks.
+static const size_t kParallelDeflateMinSize = 256 * 1024;
+static const size_t kIDATChunkSize = 8192;  // libpng's own default IDAT size.
+
+// Writes a PNG chunk straight to stream. Unlike png_write_chunk(), a failed write returns false
+// rather than png_error()ing, which would longjmp() out past C++ destructors.
+static bool write_png_chunk(SkWStream* stream, const char type[4], const uint8_t* data,
+                            size_t size) {
+    const uint8_t header[8] = {
+        (uint8_t)(size >> 24), (uint8_t)(size >> 16), (uint8_t)(size >> 8), (uint8_t)size,
+        (uint8_t)type[0], (uint8_t)type[1], (uint8_t)type[2], (uint8_t)type[3],
+    };
+    uLong crc = crc32(0, header + 4, 4);
+    if (size > 0) {
+        crc = crc32(crc, data, SkToUInt(size));
+    }
+    const uint8_t trailer[4] = {
+        (uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc,
+    };
+    return stream->write(header, sizeof(header)) &&
+           (0 == size || stream->write(data, size)) &&
+           stream->write(trailer, sizeof(trailer));
+}
+
+// Collects compressed data and writes it out as IDAT chunks of kIDATChunkSize bytes.
+class SkPNGIDATWStream : public SkWStream {
+public:
+    SkPNGIDATWStream(SkWStream* stream) : fStream(stream), fUsed(0), fBytesWritten(0) {}
+
+    bool write(const void* buffer, size_t size) override {
+        const uint8_t* src = (const uint8_t*)buffer;
+        while (size > 0) {
+            size_t tocopy = SkTMin(size, kIDATChunkSize - fUsed);
+            memcpy(fChunk + fUsed, src, tocopy);
+            fUsed += tocopy;
+            src += tocopy;
+            size -= tocopy;
+            if (kIDATChunkSize == fUsed && !this->writeChunk()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Writes out any partial chunk. Returns false if the stream failed.
+    bool writeChunk() {
+        if (fUsed > 0) {
+            if (!write_png_chunk(fStream, "IDAT", fChunk, fUsed)) {
+                return false;
+            }
+            fBytesWritten += fUsed;
+            fUsed = 0;
+        }
+        return true;
+    }
+
+    void flush() override { (void)this->writeChunk(); }
+
+    size_t bytesWritten() const override { return fBytesWritten + fUsed; }
+
+private:
+    SkWStream*  fStream;
+    uint8_t     fChunk[kIDATChunkSize];
+    size_t      fUsed;
+    size_t      fBytesWritten;
+};
+
+static inline uint8_t paeth_predictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = SkAbs32(p - a);
+    int pb = SkAbs32(p - b);
+    int pc = SkAbs32(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    }
+    return pb <= pc ? b : c;
+}
+
+enum {
+    kNone_PNGFilter,
+    kSub_PNGFilter,
+    kUp_PNGFilter,
+    kAverage_PNGFilter,
+    kPaeth_PNGFilter,
+
+    kPNGFilterCount
+};
+
+// Filters one row of len bytes (bpp bytes per pixel) against the previous unfiltered row with
+// each PNG filter, writing (len + 1)-byte candidates, filter type first, into filtered.
+// Returns the candidate with the smallest sum of absolute residuals, libpng's own heuristic.
+static const uint8_t* filter_scanline(const uint8_t* row, const uint8_t* prev, size_t len,
+                                      int bpp, uint8_t* filtered) {
+    const uint8_t* best = NULL;
+    uint32_t bestSum = SK_MaxU32;
+    for (int type = 0; type < kPNGFilterCount; type++) {
+        uint8_t* dst = filtered + type * (len + 1);
+        dst[0] = type;
+        uint32_t sum = 0;
+        for (size_t i = 0; i < len; i++) {
+            int left   = i >= (size_t)bpp ? row[i - bpp] : 0;
+            int upLeft = i >= (size_t)bpp ? prev[i - bpp] : 0;
+            int pred;
+            switch (type) {
+                case kSub_PNGFilter:     pred = left;                                   break;
+                case kUp_PNGFilter:      pred = prev[i];                                break;
+                case kAverage_PNGFilter: pred = (left + prev[i]) >> 1;                  break;
+                case kPaeth_PNGFilter:   pred = paeth_predictor(left, prev[i], upLeft); break;
+                default:                 pred = 0;                                      break;
+            }
+            uint8_t residual = row[i] - pred;
+            dst[i + 1] = residual;
+            sum += residual < 128 ? residual : 256 - residual;
+        }
+        if (sum < bestSum) {
+            bestSum = sum;
+            best = dst;
+        }
+    }
+    return best;
+}
+
+// Writes the image data and IEND chunk for an image whose scanlines proc expands to bpp bytes
+// per pixel, after png_write_info() has written the header chunks.
+static bool write_rows_parallel_deflate(png_structp png_ptr,
+                                        SkImageEncoder::RowSource* source,
+                                        transform_scanline_proc proc, int bpp) {
+    const SkImageInfo info = source->info();
+    const size_t rowBytes = info.width() * bpp;
+    SkAutoTMalloc<uint8_t> storage(2 * rowBytes + kPNGFilterCount * (rowBytes + 1));
+    uint8_t* prev = storage.get();
+    uint8_t* row = prev + rowBytes;
+    uint8_t* filtered = row + rowBytes;
+    sk_bzero(prev, rowBytes);
+
+    // png_write_info() has already written everything before the image data to this stream.
+    SkWStream* stream = (SkWStream*)png_get_io_ptr(png_ptr);
+    SkPNGIDATWStream idat(stream);
+    SkDeflateWStream deflateWStream(&idat);
+    int y = 0;
+    while (y < info.height()) {
+        SkBitmap band;
+        if (!SkNextRowBand(source, info.height() - y, &band)) {
+            return false;
+        }
+        SkAutoLockPixels alpBand(band);
+        for (int i = 0; i < band.height(); i++) {
+            proc((const char*)band.getAddr(0, i), info.width(), (char*)row);
+            if (!deflateWStream.write(filter_scanline(row, prev, rowBytes, bpp, filtered),
+                                      rowBytes + 1)) {
+                return false;
+            }
+            SkTSwap(prev, row);
+        }
+        y += band.height();
+    }
+    return deflateWStream.finalize() &&
+           idat.writeChunk() &&
+           write_png_chunk(stream, "IEND", NULL, 0);
+}
+
 class SkPNGImageEncoder : public SkImageEncoder {
 protected:
     bool onEncode(SkWStream* stream, const SkBitmap& bm, int quality) override;
+    bool onEncodeRows(SkWStream* stream, RowSource* source, int quality) override;
 private:
-    bool doEncode(SkWStream* stream, const SkBitmap& bm,
+    bool doEncode(SkWStream* stream, RowSource* source, SkColorTable* ctable,
                   const bool& hasAlpha, int colorType,
                   int bitDepth, SkColorType ct,
                   png_color_8& sig_bit);
@@ -1114,35 +1286,32 @@ private:
     typedef SkImageEncoder INHERITED;
 };
 
-bool SkPNGImageEncoder::onEncode(SkWStream* stream, const SkBitmap& bitmap, int /*quality*/) {
-    SkColorType ct = bitmap.colorType();
-
-    const bool hasAlpha = !bitmap.isOpaque();
-    int colorType = PNG_COLOR_MASK_COLOR;
-    int bitDepth = 8;   // default for color
-    png_color_8 sig_bit;
+// Picks the PNG color type and significant bits for ct.  Returns false if we can't encode ct.
+static bool choose_png_format(SkColorType ct, bool hasAlpha, int* colorType,
+                              png_color_8* sig_bit) {
+    *colorType = PNG_COLOR_MASK_COLOR;
 
     switch (ct) {
         case kIndex_8_SkColorType:
-            colorType |= PNG_COLOR_MASK_PALETTE;
+            *colorType |= PNG_COLOR_MASK_PALETTE;
             // fall through to the ARGB_8888 case
         case kN32_SkColorType:
-            sig_bit.red = 8;
-            sig_bit.green = 8;
-            sig_bit.blue = 8;
-            sig_bit.alpha = 8;
+            sig_bit->red = 8;
+            sig_bit->green = 8;
+            sig_bit->blue = 8;
+            sig_bit->alpha = 8;
             break;
         case kARGB_4444_SkColorType:
-            sig_bit.red = 4;
-            sig_bit.green = 4;
-            sig_bit.blue = 4;
-            sig_bit.alpha = 4;
+            sig_bit->red = 4;
+            sig_bit->green = 4;
+            sig_bit->blue = 4;
+            sig_bit->alpha = 4;
             break;
         case kRGB_565_SkColorType:
-            sig_bit.red = 5;
-            sig_bit.green = 6;
-            sig_bit.blue = 5;
-            sig_bit.alpha = 0;
+            sig_bit->red = 5;
+            sig_bit->green = 6;
+            sig_bit->blue = 5;
+            sig_bit->alpha = 0;
             break;
         default:
             return false;
@@ -1150,11 +1319,25 @@ bool SkPNGImageEncoder::onEncode(SkWStream* stream, const SkBitmap& bitmap, int
 
     if (hasAlpha) {
         // don't specify alpha if we're a palette, even if our ctable has alpha
-        if (!(colorType & PNG_COLOR_MASK_PALETTE)) {
-            colorType |= PNG_COLOR_MASK_ALPHA;
+        if (!(*colorType & PNG_COLOR_MASK_PALETTE)) {
+            *colorType |= PNG_COLOR_MASK_ALPHA;
         }
     } else {
-        sig_bit.alpha = 0;
+        sig_bit->alpha = 0;
+    }
+    return true;
+}
+
+bool SkPNGImageEncoder::onEncode(SkWStream* stream, const SkBitmap& bitmap, int /*quality*/) {
+    SkColorType ct = bitmap.colorType();
+
+    const bool hasAlpha = !bitmap.isOpaque();
+    int colorType;
+    int bitDepth = 8;   // default for color
+    png_color_8 sig_bit;
+
+    if (!choose_png_format(ct, hasAlpha, &colorType, &sig_bit)) {
+        return false;
     }
 
     SkAutoLockPixels alp(bitmap);
@@ -1173,13 +1356,32 @@ bool SkPNGImageEncoder::onEncode(SkWStream* stream, const SkBitmap& bitmap, int
         bitDepth = computeBitDepth(ctable->count());
     }
 
-    return doEncode(stream, bitmap, hasAlpha, colorType, bitDepth, ct, sig_bit);
+    SkBitmapRowSource source(bitmap);
+    return doEncode(stream, &source, ctable, hasAlpha, colorType, bitDepth, ct, sig_bit);
 }
 
-bool SkPNGImageEncoder::doEncode(SkWStream* stream, const SkBitmap& bitmap,
+bool SkPNGImageEncoder::onEncodeRows(SkWStream* stream, RowSource* source, int quality) {
+    const SkImageInfo info = source->info();
+    SkColorType ct = info.colorType();
+    if (kIndex_8_SkColorType == ct) {
+        // We need the color table before we see any rows.
+        return INHERITED::onEncodeRows(stream, source, quality);
+    }
+
+    const bool hasAlpha = !info.isOpaque();
+    int colorType;
+    png_color_8 sig_bit;
+    if (info.isEmpty() || !choose_png_format(ct, hasAlpha, &colorType, &sig_bit)) {
+        return false;
+    }
+    return doEncode(stream, source, NULL, hasAlpha, colorType, 8, ct, sig_bit);
+}
+
+bool SkPNGImageEncoder::doEncode(SkWStream* stream, RowSource* source, SkColorTable* ctable,
                   const bool& hasAlpha, int colorType,
                   int bitDepth, SkColorType ct,
                   png_color_8& sig_bit) {
+    const SkImageInfo info = source->info();
 
     png_structp png_ptr;
     png_infop info_ptr;
@@ -1215,7 +1417,7 @@ bool SkPNGImageEncoder::doEncode(SkWStream* stream, const SkBitmap& bitmap,
     * currently be PNG_COMPRESSION_TYPE_BASE and PNG_FILTER_TYPE_BASE. REQUIRED
     */
 
-    png_set_IHDR(png_ptr, info_ptr, bitmap.width(), bitmap.height(),
+    png_set_IHDR(png_ptr, info_ptr, info.width(), info.height(),
                  bitDepth, colorType,
                  PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE,
                  PNG_FILTER_TYPE_BASE);
@@ -1224,9 +1426,8 @@ bool SkPNGImageEncoder::doEncode(SkWStream* stream, const SkBitmap& bitmap,
     png_color paletteColors[256];
     png_byte trans[256];
     if (kIndex_8_SkColorType == ct) {
-        SkColorTable* ct = bitmap.getColorTable();
-        int numTrans = pack_palette(ct, paletteColors, trans, hasAlpha);
-        png_set_PLTE(png_ptr, info_ptr, paletteColors, ct->count());
+        int numTrans = pack_palette(ctable, paletteColors, trans, hasAlpha);
+        png_set_PLTE(png_ptr, info_ptr, paletteColors, ctable->count());
         if (numTrans > 0) {
             png_set_tRNS(png_ptr, info_ptr, trans, numTrans, NULL);
         }
@@ -1236,16 +1437,33 @@ bool SkPNGImageEncoder::doEncode(SkWStream* stream, const SkBitmap& bitmap,
 #endif
     png_write_info(png_ptr, info_ptr);
 
-    const char* srcImage = (const char*)bitmap.getPixels();
-    SkAutoSMalloc<1024> rowStorage(bitmap.width() << 2);
+    SkAutoSMalloc<1024> rowStorage(info.width() << 2);
     char* storage = (char*)rowStorage.get();
     transform_scanline_proc proc = choose_proc(ct, hasAlpha);
 
-    for (int y = 0; y < bitmap.height(); y++) {
-        png_bytep row_ptr = (png_bytep)storage;
-        proc(srcImage, bitmap.width(), storage);
-        png_write_rows(png_ptr, &row_ptr, 1);
-        srcImage += bitmap.rowBytes();
+    const int bpp = hasAlpha ? 4 : 3;
+    if (kN32_SkColorType == ct &&
+        (size_t)info.height() * info.width() * bpp >= kParallelDeflateMinSize) {
+        bool success = write_rows_parallel_deflate(png_ptr, source, proc, bpp);
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        return success;
+    }
+
+    // Rows are pulled from the source a band at a time and handed straight to libpng.
+    int y = 0;
+    while (y < info.height()) {
+        SkBitmap band;
+        if (!SkNextRowBand(source, info.height() - y, &band)) {
+            png_destroy_write_struct(&png_ptr, &info_ptr);
+            return false;
+        }
+        SkAutoLockPixels alpBand(band);
+        for (int i = 0; i < band.height(); i++) {
+            png_bytep row_ptr = (png_bytep)storage;
+            proc((const char*)band.getAddr(0, i), info.width(), storage);
+            png_write_rows(png_ptr, &row_ptr, 1);
+        }
+        y += band.height();
     }
 
     png_write_end(png_ptr, info_ptr);
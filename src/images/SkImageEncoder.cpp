@@ -6,12 +6,40 @@
  */
 
 #include "SkImageEncoder.h"
+#include "SkImageEncoderPriv.h"
 #include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkPicture.h"
 #include "SkStream.h"
 #include "SkTemplates.h"
 
 SkImageEncoder::~SkImageEncoder() {}
 
+bool SkImageEncoder::onEncodeRows(SkWStream* stream, RowSource* source, int quality) {
+    const SkImageInfo info = source->info();
+    SkBitmap bm;
+    int y = 0;
+    while (y < info.height()) {
+        SkBitmap band;
+        if (!SkNextRowBand(source, info.height() - y, &band)) {
+            return false;
+        }
+        SkAutoLockPixels alpBand(band);
+        if (NULL == band.getPixels()) {
+            return false;
+        }
+        // Index8 sources hand us their color table with the pixels.
+        if (0 == y && !bm.tryAllocPixels(info, NULL, band.getColorTable())) {
+            return false;
+        }
+        for (int i = 0; i < band.height(); i++) {
+            memcpy(bm.getAddr(0, y + i), band.getAddr(0, i), info.minRowBytes());
+        }
+        y += band.height();
+    }
+    return this->onEncode(stream, bm, quality);
+}
+
 bool SkImageEncoder::encodeStream(SkWStream* stream, const SkBitmap& bm,
                                   int quality) {
     quality = SkMin32(100, SkMax32(0, quality));
@@ -25,6 +53,11 @@ bool SkImageEncoder::encodeFile(const char file[], const SkBitmap& bm,
     return this->onEncode(&stream, bm, quality);
 }
 
+bool SkImageEncoder::encodeStream(SkWStream* stream, RowSource* source, int quality) {
+    quality = SkMin32(100, SkMax32(0, quality));
+    return this->onEncodeRows(stream, source, quality);
+}
+
 SkData* SkImageEncoder::encodeData(const SkBitmap& bm, int quality) {
     SkDynamicMemoryWStream stream;
     quality = SkMin32(100, SkMax32(0, quality));
@@ -46,6 +79,11 @@ bool SkImageEncoder::EncodeStream(SkWStream* stream, const SkBitmap& bm, Type t,
     return enc.get() && enc.get()->encodeStream(stream, bm, quality);
 }
 
+bool SkImageEncoder::EncodeStream(SkWStream* stream, RowSource* source, Type t, int quality) {
+    SkAutoTDelete<SkImageEncoder> enc(SkImageEncoder::Create(t));
+    return enc.get() && enc.get()->encodeStream(stream, source, quality);
+}
+
 SkData* SkImageEncoder::EncodeData(const SkBitmap& bm, Type t, int quality) {
     SkAutoTDelete<SkImageEncoder> enc(SkImageEncoder::Create(t));
     return enc.get() ? enc.get()->encodeData(bm, quality) : NULL;
@@ -60,3 +98,60 @@ SkData* SkImageEncoder::EncodeData(const SkImageInfo& info, const void* pixels,
     SkAutoTDelete<SkImageEncoder> enc(SkImageEncoder::Create(t));
     return enc.get() ? enc.get()->encodeData(bm, quality) : NULL;
 }
+
+namespace {
+
+// Renders a picture into a reused bitmap one band of rows at a time.  Drawing into a canvas
+// the size of the band clips playback to it, so only the ops that touch it are drawn.
+class PictureRowSource : public SkImageEncoder::RowSource {
+public:
+    PictureRowSource(const SkPicture* picture, const SkImageInfo& info, int bandHeight)
+        : fPicture(picture)
+        , fInfo(info)
+        , fBandHeight(SkTMin(SkTMax(bandHeight, 1), info.height()))
+        , fTop(0) {}
+
+    SkImageInfo info() const override { return fInfo; }
+
+    bool nextBand(SkBitmap* band) override {
+        if (fTop >= fInfo.height()) {
+            return false;
+        }
+        if (fBand.isNull() &&
+            !fBand.tryAllocPixels(fInfo.makeWH(fInfo.width(), fBandHeight))) {
+            return false;
+        }
+        const int height = SkTMin(fBandHeight, fInfo.height() - fTop);
+        if (height < fBand.height() &&
+            !fBand.extractSubset(&fBand, SkIRect::MakeWH(fInfo.width(), height))) {
+            return false;
+        }
+
+        fBand.eraseColor(SK_ColorTRANSPARENT);
+        SkCanvas canvas(fBand);
+        canvas.translate(0, -SkIntToScalar(fTop));
+        canvas.drawPicture(fPicture);
+
+        *band = fBand;
+        fTop += height;
+        return true;
+    }
+
+private:
+    const SkPicture*  fPicture;
+    const SkImageInfo fInfo;
+    const int         fBandHeight;
+    int               fTop;
+    SkBitmap          fBand;
+};
+
+}  // namespace
+
+bool SkImageEncoder::EncodePicture(SkWStream* stream, const SkPicture* picture,
+                                   const SkImageInfo& info, Type t, int quality, int bandHeight) {
+    if (NULL == picture || info.isEmpty()) {
+        return false;
+    }
+    PictureRowSource source(picture, info, bandHeight);
+    return EncodeStream(stream, &source, t, quality);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkImageEncoderPriv_DEFINED
+#define SkImageEncoderPriv_DEFINED
+
+#include "SkBitmap.h"
+#include "SkImageEncoder.h"
+
+/**
+ *  Supplies an entire bitmap as a single band, so encoders can share one row loop between
+ *  onEncode() and onEncodeRows().
+ */
+class SkBitmapRowSource : public SkImageEncoder::RowSource {
+public:
+    explicit SkBitmapRowSource(const SkBitmap& bm) : fBitmap(bm), fDone(false) {}
+
+    SkImageInfo info() const override { return fBitmap.info(); }
+
+    bool nextBand(SkBitmap* band) override {
+        if (fDone) {
+            return false;
+        }
+        fDone = true;
+        *band = fBitmap;
+        return true;
+    }
+
+private:
+    const SkBitmap& fBitmap;
+    bool            fDone;
+};
+
+/**
+ *  Fetch the next band from source into band, checking that it matches source->info() and
+ *  has no more than rowsLeft rows.  The caller still needs to lock band's pixels.
+ */
+static inline bool SkNextRowBand(SkImageEncoder::RowSource* source, int rowsLeft,
+                                 SkBitmap* band) {
+    const SkImageInfo info = source->info();
+    return source->nextBand(band) &&
+           band->width() == info.width() &&
+           band->colorType() == info.colorType() &&
+           band->height() > 0 && band->height() <= rowsLeft;
+}
+
+#endif  // SkImageEncoderPriv_DEFINED
@@ -5,11 +5,15 @@
  * found in the LICENSE file.
  */
 
+#include "SkAtomics.h"
 #include "SkDiscardableMemory.h"
 #include "SkDiscardableMemoryPool.h"
 #include "SkImageGenerator.h"
 #include "SkLazyPtr.h"
-#include "SkTInternalLList.h"
+#include "SkMath.h"
+#include "SkTDArray.h"
+#include "SkTSort.h"
+#include "SkTemplates.h"
 #include "SkThread.h"
 
 // Note:
@@ -18,8 +22,53 @@
 
 namespace {
 
+// Allocations are rounded up to one of four block sizes between each power of two, and carved out
+// of slabs of blocks of one size, so that decoded images coming and going reuse the same memory
+// rather than fragmenting the heap.  Allocations bigger than kMaxBlockSize get a slab to
+// themselves.  The budget is measured against the slabs, since that is the memory we really hold,
+// and no slab takes more than 1/kBudgetPerSlab of the budget, so little of it is lost to blocks
+// that are never used.
+static const size_t kMinBlockSize = 64;
+static const size_t kMaxBlockSize = 256 * 1024;
+static const size_t kSlabSize     = 1024 * 1024;
+static const int    kMinSlabBlocks = 4;
+static const int    kMaxSlabBlocks = 256;
+static const size_t kBudgetPerSlab = 8;
+static const int    kBlockSizeCount = 49;   // Block sizes from kMinBlockSize to kMaxBlockSize.
+
+static int floor_log2(size_t n) {
+    SkASSERT(n > 0 && n <= SK_MaxU32);
+    return 31 - SkCLZ(SkToU32(n));
+}
+
+static size_t block_size(size_t bytes) {
+    SkASSERT(bytes <= kMaxBlockSize);
+    if (bytes <= kMinBlockSize) {
+        return kMinBlockSize;
+    }
+    const size_t step = (size_t)1 << (floor_log2(bytes) - 2);
+    return (bytes + step - 1) & ~(step - 1);
+}
+
+static int block_size_index(size_t blockSize) {
+    const int log2 = floor_log2(blockSize);
+    const int index = (log2 - floor_log2(kMinBlockSize)) * 4 + (int)(blockSize >> (log2 - 2)) - 4;
+    SkASSERT(index >= 0 && index < kBlockSizeCount);
+    return index;
+}
+
 class PoolDiscardableMemory;
 
+struct Slab {
+    char*                                   fMemory;
+    size_t                                  fBlockSize;
+    int                                     fBlockCount;
+    int                                     fLiveCount;
+    SkAutoTMalloc<PoolDiscardableMemory*>   fBlocks;        // NULL for free blocks.
+    SkTDArray<int>                          fFreeBlocks;
+    int64_t                                 fLastUse;       // Atomic. Set by lock().
+};
+
 /**
  *  This non-global pool can be used for unit tests to verify that the
  *  pool works.
@@ -36,26 +85,36 @@ public:
 
     size_t getRAMUsed() override;
     void setRAMBudget(size_t budget) override;
-    size_t getRAMBudget() override { return fBudget; }
+    size_t getRAMBudget() override { return sk_atomic_load(&fBudget, sk_memory_order_relaxed); }
 
     /** purges all unlocked DMs */
     void dumpPool() override;
 
     #if SK_LAZY_CACHE_STATS  // Defined in SkDiscardableMemoryPool.h
-    int getCacheHits() override { return fCacheHits; }
-    int getCacheMisses() override { return fCacheMisses; }
+    int getCacheHits() override { return sk_atomic_load(&fHits); }
+    int getCacheMisses() override { return sk_atomic_load(&fMisses); }
     void resetCacheHitsAndMisses() override {
-        fCacheHits = fCacheMisses = 0;
+        sk_atomic_store(&fHits, 0);
+        sk_atomic_store(&fMisses, 0);
     }
-    int          fCacheHits;
-    int          fCacheMisses;
     #endif  // SK_LAZY_CACHE_STATS
 
+    void getStats(Stats*) override;
+
 private:
     SkBaseMutex* fMutex;
-    size_t       fBudget;
-    size_t       fUsed;
-    SkTInternalLList<PoolDiscardableMemory> fList;
+    size_t       fBudget;       // Atomic. Written with fMutex held.
+    size_t       fUsed;         // Atomic. Written with fMutex held.
+    size_t       fSlabBytes;    // Atomic. Written with fMutex held.
+    int64_t      fClock;        // Atomic.
+    int32_t      fHits;         // Atomic.
+    int32_t      fMisses;       // Atomic.
+    int          fPurges;
+    int          fSlabsFreed;
+
+    // Every slab, and those of each block size.  Only changed with fMutex held.
+    SkTDArray<Slab*> fSlabs;
+    SkTDArray<Slab*> fSlabsBySize[kBlockSizeCount];
 
     /** Function called to free memory if needed */
     void dumpDownTo(size_t budget);
@@ -66,6 +125,13 @@ private:
     /** called by DiscardableMemoryPool::unlock() */
     void unlock(PoolDiscardableMemory* dm);
 
+    Slab* findSlab(size_t bytes);
+    Slab* newSlab(size_t blockSize, int blockCount);
+    void freeSlab(Slab*);
+    void releaseBlock(PoolDiscardableMemory* dm, bool keepEmptySlab);
+    void purgeSlab(Slab*);
+    static bool AllUnlocked(const Slab*);
+
     friend class PoolDiscardableMemory;
 
     typedef SkDiscardableMemory::Factory INHERITED;
@@ -77,52 +143,61 @@ private:
  */
 class PoolDiscardableMemory : public SkDiscardableMemory {
 public:
-    PoolDiscardableMemory(DiscardableMemoryPool* pool,
-                            void* pointer, size_t bytes);
+    PoolDiscardableMemory(DiscardableMemoryPool* pool, Slab* slab, int block, size_t bytes);
     virtual ~PoolDiscardableMemory();
     bool lock() override;
     void* data() override;
     void unlock() override;
     friend class DiscardableMemoryPool;
 private:
-    SK_DECLARE_INTERNAL_LLIST_INTERFACE(PoolDiscardableMemory);
+    // Locking and unlocking move between the first two states without the pool's mutex. Only
+    // the pool purges, and only unlocked memory, with its mutex held.
+    enum State {
+        kLocked_State,
+        kUnlocked_State,
+        kPurged_State,
+    };
+
     DiscardableMemoryPool* const fPool;
-    bool                         fLocked;
+    int32_t                      fState;    // Atomic.
     void*                        fPointer;
     const size_t                 fBytes;
+    Slab*                        fSlab;     // NULL once purged.
+    const int                    fBlock;
 };
 
 PoolDiscardableMemory::PoolDiscardableMemory(DiscardableMemoryPool* pool,
-                                             void* pointer,
+                                             Slab* slab, int block,
                                              size_t bytes)
     : fPool(pool)
-    , fLocked(true)
-    , fPointer(pointer)
-    , fBytes(bytes) {
+    , fState(kLocked_State)
+    , fPointer(slab->fMemory + block * slab->fBlockSize)
+    , fBytes(bytes)
+    , fSlab(slab)
+    , fBlock(block) {
     SkASSERT(fPool != NULL);
-    SkASSERT(fPointer != NULL);
     SkASSERT(fBytes > 0);
     fPool->ref();
 }
 
 PoolDiscardableMemory::~PoolDiscardableMemory() {
-    SkASSERT(!fLocked); // contract for SkDiscardableMemory
+    SkASSERT(kLocked_State != sk_atomic_load(&fState)); // contract for SkDiscardableMemory
     fPool->free(this);
     fPool->unref();
 }
 
 bool PoolDiscardableMemory::lock() {
-    SkASSERT(!fLocked); // contract for SkDiscardableMemory
+    SkASSERT(kLocked_State != sk_atomic_load(&fState)); // contract for SkDiscardableMemory
     return fPool->lock(this);
 }
 
 void* PoolDiscardableMemory::data() {
-    SkASSERT(fLocked); // contract for SkDiscardableMemory
+    SkASSERT(kLocked_State == sk_atomic_load(&fState)); // contract for SkDiscardableMemory
     return fPointer;
 }
 
 void PoolDiscardableMemory::unlock() {
-    SkASSERT(fLocked); // contract for SkDiscardableMemory
+    SkASSERT(kLocked_State == sk_atomic_load(&fState)); // contract for SkDiscardableMemory
     fPool->unlock(this);
 }
 
@@ -132,114 +207,251 @@ DiscardableMemoryPool::DiscardableMemoryPool(size_t budget,
                                              SkBaseMutex* mutex)
     : fMutex(mutex)
     , fBudget(budget)
-    , fUsed(0) {
-    #if SK_LAZY_CACHE_STATS
-    fCacheHits = 0;
-    fCacheMisses = 0;
-    #endif  // SK_LAZY_CACHE_STATS
+    , fUsed(0)
+    , fSlabBytes(0)
+    , fClock(0)
+    , fHits(0)
+    , fMisses(0)
+    , fPurges(0)
+    , fSlabsFreed(0) {
 }
 DiscardableMemoryPool::~DiscardableMemoryPool() {
     // PoolDiscardableMemory objects that belong to this pool are
     // always deleted before deleting this pool since each one has a
-    // ref to the pool.
-    SkASSERT(fList.isEmpty());
+    // ref to the pool, so only empty slabs are left.
+    while (!fSlabs.isEmpty()) {
+        this->freeSlab(fSlabs.top());
+    }
+}
+
+Slab* DiscardableMemoryPool::newSlab(size_t blockSize, int blockCount) {
+    char* memory = (char*)sk_malloc_flags(blockSize * blockCount, 0);
+    if (NULL == memory) {
+        return NULL;
+    }
+    Slab* slab = SkNEW(Slab);
+    slab->fMemory = memory;
+    slab->fBlockSize = blockSize;
+    slab->fBlockCount = blockCount;
+    slab->fLiveCount = 0;
+    slab->fBlocks.reset(blockCount);
+    // Hand out blocks from the start of the slab first.
+    for (int i = blockCount - 1; i >= 0; --i) {
+        slab->fBlocks[i] = NULL;
+        *slab->fFreeBlocks.append() = i;
+    }
+    slab->fLastUse = sk_atomic_inc(&fClock);
+
+    *fSlabs.append() = slab;
+    if (blockSize <= kMaxBlockSize) {
+        *fSlabsBySize[block_size_index(blockSize)].append() = slab;
+    }
+    sk_atomic_store(&fSlabBytes, fSlabBytes + blockSize * blockCount, sk_memory_order_relaxed);
+    return slab;
+}
+
+void DiscardableMemoryPool::freeSlab(Slab* slab) {
+    SkASSERT(0 == slab->fLiveCount);
+    fSlabs.removeShuffle(fSlabs.find(slab));
+    if (slab->fBlockSize <= kMaxBlockSize) {
+        SkTDArray<Slab*>& slabs = fSlabsBySize[block_size_index(slab->fBlockSize)];
+        slabs.removeShuffle(slabs.find(slab));
+    }
+    SkASSERT(fSlabBytes >= slab->fBlockSize * slab->fBlockCount);
+    sk_atomic_store(&fSlabBytes, fSlabBytes - slab->fBlockSize * slab->fBlockCount,
+                    sk_memory_order_relaxed);
+    fSlabsFreed++;
+    sk_free(slab->fMemory);
+    SkDELETE(slab);
+}
+
+// Returns a slab with a free block big enough for bytes.
+Slab* DiscardableMemoryPool::findSlab(size_t bytes) {
+    if (bytes > kMaxBlockSize) {
+        return this->newSlab(bytes, 1);
+    }
+    const size_t blockSize = block_size(bytes);
+    const SkTDArray<Slab*>& slabs = fSlabsBySize[block_size_index(blockSize)];
+    for (int i = slabs.count() - 1; i >= 0; --i) {
+        if (!slabs[i]->fFreeBlocks.isEmpty()) {
+            return slabs[i];
+        }
+    }
+    int blockCount = SkTMin(SkTMax((int)(kSlabSize / blockSize), kMinSlabBlocks), kMaxSlabBlocks);
+    blockCount = SkTMin(blockCount, SkTMax(1, (int)(fBudget / kBudgetPerSlab / blockSize)));
+    return this->newSlab(blockSize, blockCount);
+}
+
+// Gives dm's block back to its slab. If that leaves the slab empty, frees the slab, unless asked
+// to keep it, it is the only empty one of its block size, and the pool is within budget.
+void DiscardableMemoryPool::releaseBlock(PoolDiscardableMemory* dm, bool keepEmptySlab) {
+    if (fMutex != NULL) {
+        fMutex->assertHeld();
+    }
+    Slab* slab = dm->fSlab;
+    SkASSERT(slab && slab->fBlocks[dm->fBlock] == dm);
+    slab->fBlocks[dm->fBlock] = NULL;
+    *slab->fFreeBlocks.append() = dm->fBlock;
+    slab->fLiveCount--;
+    dm->fSlab = NULL;
+    SkASSERT(fUsed >= dm->fBytes);
+    sk_atomic_store(&fUsed, fUsed - dm->fBytes, sk_memory_order_relaxed);
+
+    if (0 == slab->fLiveCount) {
+        bool keep = keepEmptySlab && slab->fBlockSize <= kMaxBlockSize &&
+                    fSlabBytes <= fBudget;
+        if (keep) {
+            const SkTDArray<Slab*>& slabs = fSlabsBySize[block_size_index(slab->fBlockSize)];
+            for (int i = 0; i < slabs.count(); ++i) {
+                if (slabs[i] != slab && 0 == slabs[i]->fLiveCount) {
+                    keep = false;
+                    break;
+                }
+            }
+        }
+        if (!keep) {
+            this->freeSlab(slab);
+        }
+    }
+}
+
+struct LastUseLessThan {
+    bool operator()(const Slab* a, const Slab* b) const {
+        return sk_atomic_load(&a->fLastUse, sk_memory_order_relaxed) <
+               sk_atomic_load(&b->fLastUse, sk_memory_order_relaxed);
+    }
+};
+
+// Returns true if every block in use in slab is unlocked, so purging them would free the slab.
+// A block may still be locked before purgeSlab() gets to it, which only means the slab survives.
+bool DiscardableMemoryPool::AllUnlocked(const Slab* slab) {
+    for (int block = 0, live = slab->fLiveCount; live > 0; ++block) {
+        const PoolDiscardableMemory* dm = slab->fBlocks[block];
+        if (NULL == dm) {
+            continue;
+        }
+        --live;
+        if (PoolDiscardableMemory::kUnlocked_State !=
+                sk_atomic_load(&dm->fState, sk_memory_order_relaxed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DiscardableMemoryPool::purgeSlab(Slab* slab) {
+    // Once the slab's last block is released, the slab itself is freed.
+    for (int block = 0, live = slab->fLiveCount; live > 0; ++block) {
+        PoolDiscardableMemory* dm = slab->fBlocks[block];
+        if (NULL == dm) {
+            continue;
+        }
+        --live;
+        if (sk_atomic_cas(&dm->fState, PoolDiscardableMemory::kUnlocked_State,
+                          PoolDiscardableMemory::kPurged_State)) {
+            fPurges++;
+            this->releaseBlock(dm, false);
+        }
+    }
 }
 
 void DiscardableMemoryPool::dumpDownTo(size_t budget) {
     if (fMutex != NULL) {
         fMutex->assertHeld();
     }
-    if (fUsed <= budget) {
+    if (fSlabBytes <= budget) {
         return;
     }
-    typedef SkTInternalLList<PoolDiscardableMemory>::Iter Iter;
-    Iter iter;
-    PoolDiscardableMemory* cur = iter.init(fList, Iter::kTail_IterStart);
-    while ((fUsed > budget) && (cur)) {
-        if (!cur->fLocked) {
-            PoolDiscardableMemory* dm = cur;
-            SkASSERT(dm->fPointer != NULL);
-            sk_free(dm->fPointer);
-            dm->fPointer = NULL;
-            SkASSERT(fUsed >= dm->fBytes);
-            fUsed -= dm->fBytes;
-            cur = iter.prev();
-            // Purged DMs are taken out of the list.  This saves times
-            // looking them up.  Purged DMs are NOT deleted.
-            fList.remove(dm);
+    // Empty slabs kept for reuse go first, since freeing them costs nothing.
+    for (int i = fSlabs.count() - 1; i >= 0 && fSlabBytes > budget; --i) {
+        if (0 == fSlabs[i]->fLiveCount) {
+            this->freeSlab(fSlabs[i]);
+        }
+    }
+    // Then purge the least recently used slabs. Slabs whose blocks are all unlocked go first,
+    // since purging them gives their memory back to the system. If that isn't enough, purge the
+    // unlocked blocks of the others too: their memory is reused before any new slab is made, and
+    // each slab is freed once its last locked block is unlocked and purged.
+    SkTDArray<Slab*> slabs;
+    slabs.append(fSlabs.count(), fSlabs.begin());
+    if (slabs.count() > 1) {
+        LastUseLessThan lessThan;
+        SkTQSort(slabs.begin(), slabs.end() - 1, lessThan);
+    }
+    // purgeSlab() may free the slab, so take each one out of slabs as it's purged.
+    for (int i = 0; i < slabs.count() && fSlabBytes > budget; ) {
+        if (AllUnlocked(slabs[i])) {
+            this->purgeSlab(slabs[i]);
+            slabs.remove(i);
         } else {
-            cur = iter.prev();
+            ++i;
         }
     }
+    for (int i = 0; i < slabs.count() && fSlabBytes > budget; ++i) {
+        this->purgeSlab(slabs[i]);
+    }
 }
 
 SkDiscardableMemory* DiscardableMemoryPool::create(size_t bytes) {
-    void* addr = sk_malloc_flags(bytes, 0);
-    if (NULL == addr) {
+    if (0 == bytes) {
         return NULL;
     }
-    PoolDiscardableMemory* dm = SkNEW_ARGS(PoolDiscardableMemory,
-                                             (this, addr, bytes));
     SkAutoMutexAcquire autoMutexAcquire(fMutex);
-    fList.addToHead(dm);
-    fUsed += bytes;
+    Slab* slab = this->findSlab(bytes);
+    if (NULL == slab) {
+        return NULL;
+    }
+    const int block = slab->fFreeBlocks.top();
+    slab->fFreeBlocks.pop();
+    slab->fLiveCount++;
+    PoolDiscardableMemory* dm = SkNEW_ARGS(PoolDiscardableMemory,
+                                           (this, slab, block, bytes));
+    slab->fBlocks[block] = dm;
+    sk_atomic_store(&slab->fLastUse, sk_atomic_inc(&fClock), sk_memory_order_relaxed);
+    sk_atomic_store(&fUsed, fUsed + bytes, sk_memory_order_relaxed);
     this->dumpDownTo(fBudget);
     return dm;
 }
 
 void DiscardableMemoryPool::free(PoolDiscardableMemory* dm) {
     SkAutoMutexAcquire autoMutexAcquire(fMutex);
-    // This is called by dm's destructor.
-    if (dm->fPointer != NULL) {
-        sk_free(dm->fPointer);
-        dm->fPointer = NULL;
-        SkASSERT(fUsed >= dm->fBytes);
-        fUsed -= dm->fBytes;
-        fList.remove(dm);
-    } else {
-        SkASSERT(!fList.isInList(dm));
+    // This is called by dm's destructor. It may have been purged already.
+    if (sk_atomic_cas(&dm->fState, PoolDiscardableMemory::kUnlocked_State,
+                      PoolDiscardableMemory::kPurged_State)) {
+        this->releaseBlock(dm, true);
     }
 }
 
 bool DiscardableMemoryPool::lock(PoolDiscardableMemory* dm) {
     SkASSERT(dm != NULL);
-    if (NULL == dm->fPointer) {
-        #if SK_LAZY_CACHE_STATS
-        SkAutoMutexAcquire autoMutexAcquire(fMutex);
-        ++fCacheMisses;
-        #endif  // SK_LAZY_CACHE_STATS
-        return false;
-    }
-    SkAutoMutexAcquire autoMutexAcquire(fMutex);
-    if (NULL == dm->fPointer) {
-        // May have been purged while waiting for lock.
-        #if SK_LAZY_CACHE_STATS
-        ++fCacheMisses;
-        #endif  // SK_LAZY_CACHE_STATS
+    if (!sk_atomic_cas(&dm->fState, PoolDiscardableMemory::kUnlocked_State,
+                       PoolDiscardableMemory::kLocked_State)) {
+        sk_atomic_inc(&fMisses);
         return false;
     }
-    dm->fLocked = true;
-    fList.remove(dm);
-    fList.addToHead(dm);
-    #if SK_LAZY_CACHE_STATS
-    ++fCacheHits;
-    #endif  // SK_LAZY_CACHE_STATS
+    // Now that it is locked, dm can't be purged, so its slab can't be freed.
+    sk_atomic_store(&dm->fSlab->fLastUse, sk_atomic_inc(&fClock), sk_memory_order_relaxed);
+    sk_atomic_inc(&fHits);
     return true;
 }
 
 void DiscardableMemoryPool::unlock(PoolDiscardableMemory* dm) {
     SkASSERT(dm != NULL);
-    SkAutoMutexAcquire autoMutexAcquire(fMutex);
-    dm->fLocked = false;
-    this->dumpDownTo(fBudget);
+    sk_atomic_store(&dm->fState, (int32_t)PoolDiscardableMemory::kUnlocked_State,
+                    sk_memory_order_release);
+    if (sk_atomic_load(&fSlabBytes, sk_memory_order_relaxed) >
+        sk_atomic_load(&fBudget, sk_memory_order_relaxed)) {
+        SkAutoMutexAcquire autoMutexAcquire(fMutex);
+        this->dumpDownTo(fBudget);
+    }
 }
 
 size_t DiscardableMemoryPool::getRAMUsed() {
-    return fUsed;
+    return sk_atomic_load(&fUsed, sk_memory_order_relaxed);
 }
 void DiscardableMemoryPool::setRAMBudget(size_t budget) {
     SkAutoMutexAcquire autoMutexAcquire(fMutex);
-    fBudget = budget;
+    sk_atomic_store(&fBudget, budget, sk_memory_order_relaxed);
     this->dumpDownTo(fBudget);
 }
 void DiscardableMemoryPool::dumpPool() {
@@ -247,6 +459,16 @@ void DiscardableMemoryPool::dumpPool() {
     this->dumpDownTo(0);
 }
 
+void DiscardableMemoryPool::getStats(Stats* stats) {
+    SkAutoMutexAcquire autoMutexAcquire(fMutex);
+    stats->fHits = sk_atomic_load(&fHits);
+    stats->fMisses = sk_atomic_load(&fMisses);
+    stats->fPurges = fPurges;
+    stats->fSlabsFreed = fSlabsFreed;
+    stats->fUsedBytes = fUsed;
+    stats->fSlabBytes = fSlabBytes;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 SK_DECLARE_STATIC_MUTEX(gMutex);
 SkDiscardableMemoryPool* create_global_pool() {
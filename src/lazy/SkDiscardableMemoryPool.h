@@ -24,6 +24,14 @@
  *  budget of memory.  When the allocated memory exceeds this size,
  *  unlocked blocks of memory are purged.  If all memory is locked, it
  *  can exceed the memory-use budget.
+ *
+ *  Allocations are carved out of slabs of same-sized blocks, and the
+ *  budget applies to the memory held in slabs (Stats::fSlabBytes),
+ *  not just the bytes asked for.  The least recently used slabs whose
+ *  blocks are all unlocked are purged whole first, then the unlocked
+ *  blocks of the least recently used slabs that also hold locked ones.
+ *  lock() and unlock() only take the pool's mutex when unlocking needs
+ *  to purge.
  */
 class SkDiscardableMemoryPool : public SkDiscardableMemory::Factory {
 public:
@@ -47,6 +55,17 @@ public:
     virtual void resetCacheHitsAndMisses() = 0;
     #endif
 
+    struct Stats {
+        int     fHits;          // Successful calls to lock().
+        int     fMisses;        // Calls to lock() that found the memory purged.
+        int     fPurges;        // Allocations purged, to stay in budget or by dumpPool().
+        int     fSlabsFreed;    // Slabs given back to the system.
+        size_t  fUsedBytes;     // Same as getRAMUsed().
+        size_t  fSlabBytes;     // Memory held in slabs. The difference from fUsedBytes
+                                // is lost to fragmentation and rounding up to block sizes.
+    };
+    virtual void getStats(Stats*) = 0;
+
     /**
      *  This non-global pool can be used for unit tests to verify that
      *  the pool works.
@@ -0,0 +1,495 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmapProcState_opts_AVX2.h"
+#include "SkBitmapProcState_utils.h"
+#include "SkPerspIter.h"
+
+/* As with SSSE3, compilers that can't build AVX2 intrinsics get stubs, which should never be
+ * called because the caller checks for AVX2 support at runtime before choosing these procs.
+ */
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+#include <immintrin.h>
+
+namespace {
+
+// The packing done by PACK_FILTER_X_NAME and PACK_FILTER_Y_NAME for ClampX_ClampY:
+//     ((clamp(f >> 16) << 4 | (f >> 12) & 0xF) << 14) | clamp((f + one) >> 16)
+inline uint32_t pack_clamp_filter(SkFixed f, unsigned max, SkFixed one) {
+    unsigned i = SkClampMax(f >> 16, max);
+    i = (i << 4) | ((f >> 12) & 0xF);
+    return (i << 14) | SkClampMax((f + one) >> 16, max);
+}
+
+// The same, for 8 coordinates at once.  max and one may differ per lane.
+inline __m256i pack_clamp_filter(__m256i f, __m256i max, __m256i one) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i i = _mm256_min_epi32(_mm256_max_epi32(_mm256_srai_epi32(f, 16), zero), max);
+    __m256i j = _mm256_srai_epi32(_mm256_add_epi32(f, one), 16);
+    j = _mm256_min_epi32(_mm256_max_epi32(j, zero), max);
+
+    __m256i lowBits = _mm256_and_si256(_mm256_srli_epi32(f, 12), _mm256_set1_epi32(0xF));
+    i = _mm256_or_si256(_mm256_slli_epi32(i, 4), lowBits);
+    return _mm256_or_si256(_mm256_slli_epi32(i, 14), j);
+}
+
+// Truncates the 32.32 fixed point values in lo (pixels 0-3) and hi (pixels 4-7) to 16.16.
+inline __m256i fractional_to_fixed(__m256i lo, __m256i hi) {
+    // Only the low 32 bits of each shifted value are kept, so a logical shift will do.
+    lo = _mm256_shuffle_epi32(_mm256_srli_epi64(lo, 16), _MM_SHUFFLE(2, 0, 2, 0));
+    hi = _mm256_shuffle_epi32(_mm256_srli_epi64(hi, 16), _MM_SHUFFLE(2, 0, 2, 0));
+    // Pixels 0 1 4 5 | 2 3 6 7, then put back in order.
+    __m256i fixed = _mm256_blend_epi32(lo, hi, 0xCC);
+    return _mm256_permute4x64_epi64(fixed, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+// Splits a packed filter coordinate (i0:14 | sub:4 | i1:14) into its parts.
+inline void unpack_filter(__m256i packed, __m256i* i0, __m256i* i1, __m256i* sub) {
+    *i0 = _mm256_srli_epi32(packed, 18);
+    *i1 = _mm256_and_si256(packed, _mm256_set1_epi32(0x3FFF));
+    *sub = _mm256_and_si256(_mm256_srli_epi32(packed, 14), _mm256_set1_epi32(0xF));
+}
+
+// Filter_32_opaque and Filter_32_alpha, for 8 pixels, as
+//     (a00 * (16 - x) + a01 * x) * (16 - y) + (a10 * (16 - x) + a11 * x) * y
+// which expands to exactly their weighted sum.  Every term fits in 16 bits.
+//
+// The top and bottom pixel pairs come in with a00 and a01 (or a10 and a11) interleaved byte by
+// byte, pixels 0 1 4 5 in the *Lo vectors and 2 3 6 7 in the *Hi vectors, the order that
+// _mm256_unpack{lo,hi}_epi8 leaves them in.
+template <bool hasAlpha>
+inline __m256i filter_8(__m256i topLo, __m256i topHi, __m256i botLo, __m256i botHi,
+                        __m256i subX, __m256i subY, __m256i alphaScale) {
+    // Each pixel's x weights as a byte pair (16 - x, x), copied across its four channels.
+    __m256i wx = _mm256_or_si256(_mm256_sub_epi32(_mm256_set1_epi32(16), subX),
+                                 _mm256_slli_epi32(subX, 8));
+    wx = _mm256_or_si256(wx, _mm256_slli_epi32(wx, 16));
+    const __m256i wxLo = _mm256_unpacklo_epi32(wx, wx);
+    const __m256i wxHi = _mm256_unpackhi_epi32(wx, wx);
+
+    // The y weights, as 16-bit values.
+    __m256i wy1 = _mm256_or_si256(subY, _mm256_slli_epi32(subY, 16));
+    __m256i wy0 = _mm256_sub_epi16(_mm256_set1_epi16(16), wy1);
+    const __m256i wy0Lo = _mm256_unpacklo_epi32(wy0, wy0);
+    const __m256i wy0Hi = _mm256_unpackhi_epi32(wy0, wy0);
+    const __m256i wy1Lo = _mm256_unpacklo_epi32(wy1, wy1);
+    const __m256i wy1Hi = _mm256_unpackhi_epi32(wy1, wy1);
+
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_maddubs_epi16(topLo, wxLo), wy0Lo),
+                                  _mm256_mullo_epi16(_mm256_maddubs_epi16(botLo, wxLo), wy1Lo));
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_maddubs_epi16(topHi, wxHi), wy0Hi),
+                                  _mm256_mullo_epi16(_mm256_maddubs_epi16(botHi, wxHi), wy1Hi));
+
+    lo = _mm256_srli_epi16(lo, 8);
+    hi = _mm256_srli_epi16(hi, 8);
+    if (hasAlpha) {
+        lo = _mm256_srli_epi16(_mm256_mullo_epi16(lo, alphaScale), 8);
+        hi = _mm256_srli_epi16(_mm256_mullo_epi16(hi, alphaScale), 8);
+    }
+    return _mm256_packus_epi16(lo, hi);
+}
+
+// As above, from the four corner pixels of each of 8 pixels, in order.
+template <bool hasAlpha>
+inline __m256i filter_corners_8(__m256i a00, __m256i a01, __m256i a10, __m256i a11,
+                        __m256i subX, __m256i subY, __m256i alphaScale) {
+    return filter_8<hasAlpha>(_mm256_unpacklo_epi8(a00, a01), _mm256_unpackhi_epi8(a00, a01),
+                              _mm256_unpacklo_epi8(a10, a11), _mm256_unpackhi_epi8(a10, a11),
+                              subX, subY, alphaScale);
+}
+
+// Gathers 8 pairs of neighboring pixels, base[offset] and the pixel after it, where each offset
+// is in units of kScale bytes.  The pairs come back byte-interleaved and split between lo and hi
+// the way filter_8() wants them.
+template <int kScale>
+inline void gather_pairs(const int* base, __m256i offset, __m256i* lo, __m256i* hi) {
+    const long long* pairs = reinterpret_cast<const long long*>(base);
+    offset = _mm256_permutevar8x32_epi32(offset, _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7));
+    *lo = _mm256_i32gather_epi64(pairs, _mm256_castsi256_si128(offset), kScale);
+    *hi = _mm256_i32gather_epi64(pairs, _mm256_extracti128_si256(offset, 1), kScale);
+    const __m256i interleave = _mm256_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7,
+                                                8, 12, 9, 13, 10, 14, 11, 15,
+                                                0, 4, 1, 5, 2, 6, 3, 7,
+                                                8, 12, 9, 13, 10, 14, 11, 15);
+    *lo = _mm256_shuffle_epi8(*lo, interleave);
+    *hi = _mm256_shuffle_epi8(*hi, interleave);
+}
+
+// Filters 8 pixels between rows row0 and row1, from 8 packed x coordinates.
+template <bool hasAlpha>
+inline __m256i filter_DX_8(const int* row0, const int* row1, __m256i xx,
+                           __m256i subY, __m256i alphaScale) {
+    __m256i x0, x1, subX;
+    unpack_filter(xx, &x0, &x1, &subX);
+
+    // Away from the right edge, x1 is always x0 + 1, so each pixel's pair can be read at once.
+    const __m256i next = _mm256_add_epi32(x0, _mm256_set1_epi32(1));
+    if (-1 == _mm256_movemask_epi8(_mm256_cmpeq_epi32(x1, next))) {
+        __m256i topLo, topHi, botLo, botHi;
+        gather_pairs<4>(row0, x0, &topLo, &topHi);
+        gather_pairs<4>(row1, x0, &botLo, &botHi);
+        return filter_8<hasAlpha>(topLo, topHi, botLo, botHi, subX, subY, alphaScale);
+    }
+    return filter_corners_8<hasAlpha>(_mm256_i32gather_epi32(row0, x0, 4),
+                                      _mm256_i32gather_epi32(row0, x1, 4),
+                                      _mm256_i32gather_epi32(row1, x0, 4),
+                                      _mm256_i32gather_epi32(row1, x1, 4),
+                                      subX, subY, alphaScale);
+}
+
+template <bool hasAlpha>
+void S32_generic_D32_filter_DX_AVX2(const SkBitmapProcState& s,
+                                    const uint32_t* xy,
+                                    int count, uint32_t* colors) {
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(s.fFilterLevel != kNone_SkFilterQuality);
+    SkASSERT(kN32_SkColorType == s.fBitmap->colorType());
+    if (hasAlpha) {
+        SkASSERT(s.fAlphaScale < 256);
+    } else {
+        SkASSERT(s.fAlphaScale == 256);
+    }
+
+    const char* srcAddr = static_cast<const char*>(s.fBitmap->getPixels());
+    size_t rb = s.fBitmap->rowBytes();
+    uint32_t XY = *xy++;
+    unsigned y0 = XY >> 14;
+    const int* row0 = reinterpret_cast<const int*>(srcAddr + (y0 >> 4) * rb);
+    const int* row1 = reinterpret_cast<const int*>(srcAddr + (XY & 0x3FFF) * rb);
+    const __m256i subY = _mm256_set1_epi32(y0 & 0xF);
+    const __m256i alphaScale = _mm256_set1_epi16(s.fAlphaScale);
+
+    while (count >= 8) {
+        __m256i xx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xy));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors),
+                            filter_DX_8<hasAlpha>(row0, row1, xx, subY, alphaScale));
+        xy += 8;
+        colors += 8;
+        count -= 8;
+    }
+    if (count > 0) {
+        // Pad the last few coordinates out with zeros, which are always in bounds.
+        uint32_t tmpXY[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+        uint32_t tmpColors[8];
+        memcpy(tmpXY, xy, count * sizeof(uint32_t));
+        __m256i xx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tmpXY));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmpColors),
+                            filter_DX_8<hasAlpha>(row0, row1, xx, subY, alphaScale));
+        memcpy(colors, tmpColors, count * sizeof(uint32_t));
+    }
+}
+
+// Filters 8 pixels from 8 packed (y, x) coordinate pairs.  Gathers from srcAddr by byte offset,
+// so the bitmap must be smaller than 2GB.
+template <bool hasAlpha>
+inline __m256i filter_DXDY_8(const int* srcAddr, __m256i rb, const uint32_t* xy,
+                             __m256i alphaScale) {
+    // Y0 X0 Y1 X1 Y2 X2 Y3 X3 -> Y0 Y1 Y2 Y3 X0 X1 X2 X3, then split into Ys and Xs.
+    const __m256i deinterleave = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xy));
+    __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xy + 8));
+    v0 = _mm256_permutevar8x32_epi32(v0, deinterleave);
+    v1 = _mm256_permutevar8x32_epi32(v1, deinterleave);
+    __m256i yy = _mm256_permute2x128_si256(v0, v1, 0x20);
+    __m256i xx = _mm256_permute2x128_si256(v0, v1, 0x31);
+
+    __m256i y0, y1, subY, x0, x1, subX;
+    unpack_filter(yy, &y0, &y1, &subY);
+    unpack_filter(xx, &x0, &x1, &subX);
+    y0 = _mm256_mullo_epi32(y0, rb);
+    y1 = _mm256_mullo_epi32(y1, rb);
+
+    // As in filter_DX_8(), read each row's pixel pairs at once away from the right edge.
+    const __m256i next = _mm256_add_epi32(x0, _mm256_set1_epi32(1));
+    x0 = _mm256_slli_epi32(x0, 2);
+    if (-1 == _mm256_movemask_epi8(_mm256_cmpeq_epi32(x1, next))) {
+        __m256i topLo, topHi, botLo, botHi;
+        gather_pairs<1>(srcAddr, _mm256_add_epi32(y0, x0), &topLo, &topHi);
+        gather_pairs<1>(srcAddr, _mm256_add_epi32(y1, x0), &botLo, &botHi);
+        return filter_8<hasAlpha>(topLo, topHi, botLo, botHi, subX, subY, alphaScale);
+    }
+    x1 = _mm256_slli_epi32(x1, 2);
+
+    return filter_corners_8<hasAlpha>(
+            _mm256_i32gather_epi32(srcAddr, _mm256_add_epi32(y0, x0), 1),
+            _mm256_i32gather_epi32(srcAddr, _mm256_add_epi32(y0, x1), 1),
+            _mm256_i32gather_epi32(srcAddr, _mm256_add_epi32(y1, x0), 1),
+            _mm256_i32gather_epi32(srcAddr, _mm256_add_epi32(y1, x1), 1),
+            subX, subY, alphaScale);
+}
+
+template <bool hasAlpha>
+void S32_generic_D32_filter_DXDY_AVX2(const SkBitmapProcState& s,
+                                      const uint32_t* xy,
+                                      int count, uint32_t* colors) {
+    SkASSERT(count > 0 && colors != NULL);
+    SkASSERT(s.fFilterLevel != kNone_SkFilterQuality);
+    SkASSERT(kN32_SkColorType == s.fBitmap->colorType());
+    SkASSERT(s.fBitmap->getSize() <= SK_MaxS32);
+    if (hasAlpha) {
+        SkASSERT(s.fAlphaScale < 256);
+    } else {
+        SkASSERT(s.fAlphaScale == 256);
+    }
+
+    const int* srcAddr = static_cast<const int*>(s.fBitmap->getPixels());
+    const __m256i rb = _mm256_set1_epi32(SkToS32(s.fBitmap->rowBytes()));
+    const __m256i alphaScale = _mm256_set1_epi16(s.fAlphaScale);
+
+    while (count >= 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors),
+                            filter_DXDY_8<hasAlpha>(srcAddr, rb, xy, alphaScale));
+        xy += 16;
+        colors += 8;
+        count -= 8;
+    }
+    if (count > 0) {
+        uint32_t tmpXY[16];
+        uint32_t tmpColors[8];
+        memset(tmpXY, 0, sizeof(tmpXY));
+        memcpy(tmpXY, xy, 2 * count * sizeof(uint32_t));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmpColors),
+                            filter_DXDY_8<hasAlpha>(srcAddr, rb, tmpXY, alphaScale));
+        memcpy(colors, tmpColors, count * sizeof(uint32_t));
+    }
+}
+
+}  // namespace
+
+void ClampX_ClampY_filter_scale_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                     int count, int x, int y) {
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask)) == 0);
+    SkASSERT(s.fInvKy == 0);
+
+    const unsigned maxX = s.fBitmap->width() - 1;
+    const SkFixed one = s.fFilterOneX;
+    const SkFractionalInt dx = s.fInvSxFractionalInt;
+    SkFractionalInt fx;
+
+    {
+        SkPoint pt;
+        s.fInvProc(s.fInvMatrix, SkIntToScalar(x) + SK_ScalarHalf,
+                                 SkIntToScalar(y) + SK_ScalarHalf, &pt);
+        const SkFixed fy = SkScalarToFixed(pt.fY) - (s.fFilterOneY >> 1);
+        const unsigned maxY = s.fBitmap->height() - 1;
+        *xy++ = pack_clamp_filter(fy, maxY, s.fFilterOneY);
+        fx = SkScalarToFractionalInt(pt.fX) - (SkFixedToFractionalInt(one) >> 1);
+    }
+
+    const __m256i maxV = _mm256_set1_epi32(maxX);
+    const __m256i oneV = _mm256_set1_epi32(one);
+
+    if (can_truncate_to_fixed_for_decal(fx, dx, count, maxX)) {
+        // Like decal_filter_scale(), step in 16.16.  Nothing needs clamping here, but
+        // pack_clamp_filter() packs in-range values the same way decal_filter_scale() does.
+        const SkFixed fixedFx = SkFractionalIntToFixed(fx);
+        const SkFixed fixedDx = SkFractionalIntToFixed(dx);
+        const __m256i steps = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        __m256i fxV = _mm256_add_epi32(_mm256_set1_epi32(fixedFx),
+                                       _mm256_mullo_epi32(steps, _mm256_set1_epi32(fixedDx)));
+        const __m256i dx8 = _mm256_set1_epi32(fixedDx * 8);
+        while (count >= 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(xy),
+                                pack_clamp_filter(fxV, maxV, oneV));
+            fxV = _mm256_add_epi32(fxV, dx8);
+            xy += 8;
+            count -= 8;
+        }
+        if (count > 0) {
+            uint32_t tmp[8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmp),
+                                pack_clamp_filter(fxV, maxV, oneV));
+            memcpy(xy, tmp, count * sizeof(uint32_t));
+        }
+        return;
+    }
+
+    // Otherwise step fx in 32.32 like the portable proc, so the truncated 16.16 values match.
+    __m256i fxLo = _mm256_setr_epi64x(fx, fx + dx, fx + 2 * dx, fx + 3 * dx);
+    __m256i fxHi = _mm256_add_epi64(fxLo, _mm256_set1_epi64x(4 * dx));
+    const __m256i dx8 = _mm256_set1_epi64x(8 * dx);
+
+    while (count >= 8) {
+        __m256i packed = pack_clamp_filter(fractional_to_fixed(fxLo, fxHi), maxV, oneV);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(xy), packed);
+        fxLo = _mm256_add_epi64(fxLo, dx8);
+        fxHi = _mm256_add_epi64(fxHi, dx8);
+        xy += 8;
+        count -= 8;
+    }
+    if (count > 0) {
+        uint32_t tmp[8];
+        __m256i packed = pack_clamp_filter(fractional_to_fixed(fxLo, fxHi), maxV, oneV);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmp), packed);
+        memcpy(xy, tmp, count * sizeof(uint32_t));
+    }
+}
+
+// Interleaves 8 packed y and 8 packed x values into 16 (y, x) pairs.
+static inline void store_yx_pairs(uint32_t xy[], __m256i y, __m256i x) {
+    __m256i lo = _mm256_unpacklo_epi32(y, x);   // pairs 0 1 | 4 5
+    __m256i hi = _mm256_unpackhi_epi32(y, x);   // pairs 2 3 | 6 7
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(xy),
+                        _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(xy + 8),
+                        _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+void ClampX_ClampY_filter_affine_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                      int count, int x, int y) {
+    SkASSERT(s.fInvType & SkMatrix::kAffine_Mask);
+    SkASSERT((s.fInvType & ~(SkMatrix::kTranslate_Mask |
+                             SkMatrix::kScale_Mask |
+                             SkMatrix::kAffine_Mask)) == 0);
+
+    SkPoint srcPt;
+    s.fInvProc(s.fInvMatrix,
+               SkIntToScalar(x) + SK_ScalarHalf,
+               SkIntToScalar(y) + SK_ScalarHalf, &srcPt);
+
+    SkFixed oneX = s.fFilterOneX;
+    SkFixed oneY = s.fFilterOneY;
+    SkFixed fx = SkScalarToFixed(srcPt.fX) - (oneX >> 1);
+    SkFixed fy = SkScalarToFixed(srcPt.fY) - (oneY >> 1);
+    SkFixed dx = s.fInvSx;
+    SkFixed dy = s.fInvKy;
+    unsigned maxX = s.fBitmap->width() - 1;
+    unsigned maxY = s.fBitmap->height() - 1;
+
+    // Lane i holds fx + i*dx and fy + i*dy, wrapping just as the portable proc's sums do.
+    const __m256i steps = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i fxV = _mm256_add_epi32(_mm256_set1_epi32(fx),
+                                   _mm256_mullo_epi32(steps, _mm256_set1_epi32(dx)));
+    __m256i fyV = _mm256_add_epi32(_mm256_set1_epi32(fy),
+                                   _mm256_mullo_epi32(steps, _mm256_set1_epi32(dy)));
+    const __m256i dx8 = _mm256_set1_epi32((int32_t)((uint32_t)dx << 3));
+    const __m256i dy8 = _mm256_set1_epi32((int32_t)((uint32_t)dy << 3));
+    const __m256i maxXV = _mm256_set1_epi32(maxX), maxYV = _mm256_set1_epi32(maxY);
+    const __m256i oneXV = _mm256_set1_epi32(oneX), oneYV = _mm256_set1_epi32(oneY);
+
+    while (count >= 8) {
+        store_yx_pairs(xy, pack_clamp_filter(fyV, maxYV, oneYV),
+                           pack_clamp_filter(fxV, maxXV, oneXV));
+        fxV = _mm256_add_epi32(fxV, dx8);
+        fyV = _mm256_add_epi32(fyV, dy8);
+        xy += 16;
+        count -= 8;
+    }
+    if (count > 0) {
+        uint32_t tmp[16];
+        store_yx_pairs(tmp, pack_clamp_filter(fyV, maxYV, oneYV),
+                            pack_clamp_filter(fxV, maxXV, oneXV));
+        memcpy(xy, tmp, 2 * count * sizeof(uint32_t));
+    }
+}
+
+void ClampX_ClampY_filter_persp_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                     int count, int x, int y) {
+    SkASSERT(s.fInvType & SkMatrix::kPerspective_Mask);
+
+    unsigned maxX = s.fBitmap->width() - 1;
+    unsigned maxY = s.fBitmap->height() - 1;
+    SkFixed oneX = s.fFilterOneX;
+    SkFixed oneY = s.fFilterOneY;
+
+    // SkPerspIter hands back (x, y) pairs, so these are interleaved the same way.
+    const __m256i half = _mm256_setr_epi32(oneX >> 1, oneY >> 1, oneX >> 1, oneY >> 1,
+                                           oneX >> 1, oneY >> 1, oneX >> 1, oneY >> 1);
+    const __m256i maxV = _mm256_setr_epi32(maxX, maxY, maxX, maxY, maxX, maxY, maxX, maxY);
+    const __m256i oneV = _mm256_setr_epi32(oneX, oneY, oneX, oneY, oneX, oneY, oneX, oneY);
+
+    SkPerspIter iter(s.fInvMatrix,
+                     SkIntToScalar(x) + SK_ScalarHalf,
+                     SkIntToScalar(y) + SK_ScalarHalf, count);
+
+    while ((count = iter.next()) != 0) {
+        const SkFixed* srcXY = iter.getXY();
+        for (; count >= 4; count -= 4) {
+            __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(srcXY));
+            __m256i packed = pack_clamp_filter(_mm256_sub_epi32(f, half), maxV, oneV);
+            // Swap each (x, y) pair into the (y, x) order the sample procs expect.
+            packed = _mm256_shuffle_epi32(packed, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(xy), packed);
+            srcXY += 8;
+            xy += 8;
+        }
+        for (; count > 0; --count) {
+            *xy++ = pack_clamp_filter(srcXY[1] - (oneY >> 1), maxY, oneY);
+            *xy++ = pack_clamp_filter(srcXY[0] - (oneX >> 1), maxX, oneX);
+            srcXY += 2;
+        }
+    }
+}
+
+void S32_opaque_D32_filter_DX_AVX2(const SkBitmapProcState& s,
+                                   const uint32_t* xy,
+                                   int count, uint32_t* colors) {
+    S32_generic_D32_filter_DX_AVX2<false>(s, xy, count, colors);
+}
+
+void S32_alpha_D32_filter_DX_AVX2(const SkBitmapProcState& s,
+                                  const uint32_t* xy,
+                                  int count, uint32_t* colors) {
+    S32_generic_D32_filter_DX_AVX2<true>(s, xy, count, colors);
+}
+
+void S32_opaque_D32_filter_DXDY_AVX2(const SkBitmapProcState& s,
+                                     const uint32_t* xy,
+                                     int count, uint32_t* colors) {
+    S32_generic_D32_filter_DXDY_AVX2<false>(s, xy, count, colors);
+}
+
+void S32_alpha_D32_filter_DXDY_AVX2(const SkBitmapProcState& s,
+                                    const uint32_t* xy,
+                                    int count, uint32_t* colors) {
+    S32_generic_D32_filter_DXDY_AVX2<true>(s, xy, count, colors);
+}
+
+#else // SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_AVX2
+
+void ClampX_ClampY_filter_scale_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                     int count, int x, int y) {
+    sk_throw();
+}
+
+void ClampX_ClampY_filter_affine_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                      int count, int x, int y) {
+    sk_throw();
+}
+
+void ClampX_ClampY_filter_persp_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                     int count, int x, int y) {
+    sk_throw();
+}
+
+void S32_opaque_D32_filter_DX_AVX2(const SkBitmapProcState& s,
+                                   const uint32_t* xy,
+                                   int count, uint32_t* colors) {
+    sk_throw();
+}
+
+void S32_alpha_D32_filter_DX_AVX2(const SkBitmapProcState& s,
+                                  const uint32_t* xy,
+                                  int count, uint32_t* colors) {
+    sk_throw();
+}
+
+void S32_opaque_D32_filter_DXDY_AVX2(const SkBitmapProcState& s,
+                                     const uint32_t* xy,
+                                     int count, uint32_t* colors) {
+    sk_throw();
+}
+
+void S32_alpha_D32_filter_DXDY_AVX2(const SkBitmapProcState& s,
+                                    const uint32_t* xy,
+                                    int count, uint32_t* colors) {
+    sk_throw();
+}
+
+#endif
@@ -0,0 +1,36 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkBitmapProcState_opts_AVX2_DEFINED
+#define SkBitmapProcState_opts_AVX2_DEFINED
+
+#include "SkBitmapProcState.h"
+
+// Bilinear matrix and sample procs for clamped 32-bit sources, 8 pixels at a time.
+// Their output matches the portable procs they replace bit for bit.
+
+void ClampX_ClampY_filter_scale_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                     int count, int x, int y);
+void ClampX_ClampY_filter_affine_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                      int count, int x, int y);
+void ClampX_ClampY_filter_persp_AVX2(const SkBitmapProcState& s, uint32_t xy[],
+                                     int count, int x, int y);
+
+void S32_opaque_D32_filter_DX_AVX2(const SkBitmapProcState& s,
+                                   const uint32_t* xy,
+                                   int count, uint32_t* colors);
+void S32_alpha_D32_filter_DX_AVX2(const SkBitmapProcState& s,
+                                  const uint32_t* xy,
+                                  int count, uint32_t* colors);
+void S32_opaque_D32_filter_DXDY_AVX2(const SkBitmapProcState& s,
+                                     const uint32_t* xy,
+                                     int count, uint32_t* colors);
+void S32_alpha_D32_filter_DXDY_AVX2(const SkBitmapProcState& s,
+                                    const uint32_t* xy,
+                                    int count, uint32_t* colors);
+
+#endif
@@ -21,6 +21,11 @@ inline SkPMFloat::SkPMFloat(SkPMColor c) {
     SkASSERT(this->isValid());
 }
 
+inline Sk4f SkPMFloat::alphas() const {
+    const int kA = SK_A32_SHIFT / 8;
+    return _mm_shuffle_ps(fVec, fVec, _MM_SHUFFLE(kA, kA, kA, kA));
+}
+
 inline SkPMColor SkPMFloat::round() const {
     return this->roundClamp();  // Haven't beaten this yet.
 }
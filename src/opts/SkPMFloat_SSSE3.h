@@ -31,6 +31,11 @@ inline SkPMColor SkPMFloat::trunc() const {
     return c;
 }
 
+inline Sk4f SkPMFloat::alphas() const {
+    const int kA = SK_A32_SHIFT / 8;
+    return _mm_shuffle_ps(fVec, fVec, _MM_SHUFFLE(kA, kA, kA, kA));
+}
+
 inline SkPMColor SkPMFloat::round() const {
     return SkPMFloat(Sk4f(0.5f) + *this).trunc();
 }
@@ -21,6 +21,10 @@ inline SkPMFloat::SkPMFloat(SkPMColor c) {
     SkASSERT(this->isValid());
 }
 
+inline Sk4f SkPMFloat::alphas() const {
+    return vdupq_n_f32(vgetq_lane_f32(fVec, SK_A32_SHIFT / 8));
+}
+
 inline SkPMColor SkPMFloat::trunc() const {
     uint32x4_t  fix8_32  = vcvtq_u32_f32(fVec);  // vcvtq_u32_f32 truncates
     uint16x4_t  fix8_16  = vmovn_u32(fix8_32);
@@ -13,6 +13,10 @@ inline SkPMFloat::SkPMFloat(SkPMColor c) {
     SkASSERT(this->isValid());
 }
 
+inline Sk4f SkPMFloat::alphas() const {
+    return Sk4f(this->a());
+}
+
 inline SkPMColor SkPMFloat::trunc() const {
     return SkPackARGB32(this->a(), this->r(), this->g(), this->b());
 }
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkTextureCompression_opts_SSE2.h"
+#include "SkTextureCompressor.h"
+
+#include <emmintrin.h>
+
+// The portable LATC and R11 EAC encoders already work on a row of four alpha values at a time,
+// as bytes in a uint32_t. The same arithmetic on 32-bit lanes handles a row of four blocks at
+// once, and the 64-bit packing of each block's indices is done two blocks to a register.
+// Every step matches the portable code, so the output is identical.
+
+static inline __m128i set1_64(uint64_t x) {
+    return _mm_set_epi32((int)(x >> 32), (int)x, (int)(x >> 32), (int)x);
+}
+
+static inline __m128i set1_32(uint32_t x) {
+    return _mm_set1_epi32((int)x);
+}
+
+// See SkTextureCompressor::MultibyteDiv3().
+static inline __m128i multibyte_div3(const __m128i& x) {
+    const __m128i k03 = set1_32(0x03030303),
+                  k0F = set1_32(0x0F0F0F0F),
+                  k3F = set1_32(0x3F3F3F3F);
+
+    const __m128i a  = _mm_and_si128(_mm_srli_epi32(x, 2), k3F);
+    const __m128i ar = _mm_slli_epi32(_mm_and_si128(x, k03), 4);
+    const __m128i b  = _mm_and_si128(_mm_srli_epi32(x, 4), k0F);
+    const __m128i br = _mm_slli_epi32(_mm_and_si128(x, k0F), 2);
+    const __m128i c  = _mm_and_si128(_mm_srli_epi32(x, 6), k03);
+    const __m128i cr = _mm_and_si128(x, k3F);
+
+    const __m128i r = _mm_and_si128(
+            _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(ar, br), cr), 6), k03);
+    return _mm_add_epi32(_mm_add_epi32(a, b), _mm_add_epi32(c, r));
+}
+
+// See SkTextureCompressor::ConvertToThreeBitIndex().
+static inline __m128i convert_to_three_bit_index(__m128i x) {
+    const __m128i k7F = set1_32(0x7F7F7F7F);
+    x = _mm_and_si128(_mm_srli_epi32(x, 1), k7F);
+    x = _mm_add_epi32(x, set1_32(0x09090909));
+    x = _mm_and_si128(_mm_srli_epi32(x, 1), k7F);
+    x = multibyte_div3(x);
+    return multibyte_div3(x);
+}
+
+static inline __m128i byte_swap_64(__m128i x) {
+    x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+    return _mm_shufflehi_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// LATC
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// See convert_index() in SkTextureCompressor_LATC.cpp.
+static inline __m128i convert_latc_index(const __m128i& alpha) {
+    const __m128i k01 = set1_32(0x01010101);
+
+    __m128i x = _mm_sub_epi32(set1_32(0x07070707), convert_to_three_bit_index(alpha));
+    const __m128i mask = _mm_and_si128(
+            _mm_or_si128(x, _mm_or_si128(_mm_srli_epi32(x, 1), _mm_srli_epi32(x, 2))), k01);
+    x = _mm_add_epi32(x, mask);
+    x = _mm_or_si128(x, _mm_and_si128(_mm_srli_epi32(x, 3), k01));
+    x = _mm_and_si128(x, set1_32(0x07070707));
+
+    // pack_index()
+    return _mm_or_si128(
+            _mm_or_si128(_mm_and_si128(x, set1_32(0x7)),
+                         _mm_and_si128(_mm_srli_epi32(x, 5), set1_32(0x38))),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi32(x, 10), set1_32(0x1C0)),
+                         _mm_and_si128(_mm_srli_epi32(x, 15), set1_32(0xE00))));
+}
+
+// Each 64 bits of x hold the indices of a block's top two rows in their low 32 bits, and of its
+// bottom two rows in their high 32 bits.
+static inline __m128i pack_latc_blocks(const __m128i& x) {
+    const __m128i indices = _mm_or_si128(_mm_and_si128(x, set1_64(0xFFFFFFFFULL)),
+                                         _mm_slli_epi64(_mm_srli_epi64(x, 32), 24));
+    return _mm_or_si128(_mm_slli_epi64(indices, 16), set1_64(0xFF));
+}
+
+static void compress_latc_blocks(uint8_t* dst, const uint8_t* src, size_t rowBytes) {
+    const __m128i row1 = convert_latc_index(_mm_loadu_si128((const __m128i*)(src)));
+    const __m128i row2 = convert_latc_index(_mm_loadu_si128((const __m128i*)(src + rowBytes)));
+    const __m128i row3 = convert_latc_index(_mm_loadu_si128((const __m128i*)(src + 2*rowBytes)));
+    const __m128i row4 = convert_latc_index(_mm_loadu_si128((const __m128i*)(src + 3*rowBytes)));
+
+    const __m128i top    = _mm_or_si128(row1, _mm_slli_epi32(row2, 12));
+    const __m128i bottom = _mm_or_si128(row3, _mm_slli_epi32(row4, 12));
+
+    _mm_storeu_si128((__m128i*)(dst), pack_latc_blocks(_mm_unpacklo_epi32(top, bottom)));
+    _mm_storeu_si128((__m128i*)(dst + 16), pack_latc_blocks(_mm_unpackhi_epi32(top, bottom)));
+}
+
+bool CompressA8toLATC_SSE2(uint8_t* dst, const uint8_t* src,
+                           int width, int height, size_t rowBytes) {
+    // Four blocks at a time, so the width must be a multiple of 16.
+    if (0 == width || 0 == height || (width % 16) != 0 || (height % 4) != 0) {
+        return SkTextureCompressor::CompressBufferToFormat(
+            dst, src,
+            kAlpha_8_SkColorType,
+            width, height, rowBytes,
+            SkTextureCompressor::kLATC_Format, false);
+    }
+
+    for (int y = 0; y < height; y += 4) {
+        for (int x = 0; x < width; x += 16) {
+            compress_latc_blocks(dst, src + x, rowBytes);
+            dst += 32;
+        }
+        src += 4 * rowBytes;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// R11 EAC
+//
+////////////////////////////////////////////////////////////////////////////////
+
+// See convert_indices() in SkTextureCompressor_R11EAC.cpp.
+static inline __m128i convert_r11eac_indices(const __m128i& alpha) {
+    const __m128i k03 = set1_32(0x03030303),
+                  k7F = set1_32(0x7F7F7F7F),
+                  k80 = set1_32(0x80808080);
+
+    __m128i x = convert_to_three_bit_index(alpha);
+
+    // Negate...
+    x = _mm_xor_si128(_mm_xor_si128(_mm_sub_epi32(k80, x), k7F), set1_32(0xFFFFFFFF));
+
+    // Add three
+    const __m128i s = _mm_add_epi32(_mm_and_si128(x, k7F), k03);
+    x = _mm_xor_si128(_mm_and_si128(_mm_xor_si128(x, k03), k80), s);
+
+    // Absolute value, and mask negatives
+    const __m128i a = _mm_and_si128(x, k80);
+    const __m128i b = _mm_srli_epi32(a, 7);
+    const __m128i m = _mm_or_si128(_mm_srli_epi32(a, 6), b);
+    x = _mm_add_epi32(_mm_xor_si128(x, _mm_or_si128(_mm_sub_epi32(a, b), a)), b);
+
+    // Add three
+    return _mm_add_epi32(x, m);
+}
+
+template<int shift>
+static inline __m128i swap_shift(const __m128i& x, const __m128i& mask) {
+    const __m128i t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, shift)), mask);
+    return _mm_xor_si128(_mm_xor_si128(x, t), _mm_slli_epi64(t, shift));
+}
+
+// See interleave6() in SkTextureCompressor_R11EAC.cpp: x holds the interleaved indices of the
+// top two rows of each block in its high 32 bits, and of the bottom two rows in its low 32 bits.
+static inline __m128i interleave6(__m128i x) {
+    x = swap_shift<10>(x, set1_64(0x3FC0003FC00000ULL));
+    x = _mm_srli_epi64(_mm_or_si128(x, _mm_or_si128(
+            _mm_and_si128(_mm_slli_epi64(x, 52), set1_64(0x3FULL << 52)),
+            _mm_and_si128(_mm_slli_epi64(x, 20), set1_64(0x3FULL << 28)))), 16);
+    x = swap_shift<6>(x, set1_64(0xFC0000ULL));
+    x = swap_shift<36>(x, set1_64(0xFC0ULL));
+    return _mm_or_si128(_mm_and_si128(x, set1_64(0xFFFULL << 36)),
+                        _mm_or_si128(_mm_slli_epi64(_mm_and_si128(x, set1_64(0xFFFFFFULL)), 12),
+                                     _mm_and_si128(_mm_srli_epi64(x, 24), set1_64(0xFFFULL))));
+}
+
+// Solid transparent and opaque blocks have their own encodings.
+static inline __m128i select_solid(const __m128i& blocks,
+                                   const __m128i& transparent, const __m128i& opaque) {
+    const __m128i kTransparent = set1_64(0x0020000000002000ULL);
+    return _mm_or_si128(_mm_andnot_si128(_mm_or_si128(transparent, opaque), blocks),
+                        _mm_or_si128(_mm_and_si128(transparent, kTransparent), opaque));
+}
+
+static void compress_r11eac_blocks(uint8_t* dst, const uint8_t* src, size_t rowBytes) {
+    const __m128i alphaRow1 = _mm_loadu_si128((const __m128i*)(src));
+    const __m128i alphaRow2 = _mm_loadu_si128((const __m128i*)(src + rowBytes));
+    const __m128i alphaRow3 = _mm_loadu_si128((const __m128i*)(src + 2*rowBytes));
+    const __m128i alphaRow4 = _mm_loadu_si128((const __m128i*)(src + 3*rowBytes));
+
+    const __m128i solid = _mm_and_si128(_mm_cmpeq_epi32(alphaRow1, alphaRow2),
+                                        _mm_and_si128(_mm_cmpeq_epi32(alphaRow1, alphaRow3),
+                                                      _mm_cmpeq_epi32(alphaRow1, alphaRow4)));
+    const __m128i transparent = _mm_and_si128(solid,
+                                              _mm_cmpeq_epi32(alphaRow1, _mm_setzero_si128()));
+    const __m128i opaque = _mm_and_si128(solid, _mm_cmpeq_epi32(alphaRow1, set1_32(0xFFFFFFFF)));
+
+    const __m128i r1r2 = _mm_or_si128(_mm_slli_epi32(convert_r11eac_indices(alphaRow1), 3),
+                                      convert_r11eac_indices(alphaRow2));
+    const __m128i r3r4 = _mm_or_si128(_mm_slli_epi32(convert_r11eac_indices(alphaRow3), 3),
+                                      convert_r11eac_indices(alphaRow4));
+
+    const __m128i kHeader = set1_64(0x8490000000000000ULL);
+    const __m128i blocks01 = byte_swap_64(
+            _mm_or_si128(kHeader, interleave6(_mm_unpacklo_epi32(r3r4, r1r2))));
+    const __m128i blocks23 = byte_swap_64(
+            _mm_or_si128(kHeader, interleave6(_mm_unpackhi_epi32(r3r4, r1r2))));
+
+    _mm_storeu_si128((__m128i*)(dst),
+                     select_solid(blocks01, _mm_unpacklo_epi32(transparent, transparent),
+                                  _mm_unpacklo_epi32(opaque, opaque)));
+    _mm_storeu_si128((__m128i*)(dst + 16),
+                     select_solid(blocks23, _mm_unpackhi_epi32(transparent, transparent),
+                                  _mm_unpackhi_epi32(opaque, opaque)));
+}
+
+bool CompressA8toR11EAC_SSE2(uint8_t* dst, const uint8_t* src,
+                             int width, int height, size_t rowBytes) {
+    // Four blocks at a time, so the width must be a multiple of 16.
+    if (0 == width || 0 == height || (width % 16) != 0 || (height % 4) != 0) {
+        return SkTextureCompressor::CompressBufferToFormat(
+            dst, src,
+            kAlpha_8_SkColorType,
+            width, height, rowBytes,
+            SkTextureCompressor::kR11_EAC_Format, false);
+    }
+
+    for (int y = 0; y < height; y += 4) {
+        for (int x = 0; x < width; x += 16) {
+            compress_r11eac_blocks(dst, src + x, rowBytes);
+            dst += 32;
+        }
+        src += 4 * rowBytes;
+    }
+    return true;
+}
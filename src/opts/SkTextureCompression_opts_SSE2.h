@@ -0,0 +1,19 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkTextureCompression_opts_SSE2_DEFINED
+#define SkTextureCompression_opts_SSE2_DEFINED
+
+#include "SkTypes.h"
+
+// These produce exactly the same blocks as the portable encoders, four blocks at a time.
+bool CompressA8toLATC_SSE2(uint8_t* dst, const uint8_t* src,
+                           int width, int height, size_t rowBytes);
+bool CompressA8toR11EAC_SSE2(uint8_t* dst, const uint8_t* src,
+                             int width, int height, size_t rowBytes);
+
+#endif
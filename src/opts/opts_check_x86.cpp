@@ -6,6 +6,7 @@
  */
 
 #include "SkBitmapFilter_opts_SSE2.h"
+#include "SkBitmapProcState_opts_AVX2.h"
 #include "SkBitmapProcState_opts_SSE2.h"
 #include "SkBitmapProcState_opts_SSSE3.h"
 #include "SkBitmapScaler.h"
@@ -19,6 +20,8 @@
 #include "SkMorphology_opts.h"
 #include "SkMorphology_opts_SSE2.h"
 #include "SkRTConf.h"
+#include "SkTextureCompression_opts.h"
+#include "SkTextureCompression_opts_SSE2.h"
 #include "SkUtils.h"
 #include "SkUtils_opts_SSE2.h"
 #include "SkXfermode.h"
@@ -27,6 +30,9 @@
 #if defined(_MSC_VER) && defined(_WIN64)
 #include <intrin.h>
 #endif
+#if defined(_MSC_VER)
+#include <immintrin.h>  // _xgetbv
+#endif
 
 /* This file must *not* be compiled with -msse or any other optional SIMD
    extension, otherwise gcc may generate SIMD instructions even for scalar ops
@@ -35,14 +41,17 @@
    compiled with -msse2 or higher. */
 
 
-/* Function to get the CPU SSE-level in runtime, for different compilers. */
+/* Function to get the CPU SSE-level in runtime, for different compilers.
+ * Sub-leaf 0 is always requested, which leaf 7 (extended features) needs.
+ */
 #ifdef _MSC_VER
 static inline void getcpuid(int info_type, int info[4]) {
 #if defined(_WIN64)
-    __cpuid(info, info_type);
+    __cpuidex(info, info_type, 0);
 #else
     __asm {
         mov    eax, [info_type]
+        xor    ecx, ecx
         cpuid
         mov    edi, [info]
         mov    [edi], eax
@@ -57,7 +66,7 @@ static inline void getcpuid(int info_type, int info[4]) {
     asm volatile (
         "cpuid \n\t"
         : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3])
-        : "a"(info_type)
+        : "a"(info_type), "2"(0)
     );
 }
 #else
@@ -69,11 +78,49 @@ static inline void getcpuid(int info_type, int info[4]) {
         "movl %%ebx, %1   \n\t"
         "popl %%ebx       \n\t"
         : "=a"(info[0]), "=r"(info[1]), "=c"(info[2]), "=d"(info[3])
-        : "a"(info_type)
+        : "a"(info_type), "2"(0)
+    );
+}
+#endif
+
+/* Which register state the OS saves on context switches, from XCR0. */
+#ifdef _MSC_VER
+static inline uint32_t get_xcr0() {
+    return (uint32_t)_xgetbv(0);
+}
+#else
+static inline uint32_t get_xcr0() {
+    uint32_t eax, edx;
+    // xgetbv, spelled out for assemblers that don't know it.
+    asm volatile (
+        ".byte 0x0f, 0x01, 0xd0 \n\t"
+        : "=a"(eax), "=d"(edx)
+        : "c"(0)
     );
+    return eax;
 }
 #endif
 
+/* AVX2 needs the CPU to support it and the OS to save the YMM registers. */
+static bool supports_avx2() {
+    int cpu_info[4] = { 0, 0, 0, 0 };
+    getcpuid(0, cpu_info);
+    if (cpu_info[0] < 7) {
+        return false;
+    }
+    getcpuid(1, cpu_info);
+    const int kOSXSAVE_AVX = (1<<27) | (1<<28);
+    if ((cpu_info[2] & kOSXSAVE_AVX) != kOSXSAVE_AVX) {
+        return false;
+    }
+    // Both SSE (XMM) and AVX (YMM) state must be enabled.
+    if ((get_xcr0() & 6) != 6) {
+        return false;
+    }
+    getcpuid(7, cpu_info);
+    return (cpu_info[1] & (1<<5)) != 0;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 /* Fetch the SIMD level directly from the CPU, at run-time.
@@ -86,7 +133,9 @@ int* get_SIMD_level() {
 
     int* level = SkNEW(int);
 
-    if ((cpu_info[2] & (1<<20)) != 0) {
+    if ((cpu_info[2] & (1<<20)) != 0 && supports_avx2()) {
+        *level = SK_CPU_SSE_LEVEL_AVX2;
+    } else if ((cpu_info[2] & (1<<20)) != 0) {
         *level = SK_CPU_SSE_LEVEL_SSE42;
     } else if ((cpu_info[2] & (1<<19)) != 0) {
         *level = SK_CPU_SSE_LEVEL_SSE41;
@@ -148,6 +197,30 @@ void SkBitmapProcState::platformProcs() {
     }
     const bool ssse3 = supports_simd(SK_CPU_SSE_LEVEL_SSSE3);
 
+    /* The AVX2 procs filter 8 pixels at a time, including through perspective.
+     * The DXDY procs gather by byte offset, so they need a bitmap under 2GB.
+     */
+    if (supports_simd(SK_CPU_SSE_LEVEL_AVX2)) {
+        const bool smallBitmap = fBitmap->getSize() <= SK_MaxS32;
+        if (fSampleProc32 == S32_opaque_D32_filter_DX) {
+            fSampleProc32 = S32_opaque_D32_filter_DX_AVX2;
+        } else if (fSampleProc32 == S32_alpha_D32_filter_DX) {
+            fSampleProc32 = S32_alpha_D32_filter_DX_AVX2;
+        } else if (fSampleProc32 == S32_opaque_D32_filter_DXDY && smallBitmap) {
+            fSampleProc32 = S32_opaque_D32_filter_DXDY_AVX2;
+        } else if (fSampleProc32 == S32_alpha_D32_filter_DXDY && smallBitmap) {
+            fSampleProc32 = S32_alpha_D32_filter_DXDY_AVX2;
+        }
+
+        if (fMatrixProc == ClampX_ClampY_filter_scale) {
+            fMatrixProc = ClampX_ClampY_filter_scale_AVX2;
+        } else if (fMatrixProc == ClampX_ClampY_filter_affine) {
+            fMatrixProc = ClampX_ClampY_filter_affine_AVX2;
+        } else if (fMatrixProc == ClampX_ClampY_filter_persp) {
+            fMatrixProc = ClampX_ClampY_filter_persp_AVX2;
+        }
+    }
+
     /* Check fSampleProc32 */
     if (fSampleProc32 == S32_opaque_D32_filter_DX) {
         if (ssse3) {
@@ -357,6 +430,27 @@ SkMorphologyImageFilter::Proc SkMorphologyGetPlatformProc(SkMorphologyProcType t
 
 ////////////////////////////////////////////////////////////////////////////////
 
+SkTextureCompressor::CompressionProc
+SkTextureCompressorGetPlatformProc(SkColorType colorType, SkTextureCompressor::Format fmt) {
+    if (!supports_simd(SK_CPU_SSE_LEVEL_SSE2) || kAlpha_8_SkColorType != colorType) {
+        return NULL;
+    }
+    switch (fmt) {
+        case SkTextureCompressor::kLATC_Format:
+            return CompressA8toLATC_SSE2;
+        case SkTextureCompressor::kR11_EAC_Format:
+            return CompressA8toR11EAC_SSE2;
+        default:
+            return NULL;
+    }
+}
+
+bool SkTextureCompressorGetPlatformDims(SkTextureCompressor::Format fmt, int* dimX, int* dimY) {
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool SkBoxBlurGetPlatformProcs(SkBoxBlurProc* boxBlurX,
                                SkBoxBlurProc* boxBlurY,
                                SkBoxBlurProc* boxBlurXY,
@@ -9,8 +9,10 @@
 
 #include "SkBitmapDevice.h"
 #include "SkCanvas.h"
+#include "SkCondVar.h"
 #include "SkGPipe.h"
 #include "SkMatrix.h"
+#include "SkThreadUtils.h"
 
 PipeController::PipeController(SkCanvas* target, SkPicture::InstallPixelRefProc proc)
 :fReader(target) {
@@ -116,3 +118,203 @@ void ThreadSafePipeController::draw(SkCanvas* target) {
         reader.playback(fBlock, fBytesWritten);
     }
 }
+
+////////////////////////////////////////////////////////////////////////////////
+
+ThreadedPipeController::ThreadedPipeController(SkCanvas* target, int blockCount,
+                                               size_t blockSize)
+: fReader(target)
+, fBlockCount(blockCount)
+, fMinBlockSize(SkAlign4(blockSize))
+, fBlocks(blockCount)
+, fFramesEnded(0)
+, fHasCurrentBlock(false)
+, fWaiters(0) {
+    SkASSERT(blockCount > 0);
+    for (int i = 0; i < fBlockCount; i++) {
+        fBlocks[i].fData = NULL;
+        fBlocks[i].fSize = 0;
+        fBlocks[i].fBytesWritten.store(0);
+        fBlocks[i].fComplete.store(false);
+        fBlocks[i].fEndsFrame = false;
+    }
+    fBlocksStarted.store(0);
+    fDestroying.store(false);
+    fWriterEvents.store(0);
+    fBlocksPlayed.store(0);
+    fFramesDrawn.store(0);
+    fStopped.store(false);
+    fReaderEvents.store(0);
+
+    SkAssertResult(SkCondVar::Supported());
+    fCondVar.reset(SkNEW(SkCondVar));
+    fThread.reset(SkNEW_ARGS(SkThread, (ThreadedPipeController::PlaybackThread, this)));
+    if (!fThread->start()) {
+        fStopped.store(true);
+    }
+}
+
+ThreadedPipeController::~ThreadedPipeController() {
+    // In case the writer never ended its recording, tell the reader to stop waiting for more.
+    fDestroying.store(true);
+    this->signal(&fWriterEvents);
+    fThread->join();
+    for (int i = 0; i < fBlockCount; i++) {
+        sk_free(fBlocks[i].fData);
+    }
+}
+
+void ThreadedPipeController::signal(SkAtomic<int32_t>* events) {
+    events->store(events->load(sk_memory_order_relaxed) + 1);
+    // Pairs with the increment in waitForChange(): either it sees our new count, or we see it.
+    if (sk_atomic_load(&fWaiters) > 0) {
+        fCondVar->lock();
+        fCondVar->broadcast();
+        fCondVar->unlock();
+    }
+}
+
+void ThreadedPipeController::waitForChange(const SkAtomic<int32_t>& events, int32_t seen) {
+    fCondVar->lock();
+    sk_atomic_inc(&fWaiters);
+    while (events.load() == seen) {
+        fCondVar->wait();
+    }
+    sk_atomic_dec(&fWaiters);
+    fCondVar->unlock();
+}
+
+void* ThreadedPipeController::requestBlock(size_t minRequest, size_t *actual) {
+    if (fHasCurrentBlock) {
+        this->completeCurrentBlock(false);
+    }
+
+    // Wait for the reader to finish playing the block we are about to reuse.
+    const int index = fBlocksStarted.load(sk_memory_order_relaxed);
+    for (;;) {
+        const int32_t seen = fReaderEvents.load();
+        if (fStopped.load()) {
+            return NULL;
+        }
+        if (index - fBlocksPlayed.load() < fBlockCount) {
+            break;
+        }
+        this->waitForChange(fReaderEvents, seen);
+    }
+
+    Block* block = &fBlocks[index % fBlockCount];
+    const size_t size = SkTMax(fMinBlockSize, minRequest);
+    if (block->fSize < size) {
+        sk_free(block->fData);
+        block->fData = sk_malloc_throw(size);
+        block->fSize = size;
+    }
+    block->fBytesWritten.store(0);
+    block->fComplete.store(false);
+    block->fEndsFrame = false;
+    fHasCurrentBlock = true;
+    fBlocksStarted.store(index + 1);
+    this->signal(&fWriterEvents);
+
+    *actual = block->fSize;
+    return block->fData;
+}
+
+void ThreadedPipeController::notifyWritten(size_t bytes) {
+    SkASSERT(fHasCurrentBlock);
+    Block* block = this->currentBlock();
+    block->fBytesWritten.store(block->fBytesWritten.load(sk_memory_order_relaxed) + bytes);
+    this->signal(&fWriterEvents);
+}
+
+void ThreadedPipeController::completeCurrentBlock(bool endsFrame) {
+    Block* block = this->currentBlock();
+    block->fEndsFrame = endsFrame;
+    block->fComplete.store(true);
+    fHasCurrentBlock = false;
+    this->signal(&fWriterEvents);
+}
+
+int ThreadedPipeController::endFrame(SkGPipeWriter* writer) {
+    // Make the writer notify us of everything it has recorded, and start a new block for whatever
+    // it records next, so that we can hand over the current block now.
+    writer->flushRecording(true);
+    const int frame = fFramesEnded++;
+    if (!fHasCurrentBlock) {
+        // Nothing was recorded since the last frame, but the reader still needs to count this one.
+        size_t unused;
+        if (NULL == this->requestBlock(0, &unused)) {
+            return frame;
+        }
+    }
+    this->completeCurrentBlock(true);
+    return frame;
+}
+
+bool ThreadedPipeController::waitForFrame(int frame) {
+    for (;;) {
+        const int32_t seen = fReaderEvents.load();
+        if (fFramesDrawn.load() > frame) {
+            return true;
+        }
+        if (fStopped.load()) {
+            return false;
+        }
+        this->waitForChange(fReaderEvents, seen);
+    }
+}
+
+void ThreadedPipeController::PlaybackThread(void* controller) {
+    static_cast<ThreadedPipeController*>(controller)->playback();
+}
+
+void ThreadedPipeController::playback() {
+    for (int index = 0; ; index++) {
+        // Wait for the writer to start our next block.
+        for (;;) {
+            const int32_t seen = fWriterEvents.load();
+            if (index < fBlocksStarted.load()) {
+                break;
+            }
+            if (fDestroying.load()) {
+                return;
+            }
+            this->waitForChange(fWriterEvents, seen);
+        }
+
+        // Play its atoms as they are written, until it is complete.
+        Block* block = &fBlocks[index % fBlockCount];
+        size_t bytesPlayed = 0;
+        for (;;) {
+            const int32_t seen = fWriterEvents.load();
+            // Once the block is complete, its byte count is final.
+            const bool complete = block->fComplete.load();
+            const size_t bytesWritten = block->fBytesWritten.load();
+            if (bytesPlayed < bytesWritten) {
+                SkGPipeReader::Status status = fReader.playback((const char*)block->fData +
+                                                                bytesPlayed,
+                                                                bytesWritten - bytesPlayed);
+                bytesPlayed = bytesWritten;
+                if (SkGPipeReader::kDone_Status == status ||
+                    SkGPipeReader::kError_Status == status) {
+                    SkASSERT(SkGPipeReader::kError_Status != status);
+                    fStopped.store(true);
+                    this->signal(&fReaderEvents);
+                    return;
+                }
+            } else if (complete) {
+                break;
+            } else if (fDestroying.load()) {
+                return;
+            } else {
+                this->waitForChange(fWriterEvents, seen);
+            }
+        }
+
+        if (block->fEndsFrame) {
+            fFramesDrawn.store(fFramesDrawn.load(sk_memory_order_relaxed) + 1);
+        }
+        fBlocksPlayed.store(index + 1);
+        this->signal(&fReaderEvents);
+    }
+}
@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 
+#include "SkAtomics.h"
 #include "SkBitmap.h"
 #include "SkChunkAlloc.h"
 #include "SkGPipe.h"
@@ -12,7 +13,9 @@
 #include "SkTDArray.h"
 
 class SkCanvas;
+class SkCondVar;
 class SkMatrix;
+class SkThread;
 
 class PipeController : public SkGPipeController {
 public:
@@ -85,3 +88,80 @@ private:
     SkTDArray<PipeBlock> fBlockList;
     int fNumberOfReaders;
 };
+
+////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Plays the stream on its own thread, while the writer is still recording it, so that one thread
+ * can record frames into an SkGPipeWriter while another rasterizes them into target.
+ *
+ * Blocks are handed over through a ring of blockCount blocks: the reader plays each atom as soon as
+ * it is written, and the writer waits in requestBlock() only when the ring is full. Neither thread
+ * takes a lock unless it has to wait for the other.
+ *
+ * The reader must not share any state with the writer, so startRecording() must be passed
+ * SkGPipeWriter::kCrossProcess_Flag (without kSharedAddressSpace_Flag). Destroying the controller
+ * waits for the reader to play everything written so far.
+ */
+class ThreadedPipeController : public SkGPipeController {
+public:
+    ThreadedPipeController(SkCanvas* target, int blockCount = 4, size_t blockSize = 16 * 1024);
+    virtual ~ThreadedPipeController();
+    void* requestBlock(size_t minRequest, size_t* actual) override;
+    void notifyWritten(size_t bytes) override;
+
+    /**
+     * Ends the current frame: sends everything recorded so far to the reader, which will count
+     * the frame as drawn once it has played all of it. Returns the frame's number (0, 1, 2...).
+     */
+    int endFrame(SkGPipeWriter*);
+
+    /**
+     * Waits until the reader has drawn frame (returned by endFrame()) and all frames before it.
+     * Returns false if playback stopped before that, e.g. because the stream was bad.
+     */
+    bool waitForFrame(int frame);
+
+private:
+    struct Block {
+        void*               fData;
+        size_t              fSize;
+        SkAtomic<size_t>    fBytesWritten;
+        SkAtomic<bool>      fComplete;      // No more bytes will be written to this block.
+        bool                fEndsFrame;     // Set before fComplete.
+    };
+
+    static void PlaybackThread(void* controller);
+    void playback();
+
+    Block* currentBlock() { return &fBlocks[(fBlocksStarted.load() - 1) % fBlockCount]; }
+    void completeCurrentBlock(bool endsFrame);
+
+    // Each thread counts the changes it makes to the state the other thread may be waiting on.
+    // A thread that finds nothing to do waits for the other's count to change from what it was
+    // before it looked; only then does it take fCondVar's lock.
+    void signal(SkAtomic<int32_t>* events);
+    void waitForChange(const SkAtomic<int32_t>& events, int32_t seen);
+
+    SkGPipeReader               fReader;
+    const int                   fBlockCount;
+    const size_t                fMinBlockSize;
+    SkAutoTArray<Block>         fBlocks;
+
+    // Written only by the writer's thread.
+    int                         fFramesEnded;
+    bool                        fHasCurrentBlock;
+    SkAtomic<int>               fBlocksStarted;
+    SkAtomic<bool>              fDestroying;
+    SkAtomic<int32_t>           fWriterEvents;
+
+    // Written only by the playback thread.
+    SkAtomic<int>               fBlocksPlayed;
+    SkAtomic<int>               fFramesDrawn;
+    SkAtomic<bool>              fStopped;
+    SkAtomic<int32_t>           fReaderEvents;
+
+    /*atomic*/ int32_t          fWaiters;
+    SkAutoTDelete<SkCondVar>    fCondVar;
+    SkAutoTDelete<SkThread>     fThread;
+};
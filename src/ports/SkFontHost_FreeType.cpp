@@ -201,6 +201,7 @@ protected:
     void generatePath(const SkGlyph& glyph, SkPath* path) override;
     void generateFontMetrics(SkPaint::FontMetrics*) override;
     SkUnichar generateGlyphToChar(uint16_t glyph) override;
+    void getEngineVersion(SkString* version) const override;
 
 private:
     SkFaceRec*  fFaceRec;
@@ -995,6 +996,19 @@ SkUnichar SkScalerContext_FreeType::generateGlyphToChar(uint16_t glyph) {
     return 0;
 }
 
+void SkScalerContext_FreeType::getEngineVersion(SkString* version) const {
+    FT_Int major, minor, patch;
+    bool lcd;
+    {
+        SkAutoMutexAcquire  ac(gFTMutex);
+        FT_Library_Version(gFTLibrary->library(), &major, &minor, &patch);
+        lcd = gFTLibrary->isLCDSupported();
+    }
+    // Whether we can filter LCD glyphs depends on the FreeType we run with, not the one we built
+    // against.
+    version->appendf("FreeType %d.%d.%d lcd %d", major, minor, patch, lcd);
+}
+
 void SkScalerContext_FreeType::generateAdvance(SkGlyph* glyph) {
    /* unhinted and light hinted text have linearly scaled advances
     * which are very cheap to compute with some font formats...
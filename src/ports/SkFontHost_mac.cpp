@@ -192,6 +192,7 @@ static void sk_memset_rect32(uint32_t* ptr, uint32_t value,
     }
 }
 
+#include <sys/sysctl.h>
 #include <sys/utsname.h>
 
 typedef uint32_t CGRGBPixel;
@@ -637,6 +638,7 @@ protected:
     void generateImage(const SkGlyph& glyph) override;
     void generatePath(const SkGlyph& glyph, SkPath* path) override;
     void generateFontMetrics(SkPaint::FontMetrics*) override;
+    void getEngineVersion(SkString* version) const override;
 
 private:
     static void CTPathElement(void *info, const CGPathElement *element);
@@ -1396,6 +1398,17 @@ void SkScalerContext_Mac::generatePath(const SkGlyph& glyph, SkPath* path) {
     }
 }
 
+void SkScalerContext_Mac::getEngineVersion(SkString* version) const {
+    // CoreText ships with the OS, and its version only changes with major releases, so use the
+    // OS build, which changes with every update. Without it, append nothing.
+    char build[64];
+    size_t size = sizeof(build);
+    if (0 == sysctlbyname("kern.osversion", build, &size, NULL, 0) && size <= sizeof(build)) {
+        build[sizeof(build) - 1] = '\0';
+        version->appendf("CoreText %x build %s", CTGetCoreTextVersion(), build);
+    }
+}
+
 void SkScalerContext_Mac::generateFontMetrics(SkPaint::FontMetrics* metrics) {
     if (NULL == metrics) {
         return;
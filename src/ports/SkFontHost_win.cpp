@@ -16,6 +16,7 @@
 #include "SkHRESULT.h"
 #include "SkMaskGamma.h"
 #include "SkMatrix22.h"
+#include "SkModuleVersion.h"
 #include "SkOTTable_maxp.h"
 #include "SkOTTable_name.h"
 #include "SkOTUtils.h"
@@ -547,6 +548,7 @@ protected:
     void generateImage(const SkGlyph& glyph) override;
     void generatePath(const SkGlyph& glyph, SkPath* path) override;
     void generateFontMetrics(SkPaint::FontMetrics*) override;
+    void getEngineVersion(SkString* version) const override;
 
 private:
     DWORD getGDIGlyphPath(const SkGlyph& glyph, UINT flags,
@@ -947,6 +949,14 @@ void SkScalerContext_GDI::generateMetrics(SkGlyph* glyph) {
 }
 
 static const MAT2 gMat2Identity = {{0, 1}, {0, 0}, {0, 0}, {0, 1}};
+void SkScalerContext_GDI::getEngineVersion(SkString* version) const {
+    // GDI's rasterizer is updated with the OS, so key on the version of the GDI we draw with.
+    SkString dllVersion;
+    if (sk_append_module_version(L"gdi32.dll", &dllVersion)) {
+        version->appendf("GDI %s", dllVersion.c_str());
+    }
+}
+
 void SkScalerContext_GDI::generateFontMetrics(SkPaint::FontMetrics* metrics) {
     if (NULL == metrics) {
         return;
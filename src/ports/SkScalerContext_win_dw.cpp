@@ -15,6 +15,7 @@
 #include "SkHRESULT.h"
 #include "SkMaskGamma.h"
 #include "SkMatrix22.h"
+#include "SkModuleVersion.h"
 #include "SkOTTable_EBLC.h"
 #include "SkOTTable_EBSC.h"
 #include "SkOTTable_gasp.h"
@@ -466,6 +467,14 @@ void SkScalerContext_DW::generateMetrics(SkGlyph* glyph) {
     // fails, and try DWRITE_TEXTURE_CLEARTYPE_3x1.
 }
 
+void SkScalerContext_DW::getEngineVersion(SkString* version) const {
+    // DirectWrite is updated with the OS, so key on the version of the dll we rasterize with.
+    SkString dllVersion;
+    if (sk_append_module_version(L"dwrite.dll", &dllVersion)) {
+        version->appendf("DirectWrite %s", dllVersion.c_str());
+    }
+}
+
 void SkScalerContext_DW::generateFontMetrics(SkPaint::FontMetrics* metrics) {
     if (NULL == metrics) {
         return;
@@ -31,6 +31,7 @@ protected:
     void generateImage(const SkGlyph& glyph) override;
     void generatePath(const SkGlyph& glyph, SkPath* path) override;
     void generateFontMetrics(SkPaint::FontMetrics*) override;
+    void getEngineVersion(SkString* version) const override;
 
 private:
     const void* drawDWMask(const SkGlyph& glyph,
@@ -151,8 +151,9 @@ static bool cull_path(const SkPath& srcPath, const SkStrokeRec& rec,
 
 class SpecialLineRec {
 public:
+    // If maxSegments > 0, reserves room in dst for at most that many segments.
     bool init(const SkPath& src, SkPath* dst, SkStrokeRec* rec,
-              int intervalCount, SkScalar intervalLength) {
+              int intervalCount, SkScalar intervalLength, int maxSegments) {
         if (rec->isHairlineStyle() || !src.isLine(fPts)) {
             return false;
         }
@@ -181,6 +182,9 @@ public:
         SkScalar ptCount = SkScalarMulDiv(pathLength,
                                           SkIntToScalar(intervalCount),
                                           intervalLength);
+        if (maxSegments > 0 && ptCount > maxSegments) {
+            ptCount = SkIntToScalar(maxSegments);
+        }
         int n = SkScalarCeilToInt(ptCount) << 2;
         dst->incReserve(n);
 
@@ -218,10 +222,21 @@ private:
 };
 
 
-bool SkDashPath::FilterDashPath(SkPath* dst, const SkPath& src, SkStrokeRec* rec,
-                                const SkRect* cullRect, const SkScalar aIntervals[],
-                                int32_t count, SkScalar initialDashLength, int32_t initialDashIndex,
-                                SkScalar intervalLength) {
+// Since the path length / dash length ratio may be arbitrarily large, we can exert significant
+// memory pressure while attempting to build the filtered path. To avoid this, we simply give up
+// dashing beyond a certain threshold.
+//
+// The original bug report (http://crbug.com/165432) is based on a path yielding more than 90
+// million dash segments and crashing the memory allocator. A limit of 1 million segments seems
+// reasonable: at 2 verbs per segment * 9 bytes per verb, this caps the maximum dash memory
+// overhead at roughly 17MB per path.
+static const SkScalar kMaxDashCount = 1000000;
+
+// If sink is not NULL, dst is a scratch path for a batch of segments.
+static bool dash_path(SkPath* dst, const SkPath& src, SkStrokeRec* rec, const SkRect* cullRect,
+                      const SkScalar aIntervals[], int32_t count, SkScalar initialDashLength,
+                      int32_t initialDashIndex, SkScalar intervalLength,
+                      SkDashPath::SegmentSink* sink) {
 
     // we do nothing if the src wants to be filled, or if our dashlength is 0
     if (rec->isFillStyle() || initialDashLength < 0) {
@@ -239,7 +254,8 @@ bool SkDashPath::FilterDashPath(SkPath* dst, const SkPath& src, SkStrokeRec* rec
     }
 
     SpecialLineRec lineRec;
-    bool specialLine = lineRec.init(*srcPtr, dst, rec, count >> 1, intervalLength);
+    bool specialLine = lineRec.init(*srcPtr, dst, rec, count >> 1, intervalLength,
+                                    sink ? SkDashPath::kMaxSegmentsPerBatch : 0);
 
     SkPathMeasure   meas(*srcPtr, false);
 
@@ -249,15 +265,6 @@ bool SkDashPath::FilterDashPath(SkPath* dst, const SkPath& src, SkStrokeRec* rec
         SkScalar    length = meas.getLength();
         int         index = initialDashIndex;
 
-        // Since the path length / dash length ratio may be arbitrarily large, we can exert
-        // significant memory pressure while attempting to build the filtered path. To avoid this,
-        // we simply give up dashing beyond a certain threshold.
-        //
-        // The original bug report (http://crbug.com/165432) is based on a path yielding more than
-        // 90 million dash segments and crashing the memory allocator. A limit of 1 million
-        // segments seems reasonable: at 2 verbs per segment * 9 bytes per verb, this caps the
-        // maximum dash memory overhead at roughly 17MB per path.
-        static const SkScalar kMaxDashCount = 1000000;
         dashCount += length * (count >> 1) / intervalLength;
         if (dashCount > kMaxDashCount) {
             dst->reset();
@@ -273,6 +280,14 @@ bool SkDashPath::FilterDashPath(SkPath* dst, const SkPath& src, SkStrokeRec* rec
             SkASSERT(dlen >= 0);
             addedSegment = false;
             if (is_even(index) && dlen > 0 && !skipFirstSegment) {
+                if (sink && segCount >= SkDashPath::kMaxSegmentsPerBatch) {
+                    if (segCount > 1) {
+                        dst->setConvexity(SkPath::kConcave_Convexity);
+                    }
+                    sink->drawSegments(*dst, *rec);
+                    dst->rewind();
+                    segCount = 0;
+                }
                 addedSegment = true;
                 ++segCount;
 
@@ -313,10 +328,21 @@ bool SkDashPath::FilterDashPath(SkPath* dst, const SkPath& src, SkStrokeRec* rec
     if (segCount > 1) {
         dst->setConvexity(SkPath::kConcave_Convexity);
     }
+    if (sink && segCount > 0) {
+        sink->drawSegments(*dst, *rec);
+    }
 
     return true;
 }
 
+bool SkDashPath::FilterDashPath(SkPath* dst, const SkPath& src, SkStrokeRec* rec,
+                                const SkRect* cullRect, const SkScalar aIntervals[],
+                                int32_t count, SkScalar initialDashLength, int32_t initialDashIndex,
+                                SkScalar intervalLength) {
+    return dash_path(dst, src, rec, cullRect, aIntervals, count, initialDashLength,
+                     initialDashIndex, intervalLength, NULL);
+}
+
 bool SkDashPath::FilterDashPath(SkPath* dst, const SkPath& src, SkStrokeRec* rec,
                                 const SkRect* cullRect, const SkPathEffect::DashInfo& info) {
     SkScalar initialDashLength = 0;
@@ -327,3 +353,75 @@ bool SkDashPath::FilterDashPath(SkPath* dst, const SkPath& src, SkStrokeRec* rec
     return FilterDashPath(dst, src, rec, cullRect, info.fIntervals, info.fCount, initialDashLength,
                           initialDashIndex, intervalLength);
 }
+
+SkScalar SkDashPath::MaxDashCount(const SkPath& src, const SkPathEffect::DashInfo& info) {
+    SkScalar intervalLength = 0;
+    for (int i = 0; i < info.fCount; ++i) {
+        intervalLength += info.fIntervals[i];
+    }
+    if (!(intervalLength > 0)) {
+        return 0;
+    }
+
+    // Curves are never longer than their control polygons.
+    SkScalar length = 0;
+    SkPath::Iter iter(src, false);
+    SkPoint pts[4];
+    SkPath::Verb verb;
+    while ((verb = iter.next(pts, false)) != SkPath::kDone_Verb) {
+        int n;
+        switch (verb) {
+            case SkPath::kLine_Verb:  n = 1; break;
+            case SkPath::kQuad_Verb:  n = 2; break;
+            case SkPath::kConic_Verb: n = 2; break;
+            case SkPath::kCubic_Verb: n = 3; break;
+            default:                  n = 0; break;
+        }
+        for (int i = 0; i < n; ++i) {
+            length += SkPoint::Distance(pts[i], pts[i + 1]);
+        }
+    }
+    return length * (info.fCount >> 1) / intervalLength;
+}
+
+// Returns true if FilterDashPath() would give up on src for having too many dashes.
+static bool too_many_dashes(const SkPath& src, const SkStrokeRec& rec, const SkRect* cullRect,
+                            int32_t count, SkScalar intervalLength) {
+    SkPath cullPathStorage;
+    const SkPath* srcPtr = &src;
+    if (cull_path(src, rec, cullRect, intervalLength, &cullPathStorage)) {
+        srcPtr = &cullPathStorage;
+    }
+
+    SkPathMeasure meas(*srcPtr, false);
+    SkScalar dashCount = 0;
+    do {
+        dashCount += meas.getLength() * (count >> 1) / intervalLength;
+        if (dashCount > kMaxDashCount) {
+            return true;
+        }
+    } while (meas.nextContour());
+    return false;
+}
+
+bool SkDashPath::StreamDashPath(const SkPath& src, SkStrokeRec* rec, const SkRect* cullRect,
+                                const SkPathEffect::DashInfo& info, SegmentSink* sink) {
+    SkScalar initialDashLength = 0;
+    int32_t initialDashIndex = 0;
+    SkScalar intervalLength = 0;
+    CalcDashParameters(info.fPhase, info.fIntervals, info.fCount,
+                       &initialDashLength, &initialDashIndex, &intervalLength);
+    if (rec->isFillStyle() || initialDashLength < 0) {
+        return false;
+    }
+
+    // Giving up half way through would leave the batches we've drawn behind, so measure first.
+    if (MaxDashCount(src, info) > kMaxDashCount &&
+        too_many_dashes(src, *rec, cullRect, info.fCount, intervalLength)) {
+        return false;
+    }
+
+    SkPath batch;
+    return dash_path(&batch, src, rec, cullRect, info.fIntervals, info.fCount, initialDashLength,
+                     initialDashIndex, intervalLength, sink);
+}
@@ -27,6 +27,34 @@ namespace SkDashPath {
     
     bool FilterDashPath(SkPath* dst, const SkPath& src, SkStrokeRec*, const SkRect*,
                         const SkPathEffect::DashInfo& info);
+
+    // StreamDashPath() hands at most this many dash segments to its sink at a time.
+    static const int kMaxSegmentsPerBatch = 1024;
+
+    /*
+     * Returns an upper bound on the number of dash segments dashing src with info makes, from the
+     * length of its control polygon.
+     */
+    SkScalar MaxDashCount(const SkPath& src, const SkPathEffect::DashInfo& info);
+
+    /*
+     * Receives a dashed path a batch of dash segments at a time. rec is how to draw them: as
+     * hairlines, as a fill (for lines we stroked ourselves), or with the stroke they came with.
+     */
+    class SegmentSink {
+    public:
+        virtual ~SegmentSink() {}
+        virtual void drawSegments(const SkPath& segments, const SkStrokeRec& rec) = 0;
+    };
+
+    /*
+     * Same as FilterDashPath(), except that rather than building the whole dashed path, hands it
+     * to sink kMaxSegmentsPerBatch segments at a time, so memory use stays bounded however many
+     * dashes there are. A dash is never split across batches. Returns false, without calling
+     * sink, if src should be drawn undashed instead.
+     */
+    bool StreamDashPath(const SkPath& src, SkStrokeRec*, const SkRect*,
+                        const SkPathEffect::DashInfo& info, SegmentSink* sink);
 }
 
 #endif
@@ -6,6 +6,7 @@
  */
 
 #include "SkMatrix44.h"
+#include "SkNx.h"
 
 static inline bool eq4(const SkMScalar* SK_RESTRICT a,
                       const SkMScalar* SK_RESTRICT b) {
@@ -777,18 +778,25 @@ static void map2_sd(const SkMScalar mat[][4], const double* SK_RESTRICT src2,
     }
 }
 
+// The affine and perspective procs map each point with one multiply-add per column of fMat, where
+// column i holds the coefficients that src2's x (0), y (1) and the implied 1 (3) contribute to each
+// of dst4's four coordinates. Float points are mapped in SkMScalar, like the other procs, and
+// double points in double.
+typedef SkNf<4, SkMScalar> Sk4m;
+
 static void map2_af(const SkMScalar mat[][4], const float* SK_RESTRICT src2,
                     int count, float* SK_RESTRICT dst4) {
-    SkMScalar r;
+    const Sk4m col0 = Sk4m::Load(mat[0]);
+    const Sk4m col1 = Sk4m::Load(mat[1]);
+    const Sk4m col3 = Sk4m::Load(mat[3]);
+    SkMScalar r[4];
     for (int n = 0; n < count; ++n) {
-        SkMScalar sx = SkFloatToMScalar(src2[0]);
-        SkMScalar sy = SkFloatToMScalar(src2[1]);
-        r = mat[0][0] * sx + mat[1][0] * sy + mat[3][0];
-        dst4[0] = SkMScalarToFloat(r);
-        r = mat[0][1] * sx + mat[1][1] * sy + mat[3][1];
-        dst4[1] = SkMScalarToFloat(r);
-        r = mat[0][2] * sx + mat[1][2] * sy + mat[3][2];
-        dst4[2] = SkMScalarToFloat(r);
+        Sk4m sx(SkFloatToMScalar(src2[0]));
+        Sk4m sy(SkFloatToMScalar(src2[1]));
+        (col0 * sx + col1 * sy + col3).store(r);
+        dst4[0] = SkMScalarToFloat(r[0]);
+        dst4[1] = SkMScalarToFloat(r[1]);
+        dst4[2] = SkMScalarToFloat(r[2]);
         dst4[3] = 1;
         src2 += 2;
         dst4 += 4;
@@ -797,12 +805,11 @@ static void map2_af(const SkMScalar mat[][4], const float* SK_RESTRICT src2,
 
 static void map2_ad(const SkMScalar mat[][4], const double* SK_RESTRICT src2,
                     int count, double* SK_RESTRICT dst4) {
+    const Sk4d col0(mat[0][0], mat[0][1], mat[0][2], mat[0][3]);
+    const Sk4d col1(mat[1][0], mat[1][1], mat[1][2], mat[1][3]);
+    const Sk4d col3(mat[3][0], mat[3][1], mat[3][2], mat[3][3]);
     for (int n = 0; n < count; ++n) {
-        double sx = src2[0];
-        double sy = src2[1];
-        dst4[0] = mat[0][0] * sx + mat[1][0] * sy + mat[3][0];
-        dst4[1] = mat[0][1] * sx + mat[1][1] * sy + mat[3][1];
-        dst4[2] = mat[0][2] * sx + mat[1][2] * sy + mat[3][2];
+        (col0 * Sk4d(src2[0]) + col1 * Sk4d(src2[1]) + col3).store(dst4);
         dst4[3] = 1;
         src2 += 2;
         dst4 += 4;
@@ -811,13 +818,16 @@ static void map2_ad(const SkMScalar mat[][4], const double* SK_RESTRICT src2,
 
 static void map2_pf(const SkMScalar mat[][4], const float* SK_RESTRICT src2,
                     int count, float* SK_RESTRICT dst4) {
-    SkMScalar r;
+    const Sk4m col0 = Sk4m::Load(mat[0]);
+    const Sk4m col1 = Sk4m::Load(mat[1]);
+    const Sk4m col3 = Sk4m::Load(mat[3]);
+    SkMScalar r[4];
     for (int n = 0; n < count; ++n) {
-        SkMScalar sx = SkFloatToMScalar(src2[0]);
-        SkMScalar sy = SkFloatToMScalar(src2[1]);
+        Sk4m sx(SkFloatToMScalar(src2[0]));
+        Sk4m sy(SkFloatToMScalar(src2[1]));
+        (col0 * sx + col1 * sy + col3).store(r);
         for (int i = 0; i < 4; i++) {
-            r = mat[0][i] * sx + mat[1][i] * sy + mat[3][i];
-            dst4[i] = SkMScalarToFloat(r);
+            dst4[i] = SkMScalarToFloat(r[i]);
         }
         src2 += 2;
         dst4 += 4;
@@ -826,12 +836,11 @@ static void map2_pf(const SkMScalar mat[][4], const float* SK_RESTRICT src2,
 
 static void map2_pd(const SkMScalar mat[][4], const double* SK_RESTRICT src2,
                     int count, double* SK_RESTRICT dst4) {
+    const Sk4d col0(mat[0][0], mat[0][1], mat[0][2], mat[0][3]);
+    const Sk4d col1(mat[1][0], mat[1][1], mat[1][2], mat[1][3]);
+    const Sk4d col3(mat[3][0], mat[3][1], mat[3][2], mat[3][3]);
     for (int n = 0; n < count; ++n) {
-        double sx = src2[0];
-        double sy = src2[1];
-        for (int i = 0; i < 4; i++) {
-            dst4[i] = mat[0][i] * sx + mat[1][i] * sy + mat[3][i];
-        }
+        (col0 * Sk4d(src2[0]) + col1 * Sk4d(src2[1]) + col3).store(dst4);
         src2 += 2;
         dst4 += 4;
     }
@@ -6,11 +6,18 @@
  */
 
 #include "SkBBoxHierarchy.h"
+#include "SkBitmap.h"
 #include "SkCanvas.h"
 #include "SkData.h"
+#include "SkImage.h"
 #include "SkPictureUtils.h"
+#include "SkPixelRef.h"
 #include "SkRecord.h"
 #include "SkShader.h"
+#include "SkTArray.h"
+#include "SkTLogic.h"
+#include "SkTSort.h"
+#include "SkTaskGroup.h"
 
 struct MeasureRecords {
     template <typename T> size_t operator()(const T& op) { return 0; }
@@ -33,3 +40,270 @@ size_t SkPictureUtils::ApproximateBytesUsed(const SkPicture* pict) {
 
     return byteCount;
 }
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// A draw of a bitmap or image that playing back a picture will make, reduced to what it takes to
+// make the same draw on a 1x1 canvas. That is enough to decode the pixels and to build any
+// mipmaps or scaled copies the real draw would look up.
+struct PrerollDraw {
+    // Bitmap generation IDs and image IDs come from separate counters, so draws share pixels
+    // when both their kind and ID match.
+    enum Kind {
+        kBitmap_Kind,
+        kImage_Kind,
+    };
+
+    Kind            fKind;
+    uint32_t        fID;
+    SkBitmap        fBitmap;
+    const SkImage*  fImage;     // Used instead of fBitmap if set. Owned by the picture.
+    SkRect          fSrc;       // Empty for the whole bitmap or image.
+    SkRect          fDst;
+    SkMatrix        fMatrix;
+    SkFilterQuality fQuality;
+};
+
+struct NestedPicture {
+    NestedPicture() {}
+    NestedPicture(const SkPicture* picture, const SkMatrix& matrix)
+        : fPicture(picture), fMatrix(matrix) {}
+
+    const SkPicture* fPicture;
+    SkMatrix         fMatrix;
+};
+
+// SkRecord visitor that tracks the CTM like SkRecordDraw's FillBounds, and collects every draw
+// of a bitmap or image, including through bitmap shaders, along with the pictures nested inside.
+class CollectImageDraws : SkNoncopyable {
+    SK_CREATE_MEMBER_DETECTOR(paint);
+public:
+    CollectImageDraws(const SkMatrix& initialCTM, SkPicture const* const drawablePicts[],
+                      int drawableCount, SkTArray<PrerollDraw>* draws,
+                      SkTArray<NestedPicture>* pictures)
+        : fInitialCTM(initialCTM)
+        , fCTM(initialCTM)
+        , fDrawablePicts(drawablePicts)
+        , fDrawableCount(drawableCount)
+        , fDraws(draws)
+        , fPictures(pictures) {}
+
+    template <typename T> void operator()(const T& op) {
+        this->updateCTM(op);
+        this->collectShader(op);
+        this->collect(op);
+    }
+
+private:
+    template <typename T> void updateCTM(const T&) {}
+    void updateCTM(const SkRecords::Restore& op)   { fCTM.setConcat(fInitialCTM, op.matrix); }
+    void updateCTM(const SkRecords::SetMatrix& op) { fCTM.setConcat(fInitialCTM, op.matrix); }
+
+    static const SkPaint* AsPtr(const SkRecords::Optional<SkPaint>& paint) { return paint; }
+    static const SkPaint* AsPtr(const SkPaint& paint) { return &paint; }
+
+    static SkFilterQuality Quality(const SkPaint* paint) {
+        return paint ? paint->getFilterQuality() : kNone_SkFilterQuality;
+    }
+
+    template <typename T>
+    SK_WHEN(HasMember_paint<T>, void) collectShader(const T& op) {
+        const SkPaint* paint = AsPtr(op.paint);
+        SkShader* shader = paint ? paint->getShader() : NULL;
+        SkBitmap bitmap;
+        SkMatrix localMatrix;
+        SkShader::TileMode xy[2];
+        if (shader &&
+            SkShader::kDefault_BitmapType == shader->asABitmap(&bitmap, &localMatrix, xy)) {
+            SkMatrix matrix;
+            matrix.setConcat(fCTM, localMatrix);
+            this->addBitmap(bitmap, NULL, SkRect::MakeWH(SkIntToScalar(bitmap.width()),
+                                                         SkIntToScalar(bitmap.height())),
+                            matrix, paint->getFilterQuality());
+        }
+    }
+    template <typename T>
+    SK_WHEN(!HasMember_paint<T>, void) collectShader(const T&) {}
+    // SaveLayer has a paint too, but its shader is never drawn.
+    void collectShader(const SkRecords::SaveLayer&) {}
+
+    template <typename T> void collect(const T&) {}
+
+    void collect(const SkRecords::DrawBitmap& op) {
+        this->addBitmap(op.bitmap.shallowCopy(), NULL,
+                        SkRect::MakeXYWH(op.left, op.top, SkIntToScalar(op.bitmap.width()),
+                                         SkIntToScalar(op.bitmap.height())),
+                        fCTM, Quality(op.paint));
+    }
+    void collect(const SkRecords::DrawBitmapRectToRect& op) {
+        this->addBitmap(op.bitmap.shallowCopy(), op.src, op.dst, fCTM, Quality(op.paint));
+    }
+    void collect(const SkRecords::DrawBitmapRectToRectBleed& op) {
+        this->addBitmap(op.bitmap.shallowCopy(), op.src, op.dst, fCTM, Quality(op.paint));
+    }
+    // Nine-patches and sprites are not filtered, so they only need decoding.
+    void collect(const SkRecords::DrawBitmapNine& op) {
+        this->addBitmap(op.bitmap.shallowCopy(), NULL, op.dst, fCTM, kNone_SkFilterQuality);
+    }
+    void collect(const SkRecords::DrawSprite& op) {
+        this->addBitmap(op.bitmap.shallowCopy(), NULL,
+                        SkRect::MakeXYWH(SkIntToScalar(op.left), SkIntToScalar(op.top),
+                                         SkIntToScalar(op.bitmap.width()),
+                                         SkIntToScalar(op.bitmap.height())),
+                        SkMatrix::I(), kNone_SkFilterQuality);
+    }
+    void collect(const SkRecords::DrawImage& op) {
+        this->addImage(op.image, NULL,
+                       SkRect::MakeXYWH(op.left, op.top, SkIntToScalar(op.image->width()),
+                                        SkIntToScalar(op.image->height())),
+                       Quality(op.paint));
+    }
+    void collect(const SkRecords::DrawImageRect& op) {
+        this->addImage(op.image, op.src, op.dst, Quality(op.paint));
+    }
+
+    void collect(const SkRecords::DrawPicture& op) {
+        SkMatrix matrix;
+        matrix.setConcat(fCTM, op.matrix);
+        fPictures->push_back(NestedPicture(op.picture, matrix));
+    }
+    void collect(const SkRecords::DrawDrawable& op) {
+        if (op.index >= 0 && op.index < fDrawableCount) {
+            fPictures->push_back(NestedPicture(fDrawablePicts[op.index], fCTM));
+        }
+    }
+
+    void addBitmap(const SkBitmap& bitmap, const SkRect* src, const SkRect& dst,
+                   const SkMatrix& matrix, SkFilterQuality quality) {
+        if (NULL == bitmap.pixelRef() || bitmap.getTexture()) {
+            return;
+        }
+        PrerollDraw& draw = fDraws->push_back();
+        draw.fKind = PrerollDraw::kBitmap_Kind;
+        draw.fID = bitmap.getGenerationID();
+        draw.fBitmap = bitmap;
+        draw.fImage = NULL;
+        draw.fSrc = src ? *src : SkRect::MakeEmpty();
+        draw.fDst = dst;
+        draw.fMatrix = matrix;
+        draw.fQuality = quality;
+    }
+
+    void addImage(const SkImage* image, const SkRect* src, const SkRect& dst,
+                  SkFilterQuality quality) {
+        if (image->getTexture()) {
+            return;
+        }
+        PrerollDraw& draw = fDraws->push_back();
+        draw.fKind = PrerollDraw::kImage_Kind;
+        draw.fID = image->uniqueID();
+        draw.fImage = image;
+        draw.fSrc = src ? *src : SkRect::MakeEmpty();
+        draw.fDst = dst;
+        draw.fMatrix = fCTM;
+        draw.fQuality = quality;
+    }
+
+    const SkMatrix              fInitialCTM;
+    SkMatrix                    fCTM;
+    SkPicture const* const*     fDrawablePicts;
+    const int                   fDrawableCount;
+    SkTArray<PrerollDraw>*      fDraws;
+    SkTArray<NestedPicture>*    fPictures;
+};
+
+struct PrerollGroup {
+    const PrerollDraw* const*   fDraws;
+    int                         fCount;
+};
+
+// Makes each draw of one bitmap or image on a 1x1 canvas, placed so that the draw covers it.
+static void preroll_group(PrerollGroup* group) {
+    SkBitmap pixel;
+    pixel.allocN32Pixels(1, 1);
+    SkCanvas canvas(pixel);
+    for (int i = 0; i < group->fCount; ++i) {
+        const PrerollDraw& draw = *group->fDraws[i];
+        // The first draw decodes. Later ones only matter if they are filtered, and so may
+        // look up mipmaps or scaled copies.
+        if (i > 0 && draw.fQuality < kMedium_SkFilterQuality) {
+            continue;
+        }
+        SkRect devDst;
+        draw.fMatrix.mapRect(&devDst, draw.fDst);
+        SkMatrix matrix = draw.fMatrix;
+        matrix.postTranslate(-SkScalarFloorToScalar(devDst.centerX()),
+                             -SkScalarFloorToScalar(devDst.centerY()));
+        canvas.setMatrix(matrix);
+
+        SkPaint paint;
+        paint.setFilterQuality(draw.fQuality);
+        const SkRect* src = draw.fSrc.isEmpty() ? NULL : &draw.fSrc;
+        if (draw.fImage) {
+            canvas.drawImageRect(draw.fImage, src, draw.fDst, &paint);
+        } else {
+            SkAutoLockPixels alp(draw.fBitmap);
+            canvas.drawBitmapRectToRect(draw.fBitmap, src, draw.fDst, &paint);
+        }
+    }
+}
+
+static bool same_pixels(const PrerollDraw* a, const PrerollDraw* b) {
+    return a->fKind == b->fKind && a->fID == b->fID;
+}
+
+struct KeyLessThan {
+    bool operator()(const PrerollDraw* a, const PrerollDraw* b) const {
+        if (a->fKind != b->fKind) {
+            return a->fKind < b->fKind;
+        }
+        return a->fID < b->fID || (a->fID == b->fID && a < b);
+    }
+};
+
+}  // namespace
+
+int SkPictureUtils::PreDecodeImages(const SkPicture* pict, const SkMatrix& matrix) {
+    SkTArray<PrerollDraw> draws;
+    SkTArray<NestedPicture> pictures;
+    pictures.push_back(NestedPicture(pict, matrix));
+    while (!pictures.empty()) {
+        const NestedPicture next = pictures.back();
+        pictures.pop_back();
+        CollectImageDraws visitor(next.fMatrix, next.fPicture->drawablePicts(),
+                                  next.fPicture->drawableCount(), &draws, &pictures);
+        const SkRecord& record = *next.fPicture->fRecord;
+        for (unsigned curOp = 0; curOp < record.count(); curOp++) {
+            record.visit<void>(curOp, visitor);
+        }
+    }
+    if (draws.empty()) {
+        return 0;
+    }
+
+    // Draws of the same pixels go to the same task, in the order they were recorded, so each
+    // bitmap or image is decoded only once.
+    SkAutoTMalloc<const PrerollDraw*> sorted(draws.count());
+    for (int i = 0; i < draws.count(); ++i) {
+        sorted[i] = &draws[i];
+    }
+    KeyLessThan lessThan;
+    SkTQSort(sorted.get(), sorted.get() + draws.count() - 1, lessThan);
+
+    SkTDArray<PrerollGroup> groups;
+    for (int i = 0; i < draws.count(); ++i) {
+        if (0 == i || !same_pixels(sorted[i], sorted[i - 1])) {
+            PrerollGroup* group = groups.append();
+            group->fDraws = &sorted[i];
+            group->fCount = 0;
+        }
+        groups.top().fCount++;
+    }
+
+    SkTaskGroup tg;
+    tg.batch(preroll_group, groups.begin(), groups.count());
+    tg.wait();
+    return groups.count();
+}
@@ -14,6 +14,7 @@
 #include "SkBitmapProcShader.h"
 #include "SkData.h"
 #include "SkEndian.h"
+#include "SkTaskGroup.h"
 
 #include "SkTextureCompression_opts.h"
 
@@ -119,6 +120,65 @@ int GetCompressedDataSize(Format fmt, int width, int height) {
     return -1;
 }
 
+namespace {
+
+struct CompressBand {
+    CompressionProc fProc;
+    uint8_t*        fDst;
+    const uint8_t*  fSrc;
+    int             fWidth;
+    int             fHeight;
+    size_t          fRowBytes;
+    bool            fSuccess;
+};
+
+}  // namespace
+
+static void compress_band(CompressBand* band) {
+    band->fSuccess = band->fProc(band->fDst, band->fSrc, band->fWidth, band->fHeight,
+                                 band->fRowBytes);
+}
+
+// Blocks are compressed independently and stored a row of blocks at a time, so large buffers
+// are split into bands of block rows, compressed in parallel.
+static bool compress_in_bands(CompressionProc proc, uint8_t* dst, const uint8_t* src,
+                              int width, int height, size_t rowBytes, Format format) {
+    static const int64_t kMinPixelsPerBand = 128 * 1024;
+    static const int kMaxBands = 32;
+
+    int dimX, dimY;
+    GetBlockDimensions(format, &dimX, &dimY, true);
+    const int blockRows = height / dimY;
+    const int bandCount = (int)SkTMin<int64_t>(SkTMin(kMaxBands, blockRows),
+                                               sk_64_mul(width, height) / kMinPixelsPerBand);
+    if (bandCount <= 1 || (width % dimX) != 0 || (height % dimY) != 0) {
+        return proc(dst, src, width, height, rowBytes);
+    }
+
+    const int blockRowSize = GetCompressedDataSize(format, width, dimY);
+    SkAutoSTMalloc<kMaxBands, CompressBand> bands(bandCount);
+    for (int i = 0; i < bandCount; ++i) {
+        const int first = blockRows * i / bandCount;
+        const int last = blockRows * (i + 1) / bandCount;
+        bands[i].fProc = proc;
+        bands[i].fDst = dst + first * blockRowSize;
+        bands[i].fSrc = src + first * dimY * rowBytes;
+        bands[i].fWidth = width;
+        bands[i].fHeight = (last - first) * dimY;
+        bands[i].fRowBytes = rowBytes;
+    }
+    SkTaskGroup tg;
+    tg.batch(compress_band, bands.get(), bandCount);
+    tg.wait();
+
+    for (int i = 0; i < bandCount; ++i) {
+        if (!bands[i].fSuccess) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool CompressBufferToFormat(uint8_t* dst, const uint8_t* src, SkColorType srcColorType,
                             int width, int height, size_t rowBytes, Format format, bool opt) {
     CompressionProc proc = NULL;
@@ -166,11 +226,14 @@ bool CompressBufferToFormat(uint8_t* dst, const uint8_t* src, SkColorType srcCol
         }
     }
 
-    if (proc) {
-        return proc(dst, src, width, height, rowBytes);
+    if (NULL == proc) {
+        return false;
     }
 
-    return false;
+    if (opt) {
+        return compress_in_bands(proc, dst, src, width, height, rowBytes, format);
+    }
+    return proc(dst, src, width, height, rowBytes);
 }
 
 SkData* CompressBitmapToFormat(const SkBitmap &bitmap, Format format) {
@@ -63,6 +63,8 @@ namespace SkTextureCompressor {
     // Compresses the given src data into dst. The src data is assumed to be
     // large enough to hold width*height pixels. The dst data is expected to
     // be large enough to hold the compressed data according to the format.
+    // With opt, platform specific encoders are used if there are any, and large
+    // buffers are compressed on several threads.
     bool CompressBufferToFormat(uint8_t* dst, const uint8_t* src, SkColorType srcColorType,
                                 int width, int height, size_t rowBytes, Format format,
                                 bool opt = true /* Use optimization if available */);
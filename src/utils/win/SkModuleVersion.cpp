@@ -0,0 +1,34 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkModuleVersion.h"
+#include "SkString.h"
+#include "SkTemplates.h"
+
+bool sk_append_module_version(const WCHAR* moduleName, SkString* version) {
+    HMODULE module = GetModuleHandleW(moduleName);
+    WCHAR path[MAX_PATH];
+    if (NULL == module || 0 == GetModuleFileNameW(module, path, SK_ARRAY_COUNT(path))) {
+        return false;
+    }
+    DWORD size = GetFileVersionInfoSizeW(path, NULL);
+    if (0 == size) {
+        return false;
+    }
+    SkAutoTMalloc<uint8_t> info(size);
+    VS_FIXEDFILEINFO* fixed;
+    UINT fixedSize;
+    if (!GetFileVersionInfoW(path, 0, size, info.get()) ||
+        !VerQueryValueW(info.get(), L"\\", reinterpret_cast<void**>(&fixed), &fixedSize) ||
+        fixedSize < sizeof(VS_FIXEDFILEINFO)) {
+        return false;
+    }
+    version->appendf("%u.%u.%u.%u",
+                     HIWORD(fixed->dwFileVersionMS), LOWORD(fixed->dwFileVersionMS),
+                     HIWORD(fixed->dwFileVersionLS), LOWORD(fixed->dwFileVersionLS));
+    return true;
+}
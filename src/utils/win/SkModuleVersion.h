@@ -0,0 +1,20 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef SkModuleVersion_DEFINED
+#define SkModuleVersion_DEFINED
+
+#include "SkTypes.h"
+
+class SkString;
+
+/** Appends the file version of the loaded module (e.g. L"dwrite.dll") to version, as
+ *  "major.minor.build.revision". Returns false and appends nothing if it can't be found.
+ */
+bool sk_append_module_version(const WCHAR* moduleName, SkString* version);
+
+#endif
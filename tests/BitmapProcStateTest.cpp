@@ -0,0 +1,137 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkShader.h"
+#include "Test.h"
+
+static const int kSrcSize = 32;
+
+// Each channel ramps in a different direction, so sampling the wrong texel (or weighting the
+// right ones wrongly) shows up as a large error, while bilinear interpolation stays smooth.
+static void make_src(SkBitmap* src) {
+    src->allocN32Pixels(kSrcSize, kSrcSize);
+    for (int y = 0; y < kSrcSize; ++y) {
+        for (int x = 0; x < kSrcSize; ++x) {
+            *src->getAddr32(x, y) = SkPackARGB32(0xFF, x * 8, y * 8, 0xFF - (x + y) * 4);
+        }
+    }
+}
+
+// Bilinear sampling of src (clamped at its edges) at the center of device pixel (x, y), in floats.
+static void reference_sample(const SkBitmap& src, const SkMatrix& inverse, int x, int y,
+                             float out[4]) {
+    SkPoint pt;
+    inverse.mapXY(x + SK_ScalarHalf, y + SK_ScalarHalf, &pt);
+    const float u = pt.fX - 0.5f, v = pt.fY - 0.5f;
+    const int x0 = (int)floorf(u), y0 = (int)floorf(v);
+    const float fx = u - x0, fy = v - y0;
+    const int max = kSrcSize - 1;
+    const SkPMColor c00 = *src.getAddr32(SkPin32(x0,     0, max), SkPin32(y0,     0, max));
+    const SkPMColor c01 = *src.getAddr32(SkPin32(x0 + 1, 0, max), SkPin32(y0,     0, max));
+    const SkPMColor c10 = *src.getAddr32(SkPin32(x0,     0, max), SkPin32(y0 + 1, 0, max));
+    const SkPMColor c11 = *src.getAddr32(SkPin32(x0 + 1, 0, max), SkPin32(y0 + 1, 0, max));
+    for (int i = 0; i < 4; ++i) {
+        const int shift = i * 8;
+        out[i] = ((c00 >> shift) & 0xFF) * (1 - fx) * (1 - fy) +
+                 ((c01 >> shift) & 0xFF) * fx * (1 - fy) +
+                 ((c10 >> shift) & 0xFF) * (1 - fx) * fy +
+                 ((c11 >> shift) & 0xFF) * fx * fy;
+    }
+}
+
+// Draws src through matrix with bilinear filtering, and compares every pixel with
+// reference_sample().  Our spans have odd lengths, to cover the procs' leftover pixels too.
+static void test_filter(skiatest::Reporter* reporter, const SkBitmap& src,
+                        const SkMatrix& matrix, U8CPU alpha, const char* name) {
+    SkBitmap dst;
+    dst.allocN32Pixels(61, 53);
+    dst.eraseColor(SK_ColorTRANSPARENT);
+
+    SkAutoTUnref<SkShader> shader(SkShader::CreateBitmapShader(src, SkShader::kClamp_TileMode,
+                                                               SkShader::kClamp_TileMode,
+                                                               &matrix));
+    SkPaint paint;
+    paint.setShader(shader);
+    paint.setFilterQuality(kLow_SkFilterQuality);
+    paint.setAlpha(alpha);
+    paint.setXfermodeMode(SkXfermode::kSrc_Mode);
+    SkCanvas canvas(dst);
+    canvas.drawPaint(paint);
+
+    SkMatrix inverse;
+    REPORTER_ASSERT(reporter, matrix.invert(&inverse));
+    const unsigned alphaScale = SkAlpha255To256(alpha);
+
+    int mismatches = 0;
+    float worst = 0;
+    for (int y = 0; y < dst.height(); ++y) {
+        for (int x = 0; x < dst.width(); ++x) {
+            float expected[4];
+            reference_sample(src, inverse, x, y, expected);
+            const SkPMColor actual = *dst.getAddr32(x, y);
+            for (int i = 0; i < 4; ++i) {
+                // Subpixel positions are quantized to 1/16, and each step truncates.
+                const float diff = SkScalarAbs(expected[i] * alphaScale / 256 -
+                                               ((actual >> (i * 8)) & 0xFF));
+                worst = SkTMax(worst, diff);
+                if (diff > 3) {
+                    mismatches++;
+                }
+            }
+            if (0xFF == alpha) {
+                REPORTER_ASSERT(reporter, 0xFF == SkGetPackedA32(actual));
+            }
+        }
+    }
+    if (mismatches) {
+        ERRORF(reporter, "%s, alpha %d: %d channels differ, by up to %g",
+               name, alpha, mismatches, worst);
+    }
+}
+
+DEF_TEST(BitmapProcState_Bilerp, reporter) {
+    SkBitmap src;
+    make_src(&src);
+
+    SkMatrix scale;
+    scale.setScale(2.3f, 1.7f);
+    scale.postTranslate(-3.25f, 2.5f);
+
+    SkMatrix downscale;
+    downscale.setScale(0.8f, 0.9f);
+    downscale.postTranslate(5.5f, -1.25f);
+
+    SkMatrix rotate;
+    rotate.setRotate(30);
+    rotate.postScale(1.5f, 1.5f);
+    rotate.postTranslate(20, -5);
+
+    SkMatrix persp;
+    persp.setScale(1.8f, 1.6f);
+    persp.setPerspX(0.004f);
+    persp.setPerspY(-0.002f);
+    persp.postTranslate(2, 3);
+
+    const struct {
+        const SkMatrix& fMatrix;
+        const char*     fName;
+    } matrices[] = {
+        { scale,     "scale"       },
+        { downscale, "downscale"   },
+        { rotate,    "affine"      },
+        { persp,     "perspective" },
+    };
+    const U8CPU alphas[] = { 0xFF, 0x80 };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(matrices); ++i) {
+        for (size_t j = 0; j < SK_ARRAY_COUNT(alphas); ++j) {
+            test_filter(reporter, src, matrices[i].fMatrix, alphas[j], matrices[i].fName);
+        }
+    }
+}
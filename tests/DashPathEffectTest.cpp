@@ -7,7 +7,11 @@
 
 #include "Test.h"
 
+#include "SkBitmap.h"
+#include "SkCanvas.h"
 #include "SkDashPathEffect.h"
+#include "SkDashPathPriv.h"
+#include "SkStrokeRec.h"
 #include "SkWriteBuffer.h"
 
 // crbug.com/348821 was rooted in SkDashPathEffect refusing to flatten and unflatten itself when
@@ -86,3 +90,118 @@ DEF_TEST(DashPathEffectTest_asPoints, r) {
         }
     }
 }
+
+// A polyline of short segments, plus a closed curvy contour, long enough for thousands of dashes.
+static SkPath make_long_path() {
+    SkPath path;
+    path.moveTo(2, 2);
+    for (int i = 1; i <= 400; ++i) {
+        path.lineTo(SkIntToScalar(2 + (i * 7) % 96), SkIntToScalar(2 + (i * 13) % 96));
+    }
+    path.addCircle(50, 50, 30);
+    path.moveTo(5, 90);
+    path.quadTo(50, 10, 95, 90);
+    return path;
+}
+
+struct CollectSink : public SkDashPath::SegmentSink {
+    CollectSink() : fBatches(0), fTooBig(false) {}
+
+    void drawSegments(const SkPath& segments, const SkStrokeRec&) override {
+        SkPath::Iter iter(segments, false);
+        SkPoint pts[4];
+        SkPath::Verb verb;
+        int contours = 0;
+        while ((verb = iter.next(pts, false)) != SkPath::kDone_Verb) {
+            contours += SkPath::kMove_Verb == verb;
+        }
+        fTooBig |= contours > SkDashPath::kMaxSegmentsPerBatch;
+        fBatches++;
+        fPath.addPath(segments);
+    }
+
+    SkPath  fPath;
+    int     fBatches;
+    bool    fTooBig;
+};
+
+// Streaming a dashed path must produce the same segments as building it, a batch at a time.
+DEF_TEST(DashPathEffectTest_stream, r) {
+    const SkScalar intervals[] = { 3, 2, 1, 2 };
+    SkAutoTUnref<SkDashPathEffect> dash(SkDashPathEffect::Create(intervals, 4, 1.5f));
+    SkPathEffect::DashInfo info;
+    SkScalar storage[4];
+    info.fIntervals = storage;
+    info.fCount = 4;
+    REPORTER_ASSERT(r, SkPathEffect::kDash_DashType == dash->asADash(&info));
+
+    const SkPath path = make_long_path();
+    REPORTER_ASSERT(r, SkDashPath::MaxDashCount(path, info) > SkDashPath::kMaxSegmentsPerBatch);
+
+    SkPaint paint;
+    paint.setStyle(SkPaint::kStroke_Style);
+    SkPath expected;
+    SkStrokeRec rec(paint);
+    REPORTER_ASSERT(r, SkDashPath::FilterDashPath(&expected, path, &rec, NULL, info));
+
+    CollectSink sink;
+    SkStrokeRec streamRec(paint);
+    REPORTER_ASSERT(r, SkDashPath::StreamDashPath(path, &streamRec, NULL, info, &sink));
+    REPORTER_ASSERT(r, sink.fBatches > 1);
+    REPORTER_ASSERT(r, !sink.fTooBig);
+    REPORTER_ASSERT(r, expected.countVerbs() == sink.fPath.countVerbs());
+    REPORTER_ASSERT(r, expected.countPoints() == sink.fPath.countPoints());
+    REPORTER_ASSERT(r, expected == sink.fPath);
+}
+
+// Drawing a long dashed path (which streams its dashes) must match drawing its dashed path.
+static void test_draw_streamed(skiatest::Reporter* r, const SkPath& path, SkPaint paint) {
+    SkBitmap bitmaps[2];
+    for (int i = 0; i < 2; ++i) {
+        bitmaps[i].allocN32Pixels(100, 100);
+        bitmaps[i].eraseColor(SK_ColorWHITE);
+    }
+
+    SkCanvas(bitmaps[0]).drawPath(path, paint);
+
+    SkPath dashed;
+    const bool doFill = paint.getFillPath(path, &dashed);
+    paint.setPathEffect(NULL);
+    if (doFill) {
+        paint.setStyle(SkPaint::kFill_Style);
+    } else {
+        paint.setStrokeWidth(0);
+    }
+    SkCanvas(bitmaps[1]).drawPath(dashed, paint);
+
+    REPORTER_ASSERT(r, 0 == memcmp(bitmaps[0].getPixels(), bitmaps[1].getPixels(),
+                                   bitmaps[0].getSize()));
+}
+
+DEF_TEST(DashPathEffectTest_drawStreamed, r) {
+    const SkScalar dots[] = { 1, 1 };
+    const SkScalar dashes[] = { 3, 2, 1, 2 };
+
+    SkPaint paint;
+    paint.setColor(0x80102030);
+    paint.setStyle(SkPaint::kStroke_Style);
+    for (int aa = 0; aa < 2; ++aa) {
+        paint.setAntiAlias(SkToBool(aa));
+
+        // Hairlines.
+        paint.setPathEffect(SkDashPathEffect::Create(dashes, 4, 0))->unref();
+        test_draw_streamed(r, make_long_path(), paint);
+
+        // A thick line, which the dasher strokes into rects.
+        SkPath line;
+        line.moveTo(-5000, 10);
+        line.lineTo(5000, 90);
+        paint.setStrokeWidth(3);
+        test_draw_streamed(r, line, paint);
+
+        // Dashes too close together to fill separately.
+        paint.setPathEffect(SkDashPathEffect::Create(dots, 2, 0))->unref();
+        test_draw_streamed(r, line, paint);
+        paint.setStrokeWidth(0);
+    }
+}
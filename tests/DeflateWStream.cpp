@@ -12,7 +12,8 @@
 DEF_TEST(SkDeflateWStream, r) {
     SkRandom random(123456);
     for (int i = 0; i < 50; ++i) {
-        uint32_t size = random.nextULessThan(10000);
+        // Every tenth stream is big enough to be compressed in several batches of blocks.
+        uint32_t size = random.nextULessThan(i % 10 ? 10000 : 2000000);
         SkAutoTMalloc<uint8_t> buffer(size);
         for (uint32_t j = 0; j < size; ++j) {
             buffer[j] = random.nextU() & 0xff;
@@ -5,6 +5,7 @@
  * found in the LICENSE file.
  */
 #include "SkDiscardableMemoryPool.h"
+#include "SkTaskGroup.h"
 
 #include "Test.h"
 
@@ -33,3 +34,180 @@ DEF_TEST(DiscardableMemoryPool, reporter) {
     REPORTER_ASSERT(reporter, !dm2->lock());
     REPORTER_ASSERT(reporter, 0 == pool->getRAMUsed());
 }
+
+// Small allocations share slabs, and the least recently used slabs are purged first.
+DEF_TEST(DiscardableMemoryPool_Slabs, reporter) {
+    SkAutoTUnref<SkDiscardableMemoryPool> pool(
+        SkDiscardableMemoryPool::Create(1024 * 1024, NULL));
+    SkDiscardableMemoryPool::Stats stats;
+
+    static const int kCount = 20;
+    SkDiscardableMemory* small[kCount];
+    for (int i = 0; i < kCount; ++i) {
+        small[i] = pool->create(1000);
+        memset(small[i]->data(), i, 1000);
+        small[i]->unlock();
+    }
+    pool->getStats(&stats);
+    REPORTER_ASSERT(reporter, kCount * 1000 == stats.fUsedBytes);
+    // 1000 bytes round up to 1024, so one slab holds them all.
+    REPORTER_ASSERT(reporter, stats.fSlabBytes >= kCount * 1024);
+    REPORTER_ASSERT(reporter, stats.fSlabBytes <= 256 * 1024);
+
+    // A second slab of bigger blocks, used more recently than the first.
+    SkDiscardableMemory* big = pool->create(200 * 1000);
+    big->unlock();
+    REPORTER_ASSERT(reporter, big->lock());
+    big->unlock();
+
+    // Going over budget purges all of the first slab, but none of the second.
+    pool->getStats(&stats);
+    pool->setRAMBudget(stats.fSlabBytes - 1);
+    for (int i = 0; i < kCount; ++i) {
+        REPORTER_ASSERT(reporter, !small[i]->lock());
+    }
+    REPORTER_ASSERT(reporter, big->lock());
+    big->unlock();
+    REPORTER_ASSERT(reporter, 200 * 1000 == pool->getRAMUsed());
+
+    pool->getStats(&stats);
+    REPORTER_ASSERT(reporter, kCount == stats.fPurges);
+    REPORTER_ASSERT(reporter, 1 == stats.fSlabsFreed);
+    REPORTER_ASSERT(reporter, 2 == stats.fHits);
+    REPORTER_ASSERT(reporter, kCount == stats.fMisses);
+
+    for (int i = 0; i < kCount; ++i) {
+        SkDELETE(small[i]);
+    }
+    SkDELETE(big);
+    pool->dumpPool();
+    pool->getStats(&stats);
+    REPORTER_ASSERT(reporter, 0 == stats.fUsedBytes);
+    REPORTER_ASSERT(reporter, 0 == stats.fSlabBytes);
+}
+
+// The budget bounds the memory held in slabs, not just the bytes asked for, and empty slabs are
+// not kept around while the pool is over budget.
+DEF_TEST(DiscardableMemoryPool_SlabBudget, reporter) {
+    static const size_t kBudget = 1024 * 1024;
+    SkAutoTUnref<SkDiscardableMemoryPool> pool(SkDiscardableMemoryPool::Create(kBudget, NULL));
+    SkDiscardableMemoryPool::Stats stats;
+
+    static const int kCount = 16;
+    SkDiscardableMemory* dms[kCount];
+    for (int i = 0; i < kCount; ++i) {
+        dms[i] = pool->create(200 * 1000);
+        dms[i]->unlock();
+        pool->getStats(&stats);
+        REPORTER_ASSERT(reporter, stats.fSlabBytes <= kBudget);
+    }
+    // The most recent allocations are the ones still around.
+    REPORTER_ASSERT(reporter, dms[kCount - 1]->lock());
+    dms[kCount - 1]->unlock();
+    REPORTER_ASSERT(reporter, !dms[0]->lock());
+    for (int i = 0; i < kCount; ++i) {
+        SkDELETE(dms[i]);
+    }
+
+    // Locked memory can push the pool over budget, and then an empty slab is freed right away.
+    pool->setRAMBudget(64 * 1024);
+    SkAutoTDelete<SkDiscardableMemory> locked(pool->create(100 * 1000));
+    SkDiscardableMemory* small = pool->create(1000);
+    small->unlock();
+    SkDELETE(small);
+    pool->getStats(&stats);
+    REPORTER_ASSERT(reporter, stats.fSlabBytes < 128 * 1024);
+    REPORTER_ASSERT(reporter, 100 * 1000 == stats.fUsedBytes);
+    locked->unlock();
+    locked.free();
+
+    // One locked block doesn't keep the unlocked blocks of its slab from being purged, and the
+    // slab goes once that block is unlocked too.
+    pool->setRAMBudget(kBudget);
+    static const int kBlocks = 64;
+    SkDiscardableMemory* blocks[kBlocks];
+    for (int i = 0; i < kBlocks; ++i) {
+        blocks[i] = pool->create(1000);
+        if (i > 0) {
+            blocks[i]->unlock();
+        }
+    }
+    pool->setRAMBudget(1024);
+    pool->getStats(&stats);
+    REPORTER_ASSERT(reporter, 1000 == stats.fUsedBytes);
+    REPORTER_ASSERT(reporter, stats.fSlabBytes > 0);
+    REPORTER_ASSERT(reporter, !blocks[kBlocks - 1]->lock());
+    blocks[0]->unlock();
+    pool->getStats(&stats);
+    REPORTER_ASSERT(reporter, 0 == stats.fUsedBytes);
+    REPORTER_ASSERT(reporter, 0 == stats.fSlabBytes);
+    for (int i = 0; i < kBlocks; ++i) {
+        SkDELETE(blocks[i]);
+    }
+}
+
+namespace {
+
+struct Churn {
+    SkDiscardableMemoryPool* fPool;
+    int                      fSeed;
+    bool                     fCorrupt;
+};
+
+// Creates, locks, checks, unlocks and deletes discardable memory of assorted sizes.
+void churn(Churn* churn) {
+    static const int kCount = 16;
+    SkDiscardableMemory* dms[kCount];
+    size_t sizes[kCount];
+    for (int i = 0; i < kCount; ++i) {
+        sizes[i] = 100 + ((churn->fSeed * 7919 + i * 104729) % 20000);
+        dms[i] = churn->fPool->create(sizes[i]);
+        memset(dms[i]->data(), churn->fSeed + i, sizes[i]);
+        dms[i]->unlock();
+    }
+    for (int pass = 0; pass < 20; ++pass) {
+        for (int i = 0; i < kCount; ++i) {
+            if (dms[i]->lock()) {
+                const uint8_t* data = (const uint8_t*)dms[i]->data();
+                if (data[0] != (uint8_t)(churn->fSeed + i) ||
+                    data[sizes[i] - 1] != (uint8_t)(churn->fSeed + i)) {
+                    churn->fCorrupt = true;
+                }
+                dms[i]->unlock();
+            } else {
+                SkDELETE(dms[i]);
+                dms[i] = churn->fPool->create(sizes[i]);
+                memset(dms[i]->data(), churn->fSeed + i, sizes[i]);
+                dms[i]->unlock();
+            }
+        }
+    }
+    for (int i = 0; i < kCount; ++i) {
+        SkDELETE(dms[i]);
+    }
+}
+
+}  // namespace
+
+SK_DECLARE_STATIC_MUTEX(gChurnMutex);
+
+// Memory that locks successfully always still holds what was written to it, even while other
+// threads make the pool purge.
+DEF_TEST(DiscardableMemoryPool_Threads, reporter) {
+    SkAutoTUnref<SkDiscardableMemoryPool> pool(
+        SkDiscardableMemoryPool::Create(256 * 1024, &gChurnMutex));
+    static const int kThreads = 8;
+    Churn churns[kThreads];
+    for (int i = 0; i < kThreads; ++i) {
+        churns[i].fPool = pool;
+        churns[i].fSeed = i;
+        churns[i].fCorrupt = false;
+    }
+    SkTaskGroup tg;
+    tg.batch(churn, churns, kThreads);
+    tg.wait();
+    for (int i = 0; i < kThreads; ++i) {
+        REPORTER_ASSERT(reporter, !churns[i].fCorrupt);
+    }
+    REPORTER_ASSERT(reporter, 0 == pool->getRAMUsed());
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkDistanceFieldGen.h"
+#include "SkPaint.h"
+#include "SkPoint.h"
+#include "SkTemplates.h"
+#include "Test.h"
+
+static void draw_circle(SkBitmap* mask, int size, SkScalar cx, SkScalar cy, SkScalar radius) {
+    mask->allocPixels(SkImageInfo::MakeA8(size, size));
+    mask->eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(*mask);
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    canvas.drawCircle(cx, cy, radius, paint);
+}
+
+// Measures how far a distance field of an anti-aliased circle is from the circle's true distances.
+static void circle_error(const unsigned char* field, int size,
+                         SkScalar cx, SkScalar cy, SkScalar radius, int* maxError, int* sumError) {
+    const int fieldSize = size + 2*SK_DistanceFieldPad;
+    *maxError = 0;
+    *sumError = 0;
+    for (int j = 0; j < fieldSize; ++j) {
+        for (int i = 0; i < fieldSize; ++i) {
+            SkScalar x = SkIntToScalar(i - SK_DistanceFieldPad) + SK_ScalarHalf;
+            SkScalar y = SkIntToScalar(j - SK_DistanceFieldPad) + SK_ScalarHalf;
+            SkScalar dist = SkPoint::Length(x - cx, y - cy) - radius;
+            // Texels outside the field's range can't be checked.
+            if (dist <= -SK_DistanceFieldMagnitude || dist > SK_DistanceFieldMagnitude - 1) {
+                continue;
+            }
+            int expected = (int)((SK_DistanceFieldMagnitude - dist) * 128 /
+                                 SK_DistanceFieldMagnitude);
+            int error = SkAbs32(expected - field[j*fieldSize + i]);
+            *maxError = SkTMax(*maxError, error);
+            *sumError += error;
+        }
+    }
+}
+
+static void test_circle(skiatest::Reporter* reporter, SkDistanceFieldGenerator* generator,
+                        int size, SkScalar cx, SkScalar cy, SkScalar radius) {
+    SkBitmap mask;
+    draw_circle(&mask, size, cx, cy, radius);
+    const size_t fieldSize = SkComputeDistanceFieldSize(size, size);
+    SkAutoTMalloc<unsigned char> sweeps(fieldSize);
+    SkAutoTMalloc<unsigned char> exact(fieldSize);
+
+    REPORTER_ASSERT(reporter, SkGenerateDistanceFieldFromA8Image(
+            sweeps.get(), (const unsigned char*)mask.getPixels(), size, size, mask.rowBytes()));
+    REPORTER_ASSERT(reporter, generator->generateFromA8Image(
+            exact.get(), (const unsigned char*)mask.getPixels(), size, size, mask.rowBytes()));
+
+    // The exact transform should be at least as close to the circle as the sweeps are. Both are
+    // limited by how well the edge texels' distances can be estimated from coverage alone.
+    int sweepsMax, sweepsSum, exactMax, exactSum;
+    circle_error(sweeps.get(), size, cx, cy, radius, &sweepsMax, &sweepsSum);
+    circle_error(exact.get(), size, cx, cy, radius, &exactMax, &exactSum);
+    REPORTER_ASSERT(reporter, exactMax <= sweepsMax);
+    REPORTER_ASSERT(reporter, exactSum <= sweepsSum + sweepsSum / 64);
+    REPORTER_ASSERT(reporter, exactMax < 128 / SK_DistanceFieldMagnitude);  // Within a texel.
+
+    // A fresh generator must give the same answer as one reused from other sizes.
+    SkDistanceFieldGenerator fresh;
+    SkAutoTMalloc<unsigned char> freshField(fieldSize);
+    REPORTER_ASSERT(reporter, fresh.generateFromA8Image(
+            freshField.get(), (const unsigned char*)mask.getPixels(), size, size,
+            mask.rowBytes()));
+    REPORTER_ASSERT(reporter, 0 == memcmp(exact.get(), freshField.get(), fieldSize));
+}
+
+static void test_bw(skiatest::Reporter* reporter) {
+    // A 1-bit square and the same square as an 8-bit mask have the same distance field.
+    static const int kSize = 20;
+    SkBitmap a8;
+    a8.allocPixels(SkImageInfo::MakeA8(kSize, kSize));
+    a8.eraseColor(SK_ColorTRANSPARENT);
+    unsigned char bw[kSize * 3];
+    sk_bzero(bw, sizeof(bw));
+    for (int y = 5; y < 15; ++y) {
+        for (int x = 3; x < 17; ++x) {
+            *a8.getAddr8(x, y) = 0xFF;
+            bw[y*3 + (x >> 3)] |= 0x80 >> (x & 7);
+        }
+    }
+
+    const size_t fieldSize = SkComputeDistanceFieldSize(kSize, kSize);
+    SkAutoTMalloc<unsigned char> fromA8(fieldSize);
+    SkAutoTMalloc<unsigned char> fromBW(fieldSize);
+    SkDistanceFieldGenerator generator;
+    REPORTER_ASSERT(reporter, generator.generateFromA8Image(
+            fromA8.get(), (const unsigned char*)a8.getPixels(), kSize, kSize, a8.rowBytes()));
+    REPORTER_ASSERT(reporter, generator.generateFromBWImage(fromBW.get(), bw, kSize, kSize, 3));
+    REPORTER_ASSERT(reporter, 0 == memcmp(fromA8.get(), fromBW.get(), fieldSize));
+
+    // Deep inside and far outside the square.
+    const int fieldWidth = kSize + 2*SK_DistanceFieldPad;
+    REPORTER_ASSERT(reporter, 255 == fromBW[(10 + SK_DistanceFieldPad)*fieldWidth +
+                                            10 + SK_DistanceFieldPad]);
+    REPORTER_ASSERT(reporter, 0 == fromBW[0]);
+}
+
+static void test_batch(skiatest::Reporter* reporter) {
+    static const int kCount = 40;
+    SkBitmap masks[kCount];
+    SkDistanceFieldJob jobs[kCount];
+    SkAutoTMalloc<unsigned char> fields[kCount];
+    for (int i = 0; i < kCount; ++i) {
+        const int size = 10 + 3*i;
+        draw_circle(&masks[i], size, SkIntToScalar(size) / 2, SkIntToScalar(size) / 3,
+                    SkIntToScalar(size) / 3 + SK_Scalar1 / 4);
+        fields[i].reset(SkComputeDistanceFieldSize(size, size));
+        jobs[i].fDistanceField = fields[i].get();
+        jobs[i].fImage = (const unsigned char*)masks[i].getPixels();
+        jobs[i].fWidth = size;
+        jobs[i].fHeight = size;
+        jobs[i].fRowBytes = masks[i].rowBytes();
+        jobs[i].fIsBW = false;
+    }
+    REPORTER_ASSERT(reporter, SkGenerateDistanceFields(jobs, kCount));
+
+    SkDistanceFieldGenerator generator;
+    for (int i = 0; i < kCount; ++i) {
+        const size_t fieldSize = SkComputeDistanceFieldSize(jobs[i].fWidth, jobs[i].fHeight);
+        SkAutoTMalloc<unsigned char> expected(fieldSize);
+        REPORTER_ASSERT(reporter, generator.generateFromA8Image(
+                expected.get(), jobs[i].fImage, jobs[i].fWidth, jobs[i].fHeight,
+                jobs[i].fRowBytes));
+        REPORTER_ASSERT(reporter, 0 == memcmp(expected.get(), fields[i].get(), fieldSize));
+    }
+}
+
+DEF_TEST(DistanceField, reporter) {
+    SkDistanceFieldGenerator generator;
+    test_circle(reporter, &generator, 64, SkIntToScalar(32), SkIntToScalar(32), SkIntToScalar(20));
+    test_circle(reporter, &generator, 17, SkScalarHalf(17), SkIntToScalar(6), SkIntToScalar(5));
+    test_circle(reporter, &generator, 100, SkIntToScalar(40), SkIntToScalar(55),
+                SkIntToScalar(35) + SK_Scalar1 / 3);
+    test_bw(reporter);
+    test_batch(reporter);
+}
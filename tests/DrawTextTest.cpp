@@ -8,7 +8,10 @@
 #include "SkBitmap.h"
 #include "SkCanvas.h"
 #include "SkColor.h"
+#include "SkGlyphCache.h"
+#include "SkGlyphCache_Globals.h"
 #include "SkPaint.h"
+#include "SkPath.h"
 #include "SkPoint.h"
 #include "SkRect.h"
 #include "SkTypes.h"
@@ -106,3 +109,113 @@ DEF_TEST(DrawText, reporter) {
         }
     }
 }
+
+static const char gPackedText[] = "Hamburgefons jqQ@#%";
+
+enum PackedClip {
+    kNone_PackedClip,
+    kRect_PackedClip,
+    kRegion_PackedClip,
+    kAA_PackedClip,
+};
+
+static void draw_packed_test_text(SkCanvas* canvas, const SkPaint& paint, PackedClip clip) {
+    drawBG(canvas);
+    canvas->save();
+    switch (clip) {
+        case kNone_PackedClip:
+            break;
+        case kRect_PackedClip:
+            canvas->clipRect(SkRect::MakeLTRB(13, 7, 181, 43));
+            break;
+        case kRegion_PackedClip:
+            canvas->clipRect(SkRect::MakeLTRB(5, 3, 60, 40));
+            canvas->clipRect(SkRect::MakeLTRB(90, 20, 170, 60), SkRegion::kUnion_Op);
+            break;
+        case kAA_PackedClip: {
+            SkPath path;
+            path.addCircle(100, 30, 27);
+            canvas->clipPath(path, SkRegion::kIntersect_Op, true);
+            break;
+        }
+    }
+    canvas->drawText(gPackedText, sizeof(gPackedText) - 1, 3, 40, paint);
+    canvas->restore();
+}
+
+// Packing is switched on a font cache private to this thread, so that this test doesn't change
+// (or purge) the strikes that tests on other threads are using.
+static void set_thread_packing(bool pack) {
+    SkGlyphCache_Globals& globals = SkGlyphCache_Globals::GetTLS();
+    globals.setPackImages(pack);
+    globals.purgeAll();
+}
+
+// Packed glyph images must draw exactly like unpacked ones, whether they come back unpacked from
+// findImage (the first draw) or are blitted straight from their runs (later draws).
+DEF_TEST(DrawText_PackedGlyphs, reporter) {
+    const bool hadThreadCache = SkToBool(SkGlyphCache_Globals::FindTLS());
+    const bool prevPacked = SkGlyphCache_Globals::GetTLS().getPackImages();
+    const SkIRect bounds = SkIRect::MakeWH(200, 64);
+
+    SkBitmap expected, actual;
+    create(&expected, bounds);
+    create(&actual, bounds);
+    SkCanvas expectedCanvas(expected);
+    SkCanvas actualCanvas(actual);
+
+    for (int aa = 0; aa <= 1; ++aa) {
+        for (int size = 11; size <= 41; size += 15) {
+            SkPaint paint;
+            paint.setColor(SK_ColorBLUE);
+            paint.setAntiAlias(SkToBool(aa));
+            paint.setTextSize(SkIntToScalar(size));
+
+            for (int clip = kNone_PackedClip; clip <= kAA_PackedClip; ++clip) {
+                set_thread_packing(false);
+                draw_packed_test_text(&expectedCanvas, paint, (PackedClip)clip);
+
+                set_thread_packing(true);
+                for (int pass = 0; pass < 2; ++pass) {
+                    draw_packed_test_text(&actualCanvas, paint, (PackedClip)clip);
+                    REPORTER_ASSERT(reporter, compare(expected, bounds, actual, bounds));
+                }
+            }
+        }
+    }
+
+    // A big, mostly empty glyph should be stored packed, and unpack to the same pixels.
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    paint.setTextSize(SkIntToScalar(60));
+    SkAutoTMalloc<uint8_t> pixels[2];
+    size_t imageSize = 0;
+    bool foundImages = true;
+    for (int packed = 0; packed <= 1 && foundImages; ++packed) {
+        set_thread_packing(SkToBool(packed));
+        SkAutoGlyphCache autoCache(paint, NULL, NULL);
+        SkGlyphCache* cache = autoCache.getCache();
+        const SkGlyph& glyph = cache->getUnicharMetrics('O');
+        const void* image = cache->findImage(glyph);
+        REPORTER_ASSERT(reporter, image);
+        REPORTER_ASSERT(reporter, glyph.isImagePacked() == SkToBool(packed));
+        foundImages = SkToBool(image);
+        if (foundImages) {
+            imageSize = glyph.computeImageSize();
+            pixels[packed].reset(imageSize);
+            memcpy(pixels[packed].get(), image, imageSize);
+            // Asking again unpacks from the stored runs.
+            REPORTER_ASSERT(reporter,
+                            0 == memcmp(cache->findImage(glyph), pixels[packed].get(), imageSize));
+        }
+    }
+    if (foundImages) {
+        REPORTER_ASSERT(reporter, 0 == memcmp(pixels[0].get(), pixels[1].get(), imageSize));
+    }
+
+    if (hadThreadCache) {
+        set_thread_packing(prevPacked);
+    } else {
+        SkGlyphCache_Globals::DeleteTLS();
+    }
+}
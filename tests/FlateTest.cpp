@@ -25,6 +25,26 @@ public:
     static const size_t kGetSizeKey = 0xDEADBEEF;
 };
 
+// A stream that takes the first fLimit bytes written to it and fails to write any more.
+class FailingWStream : public SkWStream {
+public:
+    explicit FailingWStream(size_t limit) : fLimit(limit), fWritten(0) {}
+
+    bool write(const void*, size_t size) override {
+        if (size > fLimit - fWritten) {
+            return false;
+        }
+        fWritten += size;
+        return true;
+    }
+
+    size_t bytesWritten() const override { return fWritten; }
+
+private:
+    const size_t fLimit;
+    size_t       fWritten;
+};
+
 // Returns a deterministic data of the given size that should be
 // very compressible.
 static SkData* new_test_data(size_t dataSize) {
@@ -107,8 +127,18 @@ DEF_TEST(Flate, reporter) {
     SkMemoryStream memStream;
     TestFlate(reporter, &memStream, 512);
     TestFlate(reporter, &memStream, 10240);
+    // Big enough to be split into blocks and deflated in parallel.
+    TestFlate(reporter, &memStream, 1000000);
 
     SkZeroSizeMemStream fileStream;
     TestFlate(reporter, &fileStream, 512);
     TestFlate(reporter, &fileStream, 10240);
+
+    // Failing to write the output fails the deflate, serially and in parallel.
+    const size_t sizes[] = { 10240, 1000000 };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(sizes); ++i) {
+        SkAutoDataUnref testData(new_test_data(sizes[i]));
+        FailingWStream failing(16);
+        REPORTER_ASSERT(reporter, !SkFlate::Deflate(testData->data(), sizes[i], &failing));
+    }
 }
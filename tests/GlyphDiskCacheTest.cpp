@@ -0,0 +1,145 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkData.h"
+#include "SkGlyphCache.h"
+#include "SkGlyphDiskCache.h"
+#include "SkOSFile.h"
+#include "SkPaint.h"
+#include "SkStream.h"
+#include "SkTypeface.h"
+#include "Test.h"
+
+#include <stdio.h>
+
+static bool read_matches(SkGlyphDiskCache* diskCache, const SkData* strikeKey,
+                         const SkGlyph& glyph, const uint8_t expected[]) {
+    size_t size = glyph.computeImageSize();
+    SkAutoTMalloc<uint8_t> storage(size);
+    sk_bzero(storage.get(), size);
+    SkGlyph copy = glyph;
+    copy.fImage = storage.get();
+    return diskCache->readImage(strikeKey, copy) && 0 == memcmp(storage.get(), expected, size);
+}
+
+DEF_TEST(GlyphDiskCache, reporter) {
+    SkString tmpDir = skiatest::GetTmpDir();
+    if (tmpDir.isEmpty()) {
+        return;
+    }
+    SkString path = SkOSPath::Join(tmpDir.c_str(), "glyph_disk_cache_test");
+    remove(path.c_str());
+
+    SkAutoTUnref<SkTypeface> typeface(SkTypeface::RefDefault());
+    SkPaint paint;
+    paint.setTypeface(typeface);
+    paint.setAntiAlias(true);
+    paint.setTextSize(SkIntToScalar(30));
+    SkAutoGlyphCache autoCache(paint, NULL, NULL);
+    SkGlyphCache* cache = autoCache.getCache();
+    const SkGlyph& glyph = cache->getUnicharMetrics('g');
+    const uint8_t* image = (const uint8_t*)cache->findImage(glyph);
+    REPORTER_ASSERT(reporter, image);
+    if (NULL == image) {
+        return;
+    }
+    const size_t size = glyph.computeImageSize();
+    SkAutoTMalloc<uint8_t> pixels(size);
+    memcpy(pixels.get(), image, size);
+
+    SkAutoTUnref<SkData> strikeKey(SkGlyphDiskCache::NewStrikeKey(cache->getScalerContext(),
+                                                                  cache->getDescriptor()));
+    // Strike keys don't depend on the typeface's ID in this process.
+    {
+        SkAutoTUnref<SkData> again(SkGlyphDiskCache::NewStrikeKey(cache->getScalerContext(),
+                                                                  cache->getDescriptor()));
+        REPORTER_ASSERT(reporter, strikeKey->equals(again));
+        SkAutoTUnref<SkTypeface> sameFont(SkTypeface::RefDefault());
+        SkPaint samePaint(paint);
+        samePaint.setTypeface(sameFont);
+        SkAutoGlyphCache sameCache(samePaint, NULL, NULL);
+        again.reset(SkGlyphDiskCache::NewStrikeKey(sameCache.getCache()->getScalerContext(),
+                                                   sameCache.getCache()->getDescriptor()));
+        REPORTER_ASSERT(reporter, strikeKey->equals(again));
+    }
+    {
+        SkGlyphDiskCache diskCache(path.c_str());
+        REPORTER_ASSERT(reporter, !read_matches(&diskCache, strikeKey, glyph, pixels.get()));
+
+        SkGlyph copy = glyph;
+        copy.fImage = pixels.get();
+        diskCache.addImage(strikeKey, copy);
+        // Readable before it is written out...
+        REPORTER_ASSERT(reporter, read_matches(&diskCache, strikeKey, glyph, pixels.get()));
+        diskCache.flush();
+        // ...and after.
+        REPORTER_ASSERT(reporter, read_matches(&diskCache, strikeKey, glyph, pixels.get()));
+    }
+
+    {
+        // Another cache using the same file (e.g. in the next process) sees it too.
+        SkGlyphDiskCache diskCache(path.c_str());
+        REPORTER_ASSERT(reporter, read_matches(&diskCache, strikeKey, glyph, pixels.get()));
+
+        // Nothing for other strikes, even one whose key has the same hash, or for the same glyph
+        // ID with different metrics.
+        SkAutoTMalloc<uint8_t> collidingBytes(strikeKey->size());
+        memcpy(collidingBytes.get(), strikeKey->data(), strikeKey->size());
+        collidingBytes[strikeKey->size() - 1] ^= 1;
+        SkAutoTUnref<SkData> colliding(SkData::NewWithCopy(collidingBytes.get(),
+                                                           strikeKey->size()));
+        REPORTER_ASSERT(reporter, !read_matches(&diskCache, colliding, glyph, pixels.get()));
+        SkGlyph moved = glyph;
+        moved.fLeft += 1;
+        REPORTER_ASSERT(reporter, !read_matches(&diskCache, strikeKey, moved, pixels.get()));
+    }
+
+    {
+        // A different size is a different strike.
+        SkPaint bigger(paint);
+        bigger.setTextSize(SkIntToScalar(31));
+        SkAutoGlyphCache otherCache(bigger, NULL, NULL);
+        SkAutoTUnref<SkData> otherKey(SkGlyphDiskCache::NewStrikeKey(
+                otherCache.getCache()->getScalerContext(), otherCache.getCache()->getDescriptor()));
+        REPORTER_ASSERT(reporter, !strikeKey->equals(otherKey));
+
+        // Both strikes live in the file side by side.
+        const SkGlyph& otherGlyph = otherCache.getCache()->getUnicharMetrics('g');
+        const void* otherImage = otherCache.getCache()->findImage(otherGlyph);
+        REPORTER_ASSERT(reporter, otherImage);
+        if (otherImage) {
+            {
+                SkGlyphDiskCache diskCache(path.c_str());
+                diskCache.addImage(otherKey, otherGlyph);
+            }
+            SkGlyphDiskCache diskCache(path.c_str());
+            REPORTER_ASSERT(reporter, read_matches(&diskCache, strikeKey, glyph, pixels.get()));
+            REPORTER_ASSERT(reporter, read_matches(&diskCache, otherKey, otherGlyph,
+                                                   (const uint8_t*)otherImage));
+        }
+    }
+
+    {
+        // A clobbered file is ignored, and replaced on the next write.
+        SkFILEWStream garbage(path.c_str());
+        garbage.write("not a glyph cache", 17);
+    }
+    {
+        SkGlyphDiskCache diskCache(path.c_str());
+        REPORTER_ASSERT(reporter, !read_matches(&diskCache, strikeKey, glyph, pixels.get()));
+        SkGlyph copy = glyph;
+        copy.fImage = pixels.get();
+        diskCache.addImage(strikeKey, copy);
+        diskCache.flush();
+    }
+    {
+        SkGlyphDiskCache diskCache(path.c_str());
+        REPORTER_ASSERT(reporter, read_matches(&diskCache, strikeKey, glyph, pixels.get()));
+    }
+
+    remove(path.c_str());
+}
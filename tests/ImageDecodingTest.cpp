@@ -6,6 +6,7 @@
  */
 
 #include "Resources.h"
+#include "SkBBHFactory.h"
 #include "SkBitmap.h"
 #include "SkCanvas.h"
 #include "SkColor.h"
@@ -20,6 +21,7 @@
 #include "SkImageGeneratorPriv.h"
 #include "SkImagePriv.h"
 #include "SkOSFile.h"
+#include "SkPictureRecorder.h"
 #include "SkPoint.h"
 #include "SkShader.h"
 #include "SkStream.h"
@@ -753,3 +755,169 @@ DEF_TEST(ImageDecoding_JpegOverwrite, r) {
     REPORTER_ASSERT(r, !allocator->ready());  // Decoder used correct memory
     REPORTER_ASSERT(r, sentinal == pixels[pixelCount]);
 }
+
+// Large images are deflated in parallel blocks and written as our own IDAT chunks.  Make sure
+// that produces a PNG that decodes back to the original pixels, with and without alpha.
+DEF_TEST(ImageDecoding_LargePNGRoundTrip, r) {
+    for (int opaque = 0; opaque <= 1; ++opaque) {
+        SkBitmap bm;
+        bm.allocN32Pixels(700, 400, SkToBool(opaque));
+        for (int y = 0; y < bm.height(); ++y) {
+            for (int x = 0; x < bm.width(); ++x) {
+                // Opaque pixels, so the unpremul/premul round trip is exact.
+                *bm.getAddr32(x, y) = SkPackARGB32(0xFF, (x * y) & 0xFF, (x + y) & 0xFF,
+                                                   x & 0x0F);
+            }
+        }
+
+        SkAutoDataUnref data(SkImageEncoder::EncodeData(bm, SkImageEncoder::kPNG_Type, 100));
+        REPORTER_ASSERT(r, data.get());
+        if (!data.get()) {
+            continue;
+        }
+
+        SkBitmap decoded;
+        bool success = SkImageDecoder::DecodeMemory(data->data(), data->size(), &decoded,
+                                                    kN32_SkColorType,
+                                                    SkImageDecoder::kDecodePixels_Mode);
+        REPORTER_ASSERT(r, success);
+        if (!success) {
+            continue;
+        }
+        REPORTER_ASSERT(r, decoded.width() == bm.width() && decoded.height() == bm.height());
+
+        SkAutoLockPixels alp(bm), alpDecoded(decoded);
+        for (int y = 0; y < bm.height(); ++y) {
+            if (0 != memcmp(bm.getAddr32(0, y), decoded.getAddr32(0, y), bm.width() * 4)) {
+                ERRORF(r, "PNG round trip mismatch in row %d (opaque: %d)", y, opaque);
+                break;
+            }
+        }
+    }
+}
+
+static SkPicture* make_band_test_picture(int width, int height) {
+    SkPictureRecorder recorder;
+    SkRTreeFactory factory;
+    SkCanvas* canvas = recorder.beginRecording(SkIntToScalar(width), SkIntToScalar(height),
+                                               &factory);
+    canvas->clear(SK_ColorWHITE);
+    // Aliased rects: every pixel stays exactly opaque (surviving the PNG round trip), and
+    // clipping to a band can't change which pixels they cover, as it could for curves.
+    SkPaint paint;
+    for (int i = 0; i < 20; ++i) {
+        paint.setColor(SkColorSetARGB(0xFF, i * 12, 255 - i * 12, (i * 37) & 0xFF));
+        canvas->drawRect(SkRect::MakeXYWH(SkIntToScalar((i * 53) % width),
+                                          SkIntToScalar((i * 29) % height),
+                                          SkIntToScalar(5 + 2 * i), SkIntToScalar(30 - i)),
+                         paint);
+    }
+    return recorder.endRecording();
+}
+
+static void test_picture_bands(skiatest::Reporter* r, int width, int height) {
+    SkAutoTUnref<SkPicture> picture(make_band_test_picture(width, height));
+    const SkImageInfo info = SkImageInfo::MakeN32(width, height, kOpaque_SkAlphaType);
+
+    SkBitmap expected;
+    expected.allocPixels(info);
+    expected.eraseColor(SK_ColorTRANSPARENT);
+    SkCanvas canvas(expected);
+    canvas.drawPicture(picture);
+
+    const int bandHeights[] = { 1, 17, height, 1000 };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(bandHeights); ++i) {
+        SkDynamicMemoryWStream stream;
+        REPORTER_ASSERT(r, SkImageEncoder::EncodePicture(&stream, picture, info,
+                                                         SkImageEncoder::kPNG_Type, 100,
+                                                         bandHeights[i]));
+        SkAutoDataUnref data(stream.copyToData());
+        SkBitmap decoded;
+        bool success = SkImageDecoder::DecodeMemory(data->data(), data->size(), &decoded,
+                                                    kN32_SkColorType,
+                                                    SkImageDecoder::kDecodePixels_Mode);
+        REPORTER_ASSERT(r, success);
+        if (!success) {
+            continue;
+        }
+        REPORTER_ASSERT(r, decoded.width() == width && decoded.height() == height);
+
+        SkAutoLockPixels alp(expected), alpDecoded(decoded);
+        for (int y = 0; y < height; ++y) {
+            if (0 != memcmp(expected.getAddr32(0, y), decoded.getAddr32(0, y), width * 4)) {
+                ERRORF(r, "%dx%d, band height %d: mismatch in row %d", width, height,
+                       bandHeights[i], y);
+                break;
+            }
+        }
+
+        // JPEG is lossy, so just make sure something sensible comes out.
+        SkDynamicMemoryWStream jpegStream;
+        REPORTER_ASSERT(r, SkImageEncoder::EncodePicture(&jpegStream, picture, info,
+                                                         SkImageEncoder::kJPEG_Type, 90,
+                                                         bandHeights[i]));
+        SkAutoDataUnref jpegData(jpegStream.copyToData());
+        SkBitmap jpegBitmap;
+        REPORTER_ASSERT(r, SkImageDecoder::DecodeMemory(jpegData->data(), jpegData->size(),
+                                                        &jpegBitmap, kN32_SkColorType,
+                                                        SkImageDecoder::kDecodeBounds_Mode));
+        REPORTER_ASSERT(r, jpegBitmap.width() == width && jpegBitmap.height() == height);
+    }
+}
+
+// Encoding a picture band by band should give the same pixels as rendering it all at once.
+DEF_TEST(ImageEncoding_PictureBands, r) {
+    test_picture_bands(r, 97, 211);
+    // Big enough for the PNG encoder to deflate in parallel.
+    test_picture_bands(r, 613, 211);
+}
+
+namespace {
+
+// Accepts the first fLimit bytes written to it, then fails.
+class LimitedWStream : public SkWStream {
+public:
+    LimitedWStream(size_t limit) : fLimit(limit), fBytesWritten(0) {}
+
+    bool write(const void*, size_t size) override {
+        if (size > fLimit - fBytesWritten) {
+            return false;
+        }
+        fBytesWritten += size;
+        return true;
+    }
+
+    size_t bytesWritten() const override { return fBytesWritten; }
+
+private:
+    size_t fLimit;
+    size_t fBytesWritten;
+};
+
+}  // namespace
+
+// The parallel deflate path must report a stream that fails partway through the image data or
+// the chunks after it.
+DEF_TEST(ImageDecoding_LargePNGWriteFailure, r) {
+    SkBitmap bm;
+    bm.allocN32Pixels(700, 400);
+    for (int y = 0; y < bm.height(); ++y) {
+        for (int x = 0; x < bm.width(); ++x) {
+            *bm.getAddr32(x, y) = SkPackARGB32(0xFF, (x * y) & 0xFF, (x + y) & 0xFF, x & 0x0F);
+        }
+    }
+
+    SkAutoDataUnref data(SkImageEncoder::EncodeData(bm, SkImageEncoder::kPNG_Type, 100));
+    REPORTER_ASSERT(r, data.get());
+    if (!data.get()) {
+        return;
+    }
+
+    const size_t limits[] = { data->size() / 2, data->size() - 1, data->size() };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(limits); ++i) {
+        LimitedWStream stream(limits[i]);
+        const bool success = SkImageEncoder::EncodeStream(&stream, bm, SkImageEncoder::kPNG_Type,
+                                                          100);
+        REPORTER_ASSERT(r, success == (limits[i] == data->size()));
+    }
+}
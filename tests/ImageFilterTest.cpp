@@ -31,6 +31,7 @@
 #include "SkRect.h"
 #include "SkRectShaderImageFilter.h"
 #include "SkTileImageFilter.h"
+#include "SkUnPreMultiply.h"
 #include "SkXfermodeImageFilter.h"
 #include "Test.h"
 
@@ -1136,6 +1137,267 @@ DEF_TEST(ComposedImageFilterOffset, reporter) {
     REPORTER_ASSERT(reporter, offset.fX == 1 && offset.fY == 0);
 }
 
+// A straightforward per-pixel version of the lighting filters' math, for interior pixels.
+struct LightingReference {
+    enum Light { kDistant, kPoint, kSpot } fLight;
+    SkPoint3 fPoint;        // Direction for distant lights, location otherwise.
+    SkPoint3 fTarget;
+    SkScalar fSpecularExponent, fCutoffAngle;
+    SkColor  fColor;
+    SkScalar fSurfaceScale;
+    SkScalar fK, fShininess;  // fShininess < 0 means diffuse.
+
+    SkPMColor light(const SkBitmap& src, int x, int y) const {
+        int a[3][3];
+        for (int j = 0; j < 3; ++j) {
+            for (int i = 0; i < 3; ++i) {
+                a[j][i] = SkGetPackedA32(*src.getAddr32(x - 1 + i, y - 1 + j));
+            }
+        }
+        SkScalar nx = (a[0][2] - a[0][0] + 2 * (a[1][2] - a[1][0]) + a[2][2] - a[2][0]) * 0.25f;
+        SkScalar ny = (a[2][0] - a[0][0] + 2 * (a[2][1] - a[0][1]) + a[2][2] - a[0][2]) * 0.25f;
+        // The filters take surfaceScale in units of full alpha.
+        const SkScalar surfaceScale = fSurfaceScale / 255;
+        SkPoint3 normal(-nx * surfaceScale, -ny * surfaceScale, 1);
+        normal.normalize();
+
+        SkPoint3 surfaceToLight = fPoint;
+        if (kDistant != fLight) {
+            surfaceToLight = SkPoint3(fPoint.fX - x, fPoint.fY - y,
+                                      fPoint.fZ - a[1][1] * surfaceScale);
+            surfaceToLight.normalize();
+        }
+        SkPoint3 color(SkColorGetR(fColor), SkColorGetG(fColor), SkColorGetB(fColor));
+        if (kSpot == fLight) {
+            SkPoint3 s = fTarget - fPoint;
+            s.normalize();
+            SkScalar cosOuter = SkScalarCos(SkDegreesToRadians(fCutoffAngle));
+            SkScalar cosAngle = -surfaceToLight.dot(s);
+            SkScalar scale = cosAngle < cosOuter ? 0 : SkScalarPow(cosAngle, fSpecularExponent);
+            if (cosAngle >= cosOuter && cosAngle < cosOuter + 0.016f) {
+                scale = scale * (cosAngle - cosOuter) / 0.016f;
+            }
+            color = color * scale;
+        }
+
+        SkScalar colorScale;
+        if (fShininess < 0) {
+            colorScale = fK * normal.dot(surfaceToLight);
+        } else {
+            SkPoint3 halfDir(surfaceToLight);
+            halfDir.fZ += 1;
+            halfDir.normalize();
+            colorScale = fK * SkScalarPow(normal.dot(halfDir), fShininess);
+        }
+        color = color * SkScalarClampMax(colorScale, 1);
+        SkScalar alpha = fShininess < 0 ? 255 : color.maxComponent();
+        return SkPackARGB32(SkClampMax(SkScalarRoundToInt(alpha), 255),
+                            SkClampMax(SkScalarRoundToInt(color.fX), 255),
+                            SkClampMax(SkScalarRoundToInt(color.fY), 255),
+                            SkClampMax(SkScalarRoundToInt(color.fZ), 255));
+    }
+
+    SkImageFilter* createFilter() const {
+        if (fShininess < 0) {
+            switch (fLight) {
+                case kDistant: return SkLightingImageFilter::CreateDistantLitDiffuse(
+                                       fPoint, fColor, fSurfaceScale, fK);
+                case kPoint:   return SkLightingImageFilter::CreatePointLitDiffuse(
+                                       fPoint, fColor, fSurfaceScale, fK);
+                case kSpot:    return SkLightingImageFilter::CreateSpotLitDiffuse(
+                                       fPoint, fTarget, fSpecularExponent, fCutoffAngle, fColor,
+                                       fSurfaceScale, fK);
+            }
+        }
+        switch (fLight) {
+            case kDistant: return SkLightingImageFilter::CreateDistantLitSpecular(
+                                   fPoint, fColor, fSurfaceScale, fK, fShininess);
+            case kPoint:   return SkLightingImageFilter::CreatePointLitSpecular(
+                                   fPoint, fColor, fSurfaceScale, fK, fShininess);
+            case kSpot:    return SkLightingImageFilter::CreateSpotLitSpecular(
+                                   fPoint, fTarget, fSpecularExponent, fCutoffAngle, fColor,
+                                   fSurfaceScale, fK, fShininess);
+        }
+        return NULL;
+    }
+};
+
+static bool nearly_equal(SkPMColor a, SkPMColor b) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        if (SkAbs32((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF)) > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Lighting is evaluated several pixels at a time and in bands on several threads; each pixel
+// must still come out as if lit on its own.
+DEF_TEST(ImageFilterLightingMatchesReference, reporter) {
+    // Wide and tall enough to be split into bands, with an odd width to leave ragged row ends.
+    const int width = 203, height = 171;
+    SkBitmap src;
+    src.allocN32Pixels(width, height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            U8CPU alpha = (x * 7 + y * 13 + (x * y) % 17) & 0xFF;
+            *src.getAddr32(x, y) = SkPreMultiplyARGB(alpha, 0xFF, 0xFF, 0xFF);
+        }
+    }
+
+    const SkColor color = SkColorSetRGB(0xFF, 0xC0, 0x80);
+    const SkPoint3 direction(-0.5f, -0.3f, 0.8f);
+    const SkPoint3 location(60, 40, 50), target(120, 100, 0);
+    const LightingReference lightings[] = {
+        { LightingReference::kDistant, direction, target, 0, 0, color, 3, 1.5f, -1 },
+        { LightingReference::kPoint,   location,  target, 0, 0, color, 3, 1.5f, -1 },
+        { LightingReference::kSpot,    location,  target, 2, 40, color, 3, 1.5f, -1 },
+        { LightingReference::kDistant, direction, target, 0, 0, color, 2, 1, 8 },
+        { LightingReference::kPoint,   location,  target, 0, 0, color, 2, 1, 8 },
+        { LightingReference::kSpot,    location,  target, 2, 40, color, 2, 1, 8 },
+    };
+
+    SkBitmap deviceBitmap;
+    deviceBitmap.allocN32Pixels(width, height);
+    SkBitmapDevice device(deviceBitmap);
+    SkDeviceImageFilterProxy proxy(&device, SkSurfaceProps(SkSurfaceProps::kLegacyFontHost_InitType));
+    SkImageFilter::Context ctx(SkMatrix::I(), SkIRect::MakeWH(width, height), NULL);
+
+    for (size_t i = 0; i < SK_ARRAY_COUNT(lightings); ++i) {
+        SkAutoTUnref<SkImageFilter> filter(lightings[i].createFilter());
+        SkBitmap result;
+        SkIPoint offset;
+        REPORTER_ASSERT(reporter, filter->filterImage(&proxy, src, ctx, &result, &offset));
+        REPORTER_ASSERT(reporter, result.width() == width && result.height() == height);
+        REPORTER_ASSERT(reporter, offset.fX == 0 && offset.fY == 0);
+        SkAutoLockPixels alp(result);
+        int mismatches = 0;
+        for (int y = 1; y < height - 1; ++y) {
+            for (int x = 1; x < width - 1; ++x) {
+                if (!nearly_equal(*result.getAddr32(x, y), lightings[i].light(src, x, y))) {
+                    mismatches++;
+                }
+            }
+        }
+        REPORTER_ASSERT_MESSAGE(reporter, 0 == mismatches, "lighting differs from reference");
+    }
+}
+
+// The straightforward convolution, one pixel at a time. Without convolveAlpha, src must already
+// be unpremultiplied (as the filter does it), and each result keeps src's alpha at (x, y).
+static SkPMColor convolve_reference(const SkBitmap& src, int x, int y, int size,
+                                    const SkScalar kernel[], SkScalar gain, SkScalar bias,
+                                    const SkIPoint& offset,
+                                    SkMatrixConvolutionImageFilter::TileMode tileMode,
+                                    bool convolveAlpha) {
+    SkScalar sums[4] = { 0, 0, 0, 0 };
+    for (int cy = 0; cy < size; ++cy) {
+        for (int cx = 0; cx < size; ++cx) {
+            int sx = x + cx - offset.fX, sy = y + cy - offset.fY;
+            SkPMColor s;
+            if (SkMatrixConvolutionImageFilter::kClamp_TileMode == tileMode) {
+                s = *src.getAddr32(SkPin32(sx, 0, src.width() - 1),
+                                   SkPin32(sy, 0, src.height() - 1));
+            } else if (SkMatrixConvolutionImageFilter::kRepeat_TileMode == tileMode) {
+                s = *src.getAddr32((sx + src.width()) % src.width(),
+                                   (sy + src.height()) % src.height());
+            } else if (sx < 0 || sx >= src.width() || sy < 0 || sy >= src.height()) {
+                s = 0;
+            } else {
+                s = *src.getAddr32(sx, sy);
+            }
+            SkScalar k = kernel[cy * size + cx];
+            sums[0] += k * SkGetPackedA32(s);
+            sums[1] += k * SkGetPackedR32(s);
+            sums[2] += k * SkGetPackedG32(s);
+            sums[3] += k * SkGetPackedB32(s);
+        }
+    }
+    int a = convolveAlpha ? SkClampMax(SkScalarFloorToInt(sums[0] * gain + bias), 255) : 255;
+    int r = SkClampMax(SkScalarFloorToInt(sums[1] * gain + bias), a);
+    int g = SkClampMax(SkScalarFloorToInt(sums[2] * gain + bias), a);
+    int b = SkClampMax(SkScalarFloorToInt(sums[3] * gain + bias), a);
+    if (!convolveAlpha) {
+        return SkPreMultiplyARGB(SkGetPackedA32(*src.getAddr32(x, y)), r, g, b);
+    }
+    return SkPackARGB32(a, r, g, b);
+}
+
+DEF_TEST(ImageFilterMatrixConvolutionMatchesReference, reporter) {
+    // Big enough to be split into bands, for both kernels.
+    const int width = 401, height = 301;
+    SkBitmap src;
+    src.allocN32Pixels(width, height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            U8CPU alpha = (x * 7 + y * 13 + (x * y) % 17) & 0xFF;
+            *src.getAddr32(x, y) = SkPreMultiplyARGB(alpha, x & 0xFF, y & 0xFF, (x ^ y) & 0xFF);
+        }
+    }
+    // What the filter convolves without convolveAlpha.
+    SkBitmap unpremul;
+    unpremul.allocN32Pixels(width, height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            *unpremul.getAddr32(x, y) = SkUnPreMultiply::PMColorToColor(*src.getAddr32(x, y));
+        }
+    }
+
+    // A separable tent, and the same with a dent in it, which isn't.
+    const int size = 9;
+    SkScalar separable[size * size], general[size * size];
+    for (int y = 0; y < size; ++y) {
+        for (int x = 0; x < size; ++x) {
+            separable[y * size + x] =
+                    SkIntToScalar((SkTMin(x, size - 1 - x) + 1) * (SkTMin(y, size - 1 - y) + 1));
+            general[y * size + x] = separable[y * size + x];
+        }
+    }
+    general[3 * size + 5] = 0;
+    const SkScalar* kernels[] = { separable, general };
+    const SkIPoint kernelOffset = SkIPoint::Make(3, 5);
+    const SkScalar gain = 0.0015f, bias = SkIntToScalar(3);
+
+    SkBitmap deviceBitmap;
+    deviceBitmap.allocN32Pixels(width, height);
+    SkBitmapDevice device(deviceBitmap);
+    SkDeviceImageFilterProxy proxy(&device, SkSurfaceProps(SkSurfaceProps::kLegacyFontHost_InitType));
+    SkImageFilter::Context ctx(SkMatrix::I(), SkIRect::MakeWH(width, height), NULL);
+
+    for (int convolveAlpha = 0; convolveAlpha <= 1; ++convolveAlpha) {
+        const SkBitmap& referenceSrc = convolveAlpha ? src : unpremul;
+        for (size_t k = 0; k < SK_ARRAY_COUNT(kernels); ++k) {
+            for (int tileMode = 0; tileMode <= SkMatrixConvolutionImageFilter::kMax_TileMode;
+                 ++tileMode) {
+                SkMatrixConvolutionImageFilter::TileMode mode =
+                        (SkMatrixConvolutionImageFilter::TileMode)tileMode;
+                SkAutoTUnref<SkImageFilter> filter(SkMatrixConvolutionImageFilter::Create(
+                        SkISize::Make(size, size), kernels[k], gain, bias, kernelOffset, mode,
+                        SkToBool(convolveAlpha)));
+                SkBitmap result;
+                SkIPoint offset;
+                REPORTER_ASSERT(reporter, filter->filterImage(&proxy, src, ctx, &result, &offset));
+                REPORTER_ASSERT(reporter, result.width() == width && result.height() == height);
+                SkAutoLockPixels alp(result);
+                int mismatches = 0;
+                for (int y = 0; y < height; ++y) {
+                    for (int x = 0; x < width; ++x) {
+                        SkPMColor expected = convolve_reference(referenceSrc, x, y, size,
+                                                                kernels[k], gain, bias,
+                                                                kernelOffset, mode,
+                                                                SkToBool(convolveAlpha));
+                        if (!nearly_equal(*result.getAddr32(x, y), expected)) {
+                            mismatches++;
+                        }
+                    }
+                }
+                REPORTER_ASSERT_MESSAGE(reporter, 0 == mismatches,
+                                        "matrix convolution differs from reference");
+            }
+        }
+    }
+}
+
 #if SK_SUPPORT_GPU
 const SkSurfaceProps gProps = SkSurfaceProps(SkSurfaceProps::kLegacyFontHost_InitType);
 
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkLayerPool.h"
+#include "SkPicture.h"
+#include "SkPictureRecorder.h"
+#include "SkRTree.h"
+#include "Test.h"
+
+static bool is_zero(const SkBitmap& bitmap) {
+    SkAutoLockPixels alp(bitmap);
+    const uint8_t* pixels = (const uint8_t*)bitmap.getPixels();
+    for (size_t i = 0; i < bitmap.getSize(); ++i) {
+        if (pixels[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DEF_TEST(LayerPool_AllocPixels, reporter) {
+    // Big enough to be pooled. Whether or not the second allocation reuses the first one's
+    // memory (another thread may get to it first), it must start out cleared.
+    const SkImageInfo info = SkImageInfo::MakeN32Premul(200, 100);
+    for (int i = 0; i < 2; ++i) {
+        SkBitmap bitmap;
+        bitmap.setInfo(info);
+        REPORTER_ASSERT(reporter, SkLayerPool::AllocPixels(&bitmap));
+        REPORTER_ASSERT(reporter, bitmap.getPixels());
+        REPORTER_ASSERT(reporter, bitmap.rowBytes() == info.minRowBytes());
+        REPORTER_ASSERT(reporter, is_zero(bitmap));
+        bitmap.eraseColor(SK_ColorRED);
+    }
+
+    // Small layers come straight from malloc.
+    SkBitmap small;
+    small.setInfo(SkImageInfo::MakeN32Premul(4, 4));
+    REPORTER_ASSERT(reporter, SkLayerPool::AllocPixels(&small));
+    REPORTER_ASSERT(reporter, is_zero(small));
+
+    SkBitmap empty;
+    empty.setInfo(SkImageInfo::MakeN32Premul(0, 0));
+    REPORTER_ASSERT(reporter, !SkLayerPool::AllocPixels(&empty));
+}
+
+namespace {
+
+// Remembers the device-space bounds of the layers it was asked to make.
+class LayerBoundsCanvas : public SkCanvas {
+public:
+    LayerBoundsCanvas(const SkBitmap& bitmap) : INHERITED(bitmap) {}
+
+    SkTDArray<SkIRect> fLayerBounds;
+
+protected:
+    SaveLayerStrategy willSaveLayer(const SkRect* bounds, const SkPaint* paint,
+                                    SaveFlags flags) override {
+        SkRect devBounds;
+        if (bounds) {
+            this->getTotalMatrix().mapRect(&devBounds, *bounds);
+        } else {
+            SkIRect clipBounds;
+            this->getClipDeviceBounds(&clipBounds);
+            devBounds.set(clipBounds);
+        }
+        devBounds.roundOut(fLayerBounds.append());
+        return INHERITED::willSaveLayer(bounds, paint, flags);
+    }
+
+private:
+    typedef SkCanvas INHERITED;
+};
+
+}  // namespace
+
+static SkPicture* record_layers(bool computeLayerInfo) {
+    SkRTreeFactory factory;
+    SkPictureRecorder recorder;
+    SkCanvas* canvas = recorder.beginRecording(200, 200, &factory, computeLayerInfo
+                                               ? SkPictureRecorder::kComputeSaveLayerInfo_RecordFlag
+                                               : 0);
+    SkPaint layerPaint;
+    layerPaint.setAlpha(0x80);
+    SkPaint paint;
+    paint.setColor(SK_ColorBLUE);
+
+    canvas->translate(20, 30);
+    canvas->saveLayer(NULL, &layerPaint);
+        canvas->drawRect(SkRect::MakeXYWH(10, 10, 30, 20), paint);
+        canvas->drawOval(SkRect::MakeXYWH(20, 15, 30, 20), paint);
+    canvas->restore();
+    return recorder.endRecording();
+}
+
+// With SkLayerInfo, playback should only allocate layers as big as what's drawn into them, and
+// draw exactly the same pixels.
+DEF_TEST(LayerPool_PictureLayerBounds, reporter) {
+    SkBitmap bitmaps[2];
+    SkTDArray<SkIRect> layerBounds[2];
+    for (int i = 0; i < 2; ++i) {
+        SkAutoTUnref<SkPicture> picture(record_layers(SkToBool(i)));
+        bitmaps[i].allocN32Pixels(200, 200);
+        bitmaps[i].eraseColor(SK_ColorWHITE);
+        LayerBoundsCanvas canvas(bitmaps[i]);
+        canvas.scale(2, 2);
+        canvas.drawPicture(picture);
+        layerBounds[i] = canvas.fLayerBounds;
+    }
+
+    REPORTER_ASSERT(reporter, 1 == layerBounds[0].count() && 1 == layerBounds[1].count());
+    if (1 == layerBounds[0].count() && 1 == layerBounds[1].count()) {
+        // Without layer info, the layer covers the whole canvas.
+        REPORTER_ASSERT(reporter, layerBounds[0][0] == SkIRect::MakeWH(200, 200));
+        // With it, just the rect and oval, (60,80)-(140,130) after the scale, plus padding.
+        const SkIRect& tight = layerBounds[1][0];
+        REPORTER_ASSERT(reporter, tight.contains(SkIRect::MakeLTRB(60, 80, 140, 130)));
+        REPORTER_ASSERT(reporter, SkIRect::MakeLTRB(54, 74, 146, 136).contains(tight));
+    }
+
+    SkAutoLockPixels alp0(bitmaps[0]), alp1(bitmaps[1]);
+    REPORTER_ASSERT(reporter, 0 == memcmp(bitmaps[0].getPixels(), bitmaps[1].getPixels(),
+                                          bitmaps[0].getSize()));
+}
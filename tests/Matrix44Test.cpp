@@ -212,12 +212,40 @@ static void test_map2(skiatest::Reporter* reporter, const SkMatrix44& mat) {
     }
 }
 
+// map2() maps several points at a time, for both floats and doubles.
+static void test_map2_batch(skiatest::Reporter* reporter, const SkMatrix44& mat) {
+    const int kCount = 7;
+    float  src2f[2 * kCount], dst4f[4 * kCount];
+    double src2d[2 * kCount], dst4d[4 * kCount];
+    for (int i = 0; i < 2 * kCount; ++i) {
+        src2f[i] = (float)(i * 3 - 10) / 4;
+        src2d[i] = src2f[i];
+    }
+
+    mat.map2(src2f, kCount, dst4f);
+    mat.map2(src2d, kCount, dst4d);
+    for (int n = 0; n < kCount; ++n) {
+        SkScalar src4f[] = { src2f[2 * n], src2f[2 * n + 1], 0, 1 };
+        SkScalar expectedf[4];
+        mat.mapScalars(src4f, expectedf);
+
+        SkMScalar src4m[] = { src2f[2 * n], src2f[2 * n + 1], 0, 1 };
+        SkMScalar expectedm[4];
+        mat.mapMScalars(src4m, expectedm);
+        for (int i = 0; i < 4; ++i) {
+            REPORTER_ASSERT(reporter, expectedf[i] == dst4f[4 * n + i]);
+            REPORTER_ASSERT(reporter, expectedm[i] == dst4d[4 * n + i]);
+        }
+    }
+}
+
 static void test_map2(skiatest::Reporter* reporter) {
     SkMatrix44 mat(SkMatrix44::kUninitialized_Constructor);
 
     for (size_t i = 0; i < SK_ARRAY_COUNT(gMakeProcs); ++i) {
         gMakeProcs[i](&mat);
         test_map2(reporter, mat);
+        test_map2_batch(reporter, mat);
     }
 }
 
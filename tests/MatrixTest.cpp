@@ -921,6 +921,62 @@ DEF_TEST(Matrix, reporter) {
     test_decompScale(reporter);
 }
 
+// mapPoints() and mapRects() process several points or rects at once, and should give exactly the
+// same results as mapping them one at a time.
+DEF_TEST(Matrix_MapBatch, r) {
+    SkMatrix matrices[6];
+    matrices[0].reset();
+    matrices[1].setTranslate(10, -20);
+    matrices[2].setScale(3, -0.5f, 7, 8);
+    matrices[3].setRotate(35, 5, 6);
+    matrices[4].setRotate(90);
+    matrices[4].postScale(2, 3);
+    matrices[5].setRotate(35, 5, 6);
+    matrices[5].setPerspX(SK_Scalar1 / 128);
+    matrices[5].setPerspY(-SK_Scalar1 / 300);
+
+    SkRandom rand;
+    SkPoint pts[19];
+    SkRect rects[41];
+    for (size_t i = 0; i < SK_ARRAY_COUNT(pts); ++i) {
+        pts[i].set(rand.nextRangeScalar(-200, 200), rand.nextRangeScalar(-200, 200));
+    }
+    for (size_t i = 0; i < SK_ARRAY_COUNT(rects); ++i) {
+        // Not all of these are sorted.
+        rects[i].setLTRB(rand.nextRangeScalar(-200, 200), rand.nextRangeScalar(-200, 200),
+                         rand.nextRangeScalar(-200, 200), rand.nextRangeScalar(-200, 200));
+    }
+    // With perspective, this one maps to infinity (which mapPoints() turns into (0, 0)).
+    pts[5].set(-128, 0);
+
+    for (size_t m = 0; m < SK_ARRAY_COUNT(matrices); ++m) {
+        const SkMatrix& mat = matrices[m];
+        for (int count = 0; count <= (int)SK_ARRAY_COUNT(pts); ++count) {
+            SkPoint dst[SK_ARRAY_COUNT(pts)];
+            mat.mapPoints(dst, pts, count);
+            for (int i = 0; i < count; ++i) {
+                SkPoint expected;
+                mat.mapPoints(&expected, &pts[i], 1);
+                REPORTER_ASSERT(r, expected == dst[i]);
+            }
+        }
+
+        SkRect dst[SK_ARRAY_COUNT(rects)];
+        REPORTER_ASSERT(r, mat.rectStaysRect() ==
+                           mat.mapRects(dst, rects, SK_ARRAY_COUNT(rects)));
+        for (size_t i = 0; i < SK_ARRAY_COUNT(rects); ++i) {
+            SkRect expected;
+            mat.mapRect(&expected, rects[i]);
+            REPORTER_ASSERT(r, expected == dst[i]);
+        }
+        // In place too.
+        SkRect copy[SK_ARRAY_COUNT(rects)];
+        memcpy(copy, rects, sizeof(rects));
+        mat.mapRects(copy, copy, SK_ARRAY_COUNT(rects));
+        REPORTER_ASSERT(r, 0 == memcmp(copy, dst, sizeof(dst)));
+    }
+}
+
 DEF_TEST(Matrix_Concat, r) {
     SkMatrix a;
     a.setTranslate(10, 20);
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkColorPriv.h"
+#include "SkPaint.h"
+#include "SkPerlinNoiseShader.h"
+#include "Test.h"
+
+// SkPerlinNoiseShader computes all four channels at once with Sk4f. This is the one channel at a
+// time scalar version it replaced, following the SVG spec's feTurbulence reference code, which
+// the shader must still match.
+namespace {
+
+static const int kBlockSize = 256;
+static const int kBlockMask = kBlockSize - 1;
+static const int kPerlinNoise = 4096;
+static const int kRandMaximum = SK_MaxS32;
+
+struct StitchData {
+    StitchData() : fWidth(0), fWrapX(0), fHeight(0), fWrapY(0) {}
+
+    int fWidth;
+    int fWrapX;
+    int fHeight;
+    int fWrapY;
+};
+
+class ScalarPerlinNoise {
+public:
+    // Only supports canvases without a transform, which keep the base frequency and tile size.
+    ScalarPerlinNoise(SkPerlinNoiseShader::Type type, SkScalar baseFrequencyX,
+                      SkScalar baseFrequencyY, int numOctaves, SkScalar seed,
+                      const SkISize& tileSize)
+        : fType(type)
+        , fNumOctaves(numOctaves)
+        , fStitchTiles(!tileSize.isEmpty())
+        , fTileSize(tileSize) {
+        // The shader maps the inverted frequencies through the (identity) matrix and back.
+        fBaseFrequency.set(SkScalarInvert(SkScalarInvert(baseFrequencyX)),
+                           SkScalarInvert(SkScalarInvert(baseFrequencyY)));
+        this->init(seed);
+        if (fStitchTiles) {
+            this->stitch();
+        }
+    }
+
+    SkPMColor shade(int x, int y, U8CPU paintAlpha) const {
+        // WebKit's noise coordinates are 1 based.
+        const SkPoint point = SkPoint::Make(SkIntToScalar(x + 1), SkIntToScalar(y + 1));
+        U8CPU rgba[4];
+        for (int channel = 3; channel >= 0; --channel) {
+            StitchData stitchData;
+            rgba[channel] = SkScalarFloorToInt(255 * this->turbulence(channel, &stitchData, point,
+                                                                      paintAlpha));
+        }
+        return SkPreMultiplyARGB(rgba[3], rgba[0], rgba[1], rgba[2]);
+    }
+
+private:
+    int random() {
+        static const int gRandAmplitude = 16807;
+        static const int gRandQ = 127773;
+        static const int gRandR = 2836;
+
+        int result = gRandAmplitude * (fSeed % gRandQ) - gRandR * (fSeed / gRandQ);
+        if (result <= 0) {
+            result += kRandMaximum;
+        }
+        fSeed = result;
+        return result;
+    }
+
+    void init(SkScalar seed) {
+        fSeed = SkScalarTruncToInt(seed);
+        if (fSeed <= 0) {
+            fSeed = -(fSeed % (kRandMaximum - 1)) + 1;
+        }
+        if (fSeed > kRandMaximum - 1) {
+            fSeed = kRandMaximum - 1;
+        }
+        int noise[4][kBlockSize][2];
+        for (int channel = 0; channel < 4; ++channel) {
+            for (int i = 0; i < kBlockSize; ++i) {
+                fLatticeSelector[i] = i;
+                noise[channel][i][0] = this->random() % (2 * kBlockSize);
+                noise[channel][i][1] = this->random() % (2 * kBlockSize);
+            }
+        }
+        for (int i = kBlockSize - 1; i > 0; --i) {
+            int k = fLatticeSelector[i];
+            int j = this->random() % kBlockSize;
+            fLatticeSelector[i] = fLatticeSelector[j];
+            fLatticeSelector[j] = k;
+        }
+        const SkScalar invBlockSize = SkScalarInvert(SkIntToScalar(kBlockSize));
+        for (int channel = 0; channel < 4; ++channel) {
+            for (int i = 0; i < kBlockSize; ++i) {
+                const int* permuted = noise[channel][fLatticeSelector[i]];
+                fGradient[channel][i].set(SkIntToScalar(permuted[0] - kBlockSize) * invBlockSize,
+                                          SkIntToScalar(permuted[1] - kBlockSize) * invBlockSize);
+                fGradient[channel][i].normalize();
+            }
+        }
+    }
+
+    void stitch() {
+        SkScalar tileWidth  = SkIntToScalar(fTileSize.width());
+        SkScalar tileHeight = SkIntToScalar(fTileSize.height());
+        if (fBaseFrequency.fX) {
+            SkScalar low = SkScalarFloorToScalar(tileWidth * fBaseFrequency.fX) / tileWidth;
+            SkScalar high = SkScalarCeilToScalar(tileWidth * fBaseFrequency.fX) / tileWidth;
+            fBaseFrequency.fX = fBaseFrequency.fX / low < high / fBaseFrequency.fX ? low : high;
+        }
+        if (fBaseFrequency.fY) {
+            SkScalar low = SkScalarFloorToScalar(tileHeight * fBaseFrequency.fY) / tileHeight;
+            SkScalar high = SkScalarCeilToScalar(tileHeight * fBaseFrequency.fY) / tileHeight;
+            fBaseFrequency.fY = fBaseFrequency.fY / low < high / fBaseFrequency.fY ? low : high;
+        }
+        fStitchDataInit.fWidth  = SkScalarRoundToInt(tileWidth * fBaseFrequency.fX);
+        fStitchDataInit.fWrapX  = kPerlinNoise + fStitchDataInit.fWidth;
+        fStitchDataInit.fHeight = SkScalarRoundToInt(tileHeight * fBaseFrequency.fY);
+        fStitchDataInit.fWrapY  = kPerlinNoise + fStitchDataInit.fHeight;
+    }
+
+    static int check_noise(int noiseValue, int limitValue, int newValue) {
+        return noiseValue >= limitValue ? noiseValue - newValue : noiseValue;
+    }
+
+    static SkScalar smooth_curve(SkScalar t) {
+        return t * t * (3 - 2 * t);
+    }
+
+    SkScalar noise2D(int channel, const StitchData& stitchData, const SkPoint& noiseVector) const {
+        SkScalar positionX = noiseVector.fX + kPerlinNoise;
+        SkScalar positionY = noiseVector.fY + kPerlinNoise;
+        int x0 = SkScalarFloorToInt(positionX);
+        int y0 = SkScalarFloorToInt(positionY);
+        const SkScalar fx = positionX - SkIntToScalar(x0);
+        const SkScalar fy = positionY - SkIntToScalar(y0);
+        int x1 = x0 + 1;
+        int y1 = y0 + 1;
+        if (fStitchTiles) {
+            x0 = check_noise(x0, stitchData.fWrapX, stitchData.fWidth);
+            y0 = check_noise(y0, stitchData.fWrapY, stitchData.fHeight);
+            x1 = check_noise(x1, stitchData.fWrapX, stitchData.fWidth);
+            y1 = check_noise(y1, stitchData.fWrapY, stitchData.fHeight);
+        }
+        int i = fLatticeSelector[x0 & kBlockMask];
+        int j = fLatticeSelector[x1 & kBlockMask];
+        const SkPoint* gradient = fGradient[channel];
+        SkScalar sx = smooth_curve(fx);
+        SkScalar sy = smooth_curve(fy);
+        SkScalar u = gradient[(i + y0) & kBlockMask].dot(SkPoint::Make(fx, fy));
+        SkScalar v = gradient[(j + y0) & kBlockMask].dot(SkPoint::Make(fx - 1, fy));
+        SkScalar a = SkScalarInterp(u, v, sx);
+        v = gradient[(j + y1) & kBlockMask].dot(SkPoint::Make(fx - 1, fy - 1));
+        u = gradient[(i + y1) & kBlockMask].dot(SkPoint::Make(fx, fy - 1));
+        SkScalar b = SkScalarInterp(u, v, sx);
+        return SkScalarInterp(a, b, sy);
+    }
+
+    SkScalar turbulence(int channel, StitchData* stitchData, const SkPoint& point,
+                        U8CPU paintAlpha) const {
+        if (fStitchTiles) {
+            *stitchData = fStitchDataInit;
+        }
+        SkScalar result = 0;
+        SkPoint noiseVector = SkPoint::Make(point.fX * fBaseFrequency.fX,
+                                            point.fY * fBaseFrequency.fY);
+        SkScalar ratio = SK_Scalar1;
+        for (int octave = 0; octave < fNumOctaves; ++octave) {
+            SkScalar noise = this->noise2D(channel, *stitchData, noiseVector);
+            result += (SkPerlinNoiseShader::kFractalNoise_Type == fType ? noise
+                                                                        : SkScalarAbs(noise))
+                      / ratio;
+            noiseVector.fX *= 2;
+            noiseVector.fY *= 2;
+            ratio *= 2;
+            if (fStitchTiles) {
+                stitchData->fWidth  *= 2;
+                stitchData->fWrapX   = stitchData->fWidth + kPerlinNoise;
+                stitchData->fHeight *= 2;
+                stitchData->fWrapY   = stitchData->fHeight + kPerlinNoise;
+            }
+        }
+        if (SkPerlinNoiseShader::kFractalNoise_Type == fType) {
+            result = result * SK_ScalarHalf + SK_ScalarHalf;
+        }
+        if (3 == channel) {
+            result *= SkIntToScalar(paintAlpha) / 255;
+        }
+        return SkScalarPin(result, 0, SK_Scalar1);
+    }
+
+    SkPerlinNoiseShader::Type   fType;
+    int                         fNumOctaves;
+    bool                        fStitchTiles;
+    SkISize                     fTileSize;
+    SkVector                    fBaseFrequency;
+    StitchData                  fStitchDataInit;
+    int                         fSeed;
+    int                         fLatticeSelector[kBlockSize];
+    SkPoint                     fGradient[4][kBlockSize];
+};
+
+}  // namespace
+
+static bool nearly_equal(SkPMColor a, SkPMColor b) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        if (SkAbs32((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF)) > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_noise(skiatest::Reporter* reporter, SkPerlinNoiseShader::Type type,
+                       SkScalar baseFrequency, int numOctaves, const SkISize& tileSize,
+                       U8CPU paintAlpha) {
+    const int kSize = 48;
+    const SkScalar seed = 7;
+    SkAutoTUnref<SkShader> shader(SkPerlinNoiseShader::kFractalNoise_Type == type
+            ? SkPerlinNoiseShader::CreateFractalNoise(baseFrequency, baseFrequency, numOctaves,
+                                                      seed, &tileSize)
+            : SkPerlinNoiseShader::CreateTurbulence(baseFrequency, baseFrequency, numOctaves,
+                                                    seed, &tileSize));
+    SkBitmap bitmap;
+    bitmap.allocN32Pixels(kSize, kSize);
+    SkCanvas canvas(bitmap);
+    SkPaint paint;
+    paint.setShader(shader);
+    paint.setAlpha(paintAlpha);
+    paint.setXfermodeMode(SkXfermode::kSrc_Mode);
+    canvas.drawPaint(paint);
+
+    const ScalarPerlinNoise reference(type, baseFrequency, baseFrequency, numOctaves, seed,
+                                      tileSize);
+    SkAutoLockPixels alp(bitmap);
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            const SkPMColor expected = reference.shade(x, y, paintAlpha);
+            if (!nearly_equal(*bitmap.getAddr32(x, y), expected)) {
+                ERRORF(reporter, "type %d, %d octaves, tile %dx%d, alpha %d: (%d, %d) is %08x, "
+                       "expected %08x", type, numOctaves, tileSize.width(), tileSize.height(),
+                       paintAlpha, x, y, *bitmap.getAddr32(x, y), expected);
+                return;
+            }
+        }
+    }
+}
+
+DEF_TEST(PerlinNoise_MatchesScalar, reporter) {
+    const SkISize noTile = SkISize::Make(0, 0);
+    const SkISize tile = SkISize::Make(40, 40);
+    const SkPerlinNoiseShader::Type types[] = {
+        SkPerlinNoiseShader::kFractalNoise_Type,
+        SkPerlinNoiseShader::kTurbulence_Type,
+    };
+    for (size_t i = 0; i < SK_ARRAY_COUNT(types); ++i) {
+        test_noise(reporter, types[i], 0.05f, 1, noTile, 0xFF);
+        test_noise(reporter, types[i], 0.1f, 4, noTile, 0xFF);
+        test_noise(reporter, types[i], 0.1f, 4, tile, 0xFF);
+        test_noise(reporter, types[i], 0.1f, 3, noTile, 0x80);
+    }
+}
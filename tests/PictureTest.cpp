@@ -5,18 +5,23 @@
  * found in the LICENSE file.
  */
 
+#include "SkAtomics.h"
 #include "SkBBoxHierarchy.h"
+#include "SkBitmapCache.h"
 #include "SkBlurImageFilter.h"
 #include "SkCanvas.h"
 #include "SkColorMatrixFilter.h"
 #include "SkColorPriv.h"
 #include "SkDashPathEffect.h"
 #include "SkData.h"
+#include "SkDiscardableMemoryPool.h"
+#include "SkImageGeneratorPriv.h"
 #include "SkImageGenerator.h"
 #include "SkError.h"
 #include "SkImageEncoder.h"
 #include "SkImageGenerator.h"
 #include "SkLayerInfo.h"
+#include "SkMipMap.h"
 #include "SkPaint.h"
 #include "SkPicture.h"
 #include "SkPictureRecorder.h"
@@ -28,6 +33,7 @@
 #include "SkRecord.h"
 #include "SkShader.h"
 #include "SkStream.h"
+#include "SkUtils.h"
 #include "sk_tool_utils.h"
 
 #if SK_SUPPORT_GPU
@@ -1323,3 +1329,83 @@ DEF_TEST(Picture_getRecordingCanvas, r) {
         REPORTER_ASSERT(r, !rec.getRecordingCanvas());
     }
 }
+
+namespace {
+
+class CountingImageGenerator : public SkImageGenerator {
+public:
+    CountingImageGenerator(int width, int height, int32_t* decodeCount)
+        : INHERITED(SkImageInfo::MakeN32(width, height, kOpaque_SkAlphaType))
+        , fDecodeCount(decodeCount) {}
+
+protected:
+    Result onGetPixels(const SkImageInfo& info, void* pixels, size_t rowBytes, const Options&,
+                       SkPMColor ctable[], int* ctableCount) override {
+        sk_atomic_inc(fDecodeCount);
+        for (int y = 0; y < info.height(); ++y) {
+            sk_memset32((uint32_t*)((char*)pixels + y * rowBytes), 0xFF336699, info.width());
+        }
+        return kSuccess;
+    }
+
+private:
+    int32_t* fDecodeCount;
+
+    typedef SkImageGenerator INHERITED;
+};
+
+}  // namespace
+
+// Pre-decoding should decode each lazy bitmap and image a picture draws exactly once, and build
+// the mipmaps its filtered draws need, so that playback doesn't decode anything itself.
+DEF_TEST(Picture_PreDecodeImages, r) {
+    SkAutoTUnref<SkDiscardableMemoryPool> pool(
+        SkDiscardableMemoryPool::Create(1024 * 1024, NULL));
+    int32_t decodeCounts[3] = { 0, 0, 0 };
+    SkBitmap drawn, shaded;
+    REPORTER_ASSERT(r, SkInstallDiscardablePixelRef(
+            SkNEW_ARGS(CountingImageGenerator, (200, 200, &decodeCounts[0])), &drawn, pool));
+    REPORTER_ASSERT(r, SkInstallDiscardablePixelRef(
+            SkNEW_ARGS(CountingImageGenerator, (16, 16, &decodeCounts[1])), &shaded, pool));
+    SkAutoTUnref<SkImage> image(SkImage::NewFromGenerator(
+            SkNEW_ARGS(CountingImageGenerator, (64, 64, &decodeCounts[2]))));
+    REPORTER_ASSERT(r, image);
+    SkBitmap raster;
+    raster.allocN32Pixels(8, 8);
+    raster.eraseColor(SK_ColorRED);
+
+    SkPictureRecorder recorder;
+    recorder.beginRecording(100, 100)->drawImage(image, 10, 10);
+    SkAutoTUnref<SkPicture> nested(recorder.endRecording());
+
+    SkCanvas* canvas = recorder.beginRecording(300, 300);
+    canvas->drawBitmap(drawn, 0, 0);
+    SkPaint paint;
+    paint.setFilterQuality(kMedium_SkFilterQuality);
+    canvas->save();
+    canvas->scale(SK_Scalar1 / 4, SK_Scalar1 / 4);
+    canvas->drawBitmap(drawn, 0, 0, &paint);
+    canvas->restore();
+    canvas->drawBitmap(raster, 250, 250);
+    SkPaint shaderPaint;
+    shaderPaint.setShader(SkShader::CreateBitmapShader(shaded, SkShader::kRepeat_TileMode,
+                                                       SkShader::kRepeat_TileMode))->unref();
+    canvas->drawRect(SkRect::MakeXYWH(0, 200, 100, 100), shaderPaint);
+    canvas->drawPicture(nested);
+    SkAutoTUnref<SkPicture> picture(recorder.endRecording());
+
+    REPORTER_ASSERT(r, 4 == SkPictureUtils::PreDecodeImages(picture));
+    for (int i = 0; i < 3; ++i) {
+        REPORTER_ASSERT(r, 1 == decodeCounts[i]);
+    }
+    SkAutoTUnref<const SkMipMap> mipMap(SkMipMapCache::FindAndRef(drawn));
+    REPORTER_ASSERT(r, mipMap);
+
+    SkBitmap dst;
+    dst.allocN32Pixels(300, 300);
+    SkCanvas dstCanvas(dst);
+    picture->playback(&dstCanvas);
+    REPORTER_ASSERT(r, 1 == decodeCounts[0]);
+    REPORTER_ASSERT(r, 1 == decodeCounts[1]);
+    REPORTER_ASSERT(r, 0xFF336699 == *dst.getAddr32(100, 100));
+}
@@ -10,6 +10,7 @@
 #include "SkCanvas.h"
 #include "SkGPipe.h"
 #include "SkPaint.h"
+#include "SkPath.h"
 #include "SkShader.h"
 #include "Test.h"
 
@@ -54,3 +55,62 @@ DEF_TEST(Pipe, reporter) {
 
     testDrawingAfterEndRecording(&canvas);
 }
+
+static void draw_frame(SkCanvas* canvas, int frame) {
+    SkBitmap checker;
+    checker.allocN32Pixels(16, 16);
+    for (int y = 0; y < 16; ++y) {
+        for (int x = 0; x < 16; ++x) {
+            *checker.getAddr32(x, y) = (x ^ y ^ frame) & 1 ? SK_ColorBLUE : SK_ColorYELLOW;
+        }
+    }
+
+    SkPaint paint;
+    paint.setAntiAlias(true);
+    canvas->drawColor(SK_ColorWHITE);
+    for (int i = 0; i < 50; ++i) {
+        paint.setColor(0xFF000000 | (i * 0x050301 + frame * 0x103050));
+        SkPath path;
+        path.moveTo(SkIntToScalar(i), SkIntToScalar(frame));
+        path.quadTo(SkIntToScalar(60 - i), SkIntToScalar(i), SkIntToScalar(i + frame), 60);
+        paint.setStyle(i & 1 ? SkPaint::kStroke_Style : SkPaint::kFill_Style);
+        canvas->drawPath(path, paint);
+        canvas->drawBitmap(checker, SkIntToScalar(i), SkIntToScalar(frame % 8), &paint);
+    }
+    canvas->drawText("pipe", 4, 10, 50, paint);
+}
+
+// Records frames on this thread while ThreadedPipeController plays them on another. Each frame
+// (with its flattened bitmaps) spans several blocks, and with only two of them, the two threads
+// wait for each other often.
+DEF_TEST(Pipe_Threaded, reporter) {
+    SkBitmap expected, actual;
+    expected.allocN32Pixels(64, 64);
+    actual.allocN32Pixels(64, 64);
+    SkCanvas expectedCanvas(expected);
+    SkCanvas actualCanvas(actual);
+
+    static const int kFrames = 6;
+    {
+        ThreadedPipeController controller(&actualCanvas, 2);
+        SkGPipeWriter writer;
+        SkCanvas* pipeCanvas = writer.startRecording(&controller,
+                                                     SkGPipeWriter::kCrossProcess_Flag);
+        for (int frame = 0; frame < kFrames; ++frame) {
+            draw_frame(pipeCanvas, frame);
+            REPORTER_ASSERT(reporter, frame == controller.endFrame(&writer));
+            if (frame > 0) {
+                REPORTER_ASSERT(reporter, controller.waitForFrame(frame - 1));
+            }
+        }
+        // Frames may be empty.
+        REPORTER_ASSERT(reporter, kFrames == controller.endFrame(&writer));
+        REPORTER_ASSERT(reporter, controller.waitForFrame(kFrames));
+        writer.endRecording();
+        REPORTER_ASSERT(reporter, !controller.waitForFrame(kFrames + 1));
+    }
+    draw_frame(&expectedCanvas, kFrames - 1);
+
+    REPORTER_ASSERT(reporter, 0 == memcmp(expected.getPixels(), actual.getPixels(),
+                                          expected.getSize()));
+}
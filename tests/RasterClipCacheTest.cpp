@@ -0,0 +1,163 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkGraphics.h"
+#include "SkPath.h"
+#include "SkRasterClip.h"
+#include "SkRasterClipCache.h"
+#include "SkResourceCache.h"
+#include "Test.h"
+
+static SkPath make_star(SkScalar cx, SkScalar cy, int points) {
+    SkPath path;
+    for (int i = 0; i < points; ++i) {
+        SkScalar angle = SK_ScalarPI * 2 * i / points;
+        SkScalar radius = SkIntToScalar((i & 1) ? 20 : 45);
+        SkPoint pt = SkPoint::Make(cx + radius * SkScalarCos(angle),
+                                   cy + radius * SkScalarSin(angle));
+        if (0 == i) {
+            path.moveTo(pt);
+        } else {
+            path.lineTo(pt);
+        }
+    }
+    path.close();
+    return path;
+}
+
+typedef SkAutoTUnref<const SkRasterClipCache::History> AutoHistory;
+
+static void test_histories(skiatest::Reporter* reporter) {
+    const SkISize size = SkISize::Make(100, 100);
+    const SkPath star = make_star(50, 50, 20);
+    SkPath moved;
+    star.offset(SK_Scalar1 / 8, 0, &moved);
+
+    AutoHistory root(SkRasterClipCache::NewRectHistory(SkIRect::MakeWH(100, 100), false));
+    AutoHistory same(SkRasterClipCache::NewRectHistory(SkIRect::MakeWH(100, 100), false));
+    AutoHistory forced(SkRasterClipCache::NewRectHistory(SkIRect::MakeWH(100, 100), true));
+    AutoHistory smaller(SkRasterClipCache::NewRectHistory(SkIRect::MakeWH(100, 99), false));
+    REPORTER_ASSERT(reporter, root->equals(same) && root->hash() == same->hash());
+    REPORTER_ASSERT(reporter, !root->equals(forced));
+    REPORTER_ASSERT(reporter, !root->equals(smaller));
+
+    const SkRegion::Op kIntersect = SkRegion::kIntersect_Op;
+    AutoHistory op(SkRasterClipCache::NewOpHistory(root, star, size, kIntersect, true));
+    AutoHistory sameOp(SkRasterClipCache::NewOpHistory(same, star, size, kIntersect, true));
+    AutoHistory bw(SkRasterClipCache::NewOpHistory(root, star, size, kIntersect, false));
+    AutoHistory unionOp(SkRasterClipCache::NewOpHistory(root, star, size, SkRegion::kUnion_Op,
+                                                        true));
+    AutoHistory movedOp(SkRasterClipCache::NewOpHistory(root, moved, size, kIntersect, true));
+    AutoHistory twice(SkRasterClipCache::NewOpHistory(op, star, size, kIntersect, true));
+    AutoHistory fromForced(SkRasterClipCache::NewOpHistory(forced, star, size, kIntersect, true));
+    REPORTER_ASSERT(reporter, op->equals(sameOp) && op->hash() == sameOp->hash());
+    REPORTER_ASSERT(reporter, !op->equals(bw));
+    REPORTER_ASSERT(reporter, !op->equals(unionOp));
+    REPORTER_ASSERT(reporter, !op->equals(movedOp));
+    REPORTER_ASSERT(reporter, !op->equals(twice));
+    REPORTER_ASSERT(reporter, !op->equals(fromForced));
+    REPORTER_ASSERT(reporter, !op->equals(NULL));
+
+    // Nothing is known about clips built from an unknown clip.
+    REPORTER_ASSERT(reporter, NULL == SkRasterClipCache::NewOpHistory(NULL, star, size,
+                                                                      kIntersect, true));
+    REPORTER_ASSERT(reporter, NULL == SkRasterClipCache::NewOpHistory(NULL,
+                                                                      SkRect::MakeWH(10, 10),
+                                                                      size, kIntersect, true));
+}
+
+static void test_find_add(skiatest::Reporter* reporter) {
+    SkResourceCache cache(1024 * 1024);
+    const SkISize size = SkISize::Make(100, 100);
+    const SkPath star = make_star(50, 50, 20);
+
+    SkRasterClip clip(SkIRect::MakeWH(100, 100));
+    clip.op(star, size, SkRegion::kIntersect_Op, true);
+    REPORTER_ASSERT(reporter, clip.isAA());
+
+    AutoHistory root(SkRasterClipCache::NewRectHistory(SkIRect::MakeWH(100, 100), false));
+    AutoHistory history(SkRasterClipCache::NewOpHistory(root, star, size,
+                                                        SkRegion::kIntersect_Op, true));
+
+    SkRasterClip found;
+    REPORTER_ASSERT(reporter, !SkRasterClipCache::Find(history, &found, &cache));
+    SkRasterClipCache::Add(history, clip, &cache);
+    REPORTER_ASSERT(reporter, SkRasterClipCache::Find(history, &found, &cache));
+    REPORTER_ASSERT(reporter, found.isAA());
+    REPORTER_ASSERT(reporter, found.aaRgn() == clip.aaRgn());
+
+    // Equal histories built separately find the same clip.
+    AutoHistory root2(SkRasterClipCache::NewRectHistory(SkIRect::MakeWH(100, 100), false));
+    AutoHistory history2(SkRasterClipCache::NewOpHistory(root2, star, size,
+                                                         SkRegion::kIntersect_Op, true));
+    SkRasterClip found2;
+    REPORTER_ASSERT(reporter, SkRasterClipCache::Find(history2, &found2, &cache));
+    REPORTER_ASSERT(reporter, found2.aaRgn() == clip.aaRgn());
+
+    // Lookups are by hash, but only the same history finds the clip.
+    AutoHistory other(SkRasterClipCache::NewOpHistory(root, star, size,
+                                                      SkRegion::kUnion_Op, true));
+    REPORTER_ASSERT(reporter, !SkRasterClipCache::Find(other, &found, &cache));
+    REPORTER_ASSERT(reporter, !SkRasterClipCache::Find(NULL, &found, &cache));
+
+    // NULL histories are never cached.
+    SkRasterClipCache::Add(NULL, clip, &cache);
+    REPORTER_ASSERT(reporter, !SkRasterClipCache::Find(NULL, &found, &cache));
+}
+static void draw_clipped(SkCanvas* canvas, bool doAA) {
+    canvas->clear(SK_ColorWHITE);
+    canvas->save();
+    canvas->translate(SkIntToScalar(3), SkIntToScalar(4));
+    canvas->clipPath(make_star(50, 50, 30), SkRegion::kIntersect_Op, doAA);
+    SkPath hole;
+    hole.addCircle(50, 50, 12);
+    canvas->clipPath(hole, SkRegion::kDifference_Op, doAA);
+    canvas->drawColor(SK_ColorBLUE);
+    canvas->restore();
+}
+
+// Clips found in the cache must draw exactly like freshly built ones.
+static void test_canvas(skiatest::Reporter* reporter, bool doAA) {
+    const bool wasCaching = SkGraphics::SetRasterClipCacheEnabled(true);
+
+    SkBitmap bitmaps[3];
+    for (int i = 0; i < 3; ++i) {
+        bitmaps[i].allocN32Pixels(110, 110);
+        SkCanvas canvas(bitmaps[i]);
+        if (2 == i) {
+            // Sets the same clips, but with a region clip first, so none are looked up.
+            canvas.clipRegion(SkRegion(SkIRect::MakeWH(110, 110)));
+        }
+        draw_clipped(&canvas, doAA);
+    }
+
+    // The first canvas should have left its clips in the cache.
+    const SkISize size = SkISize::Make(110, 110);
+    AutoHistory root(SkRasterClipCache::NewRectHistory(SkIRect::MakeWH(110, 110), false));
+    SkPath devPath;
+    make_star(50, 50, 30).transform(SkMatrix::MakeTrans(3, 4), &devPath);
+    AutoHistory history(SkRasterClipCache::NewOpHistory(root, devPath, size,
+                                                        SkRegion::kIntersect_Op, doAA));
+    SkRasterClip found;
+    REPORTER_ASSERT(reporter, SkRasterClipCache::Find(history, &found));
+
+    for (int i = 1; i < 3; ++i) {
+        REPORTER_ASSERT(reporter, 0 == memcmp(bitmaps[0].getPixels(), bitmaps[i].getPixels(),
+                                              bitmaps[0].getSize()));
+    }
+
+    SkGraphics::SetRasterClipCacheEnabled(wasCaching);
+}
+
+DEF_TEST(RasterClipCache, reporter) {
+    test_histories(reporter);
+    test_find_add(reporter);
+    test_canvas(reporter, true);
+    test_canvas(reporter, false);
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkColorFilter.h"
+#include "SkColorMatrixFilter.h"
+#include "SkColorPriv.h"
+#include "SkGradientShader.h"
+#include "SkPath.h"
+#include "SkRasterPipeline.h"
+#include "SkXfermode.h"
+#include "Test.h"
+
+static const int kSize = 48;
+
+// A horizontal gradient is constant in y, which the blitters shade (and filter) once per rect.
+static SkShader* make_gradient(bool constInY) {
+    const SkScalar size = SkIntToScalar(kSize);
+    const SkPoint pts[] = { { 0, 0 }, { size, constInY ? 0 : size } };
+    const SkColor colors[] = { 0xFFFF0000, 0x8000FF00, 0x000000FF, 0xFFFFFFFF };
+    return SkGradientShader::CreateLinear(pts, colors, NULL, SK_ARRAY_COUNT(colors),
+                                          SkShader::kClamp_TileMode);
+}
+
+static void make_dst(SkBitmap* dst) {
+    dst->allocN32Pixels(kSize, kSize);
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            // A mix of opaque, translucent, and transparent premultiplied colors.
+            const U8CPU a = (x * 37 + y * 11) % 3 ? 0xFF : (x * 5 + y * 7) & 0xFF;
+            *dst->getAddr32(x, y) = SkPreMultiplyARGB(a, x * 5, y * 5, (x + y) * 2);
+        }
+    }
+}
+
+static bool nearly_equal(SkPMColor a, SkPMColor b, int tolerance) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        if (SkAbs32((int)((a >> shift) & 0xFF) - (int)((b >> shift) & 0xFF)) > tolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Draws the gradient through the filter and mode with the blitters, and checks the result
+// against the shader's colors filtered and transferred one stage at a time.
+static void test_draw(skiatest::Reporter* reporter, SkColorFilter* filter,
+                      SkXfermode::Mode mode, bool antiAlias, bool constInY) {
+    SkAutoTUnref<SkShader> shader(make_gradient(constInY));
+    SkAutoTUnref<SkXfermode> xfermode(SkXfermode::Create(mode));
+
+    // Unfiltered shader colors.
+    SkBitmap shaded;
+    shaded.allocN32Pixels(kSize, kSize);
+    shaded.eraseColor(SK_ColorTRANSPARENT);
+    {
+        SkCanvas canvas(shaded);
+        SkPaint paint;
+        paint.setShader(shader);
+        canvas.drawPaint(paint);
+    }
+
+    // Coverage of the shape being drawn: an oval, or a rect to hit blitRect().
+    const SkRect bounds = SkRect::MakeXYWH(SK_Scalar1 / 3, SK_Scalar1 / 2,
+                                           SkIntToScalar(kSize - 1), SkIntToScalar(kSize - 2));
+    SkPath shape;
+    if (constInY) {
+        shape.addRect(antiAlias ? bounds : SkRect::Make(bounds.roundOut()));
+    } else {
+        shape.addOval(bounds);
+    }
+    SkBitmap coverage;
+    coverage.allocPixels(SkImageInfo::MakeA8(kSize, kSize));
+    coverage.eraseColor(SK_ColorTRANSPARENT);
+    {
+        SkCanvas canvas(coverage);
+        SkPaint paint;
+        paint.setAntiAlias(antiAlias);
+        canvas.drawPath(shape, paint);
+    }
+
+    SkBitmap dst;
+    make_dst(&dst);
+    SkBitmap expected;
+    make_dst(&expected);
+
+    {
+        SkCanvas canvas(dst);
+        SkPaint paint;
+        paint.setShader(shader);
+        paint.setColorFilter(filter);
+        paint.setXfermode(xfermode);
+        paint.setAntiAlias(antiAlias);
+        canvas.drawPath(shape, paint);
+    }
+
+    const SkXfermodeProc proc = SkXfermode::GetProc(mode);
+    SkPMColor filtered[kSize];
+    for (int y = 0; y < kSize; ++y) {
+        filter->filterSpan(shaded.getAddr32(0, y), kSize, filtered);
+        for (int x = 0; x < kSize; ++x) {
+            const U8CPU aa = *coverage.getAddr8(x, y);
+            if (0 == aa) {
+                continue;
+            }
+            SkPMColor* d = expected.getAddr32(x, y);
+            const SkPMColor result = proc(filtered[x], *d);
+            *d = 0xFF == aa ? result : SkFourByteInterp(result, *d, aa);
+        }
+    }
+
+    int mismatches = 0;
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            // The stages run in floats rather than 8-bit fixed point, so allow for rounding.
+            if (!nearly_equal(*dst.getAddr32(x, y), *expected.getAddr32(x, y), 3)) {
+                mismatches++;
+            }
+        }
+    }
+    if (mismatches) {
+        ERRORF(reporter, "%d pixels differ for mode %s, filter %p, antiAlias %d, constInY %d",
+               mismatches, SkXfermode::ModeName(mode), filter, antiAlias, constInY);
+    }
+}
+
+DEF_TEST(RasterPipeline, reporter) {
+    SkColorMatrix saturation;
+    saturation.setSaturation(SK_Scalar1 / 4);
+    SkAutoTUnref<SkColorFilter> matrix(SkColorMatrixFilter::Create(saturation));
+    SkAutoTUnref<SkColorFilter> tint(SkColorFilter::CreateModeFilter(0x80204080,
+                                                                     SkXfermode::kSrcATop_Mode));
+    SkAutoTUnref<SkColorFilter> screen(SkColorFilter::CreateModeFilter(0xFF336699,
+                                                                       SkXfermode::kScreen_Mode));
+    // Without a color filter, the other blitters draw.
+    SkColorFilter* filters[] = { matrix.get(), tint.get(), screen.get() };
+
+    // Composed filters and non-coefficient modes are left to the other blitters.
+    SkAutoTUnref<SkColorFilter> composed(SkColorFilter::CreateComposeFilter(matrix, tint));
+    REPORTER_ASSERT(reporter, SkRasterPipeline::CanFuse(matrix, NULL));
+    REPORTER_ASSERT(reporter, SkRasterPipeline::CanFuse(tint, NULL));
+    REPORTER_ASSERT(reporter, !SkRasterPipeline::CanFuse(composed, NULL));
+    SkAutoTUnref<SkXfermode> multiply(SkXfermode::Create(SkXfermode::kMultiply_Mode));
+    REPORTER_ASSERT(reporter, !SkRasterPipeline::CanFuse(NULL, multiply));
+
+    for (int mode = 0; mode <= SkXfermode::kLastCoeffMode; ++mode) {
+        if (SkXfermode::kClear_Mode == mode) {
+            continue;   // SkBlitter::Choose() turns clear into src with transparent black.
+        }
+        for (size_t f = 0; f < SK_ARRAY_COUNT(filters); ++f) {
+            for (int i = 0; i < 4; ++i) {
+                test_draw(reporter, filters[f], (SkXfermode::Mode)mode, SkToBool(i & 1),
+                          SkToBool(i & 2));
+            }
+        }
+    }
+}
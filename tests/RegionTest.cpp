@@ -230,6 +230,105 @@ static bool test_rects(const SkIRect rect[], int count) {
     return true;
 }
 
+static bool op_contains(SkRegion::Op op, bool a, bool b) {
+    switch (op) {
+        case SkRegion::kDifference_Op:          return a && !b;
+        case SkRegion::kIntersect_Op:           return a && b;
+        case SkRegion::kUnion_Op:               return a || b;
+        case SkRegion::kXOR_Op:                 return a != b;
+        case SkRegion::kReverseDifference_Op:   return b && !a;
+        case SkRegion::kReplace_Op:             return b;
+    }
+    return false;
+}
+
+// Builds the region covering the pixels in area for which op_contains() is true, by adding them
+// a run of pixels at a time.
+static void pixel_op(const SkRegion& a, const SkRegion& b, SkRegion::Op op, const SkIRect& area,
+                     SkRegion* result) {
+    SkRegion pixels;
+    for (int y = area.fTop; y < area.fBottom; ++y) {
+        for (int x = area.fLeft; x < area.fRight; ++x) {
+            int right = x;
+            while (right < area.fRight &&
+                   op_contains(op, a.contains(right, y), b.contains(right, y))) {
+                ++right;
+            }
+            if (right > x) {
+                pixels.op(SkIRect::MakeLTRB(x, y, right, y + 1), SkRegion::kUnion_Op);
+                x = right;
+            }
+        }
+    }
+    result->swap(pixels);
+}
+
+// Checks each op of complex regions with rects and with each other, alone and chained with
+// one OpScratch, against the same ops done a pixel at a time.
+static void test_ops(skiatest::Reporter* reporter) {
+    const int kSize = 24;
+    const SkIRect area = SkIRect::MakeLTRB(-2, -2, kSize + 8, kSize + 2);
+    SkRandom rand;
+    for (int i = 0; i < 200; ++i) {
+        SkRegion a, b;
+        for (int j = 0; j < 6; ++j) {
+            SkIRect r;
+            r.set(rand.nextU() % kSize, rand.nextU() % kSize,
+                  rand.nextU() % kSize, rand.nextU() % kSize);
+            r.sort();
+            a.op(r, SkRegion::kXOR_Op);
+            if (j < 3) {
+                b.op(r.makeOffset(kSize / 4, -1), SkRegion::kXOR_Op);
+            }
+        }
+        SkIRect rect;
+        rect.set(rand.nextU() % kSize, rand.nextU() % kSize,
+                 rand.nextU() % kSize, rand.nextU() % kSize);
+        rect.sort();
+        rect.outset(1, 1);
+        const SkRegion rectRgn(rect);
+
+        SkRegion chain(a), chainExpected(a);
+        SkRegion::OpScratch scratch;
+        for (int op = 0; op < SkRegion::kOpCnt; ++op) {
+            const SkRegion::Op rgnOp = (SkRegion::Op)op;
+            SkRegion result, expected;
+
+            result.op(a, rect, rgnOp);
+            pixel_op(a, rectRgn, rgnOp, area, &expected);
+            REPORTER_ASSERT(reporter, result == expected);
+
+            result.op(rect, a, rgnOp);
+            pixel_op(rectRgn, a, rgnOp, area, &expected);
+            REPORTER_ASSERT(reporter, result == expected);
+
+            result.op(a, b, rgnOp);
+            pixel_op(a, b, rgnOp, area, &expected);
+            REPORTER_ASSERT(reporter, result == expected);
+
+            // Ops write over chain's runs in place unless they're shared, as they are with
+            // before on every other pass.
+            SkRegion before;
+            if (i & 1) {
+                before = chain;
+            }
+            const SkRegion beforeExpected(chainExpected);
+
+            const SkRegion& operand = (op & 1) ? rectRgn : b;
+            pixel_op(chainExpected, operand, rgnOp, area, &chainExpected);
+            if (op & 1) {
+                chain.op(rect, rgnOp, &scratch);
+            } else {
+                chain.op(b, rgnOp, &scratch);
+            }
+            REPORTER_ASSERT(reporter, chain == chainExpected);
+            if (i & 1) {
+                REPORTER_ASSERT(reporter, before == beforeExpected);
+            }
+        }
+    }
+}
+
 DEF_TEST(Region, reporter) {
     const SkIRect r2[] = {
         { 0, 0, 1, 1 },
@@ -261,4 +360,5 @@ DEF_TEST(Region, reporter) {
     test_proc(reporter, intersects_proc);
     test_empties(reporter);
     test_fromchrome(reporter);
+    test_ops(reporter);
 }
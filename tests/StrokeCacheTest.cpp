@@ -0,0 +1,171 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkBitmap.h"
+#include "SkCanvas.h"
+#include "SkDashPathEffect.h"
+#include "SkPaint.h"
+#include "SkPath.h"
+#include "SkResourceCache.h"
+#include "SkStrokeCache.h"
+#include "Test.h"
+
+static SkPath make_chart(int points) {
+    SkPath path;
+    path.moveTo(0, 50);
+    for (int i = 1; i < points; ++i) {
+        path.quadTo(SkIntToScalar(i * 10 - 5), SkIntToScalar((i * 37) % 100),
+                    SkIntToScalar(i * 10), SkIntToScalar((i * 53) % 100));
+    }
+    return path;
+}
+
+static SkPaint make_stroke() {
+    SkPaint paint;
+    paint.setStyle(SkPaint::kStroke_Style);
+    paint.setStrokeWidth(5);
+    paint.setStrokeJoin(SkPaint::kMiter_Join);
+    return paint;
+}
+
+// Returns true if the fill path came from the cache, which we can tell because it then shares its
+// SkPathRef (and so its generation ID) with the path that was cached.
+static bool get_fill_path(skiatest::Reporter* reporter, const SkPaint& paint, const SkPath& src,
+                          SkResourceCache* cache, uint32_t* genID) {
+    SkPath expected, dst;
+    const SkRect cullRect = SkRect::MakeWH(100, 100);
+    const bool doFill = paint.getFillPath(src, &expected, &cullRect, 2);
+    REPORTER_ASSERT(reporter,
+                    doFill == SkStrokeCache::GetFillPath(paint, src, &dst, &cullRect, 2, cache));
+    REPORTER_ASSERT(reporter, expected == dst);
+
+    const bool hit = dst.getGenerationID() == *genID;
+    *genID = dst.getGenerationID();
+    return hit;
+}
+
+static void test_find_add(skiatest::Reporter* reporter) {
+    SkResourceCache cache(1024 * 1024);
+    const SkPath chart = make_chart(20);
+    const SkPaint stroke = make_stroke();
+
+    uint32_t genID = 0;
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, stroke, chart, &cache, &genID));
+    REPORTER_ASSERT(reporter, cache.getTotalBytesUsed() > 0);
+    REPORTER_ASSERT(reporter, get_fill_path(reporter, stroke, chart, &cache, &genID));
+
+    // Copies of a path share its SkPathRef, so they share its results too.
+    SkPath copy(chart);
+    REPORTER_ASSERT(reporter, get_fill_path(reporter, stroke, copy, &cache, &genID));
+
+    // Anything that changes the fill path is part of the key.
+    SkPaint paints[6];
+    for (size_t i = 0; i < SK_ARRAY_COUNT(paints); ++i) {
+        paints[i] = stroke;
+    }
+    paints[0].setStrokeWidth(6);
+    paints[1].setStrokeJoin(SkPaint::kRound_Join);
+    paints[2].setStrokeCap(SkPaint::kSquare_Cap);
+    paints[3].setStrokeMiter(2);
+    paints[4].setStyle(SkPaint::kStrokeAndFill_Style);
+    const SkScalar intervals[] = { 10, 5 };
+    paints[5].setPathEffect(SkDashPathEffect::Create(intervals, 2, 0))->unref();
+    for (size_t i = 0; i < SK_ARRAY_COUNT(paints); ++i) {
+        REPORTER_ASSERT(reporter, !get_fill_path(reporter, paints[i], chart, &cache, &genID));
+        REPORTER_ASSERT(reporter, get_fill_path(reporter, paints[i], chart, &cache, &genID));
+    }
+
+    // Path effects are compared by value.
+    SkPaint dashed(stroke);
+    dashed.setPathEffect(SkDashPathEffect::Create(intervals, 2, 0))->unref();
+    REPORTER_ASSERT(reporter, get_fill_path(reporter, dashed, chart, &cache, &genID));
+    dashed.setPathEffect(SkDashPathEffect::Create(intervals, 2, 1))->unref();
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, dashed, chart, &cache, &genID));
+
+    // Even ones too big to key on the stack, down to their last byte.
+    SkScalar manyIntervals[100];
+    for (size_t i = 0; i < SK_ARRAY_COUNT(manyIntervals); ++i) {
+        manyIntervals[i] = SkIntToScalar(1 + i % 7);
+    }
+    const int manyCount = SK_ARRAY_COUNT(manyIntervals);
+    dashed.setPathEffect(SkDashPathEffect::Create(manyIntervals, manyCount, 0))->unref();
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, dashed, chart, &cache, &genID));
+    dashed.setPathEffect(SkDashPathEffect::Create(manyIntervals, manyCount, 0))->unref();
+    REPORTER_ASSERT(reporter, get_fill_path(reporter, dashed, chart, &cache, &genID));
+    manyIntervals[manyCount - 1] += 1;
+    dashed.setPathEffect(SkDashPathEffect::Create(manyIntervals, manyCount, 0))->unref();
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, dashed, chart, &cache, &genID));
+
+    SkPath evenOdd(chart);
+    evenOdd.setFillType(SkPath::kEvenOdd_FillType);
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, paints[4], evenOdd, &cache, &genID));
+
+    // Fills and volatile paths are not cached.
+    cache.purgeAll();
+    SkPaint fill;
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, fill, chart, &cache, &genID));
+    SkPath temp(make_chart(20));
+    temp.setIsVolatile(true);
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, stroke, temp, &cache, &genID));
+    REPORTER_ASSERT(reporter, 0 == cache.getTotalBytesUsed());
+}
+
+static void test_purge(skiatest::Reporter* reporter) {
+    SkResourceCache cache(1024 * 1024);
+    const SkPaint stroke = make_stroke();
+    const SkPath other = make_chart(10);
+    uint32_t genID = 0;
+
+    // Editing a path purges its results, so the edited path is stroked again.
+    SkPath chart = make_chart(20);
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, stroke, chart, &cache, &genID));
+    chart.lineTo(0, 0);
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, stroke, chart, &cache, &genID));
+    REPORTER_ASSERT(reporter, get_fill_path(reporter, stroke, chart, &cache, &genID));
+    const size_t bytesUsed = cache.getTotalBytesUsed();
+
+    // So does deleting it. (The cache checks for purges when it's next used.)
+    chart.reset();
+    uint32_t otherGenID = 0;
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, stroke, other, &cache, &otherGenID));
+    REPORTER_ASSERT(reporter, cache.getTotalBytesUsed() < bytesUsed);
+    {
+        SkPath doomed = make_chart(30);
+        REPORTER_ASSERT(reporter, !get_fill_path(reporter, stroke, doomed, &cache, &genID));
+    }
+    REPORTER_ASSERT(reporter, get_fill_path(reporter, stroke, other, &cache, &otherGenID));
+    REPORTER_ASSERT(reporter, cache.getTotalBytesUsed() < bytesUsed);
+
+    // Transforming a path in place changes it too.
+    SkPath moved = make_chart(20);
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, stroke, moved, &cache, &genID));
+    moved.transform(SkMatrix::MakeTrans(3, 4));
+    REPORTER_ASSERT(reporter, !get_fill_path(reporter, stroke, moved, &cache, &genID));
+}
+
+// Drawing a stroke again must look exactly like drawing it the first time.
+static void test_canvas(skiatest::Reporter* reporter) {
+    const SkPath chart = make_chart(20);
+    SkPaint paint = make_stroke();
+    paint.setAntiAlias(true);
+
+    SkBitmap bitmaps[2];
+    for (int i = 0; i < 2; ++i) {
+        bitmaps[i].allocN32Pixels(200, 100);
+        bitmaps[i].eraseColor(SK_ColorWHITE);
+        SkCanvas canvas(bitmaps[i]);
+        canvas.drawPath(chart, paint);
+    }
+    REPORTER_ASSERT(reporter, 0 == memcmp(bitmaps[0].getPixels(), bitmaps[1].getPixels(),
+                                          bitmaps[0].getSize()));
+}
+
+DEF_TEST(StrokeCache, reporter) {
+    test_find_add(reporter);
+    test_purge(reporter);
+    test_canvas(reporter);
+}
@@ -9,6 +9,7 @@
 #include "SkData.h"
 #include "SkEndian.h"
 #include "SkImageInfo.h"
+#include "SkRandom.h"
 #include "SkTextureCompressor.h"
 #include "Test.h"
 
@@ -302,3 +303,56 @@ DEF_TEST(CompressLATC, reporter) {
         }
     }
 }
+
+/**
+ * Make sure that large masks, which are compressed in parallel and with the platform's
+ * encoders, come out the same as when compressed a row of blocks at a time.
+ */
+DEF_TEST(CompressLargeA8MatchesRows, reporter) {
+    static const int kWidth = 768;   // Divisible by 48, like CompressCheckerboard, and big
+    static const int kHeight = 576;  // enough to be split across threads.
+    SkAutoTMalloc<uint8_t> pixels(kWidth * kHeight);
+    SkRandom rand;
+    for (int y = 0; y < kHeight; ++y) {
+        for (int x = 0; x < kWidth; ++x) {
+            uint8_t alpha;
+            switch ((y / 48 + x / 48) % 4) {
+                case 0: alpha = 0; break;
+                case 1: alpha = 0xFF; break;
+                case 2: alpha = static_cast<uint8_t>(x + y); break;
+                default: alpha = static_cast<uint8_t>(rand.nextU()); break;
+            }
+            pixels[y * kWidth + x] = alpha;
+        }
+    }
+
+    for (int i = 0; i < SkTextureCompressor::kFormatCnt; ++i) {
+        const SkTextureCompressor::Format fmt = static_cast<SkTextureCompressor::Format>(i);
+        if (!compresses_a8(fmt)) {
+            continue;
+        }
+        int dimX, dimY;
+        SkTextureCompressor::GetBlockDimensions(fmt, &dimX, &dimY, true);
+        const int size = SkTextureCompressor::GetCompressedDataSize(fmt, kWidth, kHeight);
+        const int rowSize = SkTextureCompressor::GetCompressedDataSize(fmt, kWidth, dimY);
+        REPORTER_ASSERT(reporter, size > 0 && rowSize > 0);
+
+        SkAutoTMalloc<uint8_t> whole(size), rows(size);
+        REPORTER_ASSERT(reporter, SkTextureCompressor::CompressBufferToFormat(
+                whole.get(), pixels.get(), kAlpha_8_SkColorType, kWidth, kHeight, kWidth, fmt));
+        for (int y = 0; y < kHeight; y += dimY) {
+            REPORTER_ASSERT(reporter, SkTextureCompressor::CompressBufferToFormat(
+                    rows.get() + (y / dimY) * rowSize, pixels.get() + y * kWidth,
+                    kAlpha_8_SkColorType, kWidth, dimY, kWidth, fmt));
+        }
+        REPORTER_ASSERT(reporter, 0 == memcmp(whole.get(), rows.get(), size));
+
+#if defined(SK_CPU_X86)
+        // The SSE2 encoders produce exactly what the portable ones do.
+        REPORTER_ASSERT(reporter, SkTextureCompressor::CompressBufferToFormat(
+                rows.get(), pixels.get(), kAlpha_8_SkColorType, kWidth, kHeight, kWidth, fmt,
+                false));
+        REPORTER_ASSERT(reporter, 0 == memcmp(whole.get(), rows.get(), size));
+#endif
+    }
+}
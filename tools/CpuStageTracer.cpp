@@ -0,0 +1,87 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "CpuStageTracer.h"
+#include "SkTraceEvent.h"
+
+#include <string.h>
+
+const char CpuStageTracer::kCategory[] = TRACE_DISABLED_BY_DEFAULT("skia.gpu.stages");
+
+void CpuStageTracer::reset() {
+    SkAutoMutexAcquire lock(fMutex);
+    fStages.rewind();
+}
+
+double CpuStageTracer::ms(const char* name) const {
+    for (int i = 0; i < fStages.count(); i++) {
+        if (0 == strcmp(fStages[i].fName, name)) {
+            return fStages[i].fMs;
+        }
+    }
+    return 0;
+}
+
+const uint8_t* CpuStageTracer::getCategoryGroupEnabled(const char* name) {
+    return 0 == strcmp(name, kCategory) ? &fEnabled : &fDisabled;
+}
+
+const char* CpuStageTracer::getCategoryGroupName(const uint8_t* categoryEnabledFlag) {
+    return categoryEnabledFlag == &fEnabled ? kCategory : "disabled";
+}
+
+CpuStageTracer::Stage* CpuStageTracer::findOrAddStage(const char* name) {
+    // Names are string literals, so pointer equality catches nearly every lookup.
+    for (int i = 0; i < fStages.count(); i++) {
+        if (fStages[i].fName == name || 0 == strcmp(fStages[i].fName, name)) {
+            return &fStages[i];
+        }
+    }
+    Stage* stage = fStages.append();
+    stage->fName = name;
+    stage->fMs = 0;
+    return stage;
+}
+
+SkEventTracer::Handle CpuStageTracer::addTraceEvent(char phase,
+                                                    const uint8_t* categoryEnabledFlag,
+                                                    const char* name,
+                                                    uint64_t id,
+                                                    int32_t numArgs,
+                                                    const char** argNames,
+                                                    const uint8_t* argTypes,
+                                                    const uint64_t* argValues,
+                                                    uint8_t flags) {
+    if (TRACE_EVENT_PHASE_COMPLETE != phase || categoryEnabledFlag != &fEnabled) {
+        return 0;
+    }
+    SkAutoMutexAcquire lock(fMutex);
+    int index = 0;
+    while (index < fOpen.count() && fOpen[index].fInUse) {
+        index++;
+    }
+    if (index == fOpen.count()) {
+        fOpen.append();
+    }
+    fOpen[index].fInUse = true;
+    fOpen[index].fTimer.start();
+    return index + 1;
+}
+
+void CpuStageTracer::updateTraceEventDuration(const uint8_t* categoryEnabledFlag,
+                                              const char* name,
+                                              SkEventTracer::Handle handle) {
+    if (0 == handle) {
+        return;
+    }
+    SkAutoMutexAcquire lock(fMutex);
+    OpenEvent& event = fOpen[SkToInt(handle - 1)];
+    SkASSERT(event.fInUse);
+    event.fTimer.end();
+    event.fInUse = false;
+    this->findOrAddStage(name)->fMs += event.fTimer.fWall;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef CpuStageTracer_DEFINED
+#define CpuStageTracer_DEFINED
+
+#include "SkEventTracer.h"
+#include "SkMutex.h"
+#include "SkTDArray.h"
+#include "Timer.h"
+
+/**
+ *  An SkEventTracer that only listens to the "skia.gpu.stages" category and sums the wall time
+ *  spent inside each named scope.  Ganesh brackets its CPU-side stages (batching, flushing,
+ *  program lookup, buffer mapping) with TRACE_EVENT0 in that category, so installing one of
+ *  these lets a tool break down where the CPU time of a GPU draw goes.  Paired with the null
+ *  GL context this measures driver-independent CPU overhead.
+ *
+ *  Stages may nest (e.g. program lookup happens inside flush), so the totals are inclusive.
+ */
+class CpuStageTracer : public SkEventTracer {
+public:
+    static const char kCategory[];
+
+    CpuStageTracer() : fEnabled(kEnabledForRecording_CategoryGroupEnabledFlags), fDisabled(0) {}
+
+    /** Forget all accumulated times. */
+    void reset();
+
+    /** Number of distinct stages seen since the last reset(). */
+    int count() const { return fStages.count(); }
+    const char* name(int i) const { return fStages[i].fName; }
+    /** Total milliseconds spent in stage i since the last reset(). */
+    double ms(int i) const { return fStages[i].fMs; }
+    /** Total milliseconds spent in the named stage since the last reset(), or 0. */
+    double ms(const char* name) const;
+
+    const uint8_t* getCategoryGroupEnabled(const char* name) override;
+    const char* getCategoryGroupName(const uint8_t* categoryEnabledFlag) override;
+
+    SkEventTracer::Handle addTraceEvent(char phase,
+                                        const uint8_t* categoryEnabledFlag,
+                                        const char* name,
+                                        uint64_t id,
+                                        int32_t numArgs,
+                                        const char** argNames,
+                                        const uint8_t* argTypes,
+                                        const uint64_t* argValues,
+                                        uint8_t flags) override;
+
+    void updateTraceEventDuration(const uint8_t* categoryEnabledFlag,
+                                  const char* name,
+                                  SkEventTracer::Handle handle) override;
+
+private:
+    struct Stage {
+        const char* fName;
+        double      fMs;
+    };
+    struct OpenEvent {
+        WallTimer fTimer;
+        bool      fInUse;
+    };
+
+    Stage* findOrAddStage(const char* name);
+
+    const uint8_t       fEnabled;
+    const uint8_t       fDisabled;
+    SkMutex             fMutex;
+    SkTDArray<Stage>    fStages;
+    // Scopes currently open, indexed by handle - 1.  Slots are recycled once a scope closes.
+    SkTDArray<OpenEvent> fOpen;
+};
+
+#endif  // CpuStageTracer_DEFINED
@@ -0,0 +1,346 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "RecordProfiler.h"
+
+#include "SkBBoxHierarchy.h"
+#include "SkCanvas.h"
+#include "SkPicture.h"
+#include "SkRecord.h"
+#include "SkRecordDraw.h"
+#include "SkRecorder.h"
+#include "SkTLogic.h"
+#include "SkTSort.h"
+#include "SkXfermode.h"
+#include "Timer.h"
+
+namespace {
+
+// SkRecordFillBounds() hands its bounds to a BBH; this one just keeps them.
+class BoundsCollector : public SkBBoxHierarchy {
+public:
+    explicit BoundsCollector(SkRect* bounds) : fBounds(bounds) {}
+
+    void insert(const SkRect boundsArray[], int N) override {
+        memcpy(fBounds, boundsArray, N * sizeof(SkRect));
+    }
+    void search(const SkRect&, SkTDArray<unsigned>*) const override {}
+    size_t bytesUsed() const override { return 0; }
+    SkRect getRootBound() const override { return SkRect::MakeEmpty(); }
+
+private:
+    SkRect* fBounds;
+};
+
+// Finds an op's type and the features of its paint, if it has one.
+class Classifier {
+public:
+    Classifier() : fType(SkRecords::NoOp_Type), fPaintFeatures(0) {}
+
+    template <typename T>
+    void operator()(const T& op) {
+        fType = T::kType;
+        fPaintFeatures = PaintFeatures(op);
+    }
+
+    SkRecords::Type fType;
+    unsigned        fPaintFeatures;
+
+private:
+    SK_CREATE_MEMBER_DETECTOR(paint);
+
+    static const SkPaint* AsPtr(const SkRecords::Optional<SkPaint>& paint) { return paint; }
+    static const SkPaint* AsPtr(const SkPaint& paint) { return &paint; }
+
+    template <typename T>
+    static SK_WHEN(HasMember_paint<T>, unsigned) PaintFeatures(const T& op) {
+        const SkPaint* paint = AsPtr(op.paint);
+        if (NULL == paint) {
+            return 0;
+        }
+        unsigned features = 0;
+        if (paint->isAntiAlias())       { features |= RecordProfiler::kAntiAlias_PaintFeature; }
+        if (paint->getShader())         { features |= RecordProfiler::kShader_PaintFeature; }
+        if (paint->getMaskFilter())     { features |= RecordProfiler::kMaskFilter_PaintFeature; }
+        if (paint->getColorFilter())    { features |= RecordProfiler::kColorFilter_PaintFeature; }
+        if (paint->getImageFilter())    { features |= RecordProfiler::kImageFilter_PaintFeature; }
+        if (paint->getPathEffect())     { features |= RecordProfiler::kPathEffect_PaintFeature; }
+        if (!SkXfermode::IsMode(paint->getXfermode(), SkXfermode::kSrcOver_Mode)) {
+            features |= RecordProfiler::kXfermode_PaintFeature;
+        }
+        return features;
+    }
+
+    template <typename T>
+    static SK_WHEN(!HasMember_paint<T>, unsigned) PaintFeatures(const T&) { return 0; }
+};
+
+// Wraps SkRecords::Draw to time each op.
+class TimedDraw {
+public:
+    TimedDraw(SkCanvas* canvas, SkDrawable* const drawables[], int drawableCount)
+        : fDraw(canvas, NULL, drawables, drawableCount) {}
+
+    template <typename T>
+    double operator()(const T& op) {
+        fTimer.start();
+        fDraw(op);
+        fTimer.end();
+        return fTimer.fWall;
+    }
+
+private:
+    SkRecords::Draw fDraw;
+    WallTimer       fTimer;
+};
+
+struct OpCost {
+    uint32_t    fKey;       // Type, paint features, and area bucket; see make_key().
+    double      fMs;
+    double      fMaxMs;
+    double      fPixels;
+
+    static bool KeyLessThan(const OpCost& a, const OpCost& b) { return a.fKey < b.fKey; }
+};
+
+static bool key_less_than(const RecordProfiler::Hotspot& a, const RecordProfiler::Hotspot& b) {
+    return a.fKey < b.fKey;
+}
+
+static bool costlier_than(const RecordProfiler::Hotspot& a, const RecordProfiler::Hotspot& b) {
+    return a.fMs > b.fMs;
+}
+
+static uint32_t make_key(SkRecords::Type type, unsigned paintFeatures,
+                         RecordProfiler::AreaBucket area) {
+    return (uint32_t)type << 16 | paintFeatures << 8 | area;
+}
+
+static RecordProfiler::AreaBucket area_bucket(double pixels) {
+    // Each bucket is 16x bigger than the last: 16x16, 64x64, 256x256, 1024x1024.
+    double limit = 256;
+    int bucket = 0;
+    while (bucket < RecordProfiler::kHuge_AreaBucket && pixels > limit) {
+        limit *= 16;
+        bucket++;
+    }
+    return (RecordProfiler::AreaBucket)bucket;
+}
+
+static const char* kOpNames[] = {
+#define NAME(T) #T,
+    SK_RECORD_TYPES(NAME)
+#undef NAME
+};
+
+static void append_escaped(SkString* json, const char* str) {
+    json->append("\"");
+    for (const char* c = str; *c; ++c) {
+        if ('"' == *c || '\\' == *c) {
+            json->append("\\");
+            json->append(c, 1);
+        } else if ((unsigned char)*c < 0x20) {
+            json->appendf("\\u%04x", *c);
+        } else {
+            json->append(c, 1);
+        }
+    }
+    json->append("\"");
+}
+
+}  // namespace
+
+const char* RecordProfiler::PaintFeatureName(int bit) {
+    static const char* kNames[] = {
+        "aa", "shader", "maskfilter", "colorfilter", "imagefilter", "xfermode", "patheffect",
+    };
+    SK_COMPILE_ASSERT(SK_ARRAY_COUNT(kNames) == kPaintFeatureCount, paint_feature_names);
+    SkASSERT(bit >= 0 && bit < kPaintFeatureCount);
+    return kNames[bit];
+}
+
+const char* RecordProfiler::AreaBucketName(AreaBucket area) {
+    static const char* kNames[] = { "tiny", "small", "medium", "large", "huge" };
+    SK_COMPILE_ASSERT(SK_ARRAY_COUNT(kNames) == kAreaBucketCount, area_bucket_names);
+    return kNames[area];
+}
+
+void RecordProfiler::reset() {
+    fHotspots.reset();
+    fPlaybacks = 0;
+    fTotalMs = 0;
+}
+
+void RecordProfiler::profile(const SkPicture* picture, SkCanvas* canvas, int loops) {
+    SkRecord record;
+    SkRecorder recorder(&record, picture->cullRect());
+    picture->playback(&recorder);
+
+    const SkDrawableList* drawables = recorder.getDrawableList();
+    this->profile(record, picture->cullRect(), canvas, loops,
+                  drawables ? drawables->begin() : NULL, drawables ? drawables->count() : 0);
+}
+
+void RecordProfiler::profile(const SkRecord& record, const SkRect& cullRect, SkCanvas* canvas,
+                             int loops) {
+    this->profile(record, cullRect, canvas, loops, NULL, 0);
+}
+
+void RecordProfiler::profile(const SkRecord& record, const SkRect& cullRect, SkCanvas* canvas,
+                             int loops, SkDrawable* const drawables[], int drawableCount) {
+    const int count = record.count();
+    if (0 == count || loops <= 0) {
+        return;
+    }
+
+    SkAutoTMalloc<OpCost> costs(count);
+    sk_bzero(costs.get(), count * sizeof(OpCost));
+
+    // Time every op, playing the whole record back each loop so ops see realistic state.
+    for (int loop = 0; loop < loops; ++loop) {
+        SkAutoCanvasRestore acr(canvas, true);
+        TimedDraw draw(canvas, drawables, drawableCount);
+        for (int i = 0; i < count; ++i) {
+            const double ms = record.visit<double>(i, draw);
+            costs[i].fMs += ms;
+            costs[i].fMaxMs = SkTMax(costs[i].fMaxMs, ms);
+        }
+    }
+
+    // Then classify each op by type, paint, and the device pixels its bounds cover.
+    SkAutoTMalloc<SkRect> bounds(count);
+    BoundsCollector collector(bounds.get());
+    SkRecordFillBounds(cullRect, record, &collector);
+
+    const SkMatrix& ctm = canvas->getTotalMatrix();
+    SkRect clip = SkRect::MakeEmpty();
+    SkIRect devClip;
+    if (canvas->getClipDeviceBounds(&devClip)) {
+        clip = SkRect::Make(devClip);
+    }
+    for (int i = 0; i < count; ++i) {
+        Classifier classifier;
+        record.visit<void>(i, classifier);
+        SkRect devBounds;
+        ctm.mapRect(&devBounds, bounds[i]);
+        if (!devBounds.intersect(clip)) {
+            devBounds.setEmpty();
+        }
+        costs[i].fPixels = (double)devBounds.width() * devBounds.height();
+        costs[i].fKey = make_key(classifier.fType, classifier.fPaintFeatures,
+                                 area_bucket(costs[i].fPixels));
+    }
+
+    // Merge ops with the same key into the hotspots, both in key order.
+    SkTQSort(costs.get(), costs.get() + count - 1, OpCost::KeyLessThan);
+    if (fHotspots.count() > 1) {
+        SkTQSort(fHotspots.begin(), fHotspots.end() - 1, key_less_than);
+    }
+    SkTDArray<Hotspot> merged;
+    int h = 0;
+    for (int i = 0; i < count;) {
+        const uint32_t key = costs[i].fKey;
+        while (h < fHotspots.count() && fHotspots[h].fKey < key) {
+            *merged.append() = fHotspots[h++];
+        }
+        Hotspot* hotspot = merged.append();
+        if (h < fHotspots.count() && fHotspots[h].fKey == key) {
+            *hotspot = fHotspots[h++];
+        } else {
+            const SkRecords::Type type = (SkRecords::Type)(key >> 16);
+            hotspot->fKey = key;
+            hotspot->fOp = kOpNames[type];
+            hotspot->fPaintFeatures = (key >> 8) & 0xFF;
+            hotspot->fArea = (AreaBucket)(key & 0xFF);
+            hotspot->fCount = 0;
+            hotspot->fMs = 0;
+            hotspot->fMaxMs = 0;
+            hotspot->fPixels = 0;
+        }
+        for (; i < count && costs[i].fKey == key; ++i) {
+            hotspot->fCount += loops;
+            hotspot->fMs += costs[i].fMs;
+            hotspot->fMaxMs = SkTMax(hotspot->fMaxMs, costs[i].fMaxMs);
+            hotspot->fPixels += costs[i].fPixels * loops;
+            fTotalMs += costs[i].fMs;
+        }
+    }
+    while (h < fHotspots.count()) {
+        *merged.append() = fHotspots[h++];
+    }
+    // NoOps are what SkRecordOptimize leaves behind; their cost is just the visit.
+    for (int i = merged.count() - 1; i >= 0; --i) {
+        if (SkRecords::NoOp_Type == merged[i].fKey >> 16) {
+            fTotalMs -= merged[i].fMs;
+            merged.remove(i);
+        }
+    }
+    if (merged.count() > 1) {
+        SkTQSort(merged.begin(), merged.end() - 1, costlier_than);
+    }
+    fHotspots.swap(merged);
+    fPlaybacks += loops;
+}
+
+void RecordProfiler::appendJSON(SkString* json, const char* name, int top) const {
+    const SkTDArray<Hotspot>& hotspots = fHotspots;
+    const int count = top < 0 ? hotspots.count() : SkTMin(top, hotspots.count());
+    const double playbacks = SkTMax(fPlaybacks, 1);
+
+    json->append("{\n  \"name\": ");
+    append_escaped(json, name);
+    json->appendf(",\n  \"playbacks\": %d,\n  \"total_ms\": %g,\n  \"hotspots\": [",
+                  fPlaybacks, fTotalMs / playbacks);
+    for (int i = 0; i < count; ++i) {
+        const Hotspot& hotspot = hotspots[i];
+        json->appendf("%s\n    { \"op\": \"%s\", \"paint\": [", i ? "," : "", hotspot.fOp);
+        const char* separator = "";
+        for (int bit = 0; bit < kPaintFeatureCount; ++bit) {
+            if (hotspot.fPaintFeatures & (1 << bit)) {
+                json->appendf("%s\"%s\"", separator, PaintFeatureName(bit));
+                separator = ", ";
+            }
+        }
+        json->appendf("], \"area\": \"%s\", \"count\": %g, \"ms\": %g, \"percent\": %.2f, "
+                      "\"mean_us\": %g, \"max_us\": %g, \"pixels\": %g }",
+                      AreaBucketName(hotspot.fArea),
+                      hotspot.fCount / playbacks,
+                      hotspot.fMs / playbacks,
+                      fTotalMs > 0 ? 100 * hotspot.fMs / fTotalMs : 0.0,
+                      1000 * hotspot.fMs / hotspot.fCount,
+                      1000 * hotspot.fMaxMs,
+                      hotspot.fPixels / playbacks);
+    }
+    json->append("\n  ]\n}");
+}
+
+void RecordProfiler::dump(int top) const {
+    const SkTDArray<Hotspot>& hotspots = fHotspots;
+    const int count = top < 0 ? hotspots.count() : SkTMin(top, hotspots.count());
+    const double playbacks = SkTMax(fPlaybacks, 1);
+
+    SkDebugf("%.3fms per playback\n", fTotalMs / playbacks);
+    SkDebugf("     %%\t      ms\t   count\t mean_us\t  max_us\top\tarea\tpaint\n");
+    for (int i = 0; i < count; ++i) {
+        const Hotspot& hotspot = hotspots[i];
+        SkString features;
+        for (int bit = 0; bit < kPaintFeatureCount; ++bit) {
+            if (hotspot.fPaintFeatures & (1 << bit)) {
+                features.appendf("%s%s", features.isEmpty() ? "" : "+", PaintFeatureName(bit));
+            }
+        }
+        SkDebugf("%6.2f\t%8.3f\t%8.0f\t%8.2f\t%8.2f\t%s\t%s\t%s\n",
+                 fTotalMs > 0 ? 100 * hotspot.fMs / fTotalMs : 0.0,
+                 hotspot.fMs / playbacks,
+                 hotspot.fCount / playbacks,
+                 1000 * hotspot.fMs / hotspot.fCount,
+                 1000 * hotspot.fMaxMs,
+                 hotspot.fOp,
+                 AreaBucketName(hotspot.fArea),
+                 features.isEmpty() ? "-" : features.c_str());
+    }
+}
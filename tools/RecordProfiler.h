@@ -0,0 +1,106 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#ifndef RecordProfiler_DEFINED
+#define RecordProfiler_DEFINED
+
+#include "SkString.h"
+#include "SkTDArray.h"
+
+class SkCanvas;
+class SkDrawable;
+class SkPicture;
+class SkRecord;
+struct SkRect;
+
+/**
+ *  Times each op of an SkRecord as it's drawn with SkRecords::Draw, and aggregates the costs by
+ *  op type, the paint features the op uses, and how many device pixels it covers, so that the
+ *  ops that dominate playback of real content can be found and targeted.
+ *
+ *  Only meaningful for raster canvases: GPU canvases defer their work, so an op's time there is
+ *  just the cost of recording it.
+ */
+class RecordProfiler {
+public:
+    enum PaintFeatures {
+        kAntiAlias_PaintFeature   = 1 << 0,
+        kShader_PaintFeature      = 1 << 1,
+        kMaskFilter_PaintFeature  = 1 << 2,
+        kColorFilter_PaintFeature = 1 << 3,
+        kImageFilter_PaintFeature = 1 << 4,
+        kXfermode_PaintFeature    = 1 << 5,     // Anything but src-over.
+        kPathEffect_PaintFeature  = 1 << 6,
+
+        kPaintFeatureCount = 7
+    };
+
+    // Device pixels covered by an op's bounds, clipped to the canvas.
+    enum AreaBucket {
+        kTiny_AreaBucket,       // Up to 16x16.
+        kSmall_AreaBucket,      // Up to 64x64.
+        kMedium_AreaBucket,     // Up to 256x256.
+        kLarge_AreaBucket,      // Up to 1024x1024.
+        kHuge_AreaBucket,
+
+        kAreaBucketCount
+    };
+
+    struct Hotspot {
+        const char* fOp;            // e.g. "DrawRect".
+        unsigned    fPaintFeatures; // PaintFeatures bits.
+        AreaBucket  fArea;
+        // Summed over all playbacks; divide by playbacks() for per-playback figures.
+        double      fCount;
+        double      fMs;
+        double      fMaxMs;         // Slowest single op.
+        double      fPixels;        // Device pixels covered.
+
+        uint32_t    fKey;           // Identifies the op, paint features, and area together.
+    };
+
+    RecordProfiler() : fPlaybacks(0), fTotalMs(0) {}
+
+    /**
+     *  Draws record into canvas loops times, timing every op, and adds the costs to the
+     *  profile.  cullRect is the record's cull rect, used to bound each op.
+     */
+    void profile(const SkRecord&, const SkRect& cullRect, SkCanvas*, int loops);
+
+    /** Records picture into an SkRecord, then profiles drawing that into canvas. */
+    void profile(const SkPicture*, SkCanvas*, int loops);
+
+    /** Forget everything profiled so far. */
+    void reset();
+
+    /** Hotspots, most expensive first. */
+    int count() const { return fHotspots.count(); }
+    const Hotspot& operator[](int i) const { return fHotspots[i]; }
+
+    /** Playbacks profiled, and the time they took over all ops. */
+    int playbacks() const { return fPlaybacks; }
+    double totalMs() const { return fTotalMs; }
+
+    /** Appends a JSON object describing the profile (and the top hotspots, or all if < 0). */
+    void appendJSON(SkString* json, const char* name, int top = -1) const;
+
+    /** Prints a table of the top hotspots, or all if < 0, with SkDebugf. */
+    void dump(int top = -1) const;
+
+    static const char* PaintFeatureName(int bit);
+    static const char* AreaBucketName(AreaBucket);
+
+private:
+    void profile(const SkRecord&, const SkRect& cullRect, SkCanvas*, int loops,
+                 SkDrawable* const drawables[], int drawableCount);
+
+    SkTDArray<Hotspot>  fHotspots;
+    int                 fPlaybacks;
+    double              fTotalMs;
+};
+
+#endif  // RecordProfiler_DEFINED
@@ -40,8 +40,17 @@ def get_args(bot):
       config.extend(['msaa4', 'nvprmsaa4'])
     else:
       config.extend(['msaa16', 'nvprmsaa16'])
+  if '-CPU-' in bot:
+    # No real GPU, but we can still track Ganesh's CPU overhead on the null GL context.
+    config.append('nullgpu')
+  if 'CpuStages' in bot:
+    # --cpuStages traces every GPU stage, which slows down everything else in the run, so it
+    # gets a bot of its own that only runs the null GL context.
+    config = ['nullgpu']
   args.append('--config')
   args.extend(config)
+  if 'CpuStages' in bot:
+    args.append('--cpuStages')
 
   if 'Valgrind' in bot:
     # Don't care about Valgrind performance.
@@ -75,6 +84,8 @@ def self_test():
   args = {}
   cases = [
     'Perf-Android-Nexus7-Tegra3-Arm7-Release',
+    'Perf-Ubuntu-GCC-GCE-CPU-AVX2-x86_64-Release',
+    'Perf-Ubuntu-GCC-GCE-CPU-AVX2-x86_64-Release-CpuStages',
     'Test-Ubuntu-GCC-ShuttleA-GPU-GTX550Ti-x86_64-Release-Valgrind',
     'Test-Win7-MSVC-ShuttleA-GPU-HD2000-x86-Debug-ANGLE',
   ]
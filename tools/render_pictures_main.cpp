@@ -17,13 +17,16 @@
 #include "SkOSFile.h"
 #include "SkPicture.h"
 #include "SkPictureRecorder.h"
+#include "SkPictureUtils.h"
 #include "SkStream.h"
 #include "SkString.h"
+#include "SkTaskGroup.h"
 
 #include "image_expectations.h"
 #include "PictureRenderer.h"
 #include "PictureRenderingFlags.h"
 #include "picture_utils.h"
+#include "Timer.h"
 
 // Flags used by this file, alphabetically:
 DEFINE_bool(bench_record, false, "If true, drop into an infinite loop of recording the picture.");
@@ -41,6 +44,8 @@ DEFINE_bool(gpuStats, false, "Only meaningful with gpu configurations. "
             "Report some GPU call statistics.");
 #endif
 DEFINE_bool(mpd, false, "If true, use MultiPictureDraw for rendering.");
+DEFINE_bool(preDecodeImages, false, "Decode the images in each skp in parallel before drawing it, "
+            "and report how much playback time that saves. Requires --deferImageDecoding.");
 DEFINE_string(readJsonSummaryPath, "", "JSON file to read image expectations from.");
 DECLARE_string(readPath);
 DEFINE_bool(writeChecksumBasedFilenames, false,
@@ -140,6 +145,46 @@ static bool write_image_to_file(const void* buffer, size_t size, SkBitmap* bitma
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Plays back a freshly deserialized copy of picture, whose images have not been decoded yet, then
+ * pre-decodes picture's images and plays it back, and reports how long each took.
+ * Called only by render_picture_internal().
+ */
+static void pre_decode_images(const SkString& inputPath, const SkPicture* picture,
+                              SkPicture::InstallPixelRefProc proc) {
+    SkFILEStream inputStream(inputPath.c_str());
+    SkAutoTUnref<SkPicture> fresh(SkPicture::CreateFromStream(&inputStream, proc));
+    SkIRect bounds;
+    picture->cullRect().roundOut(&bounds);
+    SkBitmap bitmap;
+    if (NULL == fresh || !bitmap.tryAllocN32Pixels(bounds.width(), bounds.height())) {
+        SkDebugf("Could not measure pre-decoding %s\n", inputPath.c_str());
+        SkPictureUtils::PreDecodeImages(picture);
+        return;
+    }
+    SkCanvas canvas(bitmap);
+    canvas.translate(-SkIntToScalar(bounds.left()), -SkIntToScalar(bounds.top()));
+
+    WallTimer timer;
+    timer.start();
+    fresh->playback(&canvas);
+    timer.end();
+    const double coldMs = timer.fWall;
+
+    timer.start();
+    const int imageCount = SkPictureUtils::PreDecodeImages(picture);
+    timer.end();
+    const double preDecodeMs = timer.fWall;
+
+    canvas.clear(SK_ColorTRANSPARENT);
+    timer.start();
+    picture->playback(&canvas);
+    timer.end();
+    SkDebugf("pre-decoded %d images in %.2fms; playback took %.2fms instead of %.2fms, "
+             "%.2fms less stalling\n", imageCount, preDecodeMs, timer.fWall, coldMs,
+             coldMs - timer.fWall);
+}
+
 /**
  * Called only by render_picture().
  */
@@ -192,6 +237,10 @@ static bool render_picture_internal(const SkString& inputPath, const SkString* w
         SkAutoTUnref<SkPicture> other(recorder.endRecording());
     }
 
+    if (FLAGS_preDecodeImages) {
+        pre_decode_images(inputPath, picture, proc);
+    }
+
     SkDebugf("drawing... [%f %f %f %f] %s\n", 
              picture->cullRect().fLeft, picture->cullRect().fTop,
              picture->cullRect().fRight, picture->cullRect().fBottom,
@@ -435,6 +484,11 @@ int tool_main(int argc, char** argv) {
         }
     }
 
+    if (FLAGS_preDecodeImages && !FLAGS_deferImageDecoding) {
+        SkDebugf("--preDecodeImages requires --deferImageDecoding\n");
+        exit(-1);
+    }
+
     SkString errorString;
     SkAutoTUnref<sk_tools::PictureRenderer> renderer(parseRenderer(errorString,
                                                                    kRender_PictureTool));
@@ -447,6 +501,8 @@ int tool_main(int argc, char** argv) {
     }
 
     SkAutoGraphics ag;
+    SkAutoTDelete<SkTaskGroup::Enabler> taskGroupEnabler(
+        FLAGS_preDecodeImages ? SkNEW(SkTaskGroup::Enabler) : NULL);
 
     SkString writePath;
     if (FLAGS_writePath.count() == 1) {
@@ -11,6 +11,10 @@
 #include "SkColorPriv.h"
 #include "SkTypes.h"
 
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    #include <emmintrin.h>
+#endif
+
 /*static*/ char const * const DiffRecord::ResultNames[DiffRecord::kResultCount] = {
     "EqualBits",
     "EqualPixels",
@@ -155,6 +159,126 @@ static inline bool colors_match_thresholded(SkPMColor c0, SkPMColor c1, const in
 const SkPMColor PMCOLOR_WHITE = SkPreMultiplyColor(SK_ColorWHITE);
 const SkPMColor PMCOLOR_BLACK = SkPreMultiplyColor(SK_ColorBLACK);
 
+/** Running totals of the per-channel differences between the pixels of two rows. The channel
+ *  arrays are indexed by byte within an SkPMColor, i.e. by SK_A32_SHIFT / 8 and so on.
+ */
+struct DiffTotals {
+    DiffTotals() : fValueSum(0), fMismatchedPixels(0) {
+        for (int i = 0; i < 4; i++) {
+            fTotal[i] = fMax[i] = 0;
+        }
+    }
+
+    uint32_t fTotal[4];
+    uint32_t fMax[4];
+    uint64_t fValueSum;         // Sum over all pixels of max(|dR|, |dG|, |dB|).
+    int      fMismatchedPixels;
+};
+
+static inline void diff_pixel(SkPMColor c0, SkPMColor c1, DiffMetricProc diffFunction,
+                              const int colorThreshold, SkPMColor* difference, SkPMColor* white,
+                              DiffTotals* totals) {
+    uint32_t thisA = SkAbs32(SkGetPackedA32(c0) - SkGetPackedA32(c1));
+    uint32_t thisR = SkAbs32(SkGetPackedR32(c0) - SkGetPackedR32(c1));
+    uint32_t thisG = SkAbs32(SkGetPackedG32(c0) - SkGetPackedG32(c1));
+    uint32_t thisB = SkAbs32(SkGetPackedB32(c0) - SkGetPackedB32(c1));
+    totals->fTotal[SK_A32_SHIFT / 8] += thisA;
+    totals->fTotal[SK_R32_SHIFT / 8] += thisR;
+    totals->fTotal[SK_G32_SHIFT / 8] += thisG;
+    totals->fTotal[SK_B32_SHIFT / 8] += thisB;
+    // In HSV, value is defined as max RGB component.
+    totals->fValueSum += MAX3(thisR, thisG, thisB);
+    totals->fMax[SK_A32_SHIFT / 8] = SkTMax(totals->fMax[SK_A32_SHIFT / 8], thisA);
+    totals->fMax[SK_R32_SHIFT / 8] = SkTMax(totals->fMax[SK_R32_SHIFT / 8], thisR);
+    totals->fMax[SK_G32_SHIFT / 8] = SkTMax(totals->fMax[SK_G32_SHIFT / 8], thisG);
+    totals->fMax[SK_B32_SHIFT / 8] = SkTMax(totals->fMax[SK_B32_SHIFT / 8], thisB);
+    if (!colors_match_thresholded(c0, c1, colorThreshold)) {
+        totals->fMismatchedPixels++;
+        *difference = diffFunction(c0, c1);
+        *white = PMCOLOR_WHITE;
+    } else {
+        *difference = 0;
+        *white = PMCOLOR_BLACK;
+    }
+}
+
+static void diff_row(const SkPMColor* base, const SkPMColor* comparison, int count,
+                     DiffMetricProc diffFunction, const int colorThreshold,
+                     SkPMColor* difference, SkPMColor* white, DiffTotals* totals) {
+    int x = 0;
+#if SK_CPU_SSE_LEVEL >= SK_CPU_SSE_LEVEL_SSE2
+    // A negative threshold makes every pixel a mismatch; leave that to the scalar loop.
+    if (colorThreshold >= 0) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i threshold = _mm_set1_epi8((char)SkTMin(colorThreshold, 255));
+        const __m128i rgbMask = _mm_set1_epi32(~(SK_A32_MASK << SK_A32_SHIFT));
+        const __m128i lowByte = _mm_set1_epi32(0xFF);
+        const __m128i white4 = _mm_set1_epi32(PMCOLOR_WHITE);
+        const __m128i black4 = _mm_set1_epi32(PMCOLOR_BLACK);
+        __m128i maxes = zero;       // 16 x u8:  per-channel maxima of 4 pixel slots.
+        __m128i sums = zero;        // 4 x u32:  per-channel sums.
+        __m128i values = zero;      // 4 x u32:  per-slot sums of the max RGB difference.
+
+        for (; x + 4 <= count; x += 4) {
+            const __m128i a = _mm_loadu_si128((const __m128i*)(base + x));
+            const __m128i b = _mm_loadu_si128((const __m128i*)(comparison + x));
+            if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) {
+                _mm_storeu_si128((__m128i*)(difference + x), zero);
+                _mm_storeu_si128((__m128i*)(white + x), black4);
+                continue;
+            }
+
+            // |a - b| for each of the 16 channels.
+            const __m128i d = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+            maxes = _mm_max_epu8(maxes, d);
+
+            // Fold the 4 pixels into 4 per-channel sums, widening as we go.
+            const __m128i d16 = _mm_add_epi16(_mm_unpacklo_epi8(d, zero),
+                                              _mm_unpackhi_epi8(d, zero));
+            sums = _mm_add_epi32(sums, _mm_add_epi32(_mm_unpacklo_epi16(d16, zero),
+                                                     _mm_unpackhi_epi16(d16, zero)));
+
+            __m128i rgb = _mm_and_si128(d, rgbMask);
+            rgb = _mm_max_epu8(rgb, _mm_srli_epi32(rgb, 8));
+            rgb = _mm_max_epu8(rgb, _mm_srli_epi32(rgb, 16));
+            values = _mm_add_epi32(values, _mm_and_si128(rgb, lowByte));
+
+            // A pixel matches if none of its channels differ by more than the threshold.
+            const __m128i match = _mm_cmpeq_epi32(_mm_subs_epu8(d, threshold), zero);
+            const int matchBits = _mm_movemask_ps(_mm_castsi128_ps(match));
+            _mm_storeu_si128((__m128i*)(white + x),
+                             _mm_or_si128(_mm_and_si128(match, black4),
+                                          _mm_andnot_si128(match, white4)));
+            for (int i = 0; i < 4; i++) {
+                if (matchBits & (1 << i)) {
+                    difference[x + i] = 0;
+                } else {
+                    totals->fMismatchedPixels++;
+                    difference[x + i] = diffFunction(base[x + i], comparison[x + i]);
+                }
+            }
+        }
+
+        uint8_t maxBytes[16];
+        uint32_t sumWords[4], valueWords[4];
+        _mm_storeu_si128((__m128i*)maxBytes, maxes);
+        _mm_storeu_si128((__m128i*)sumWords, sums);
+        _mm_storeu_si128((__m128i*)valueWords, values);
+        for (int i = 0; i < 4; i++) {
+            for (int slot = 0; slot < 4; slot++) {
+                totals->fMax[i] = SkTMax<uint32_t>(totals->fMax[i], maxBytes[4 * slot + i]);
+            }
+            totals->fTotal[i] += sumWords[i];
+            totals->fValueSum += valueWords[i];
+        }
+    }
+#endif
+    for (; x < count; x++) {
+        diff_pixel(base[x], comparison[x], diffFunction, colorThreshold,
+                   difference + x, white + x, totals);
+    }
+}
+
 void compute_diff(DiffRecord* dr, DiffMetricProc diffFunction, const int colorThreshold) {
     const int w = dr->fComparison.fBitmap.width();
     const int h = dr->fComparison.fBitmap.height();
@@ -165,64 +289,31 @@ void compute_diff(DiffRecord* dr, DiffMetricProc diffFunction, const int colorTh
 
     SkAutoLockPixels alpDiff(dr->fDifference.fBitmap);
     SkAutoLockPixels alpWhite(dr->fWhite.fBitmap);
-    int mismatchedPixels = 0;
-    int totalMismatchA = 0;
-    int totalMismatchR = 0;
-    int totalMismatchG = 0;
-    int totalMismatchB = 0;
+    DiffTotals totals;
+    for (int y = 0; y < h; y++) {
+        diff_row(dr->fBase.fBitmap.getAddr32(0, y), dr->fComparison.fBitmap.getAddr32(0, y), w,
+                 diffFunction, colorThreshold, dr->fDifference.fBitmap.getAddr32(0, y),
+                 dr->fWhite.fBitmap.getAddr32(0, y), &totals);
+    }
+    dr->fMaxMismatchA = SkTMax(dr->fMaxMismatchA, totals.fMax[SK_A32_SHIFT / 8]);
+    dr->fMaxMismatchR = SkTMax(dr->fMaxMismatchR, totals.fMax[SK_R32_SHIFT / 8]);
+    dr->fMaxMismatchG = SkTMax(dr->fMaxMismatchG, totals.fMax[SK_G32_SHIFT / 8]);
+    dr->fMaxMismatchB = SkTMax(dr->fMaxMismatchB, totals.fMax[SK_B32_SHIFT / 8]);
 
     // Accumulate fractionally different pixels, then divide out
     // # of pixels at the end.
-    dr->fWeightedFraction = 0;
-    for (int y = 0; y < h; y++) {
-        for (int x = 0; x < w; x++) {
-            SkPMColor c0 = *dr->fBase.fBitmap.getAddr32(x, y);
-            SkPMColor c1 = *dr->fComparison.fBitmap.getAddr32(x, y);
-            SkPMColor outputDifference = diffFunction(c0, c1);
-            uint32_t thisA = SkAbs32(SkGetPackedA32(c0) - SkGetPackedA32(c1));
-            uint32_t thisR = SkAbs32(SkGetPackedR32(c0) - SkGetPackedR32(c1));
-            uint32_t thisG = SkAbs32(SkGetPackedG32(c0) - SkGetPackedG32(c1));
-            uint32_t thisB = SkAbs32(SkGetPackedB32(c0) - SkGetPackedB32(c1));
-            totalMismatchA += thisA;
-            totalMismatchR += thisR;
-            totalMismatchG += thisG;
-            totalMismatchB += thisB;
-            // In HSV, value is defined as max RGB component.
-            int value = MAX3(thisR, thisG, thisB);
-            dr->fWeightedFraction += ((float) value) / 255;
-            if (thisA > dr->fMaxMismatchA) {
-                dr->fMaxMismatchA = thisA;
-            }
-            if (thisR > dr->fMaxMismatchR) {
-                dr->fMaxMismatchR = thisR;
-            }
-            if (thisG > dr->fMaxMismatchG) {
-                dr->fMaxMismatchG = thisG;
-            }
-            if (thisB > dr->fMaxMismatchB) {
-                dr->fMaxMismatchB = thisB;
-            }
-            if (!colors_match_thresholded(c0, c1, colorThreshold)) {
-                mismatchedPixels++;
-                *dr->fDifference.fBitmap.getAddr32(x, y) = outputDifference;
-                *dr->fWhite.fBitmap.getAddr32(x, y) = PMCOLOR_WHITE;
-            } else {
-                *dr->fDifference.fBitmap.getAddr32(x, y) = 0;
-                *dr->fWhite.fBitmap.getAddr32(x, y) = PMCOLOR_BLACK;
-            }
-        }
-    }
-    if (0 == mismatchedPixels) {
+    dr->fWeightedFraction = (float)(totals.fValueSum / 255.0);
+    if (0 == totals.fMismatchedPixels) {
         dr->fResult = DiffRecord::kEqualPixels_Result;
         return;
     }
     dr->fResult = DiffRecord::kDifferentPixels_Result;
     int pixelCount = w * h;
-    dr->fFractionDifference = ((float) mismatchedPixels) / pixelCount;
+    dr->fFractionDifference = ((float) totals.fMismatchedPixels) / pixelCount;
     dr->fWeightedFraction /= pixelCount;
-    dr->fTotalMismatchA = totalMismatchA;
-    dr->fAverageMismatchA = ((float) totalMismatchA) / pixelCount;
-    dr->fAverageMismatchR = ((float) totalMismatchR) / pixelCount;
-    dr->fAverageMismatchG = ((float) totalMismatchG) / pixelCount;
-    dr->fAverageMismatchB = ((float) totalMismatchB) / pixelCount;
+    dr->fTotalMismatchA = totals.fTotal[SK_A32_SHIFT / 8];
+    dr->fAverageMismatchA = ((float) totals.fTotal[SK_A32_SHIFT / 8]) / pixelCount;
+    dr->fAverageMismatchR = ((float) totals.fTotal[SK_R32_SHIFT / 8]) / pixelCount;
+    dr->fAverageMismatchG = ((float) totals.fTotal[SK_G32_SHIFT / 8]) / pixelCount;
+    dr->fAverageMismatchB = ((float) totals.fTotal[SK_B32_SHIFT / 8]) / pixelCount;
 }
@@ -17,6 +17,8 @@
 #include "SkTDArray.h"
 #include "SkTemplates.h"
 #include "SkTSearch.h"
+#include "SkTaskGroup.h"
+#include "SkTime.h"
 
 __SK_FORCE_IMAGE_DECODER_LINKING;
 
@@ -30,6 +32,7 @@ __SK_FORCE_IMAGE_DECODER_LINKING;
  * Creates an index.html in the current third directory to compare each
  * pair that does not match exactly.
  * Recursively descends directories, unless run with --norecurse.
+ * File pairs are compared in parallel, on --threads threads.
  *
  * Returns zero exit code if all images match across baseDir and comparisonDir.
  */
@@ -66,7 +69,9 @@ struct DiffSummary {
         : fNumMatches(0)
         , fNumMismatches(0)
         , fMaxMismatchV(0)
-        , fMaxMismatchPercent(0) { };
+        , fMaxMismatchPercent(0)
+        , fNumPixels(0)
+        , fElapsedMS(0) { };
 
     ~DiffSummary() {
         for (int i = 0; i < DiffRecord::kResultCount; ++i) {
@@ -84,6 +89,10 @@ struct DiffSummary {
     uint32_t fMaxMismatchV;
     float fMaxMismatchPercent;
 
+    // Pixels compared by file pairs that were decoded, and the time taken to compare all pairs.
+    uint64_t fNumPixels;
+    SkMSec fElapsedMS;
+
     FileArray fResultsOfType[DiffRecord::kResultCount];
     FileArray fStatusOfType[DiffResource::kStatusCount][DiffResource::kStatusCount];
 
@@ -165,6 +174,10 @@ struct DiffSummary {
             printf("Maximum pixel intensity mismatch %d\n", fMaxMismatchV);
             printf("Largest area mismatch was %.2f%% of pixels\n",fMaxMismatchPercent);
         }
+        const double seconds = SkTMax<SkMSec>(fElapsedMS, 1) / 1000.0;
+        printf("compared %.1f Mpixels in %.2f s: %.1f file pairs/s, %.1f Mpixels/s\n",
+               fNumPixels / 1e6, seconds, (fNumMatches + fNumMismatches) / seconds,
+               fNumPixels / 1e6 / seconds);
     }
 
     void printfFailingBaseNames(const char separator[]) {
@@ -199,12 +212,14 @@ struct DiffSummary {
             break;
           case DiffRecord::kEqualPixels_Result:
             fNumMatches++;
+            fNumPixels += (uint64_t)drp->fBase.fBitmap.width() * drp->fBase.fBitmap.height();
             break;
           case DiffRecord::kDifferentSizes_Result:
             fNumMismatches++;
             break;
           case DiffRecord::kDifferentPixels_Result:
             fNumMismatches++;
+            fNumPixels += (uint64_t)drp->fBase.fBitmap.width() * drp->fBase.fBitmap.height();
             if (drp->fFractionDifference * 100 > fMaxMismatchPercent) {
                 fMaxMismatchPercent = drp->fFractionDifference * 100;
             }
@@ -372,6 +387,59 @@ static void get_bounds(DiffRecord& drp) {
 
 #define VERBOSE_STATUS(status,color,filename) if (verbose) printf( "[ " color " %10s " ANSI_COLOR_RESET " ] %s\n", status, filename->c_str())
 
+/// Reads, decodes and diffs a pair of files that exist in both baseDir and comparisonDir.
+static void compare_file_pair(DiffRecord* drp, DiffMetricProc dmp, const int colorThreshold,
+                              const SkString& outputDir) {
+    SkAutoDataUnref baseFileBits(read_file(drp->fBase.fFullPath.c_str()));
+    if (baseFileBits) {
+        drp->fBase.fStatus = DiffResource::kRead_Status;
+    }
+    SkAutoDataUnref comparisonFileBits(read_file(drp->fComparison.fFullPath.c_str()));
+    if (comparisonFileBits) {
+        drp->fComparison.fStatus = DiffResource::kRead_Status;
+    }
+    if (NULL == baseFileBits || NULL == comparisonFileBits) {
+        if (NULL == baseFileBits) {
+            drp->fBase.fStatus = DiffResource::kCouldNotRead_Status;
+        }
+        if (NULL == comparisonFileBits) {
+            drp->fComparison.fStatus = DiffResource::kCouldNotRead_Status;
+        }
+        drp->fResult = DiffRecord::kCouldNotCompare_Result;
+
+    } else if (are_buffers_equal(baseFileBits, comparisonFileBits)) {
+        drp->fResult = DiffRecord::kEqualBits_Result;
+    } else {
+        AutoReleasePixels arp(drp);
+        get_bitmap(baseFileBits, drp->fBase, SkImageDecoder::kDecodePixels_Mode);
+        get_bitmap(comparisonFileBits, drp->fComparison, SkImageDecoder::kDecodePixels_Mode);
+        if (DiffResource::kDecoded_Status == drp->fBase.fStatus &&
+            DiffResource::kDecoded_Status == drp->fComparison.fStatus) {
+            create_and_write_diff_image(drp, dmp, colorThreshold, outputDir, drp->fBase.fFilename);
+        } else {
+            drp->fResult = DiffRecord::kCouldNotCompare_Result;
+        }
+    }
+}
+
+struct DiffTask {
+    DiffRecord*     fDrp;
+    DiffMetricProc  fDmp;
+    int             fColorThreshold;
+    const SkString* fOutputDir;
+    bool            fGetBounds;
+    bool            fComparePair;
+};
+
+static void run_diff_task(DiffTask* task) {
+    if (task->fComparePair) {
+        compare_file_pair(task->fDrp, task->fDmp, task->fColorThreshold, *task->fOutputDir);
+    }
+    if (task->fGetBounds) {
+        get_bounds(*task->fDrp);
+    }
+}
+
 /// Creates difference images, returns the number that have a 0 metric.
 /// If outputDir.isEmpty(), don't write out diff files.
 static void create_diff_images (DiffMetricProc dmp,
@@ -454,7 +522,7 @@ static void create_diff_images (DiffMetricProc dmp,
 
             ++j;
         } else {
-            // Found the same filename in both baseDir and comparisonDir.
+            // Found the same filename in both baseDir and comparisonDir; compare them below.
             SkASSERT(DiffRecord::kUnknown_Result == drp->fResult);
 
             basePath.append(*baseFiles[i]);
@@ -468,53 +536,11 @@ static void create_diff_images (DiffMetricProc dmp,
             drp->fComparison.fFullPath = comparisonPath;
             drp->fComparison.fStatus = DiffResource::kExists_Status;
 
-            SkAutoDataUnref baseFileBits(read_file(drp->fBase.fFullPath.c_str()));
-            if (baseFileBits) {
-                drp->fBase.fStatus = DiffResource::kRead_Status;
-            }
-            SkAutoDataUnref comparisonFileBits(read_file(drp->fComparison.fFullPath.c_str()));
-            if (comparisonFileBits) {
-                drp->fComparison.fStatus = DiffResource::kRead_Status;
-            }
-            if (NULL == baseFileBits || NULL == comparisonFileBits) {
-                if (NULL == baseFileBits) {
-                    drp->fBase.fStatus = DiffResource::kCouldNotRead_Status;
-                    VERBOSE_STATUS("READ FAIL", ANSI_COLOR_RED, baseFiles[i]);
-                }
-                if (NULL == comparisonFileBits) {
-                    drp->fComparison.fStatus = DiffResource::kCouldNotRead_Status;
-                    VERBOSE_STATUS("READ FAIL", ANSI_COLOR_RED, comparisonFiles[j]);
-                }
-                drp->fResult = DiffRecord::kCouldNotCompare_Result;
-
-            } else if (are_buffers_equal(baseFileBits, comparisonFileBits)) {
-                drp->fResult = DiffRecord::kEqualBits_Result;
-                VERBOSE_STATUS("MATCH", ANSI_COLOR_GREEN, baseFiles[i]);
-            } else {
-                AutoReleasePixels arp(drp);
-                get_bitmap(baseFileBits, drp->fBase, SkImageDecoder::kDecodePixels_Mode);
-                get_bitmap(comparisonFileBits, drp->fComparison,
-                           SkImageDecoder::kDecodePixels_Mode);
-                VERBOSE_STATUS("DIFFERENT", ANSI_COLOR_RED, baseFiles[i]);
-                if (DiffResource::kDecoded_Status == drp->fBase.fStatus &&
-                    DiffResource::kDecoded_Status == drp->fComparison.fStatus) {
-                    create_and_write_diff_image(drp, dmp, colorThreshold,
-                                                outputDir, drp->fBase.fFilename);
-                } else {
-                    drp->fResult = DiffRecord::kCouldNotCompare_Result;
-                }
-            }
-
             ++i;
             ++j;
         }
 
-        if (getBounds) {
-            get_bounds(*drp);
-        }
-        SkASSERT(DiffRecord::kUnknown_Result != drp->fResult);
         differences->push(drp);
-        summary->add(drp);
     }
 
     for (; i < baseFiles.count(); ++i) {
@@ -531,11 +557,7 @@ static void create_diff_images (DiffMetricProc dmp,
         drp->fComparison.fStatus = DiffResource::kDoesNotExist_Status;
 
         drp->fResult = DiffRecord::kCouldNotCompare_Result;
-        if (getBounds) {
-            get_bounds(*drp);
-        }
         differences->push(drp);
-        summary->add(drp);
     }
 
     for (; j < comparisonFiles.count(); ++j) {
@@ -552,10 +574,43 @@ static void create_diff_images (DiffMetricProc dmp,
         drp->fComparison.fStatus = DiffResource::kExists_Status;
 
         drp->fResult = DiffRecord::kCouldNotCompare_Result;
-        if (getBounds) {
-            get_bounds(*drp);
-        }
         differences->push(drp);
+    }
+
+    // Reading, decoding and diffing each pair is independent of all the others.
+    SkAutoTMalloc<DiffTask> tasks(differences->count());
+    for (int k = 0; k < differences->count(); ++k) {
+        DiffTask& task = tasks[k];
+        task.fDrp = (*differences)[k];
+        task.fDmp = dmp;
+        task.fColorThreshold = colorThreshold;
+        task.fOutputDir = &outputDir;
+        task.fGetBounds = getBounds;
+        task.fComparePair = DiffRecord::kUnknown_Result == task.fDrp->fResult;
+    }
+    const SkMSec start = SkTime::GetMSecs();
+    SkTaskGroup().batch(run_diff_task, tasks.get(), differences->count());
+    summary->fElapsedMS = SkTime::GetMSecs() - start;
+
+    for (int k = 0; k < differences->count(); ++k) {
+        DiffRecord* drp = tasks[k].fDrp;
+        if (tasks[k].fComparePair) {
+            const SkString* baseName = &drp->fBase.fFilename;
+            const SkString* comparisonName = &drp->fComparison.fFilename;
+            if (DiffResource::kCouldNotRead_Status == drp->fBase.fStatus) {
+                VERBOSE_STATUS("READ FAIL", ANSI_COLOR_RED, baseName);
+            }
+            if (DiffResource::kCouldNotRead_Status == drp->fComparison.fStatus) {
+                VERBOSE_STATUS("READ FAIL", ANSI_COLOR_RED, comparisonName);
+            }
+            if (DiffRecord::kEqualBits_Result == drp->fResult) {
+                VERBOSE_STATUS("MATCH", ANSI_COLOR_GREEN, baseName);
+            } else if (DiffResource::kCouldNotRead_Status != drp->fBase.fStatus &&
+                       DiffResource::kCouldNotRead_Status != drp->fComparison.fStatus) {
+                VERBOSE_STATUS("DIFFERENT", ANSI_COLOR_RED, baseName);
+            }
+        }
+        SkASSERT(DiffRecord::kUnknown_Result != drp->fResult);
         summary->add(drp);
     }
 
@@ -593,6 +648,8 @@ static void usage (char * argv0) {
 "\n    --sortbymaxmismatch: sort by worst color channel mismatch;"
 "\n                         break ties with -sortbymismatch"
 "\n    --sortbymismatch: sort by average color channel mismatch"
+"\n    --threads <n>: compare file pairs on n threads; 0 compares them all on this"
+"\n                   thread [default is derived from CPUs available]"
 "\n    --threshold <n>: only report differences > n (per color channel) [default 0]"
 "\n    --weighted: sort by # pixels different weighted by color difference"
 "\n"
@@ -616,6 +673,7 @@ int tool_main(int argc, char** argv) {
     // Maximum error tolerated in any one color channel in any one pixel before
     // a difference is reported.
     int colorThreshold = 0;
+    int threads = -1;
     SkString baseDir;
     SkString comparisonDir;
     SkString outputDir;
@@ -728,6 +786,10 @@ int tool_main(int argc, char** argv) {
             sortProc = compare<CompareDiffMeanMismatches>;
             continue;
         }
+        if (!strcmp(argv[i], "--threads")) {
+            threads = atoi(argv[++i]);
+            continue;
+        }
         if (!strcmp(argv[i], "--threshold")) {
             colorThreshold = atoi(argv[++i]);
             continue;
@@ -804,6 +866,7 @@ int tool_main(int argc, char** argv) {
         matchSubstrings.push(new SkString(""));
     }
 
+    SkTaskGroup::Enabler enabled(threads);
     create_diff_images(diffProc, colorThreshold, &differences,
                        baseDir, comparisonDir, outputDir,
                        matchSubstrings, nomatchSubstrings, recurseIntoSubdirs, generateDiffs,
@@ -117,6 +117,21 @@ SkString filename_to_white_filename(const SkString& filename) {
     return filename_to_derived_filename(filename, "-white.png");
 }
 
+/** Returns true if the two same-sized bitmaps have byte-identical pixels. This is much cheaper
+ *  than compute_diff, which then need not allocate or fill the difference images at all.
+ */
+static bool pixels_equal(const SkBitmap& base, const SkBitmap& comparison) {
+    SkAutoLockPixels alpBase(base);
+    SkAutoLockPixels alpComparison(comparison);
+    const size_t rowBytes = base.width() * sizeof(SkPMColor);
+    for (int y = 0; y < base.height(); y++) {
+        if (memcmp(base.getAddr32(0, y), comparison.getAddr32(0, y), rowBytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void create_and_write_diff_image(DiffRecord* drp,
                                  DiffMetricProc dmp,
                                  const int colorThreshold,
@@ -127,6 +142,9 @@ void create_and_write_diff_image(DiffRecord* drp,
 
     if (w != drp->fComparison.fBitmap.width() || h != drp->fComparison.fBitmap.height()) {
         drp->fResult = DiffRecord::kDifferentSizes_Result;
+    } else if (colorThreshold >= 0 &&
+               pixels_equal(drp->fBase.fBitmap, drp->fComparison.fBitmap)) {
+        drp->fResult = DiffRecord::kEqualPixels_Result;
     } else {
         drp->fDifference.fBitmap.allocN32Pixels(w, h);
 
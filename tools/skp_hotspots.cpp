@@ -0,0 +1,105 @@
+/*
+ * Copyright 2015 Google Inc.
+ *
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include "SkCanvas.h"
+#include "SkCommandLineFlags.h"
+#include "SkGraphics.h"
+#include "SkOSFile.h"
+#include "SkPicture.h"
+#include "SkStream.h"
+
+#include "LazyDecodeBitmap.h"
+#include "RecordProfiler.h"
+
+DEFINE_string2(skps, r, "", ".SKPs to profile, or directories of them.");
+DEFINE_string(match, "", "The usual filters on file names to profile.");
+DEFINE_int32(loops, 10, "Times to play back each SKP while profiling.");
+DEFINE_int32(top, 20, "Hotspots to print per SKP, or -1 for all.");
+DEFINE_double(scale, 1.0, "Scale to play back the SKPs at.");
+DEFINE_string(json, "", "If given, write every SKP's hotspots here as a JSON array.");
+
+static bool profile(const char* path, SkString* json) {
+    SkAutoTDelete<SkStream> stream(SkStream::NewFromFile(path));
+    if (!stream) {
+        SkDebugf("Could not read %s.\n", path);
+        return false;
+    }
+    SkAutoTUnref<SkPicture> pic(SkPicture::CreateFromStream(stream, sk_tools::LazyDecodeBitmap));
+    if (!pic) {
+        SkDebugf("Could not read %s as an SkPicture.\n", path);
+        return false;
+    }
+
+    const SkScalar scale = SkDoubleToScalar(FLAGS_scale);
+    SkBitmap bitmap;
+    if (!bitmap.tryAllocN32Pixels(SkScalarCeilToInt(pic->cullRect().width() * scale),
+                                  SkScalarCeilToInt(pic->cullRect().height() * scale))) {
+        SkDebugf("Could not allocate a canvas for %s.\n", path);
+        return false;
+    }
+    SkCanvas canvas(bitmap);
+    canvas.scale(scale, scale);
+    canvas.translate(-pic->cullRect().x(), -pic->cullRect().y());
+
+    RecordProfiler profiler;
+    profiler.profile(pic, &canvas, FLAGS_loops);
+
+    SkString name = SkOSPath::Basename(path);
+    SkDebugf("%s: ", name.c_str());
+    profiler.dump(FLAGS_top);
+    SkDebugf("\n");
+
+    json->append(json->isEmpty() ? "[\n" : ",\n");
+    profiler.appendJSON(json, name.c_str());
+    return true;
+}
+
+int tool_main(int argc, char** argv);
+int tool_main(int argc, char** argv) {
+    SkCommandLineFlags::SetUsage("Finds the ops that dominate raster playback of SKPs.\n");
+    SkCommandLineFlags::Parse(argc, argv);
+    SkAutoGraphics ag;
+
+    SkString json;
+    for (int i = 0; i < FLAGS_skps.count(); i++) {
+        SkTArray<SkString> paths;
+        if (sk_isdir(FLAGS_skps[i])) {
+            SkOSFile::Iter it(FLAGS_skps[i], ".skp");
+            SkString path;
+            while (it.next(&path)) {
+                paths.push_back(SkOSPath::Join(FLAGS_skps[i], path.c_str()));
+            }
+        } else {
+            paths.push_back().set(FLAGS_skps[i]);
+        }
+
+        for (int j = 0; j < paths.count(); j++) {
+            if (SkCommandLineFlags::ShouldSkip(FLAGS_match, paths[j].c_str())) {
+                continue;
+            }
+            if (!profile(paths[j].c_str(), &json)) {
+                return 1;
+            }
+        }
+    }
+
+    if (!FLAGS_json.isEmpty()) {
+        json.append(json.isEmpty() ? "[]\n" : "\n]\n");
+        SkFILEWStream out(FLAGS_json[0]);
+        if (!out.isValid() || !out.write(json.c_str(), json.size())) {
+            SkDebugf("Could not write %s.\n", FLAGS_json[0]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#if !defined SK_BUILD_FOR_IOS
+int main(int argc, char * const argv[]) {
+    return tool_main(argc, (char**) argv);
+}
+#endif
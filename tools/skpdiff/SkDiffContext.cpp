@@ -95,6 +95,25 @@ static SkString get_combined_name(const SkString& a, const SkString& b) {
     return result;
 }
 
+// Returns true if the two bitmaps have the same size and pixels, which every differ would report
+// as a correct result with no points of interest.
+static bool same_pixels(const SkBitmap& baseline, const SkBitmap& test) {
+    if (baseline.width() != test.width() || baseline.height() != test.height() ||
+        baseline.width() <= 0 || baseline.height() <= 0 ||
+        baseline.colorType() != test.colorType() || kN32_SkColorType != baseline.colorType()) {
+        return false;
+    }
+    SkAutoLockPixels alpBaseline(baseline);
+    SkAutoLockPixels alpTest(test);
+    const size_t rowBytes = baseline.width() * sizeof(SkPMColor);
+    for (int y = 0; y < baseline.height(); y++) {
+        if (memcmp(baseline.getAddr32(0, y), test.getAddr32(0, y), rowBytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void SkDiffContext::addDiff(const char* baselinePath, const char* testPath) {
     // Load the images at the paths
     SkBitmap baselineBitmap;
@@ -134,7 +153,8 @@ void SkDiffContext::addDiff(const char* baselinePath, const char* testPath) {
     bitmapsToCreate.rgbDiff = !fRgbDiffDir.isEmpty();
     bitmapsToCreate.whiteDiff = !fWhiteDiffDir.isEmpty();
 
-    // Perform each diff
+    // Perform each diff, unless the images are identical
+    const bool samePixels = same_pixels(baselineBitmap, testBitmap);
     for (int differIndex = 0; differIndex < fDifferCount; differIndex++) {
         SkImageDiffer* differ = fDiffers[differIndex];
 
@@ -142,6 +162,16 @@ void SkDiffContext::addDiff(const char* baselinePath, const char* testPath) {
         DiffData& diffData = newRecord->fDiffs.push_back();
         diffData.fDiffName = differ->getName();
 
+        if (samePixels) {
+            diffData.fResult.result = SkImageDiffer::RESULT_CORRECT;
+            diffData.fResult.poiCount = 0;
+            diffData.fResult.maxRedDiff = 0;
+            diffData.fResult.maxGreenDiff = 0;
+            diffData.fResult.maxBlueDiff = 0;
+            diffData.fResult.timeElapsed = 0;
+            continue;
+        }
+
         if (!differ->diff(&baselineBitmap, &testBitmap, bitmapsToCreate, &diffData.fResult)) {
             // if the diff failed, record -1 as the result
             // TODO(djsollen): Record more detailed information about exactly what failed.
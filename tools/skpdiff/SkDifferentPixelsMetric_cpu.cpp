@@ -64,10 +64,12 @@ bool SkDifferentPixelsMetric::diff(SkBitmap* baseline, SkBitmap* test,
         // of assuming 4 bytes per pixel.
         uint32_t* baselineRow = static_cast<uint32_t *>(baseline->getAddr(0, y));
         uint32_t* testRow = static_cast<uint32_t *>(test->getAddr(0, y));
+        // Most rows of most image pairs are identical, and memcmp checks them much faster.
+        if (0 == memcmp(baselineRow, testRow, width * sizeof(uint32_t))) {
+            continue;
+        }
         for (int x = 0; x < width; x++) {
             // Compare one pixel at a time so each differing pixel can be noted
-            // TODO(epoger): This loop looks like a good place to work on performance,
-            // but we should run the code through a profiler to be sure.
             uint32_t baselinePixel = baselineRow[x];
             uint32_t testPixel = testRow[x];
             if (baselinePixel != testPixel) {
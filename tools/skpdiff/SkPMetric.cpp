@@ -2,6 +2,7 @@
 #include <math.h>
 
 #include "SkBitmap.h"
+#include "SkNx.h"
 #include "skpdiff_util.h"
 #include "SkPMetric.h"
 #include "SkPMetricUtil_generated.h"
@@ -210,6 +211,61 @@ static void lab_to_l(const ImageLAB* imageLAB, ImageL* outImageL) {
     }
 }
 
+// Convolves one pixel, mirroring the matrix at the edges of the image.
+static float convolve_pixel(const ImageL* imageL, bool vertical, float* const rowPtrs[],
+                            const float matrix[], int radius, int x, int y) {
+    float lSum = 0.0f;
+    for (int xx = -radius; xx <= radius; xx++) {
+        int nx = x;
+        int ny = y;
+
+        // We mirror at edges so that edge pixels that the filter weighting still makes
+        // sense.
+        if (vertical) {
+            ny += xx;
+            if (ny < 0) {
+                ny = -ny;
+            }
+            if (ny >= imageL->height) {
+                ny = imageL->height + (imageL->height - ny - 1);
+            }
+        } else {
+            nx += xx;
+            if (nx < 0) {
+                nx = -nx;
+            }
+            if (nx >= imageL->width) {
+                nx = imageL->width + (imageL->width - nx - 1);
+            }
+        }
+
+        float weight = matrix[xx + radius];
+        lSum += rowPtrs[ny - y + radius][nx] * weight;
+    }
+    return lSum;
+}
+
+// Convolves count pixels that need no mirroring: taps[i] points at the pixels under matrix[i].
+// Sums the taps in the same order as convolve_pixel, so the results are identical.
+static void convolve_span(const float* const taps[], const float matrix[], int matrixCount,
+                          int count, float* dst) {
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        Sk4f lSum(0.0f);
+        for (int i = 0; i < matrixCount; i++) {
+            lSum += Sk4f::Load(taps[i] + x) * Sk4f(matrix[i]);
+        }
+        lSum.store(dst + x);
+    }
+    for (; x < count; x++) {
+        float lSum = 0.0f;
+        for (int i = 0; i < matrixCount; i++) {
+            lSum += taps[i][x] * matrix[i];
+        }
+        dst[x] = lSum;
+    }
+}
+
 /// Convolves an image with the given filter in one direction and saves it to the output image
 static void convolve(const ImageL* imageL, bool vertical, ImageL* outImageL) {
     SkASSERT(imageL->width == outImageL->width);
@@ -226,38 +282,37 @@ static void convolve(const ImageL* imageL, bool vertical, ImageL* outImageL) {
     }
     float* writeRow = outImageL->getRow(0);
 
-    for (int y = 0; y < imageL->height; y++) {
-        for (int x = 0; x < imageL->width; x++) {
-            float lSum = 0.0f;
-            for (int xx = -radius; xx <= radius; xx++) {
-                int nx = x;
-                int ny = y;
-
-                // We mirror at edges so that edge pixels that the filter weighting still makes
-                // sense.
-                if (vertical) {
-                    ny += xx;
-                    if (ny < 0) {
-                        ny = -ny;
-                    }
-                    if (ny >= imageL->height) {
-                        ny = imageL->height + (imageL->height - ny - 1);
-                    }
-                } else {
-                    nx += xx;
-                    if (nx < 0) {
-                        nx = -nx;
-                    }
-                    if (nx >= imageL->width) {
-                        nx = imageL->width + (imageL->width - nx - 1);
-                    }
+    const int width = imageL->width;
+    const int height = imageL->height;
+    for (int y = 0; y < height; y++) {
+        // Only the pixels within radius of an edge need mirroring.
+        int spanLeft = width, spanRight = width;
+        const float* taps[matrixCount];
+        if (vertical) {
+            if (y >= radius && y < height - radius) {
+                spanLeft = 0;
+                for (int i = 0; i < matrixCount; i++) {
+                    taps[i] = rowPtrs[i];
                 }
-
-                float weight = matrix[xx + radius];
-                lSum += rowPtrs[ny - y + radius][nx] * weight;
             }
-            writeRow[x] = lSum;
+        } else if (width > 2 * radius) {
+            spanLeft = radius;
+            spanRight = width - radius;
+            for (int i = 0; i < matrixCount; i++) {
+                taps[i] = rowPtrs[radius] + spanLeft + i - radius;
+            }
+        }
+
+        for (int x = 0; x < spanLeft; x++) {
+            writeRow[x] = convolve_pixel(imageL, vertical, rowPtrs, matrix, radius, x, y);
         }
+        if (spanLeft < spanRight) {
+            convolve_span(taps, matrix, matrixCount, spanRight - spanLeft, writeRow + spanLeft);
+        }
+        for (int x = spanRight; x < width; x++) {
+            writeRow[x] = convolve_pixel(imageL, vertical, rowPtrs, matrix, radius, x, y);
+        }
+
         // As we move down, scroll the row pointers down with us
         for (int y = 0; y < matrixCount - 1; y++)
         {